@@ -54,3 +54,8 @@ struct Object
 layout(set = 3, binding = 0) buffer ObjectStorageBufferObject{
     Object[] Objects;
 };
+
+// Written per draw, gl_InstanceIndex (which includes firstInstance) -> index into Objects
+layout(set = 3, binding = 1) buffer InstanceIndexStorageBufferObject{
+    uint[] InstanceIndexBuffer;
+};
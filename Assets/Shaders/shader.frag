@@ -6,11 +6,14 @@ layout(location = 1) in vec2 InTexCoords;
 
 layout(location = 0) out vec4 outColor;
 
+// Permutation features, see ShaderPermutationFeatures
+layout(constant_id = 0) const bool ALPHA_TEST = false;
+layout(constant_id = 1) const bool VERTEX_COLOR = false;
+
 layout(push_constant) uniform PushConstants {
-    int ObjectIndex;
     int MaterialIndex;
     int ActiveSceneIndex;
-    int Padding;
+    int Padding[2];
 } DrawPushData;
 
 void main()
@@ -20,4 +23,8 @@ void main()
                                           Samplers[int(ActiveMaterial.AlbedoSamplerIndex)]), InTexCoords);
     // Use the calculated light and the original alpha
     outColor = ActiveMaterial.AlbedoColor * TextureColor;
+    if (VERTEX_COLOR)
+        outColor.rgb *= OutColor;
+    if (ALPHA_TEST && outColor.a < 0.5)
+        discard;
 }
\ No newline at end of file
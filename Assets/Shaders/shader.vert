@@ -10,14 +10,13 @@ layout(location = 0) out vec3 OutColor;
 layout(location = 1) out vec2 OutTexCoords;
 
 layout(push_constant) uniform PushConstants {
-    int ObjectIndex;
     int MaterialIndex;
     int ActiveSceneIndex;
-    int Padding;
+    int Padding[2];
 } DrawPushData;
 
 void main() {
-    Object ActiveObject = Objects[DrawPushData.ObjectIndex];
+    Object ActiveObject = Objects[InstanceIndexBuffer[gl_InstanceIndex]];
     Scene ActiveScene = SceneUBO.Scenes[DrawPushData.ActiveSceneIndex];
     
     mat4 ModelMatrix = ActiveObject.TransformationMat;
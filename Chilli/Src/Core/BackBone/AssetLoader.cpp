@@ -23,6 +23,8 @@
 #include "tiny_obj_loader.h"
 
 #include <unordered_map>
+#include <algorithm>
+#include <bit>
 #include <functional>
 
 // A temporary struct just for hashing 8 floats together
@@ -97,6 +99,24 @@ namespace Chilli
 		NewData.Pixels = stbi_load(Path.c_str(), &Width, &Height, &NumChannels, STBI_rgb_alpha);
 		if (NewData.Pixels == nullptr)
 			CH_CORE_ERROR("Given Path {} doesnot result any pixel data", Path);
+		else
+			NewData.PixelsSize = uint64_t(Width) * Height * 4;
+
+		if (NewData.Pixels != nullptr && _Settings.GenerateMips)
+		{
+			// Level 0 stays first so anything reading only the top level sees the same data
+			uint32_t MipCount = GetFullMipCount(uint32_t(Width), uint32_t(Height));
+			uint64_t ChainSize = LayoutMipChainRGBA8(uint32_t(Width), uint32_t(Height), MipCount, NewData.Mips);
+
+			void* Chain = malloc(size_t(ChainSize));
+			memcpy(Chain, NewData.Pixels, size_t(NewData.Mips[0].Size));
+			stbi_image_free(NewData.Pixels);
+			NewData.Pixels = Chain;
+			NewData.PixelsSize = ChainSize;
+
+			GenerateMipChainRGBA8(NewData.Pixels, NewData.Mips.data(), MipCount, _Settings.Mips);
+		}
+		CH_MEMORY_TRACK_ALLOC(MemoryTag::ASSETS, size_t(NewData.PixelsSize));
 		NewData.Resolution = { Width, Height };
 		NewData.NumChannels = NumChannels;
 		NewData.FileName = GetFileNameWithExtension(Path);
@@ -128,7 +148,11 @@ namespace Chilli
 		if (!Handle)
 			return;
 
-		stbi_image_free(Handle->Pixels);
+		if (Handle->Mips.empty())
+			stbi_image_free(Handle->Pixels);
+		else
+			free(Handle->Pixels);
+		CH_MEMORY_TRACK_FREE(MemoryTag::ASSETS, size_t(Handle->PixelsSize));
 
 		ImageDataStore->Remove(_ImageDataHandles[Index]);
 
@@ -141,6 +165,228 @@ namespace Chilli
 		Unload(Ctxt, Data.ValPtr->FilePath);
 	}
 
+	Ktx2ImageLoader::~Ktx2ImageLoader()
+	{
+		for (int i = 0; i < _IndexMaps.size(); i++)
+		{
+			if (_IndexMaps[i].IsValid())
+				CH_CORE_ERROR("All KTX2 Image Data Must be Unloaded!");
+		}
+	}
+
+	// The VkFormat values KTX2 stores, kept here so the loader does not need the Vulkan headers
+	static ImageFormat Ktx2FormatToImageFormat(uint32_t VkFormat)
+	{
+		switch (VkFormat)
+		{
+		case 37:  return ImageFormat::RGBA8;      // VK_FORMAT_R8G8B8A8_UNORM
+		case 43:  return ImageFormat::SRGBA8;     // VK_FORMAT_R8G8B8A8_SRGB
+		case 133: return ImageFormat::BC1_RGBA;   // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+		case 134: return ImageFormat::BC1_SRGBA;
+		case 135: return ImageFormat::BC2_RGBA;
+		case 136: return ImageFormat::BC2_SRGBA;
+		case 137: return ImageFormat::BC3_RGBA;
+		case 138: return ImageFormat::BC3_SRGBA;
+		case 139: return ImageFormat::BC4_R;      // VK_FORMAT_BC4_UNORM_BLOCK
+		case 141: return ImageFormat::BC5_RG;     // VK_FORMAT_BC5_UNORM_BLOCK
+		case 143: return ImageFormat::BC6H_RGBF;  // VK_FORMAT_BC6H_UFLOAT_BLOCK
+		case 145: return ImageFormat::BC7_RGBA;
+		case 146: return ImageFormat::BC7_SRGBA;
+		default:  return ImageFormat::NONE;
+		}
+	}
+
+// Largest edge a KTX2 image may have, anything above it is treated as a corrupt header
+#define CH_KTX2_MAX_DIMENSION 16384
+
+	static bool LoadKtx2(const std::string& Path, ImageData& Data)
+	{
+		struct Ktx2Header
+		{
+			uint8_t Identifier[12];
+			uint32_t VkFormat, TypeSize;
+			uint32_t PixelWidth, PixelHeight, PixelDepth;
+			uint32_t LayerCount, FaceCount, LevelCount;
+			uint32_t SupercompressionScheme;
+			uint32_t DfdByteOffset, DfdByteLength, KvdByteOffset, KvdByteLength;
+			uint64_t SgdByteOffset, SgdByteLength;
+		};
+		struct Ktx2Level
+		{
+			uint64_t ByteOffset, ByteLength, UncompressedByteLength;
+		};
+		static_assert(sizeof(Ktx2Header) == 80, "KTX2 header has to match the file layout");
+
+		static const uint8_t Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+		std::ifstream File(Path, std::ios::binary);
+		if (!File)
+		{
+			CH_CORE_ERROR("Failed to open KTX2 file {}", Path);
+			return false;
+		}
+
+		Ktx2Header Header{};
+		File.read(reinterpret_cast<char*>(&Header), sizeof(Header));
+		if (!File || memcmp(Header.Identifier, Identifier, sizeof(Identifier)) != 0)
+		{
+			CH_CORE_ERROR("{} is not a KTX2 file", Path);
+			return false;
+		}
+
+		Data.Format = Ktx2FormatToImageFormat(Header.VkFormat);
+		if (Data.Format == ImageFormat::NONE)
+		{
+			CH_CORE_ERROR("{} uses VkFormat {} which has no ImageFormat", Path, Header.VkFormat);
+			return false;
+		}
+		if (Header.SupercompressionScheme != 0)
+		{
+			CH_CORE_ERROR("{} is supercompressed (scheme {}), only plain KTX2 files are supported", Path,
+				Header.SupercompressionScheme);
+			return false;
+		}
+		if (Header.PixelDepth > 1 || Header.LayerCount > 1 || Header.FaceCount != 1)
+		{
+			CH_CORE_ERROR("{} is not a single 2D image, arrays, cubemaps and 3D textures are not supported", Path);
+			return false;
+		}
+
+		if (Header.PixelWidth == 0 || Header.PixelHeight == 0 || Header.PixelWidth > CH_KTX2_MAX_DIMENSION ||
+			Header.PixelHeight > CH_KTX2_MAX_DIMENSION)
+		{
+			CH_CORE_ERROR("{} has an invalid size of {}x{}", Path, Header.PixelWidth, Header.PixelHeight);
+			return false;
+		}
+
+		// A level count of 0 asks for mips to be generated at load, only the base level is stored then
+		uint32_t LevelCount = std::max(Header.LevelCount, 1u);
+		uint32_t MaxLevelCount = uint32_t(std::bit_width(std::max(Header.PixelWidth, Header.PixelHeight)));
+		if (LevelCount > MaxLevelCount)
+		{
+			CH_CORE_ERROR("{} has {} levels, a {}x{} image has at most {}", Path, LevelCount, Header.PixelWidth,
+				Header.PixelHeight, MaxLevelCount);
+			return false;
+		}
+
+		std::vector<Ktx2Level> Levels(LevelCount);
+		File.read(reinterpret_cast<char*>(Levels.data()), sizeof(Ktx2Level) * LevelCount);
+		if (!File)
+		{
+			CH_CORE_ERROR("{} has a truncated level index", Path);
+			return false;
+		}
+
+		std::streamoff Cursor = File.tellg();
+		File.seekg(0, std::ios::end);
+		uint64_t FileSize = uint64_t(File.tellg());
+		File.seekg(Cursor);
+
+		// Levels are stored smallest first, the whole span is read at once and the regions point into it
+		uint64_t First = UINT64_MAX, End = 0;
+		for (uint32_t Mip = 0; Mip < LevelCount; Mip++)
+		{
+			const auto& Level = Levels[Mip];
+			uint32_t Width = std::max(Header.PixelWidth >> Mip, 1u);
+			uint32_t Height = std::max(Header.PixelHeight >> Mip, 1u);
+			uint64_t RequiredSize = IsBlockCompressedFormat(Data.Format)
+				? GetBlockCompressedLevelSize(Data.Format, Width, Height) : uint64_t(Width) * Height * 4;
+
+			if (Level.ByteLength < RequiredSize || Level.ByteOffset > FileSize ||
+				Level.ByteLength > FileSize - Level.ByteOffset)
+			{
+				CH_CORE_ERROR("{} level {} ({} bytes at {}) does not hold a {}x{} image inside the file", Path, Mip,
+					Level.ByteLength, Level.ByteOffset, Width, Height);
+				return false;
+			}
+
+			First = std::min(First, Level.ByteOffset);
+			End = std::max(End, Level.ByteOffset + Level.ByteLength);
+		}
+
+		Data.Pixels = malloc(size_t(End - First));
+		File.seekg(std::streamoff(First));
+		File.read(static_cast<char*>(Data.Pixels), std::streamsize(End - First));
+		if (!File)
+		{
+			CH_CORE_ERROR("{} has truncated level data", Path);
+			free(Data.Pixels);
+			Data.Pixels = nullptr;
+			return false;
+		}
+
+		Data.PixelsSize = End - First;
+		CH_MEMORY_TRACK_ALLOC(MemoryTag::ASSETS, size_t(Data.PixelsSize));
+
+		Data.Mips.resize(LevelCount);
+		for (uint32_t Mip = 0; Mip < LevelCount; Mip++)
+		{
+			auto& Region = Data.Mips[Mip];
+			Region.Offset = Levels[Mip].ByteOffset - First;
+			Region.Size = Levels[Mip].ByteLength;
+			Region.Width = std::max(Header.PixelWidth >> Mip, 1u);
+			Region.Height = std::max(Header.PixelHeight >> Mip, 1u);
+		}
+
+		Data.Resolution = { int(Header.PixelWidth), int(Header.PixelHeight) };
+		Data.NumChannels = 4;
+		return true;
+	}
+
+	BackBone::AssetHandle<ImageData> Ktx2ImageLoader::LoadTyped(BackBone::SystemContext& Ctxt, const std::string& Path)
+	{
+		auto Command = Chilli::Command(Ctxt);
+		auto ImageDataStore = Command.GetStore<ImageData>();
+
+		uint64_t HashValue = HashString64(GetFileNameWithExtension(Path));
+
+		int Index = IndexEntry::FindIndex(_IndexMaps, HashValue);
+		if (Index != -1)
+			return _ImageDataHandles[Index];
+
+		ImageData NewData{};
+		LoadKtx2(Path, NewData);
+		NewData.FileName = GetFileNameWithExtension(Path);
+		NewData.FilePath = Path;
+
+		auto ImageDataHandle = ImageDataStore->Add(NewData);
+
+		uint32_t NewIndex = static_cast<uint32_t>(_ImageDataHandles.size());
+		_ImageDataHandles.push_back(ImageDataHandle);
+
+		IndexEntry::AddOrUpdateSorted(_IndexMaps, { HashValue, NewIndex });
+
+		return ImageDataHandle;
+	}
+
+	void Ktx2ImageLoader::Unload(BackBone::SystemContext& Ctxt, const std::string& Path)
+	{
+		auto Command = Chilli::Command(Ctxt);
+		auto ImageDataStore = Command.GetStore<ImageData>();
+
+		uint64_t HashValue = HashString64(GetFileNameWithExtension(Path));
+
+		int Index = IndexEntry::FindIndex(_IndexMaps, HashValue);
+		if (Index == -1)
+			return;
+
+		auto Handle = ImageDataStore->Get(_ImageDataHandles[Index]);
+		if (!Handle)
+			return;
+
+		free(Handle->Pixels);
+		CH_MEMORY_TRACK_FREE(MemoryTag::ASSETS, size_t(Handle->PixelsSize));
+
+		ImageDataStore->Remove(_ImageDataHandles[Index]);
+
+		IndexEntry::Invalidate(_IndexMaps, HashValue);
+	}
+
+	void Ktx2ImageLoader::Unload(BackBone::SystemContext& Ctxt, const BackBone::AssetHandle<ImageData>& Data)
+	{
+		Unload(Ctxt, Data.ValPtr->FilePath);
+	}
+
 	CGLFTMeshLoader::~CGLFTMeshLoader()
 	{
 		for (int i = 0; i < _IndexMaps.size(); i++)
@@ -241,6 +487,7 @@ namespace Chilli
 				}
 
 				auto Handle = Store->Add(NewMesh);
+				CH_MEMORY_TRACK_ALLOC(MemoryTag::ASSETS, NewMesh.GetPayloadSize());
 				Collection.Meshes.push_back(Handle);
 			}
 		}
@@ -290,6 +537,8 @@ namespace Chilli
 		auto RawMeshStore = Command.GetStore<RawMeshData>();
 		for (auto& i : Handle->Meshes)
 		{
+			if (auto RawMesh = RawMeshStore->Get(i))
+				CH_MEMORY_TRACK_FREE(MemoryTag::ASSETS, RawMesh->GetPayloadSize());
 			RawMeshStore->Remove(i);
 		}
 
@@ -396,6 +645,7 @@ namespace Chilli
 			memcpy(NewMesh.Indices.data(), indices.data(), NewMesh.Indices.size());
 
 			auto Handle = Store->Add(NewMesh);
+			CH_MEMORY_TRACK_ALLOC(MemoryTag::ASSETS, NewMesh.GetPayloadSize());
 			Collection.Meshes.push_back(Handle);
 		}
 	}
@@ -452,6 +702,8 @@ namespace Chilli
 		auto RawMeshStore = Command.GetStore<RawMeshData>();
 		for (auto& i : Handle->Meshes)
 		{
+			if (auto RawMesh = RawMeshStore->Get(i))
+				CH_MEMORY_TRACK_FREE(MemoryTag::ASSETS, RawMesh->GetPayloadSize());
 			RawMeshStore->Remove(i);
 		}
 
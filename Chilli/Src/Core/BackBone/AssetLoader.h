@@ -3,6 +3,7 @@
 #include "Maths.h"
 #include "BackBone.h"
 #include "Image.h"
+#include "MipChain.h"
 #include "Mesh.h"
 #include "Pipeline.h"
 
@@ -103,6 +104,10 @@ namespace Chilli
 		ImageFormat Format = ImageFormat::NONE;
 		std::string FileName;
 		std::string FilePath;
+		// Set by containers that carry their own mip chain, Pixels then holds every level at these regions
+		std::vector<ImageMipRegion> Mips;
+		// Bytes Pixels points at, the loader counts them under MemoryTag::ASSETS
+		uint64_t PixelsSize = 0;
 
 		~ImageData() {
 
@@ -138,9 +143,22 @@ namespace Chilli
 	class ImageLoader : public BaseLoader<ImageData>
 	{
 	public:
+		struct ImportSettings
+		{
+			// The full chain is filtered on the CPU every time the image is loaded, nothing is cached next to
+			// the source, so it is a load time cost per image. Off by default, mips are then blitted at upload
+			bool GenerateMips = false;
+			// SRGB should match how the image is sampled, a chain built linear is slightly too dark as sRGB
+			MipChainSpec Mips;
+		};
+
 		ImageLoader() {}
 		~ImageLoader();
 
+		// Used for every image loaded after the call
+		void SetImportSettings(const ImportSettings& Settings) { _Settings = Settings; }
+		const ImportSettings& GetImportSettings() const { return _Settings; }
+
 		virtual BackBone::AssetHandle<ImageData> LoadTyped(BackBone::SystemContext& Ctxt, const std::string& Path) override;
 		virtual void Unload(BackBone::SystemContext& Ctxt, const std::string& Path) override;
 		virtual void Unload(BackBone::SystemContext& Ctxt, const BackBone::AssetHandle<ImageData>& Data) override;
@@ -152,6 +170,28 @@ namespace Chilli
 	private:
 		std::vector<IndexEntry> _IndexMaps;
 		std::vector<BackBone::AssetHandle<ImageData>> _ImageDataHandles;   // Maps Hash index to _ImageDatas index
+		ImportSettings _Settings;
+	};
+
+	// KTX2 textures with their mip chain as stored, block compressed data is never decoded here.
+	// Only 2D images with one layer and face and no supercompression are read
+	class Ktx2ImageLoader : public BaseLoader<ImageData>
+	{
+	public:
+		Ktx2ImageLoader() {}
+		~Ktx2ImageLoader();
+
+		virtual BackBone::AssetHandle<ImageData> LoadTyped(BackBone::SystemContext& Ctxt, const std::string& Path) override;
+		virtual void Unload(BackBone::SystemContext& Ctxt, const std::string& Path) override;
+		virtual void Unload(BackBone::SystemContext& Ctxt, const BackBone::AssetHandle<ImageData>& Data) override;
+
+		virtual bool DoesExist(const std::string& Path) const override { return true; }
+		virtual int __FindIndex(const std::string& Path) const override { return 0; }
+
+		virtual std::vector<std::string> GetExtensions() override { return { ".ktx2" }; }
+	private:
+		std::vector<IndexEntry> _IndexMaps;
+		std::vector<BackBone::AssetHandle<ImageData>> _ImageDataHandles;
 	};
 
 	enum class MeshAttribute {
@@ -170,6 +210,8 @@ namespace Chilli
 		std::vector<uint8_t> Vertices;
 		std::vector<uint8_t> Indices;
 		VertexInputShaderLayout FileLayout;
+
+		size_t GetPayloadSize() const { return Vertices.size() + Indices.size(); }
 	};
 
 	struct MeshLoaderData
@@ -10,6 +10,7 @@
 #include <vector>
 #include <tuple>
 #include "SparseSet.h"
+#include "Profiling/MemoryTracker.h"
 
 namespace Chilli
 {
@@ -102,9 +103,9 @@ namespace Chilli
 		template<typename _T>
 		struct PerComponentStorage : public __IPerComponentStorage__
 		{
-			std::vector<Entity> Dense;
-			std::vector<uint32_t> Sparse;
-			std::vector<_T> Components;
+			TrackedVector<Entity, MemoryTag::ECS> Dense;
+			TrackedVector<uint32_t, MemoryTag::ECS> Sparse;
+			TrackedVector<_T, MemoryTag::ECS> Components;
 
 			void Add(Entity id, _T component)
 			{
@@ -622,6 +623,7 @@ namespace Chilli
 			AssetStore() = default;
 			~AssetStore()
 			{
+				CH_MEMORY_TRACK_FREE(MemoryTag::ASSETS, sizeof(T) * _Data.size());
 			}
 
 			AssetHandle<T> Add(const T& val)
@@ -641,6 +643,8 @@ namespace Chilli
 				_Sparse[id] = _Dense.size();
 				_Dense.push_back(id);
 				_Data.push_back(std::make_unique<T>(val));
+				// Only the asset itself, pixel and mesh payloads are counted by the loaders that own them
+				CH_MEMORY_TRACK_ALLOC(MemoryTag::ASSETS, sizeof(T));
 				Handle.Handle = id;
 				Handle.ValPtr = Get(Handle);
 
@@ -667,6 +671,7 @@ namespace Chilli
 				_Data.pop_back();
 				_Sparse[id] = npos;
 				_FreeList.push_back(id);
+				CH_MEMORY_TRACK_FREE(MemoryTag::ASSETS, sizeof(T));
 			}
 
 			T* Get(const AssetHandle<T>& Handle)
@@ -3,6 +3,7 @@
 #include "DeafultExtensions.h"
 #include "Window/Window.h"
 #include "Profiling\Timer.h"
+#include "TextureCompression.h"
 
 #include "glm/glm.hpp"
 #include <glm/gtc/matrix_transform.hpp>
@@ -90,16 +91,51 @@ namespace Chilli
 		}
 	}
 
+#if CHILLI_ENABLE_MEMORY_TRACKING == true
+	void OnMemoryTrackingReport(BackBone::SystemContext& Ctxt)
+	{
+		auto Command = Chilli::Command(Ctxt);
+		auto Resource = Command.GetResource<MemoryTrackingResource>();
+
+		if (Resource->DumpInterval <= 0.0f)
+			return;
+
+		if (Resource->DumpTimer.ElapsedMsl() >= (long long)(Resource->DumpInterval * 1000.0f))
+		{
+			CH_MEMORY_DUMP();
+			Resource->DumpTimer.Reset();
+		}
+	}
+
+	void OnMemoryTrackingShutDown(BackBone::SystemContext& Ctxt)
+	{
+		CH_MEMORY_DUMP();
+	}
+#endif
+
 	void DeafultExtension::Build(BackBone::App& App)
 	{
 		App.Registry.AddResource<ParentChildMapTable>();
 		App.Registry.Register<Chilli::TransformComponent>();
 
+#if CHILLI_ENABLE_MEMORY_TRACKING == true
+		for (int i = 0; i < int(MemoryTag::COUNT); i++)
+			CH_MEMORY_SET_BUDGET(MemoryTag(i), _Config.MemoryConfig.Budgets[i]);
+
+		App.Registry.AddResource<MemoryTrackingResource>();
+		App.Registry.GetResource<MemoryTrackingResource>()->DumpInterval = _Config.MemoryConfig.DumpInterval;
+		App.SystemScheduler.AddSystem(BackBone::ScheduleTimer::UPDATE, OnMemoryTrackingReport);
+		App.SystemScheduler.AddSystem(BackBone::ScheduleTimer::SHUTDOWN, OnMemoryTrackingShutDown);
+#endif
+
 		_Config.PepperConfig.MaxFramesInFlight = _Config.RenderConfig.Spec.MaxFrameInFlight;
 
 		App.SystemScheduler.AddSystemOverLayAfter(BackBone::ScheduleTimer::UPDATE, OnTransformComponentParentChild);
 		App.SystemScheduler.AddSystemOverLayAfter(BackBone::ScheduleTimer::UPDATE, HandleParentChildTransform);
 
+		App.Registry.AddResource<SpatialIndexResource>();
+		App.SystemScheduler.AddSystemOverLayAfter(BackBone::ScheduleTimer::UPDATE, OnSpatialIndexUpdate);
+
 		App.Extensions.AddExtension(std::make_unique<WindowExtension>(_Config.WindowConfig), true, &App);
 		App.Extensions.AddExtension(std::make_unique<RenderExtension>(_Config.RenderConfig), true, &App);
 		App.Extensions.AddExtension(std::make_unique<CameraExtension>(), true, &App);
@@ -343,6 +379,21 @@ namespace Chilli
 		return BackBone::AssetHandle<Mesh>();
 	}
 
+	// Reads the POSITION attribute out of binding 0, anything else leaves the bounds invalid
+	static MeshBounds ComputeMeshBounds(const VertexInputShaderLayout& Layout, const void* Vertices, uint32_t VertexCount)
+	{
+		for (const auto& Binding : Layout.Bindings)
+		{
+			if (Binding.BindingIndex != 0 || Binding.IsInstanced)
+				continue;
+
+			for (const auto& Attrib : Binding.Attribs)
+				if (Attrib.Location == (uint32_t)MeshAttribute::POSITION && Attrib.Type == ShaderObjectTypes::FLOAT3)
+					return MeshBounds::FromPositions(Vertices, VertexCount, Binding.Stride, Attrib.Offset);
+		}
+		return MeshBounds();
+	}
+
 	BackBone::AssetHandle<Mesh> Command::CreateMesh(const MeshCreateInfo& Info)
 	{
 		auto RenderCommandService = _Ctxt.ServiceRegistry->GetService<Chilli::RenderCommand>();
@@ -355,6 +406,18 @@ namespace Chilli
 		Chilli::Mesh NewMesh;
 		NewMesh.IndexBufferState = Info.IndexBufferState;
 		NewMesh.MeshLayout = Info.MeshLayout;
+
+		// Static geometry is suballocated out of the shared arena pages instead of owning its buffers
+		if (MeshArena::CanHold(Info))
+		{
+			GetService<MeshArena>()->Allocate(Info, NewMesh);
+			NewMesh.VertexCount = Info.VertCount;
+			NewMesh.Bounds = ComputeMeshBounds(Info.MeshLayout, Info.Vertices, Info.VertCount);
+			NewMesh.IBType = Info.IndexType;
+			NewMesh.IndexCount = Info.IndexCount;
+			return MeshStore->Add(NewMesh);
+		}
+
 		// The "highest" binding index defines how many slots we actually need to bind in Vulkan
 		uint32_t MaxBindingIndex = 0;
 
@@ -386,6 +449,7 @@ namespace Chilli
 
 		NewMesh.ActiveVBHandlesCount = MaxBindingIndex + 1;
 		NewMesh.VertexCount = Info.VertCount;
+		NewMesh.Bounds = ComputeMeshBounds(Info.MeshLayout, Info.Vertices, Info.VertCount);
 
 		if (Info.IndexCount > 0)
 		{
@@ -420,10 +484,28 @@ namespace Chilli
 
 		CH_CORE_ASSERT(Mesh != nullptr, "Mesh Not Found");
 		CH_CORE_ASSERT(Binding < 16, "Binding Over Limit");
-		CH_CORE_ASSERT(Mesh->VertexBufferHandles[Binding].ValPtr->CreateInfo.SizeInBytes >= Size, "Given Size Exceeds Mesh Initialized Size");
+
+		size_t Base = 0;
+		if (Mesh->ArenaPage != UINT32_MAX)
+		{
+			// Arena meshes only own their range of the page's buffer
+			uint32_t Stride = 0;
+			for (const auto& LayoutBinding : Mesh->MeshLayout.Bindings)
+				if (LayoutBinding.BindingIndex == Binding)
+					Stride = LayoutBinding.Stride;
+
+			CH_CORE_ASSERT(Offset + Size <= size_t(Mesh->ArenaVertexCount) * Stride, "Given Size Exceeds Mesh Initialized Size");
+			Base = size_t(Mesh->VertexOffset) * Stride;
+		}
+		else
+			CH_CORE_ASSERT(Mesh->VertexBufferHandles[Binding].ValPtr->CreateInfo.SizeInBytes >= Size, "Given Size Exceeds Mesh Initialized Size");
 
 		Mesh->VertexCount = Count;
-		this->MapBufferData(Mesh->VertexBufferHandles[Binding], Data, Size, Offset);
+		this->MapBufferData(Mesh->VertexBufferHandles[Binding], Data, Size, Base + Offset);
+
+		// A full rewrite of the positions gives new bounds, a partial one can't be trusted anymore
+		if (Binding == 0)
+			Mesh->Bounds = Offset == 0 ? ComputeMeshBounds(Mesh->MeshLayout, Data, Count) : MeshBounds();
 	}
 
 	void Command::MapMeshIndexBufferData(BackBone::AssetHandle<Mesh> Handle, void* Data, uint32_t Count,
@@ -437,10 +519,19 @@ namespace Chilli
 		auto Mesh = MeshStore->Get(Handle);
 
 		CH_CORE_ASSERT(Mesh != nullptr, "Mesh Not Found");
-		CH_CORE_ASSERT(Mesh->IBHandle.ValPtr->CreateInfo.SizeInBytes >= Size, "Given Size Exceeds Mesh Initialized Size");
+
+		size_t Base = 0;
+		if (Mesh->ArenaPage != UINT32_MAX)
+		{
+			const size_t IndexSize = Mesh->IBType == IndexBufferType::UINT16_T ? sizeof(uint16_t) : sizeof(uint32_t);
+			CH_CORE_ASSERT(Offset + Size <= Mesh->ArenaIndexCount * IndexSize, "Given Size Exceeds Mesh Initialized Size");
+			Base = Mesh->FirstIndex * IndexSize;
+		}
+		else
+			CH_CORE_ASSERT(Mesh->IBHandle.ValPtr->CreateInfo.SizeInBytes >= Size, "Given Size Exceeds Mesh Initialized Size");
 
 		Mesh->IndexCount = Count;
-		this->MapBufferData(Mesh->IBHandle, Data, Size, Offset);
+		this->MapBufferData(Mesh->IBHandle, Data, Size, Base + Offset);
 	}
 
 	void Command::MakeNoiseTextureData(uint32_t Handle, uint8_t* Texture, uint32_t Width, uint32_t Height, bool ColorR, bool ColorG, bool ColorB)
@@ -1151,9 +1242,19 @@ namespace Chilli
 
 		CH_CORE_ASSERT(Mesh != nullptr, "Mesh Not Found");
 
-		DestroyBuffer(Mesh->VertexBufferHandles[0]);
-		if (Mesh->IndexCount != 0)
-			DestroyBuffer(Mesh->IBHandle);
+		// Handles are reset once the buffers are gone, destroying a mesh twice is a no-op
+		if (Mesh->ArenaPage != UINT32_MAX)
+			GetService<MeshArena>()->Free(*Mesh);
+		else
+		{
+			if (Mesh->VertexBufferHandles[0].IsValid())
+				DestroyBuffer(Mesh->VertexBufferHandles[0]);
+			if (Mesh->IndexCount != 0 && Mesh->IBHandle.IsValid())
+				DestroyBuffer(Mesh->IBHandle);
+			Mesh->VertexBufferHandles = {};
+			Mesh->ActiveVBHandlesCount = 0;
+			Mesh->IBHandle = {};
+		}
 
 		if (Free)
 			MeshStore->Remove(mesh);
@@ -1285,6 +1386,31 @@ namespace Chilli
 		RenderCommandService->LinkShaderProgram(Program->RawProgramHandle);
 	}
 
+	BackBone::AssetHandle<ShaderProgram> Command::GetShaderProgramVariant(const BackBone::AssetHandle<ShaderProgram>& Handle,
+		ShaderPermutationKey Key)
+	{
+		auto RenderCommandService = _Ctxt.ServiceRegistry->GetService<RenderCommand>();
+		auto ShaderProgramStore = _Ctxt.AssetRegistry->GetStore<ShaderProgram>();
+
+		auto Program = ShaderProgramStore->Get(Handle);
+		CH_CORE_ASSERT(Program != nullptr, "Shader Program not Found is null");
+		CH_CORE_ASSERT(!Program->IsVariant, "Variants are specialized from the base program");
+
+		auto Found = Program->Variants.find(Key);
+		if (Found != Program->Variants.end())
+			return Found->second;
+
+		ShaderProgram Variant;
+		Variant.RawProgramHandle = RenderCommandService->GetShaderProgramVariant(Program->RawProgramHandle, Key);
+		Variant.Permutation = Key;
+		Variant.IsVariant = true;
+		Variant.BaseProgram = Handle;
+
+		auto VariantHandle = ShaderProgramStore->Add(Variant);
+		Program->Variants[Key] = VariantHandle;
+		return VariantHandle;
+	}
+
 	void Command::SetParentEntity(BackBone::Entity Child, BackBone::Entity Parent)
 	{
 		CH_CORE_ASSERT(this->GetComponent<TransformComponent>(Child) != nullptr, "Child Needs TransformComponent");
@@ -1302,7 +1428,18 @@ namespace Chilli
 		auto Program = ShaderProgramStore->Get(Handle);
 		CH_CORE_ASSERT(Program != nullptr, "Shader Module not Found is null");
 
+		// A variant only drops its asset, the raw variant stays with the base program
+		if (Program->IsVariant)
+		{
+			if (auto Base = ShaderProgramStore->Get(Program->BaseProgram))
+				Base->Variants.erase(Program->Permutation);
+			ShaderProgramStore->Remove(Handle);
+			return;
+		}
+
 		RenderCommandService->ClearShaderProgram(Program->RawProgramHandle);
+		for (auto& [Key, VariantHandle] : Program->Variants)
+			ShaderProgramStore->Remove(VariantHandle);
 		ShaderProgramStore->Remove(Handle);
 	}
 
@@ -1488,7 +1625,7 @@ namespace Chilli
 	}
 
 	std::pair<BackBone::AssetHandle<Image>, BackBone::AssetHandle<ImageData>> Command::AllocateImage(const char* FilePath,
-		ImageFormat Format, uint32_t Usage, ImageType Type, uint32_t MipLevel, bool YFlip)
+		ImageFormat Format, uint32_t Usage, ImageType Type, uint32_t MipLevel, bool YFlip, bool Streamed)
 	{
 		auto ImageData = this->LoadAsset<Chilli::ImageData>(FilePath);
 
@@ -1505,6 +1642,14 @@ namespace Chilli
 			ImageSpec.MipLevel = MipLevel;
 		ImageSpec.YFlip = YFlip;
 		ImageSpec.State = ResourceState::ShaderRead;
+		ImageSpec.Streamed = Streamed;
+
+		// Chains stored with the data (built on import or read from KTX2) are uploaded as they are, the runtime
+		// blit only fills in when there is no chain or it is shorter than asked for
+		const auto& Mips = ImageData.ValPtr->Mips;
+		if (!Mips.empty() && (IsBlockCompressedFormat(ImageData.ValPtr->Format) || Mips.size() >= ImageSpec.MipLevel))
+			return { this->_AllocatePackedImage(ImageSpec, *ImageData.ValPtr), ImageData };
+
 		auto Image = this->AllocateImage(ImageSpec);
 
 		this->MapImageData(Image, (void*)ImageData.ValPtr->Pixels, ImageData.ValPtr->Resolution.x,
@@ -1513,6 +1658,67 @@ namespace Chilli
 		return { Image, ImageData };
 	}
 
+	BackBone::AssetHandle<Image> Command::_AllocatePackedImage(ImageSpec& Spec, const Chilli::ImageData& Data)
+	{
+		auto RenderService = GetService<Renderer>();
+		auto RenderCommandService = GetService<RenderCommand>();
+		auto ImageStore = GetStore<Image>();
+
+		// Block compressed data can only be used in its own format, uncompressed chains keep the one asked for
+		// so RGBA8 data can still be sampled as sRGB
+		if (IsBlockCompressedFormat(Data.Format))
+			Spec.Format = Data.Format;
+		Spec.MipLevel = std::min(Spec.MipLevel, uint32_t(Data.Mips.size()));
+
+		const void* Pixels = Data.Pixels;
+		const ImageMipRegion* Mips = Data.Mips.data();
+
+		// Devices without BC sampling (lavapipe among them) get every level decoded on the CPU
+		std::vector<uint8_t> Decoded;
+		std::vector<ImageMipRegion> DecodedMips;
+		if (!RenderService->GetActiveRenderDeviceLimit().CanSampleFormat(Spec.Format))
+		{
+			ImageFormat DecodedFormat = GetDecodedFormat(Data.Format);
+			if (DecodedFormat == ImageFormat::NONE)
+			{
+				CH_CORE_ERROR("{} cannot be sampled on this device and has no CPU decoder", Data.FilePath);
+				return BackBone::AssetHandle<Image>();
+			}
+			CH_CORE_WARN("{} is block compressed and not supported by the device, decoding on the CPU", Data.FilePath);
+
+			DecodedMips.resize(Spec.MipLevel);
+			for (size_t Mip = 0; Mip < Spec.MipLevel; Mip++)
+			{
+				auto& Region = DecodedMips[Mip];
+				Region.Width = Data.Mips[Mip].Width;
+				Region.Height = Data.Mips[Mip].Height;
+				Region.Offset = Decoded.size();
+				Region.Size = uint64_t(Region.Width) * Region.Height * 4;
+				Decoded.resize(size_t(Region.Offset + Region.Size));
+
+				if (!DecodeBlockCompressedImage(Data.Format, static_cast<const uint8_t*>(Data.Pixels) + Data.Mips[Mip].Offset,
+					Data.Mips[Mip].Size, Region.Width, Region.Height, Decoded.data() + Region.Offset))
+				{
+					CH_CORE_ERROR("{} level {} is too small for a {}x{} image", Data.FilePath, Mip, Region.Width,
+						Region.Height);
+					return BackBone::AssetHandle<Image>();
+				}
+			}
+
+			Spec.Format = DecodedFormat;
+			Pixels = Decoded.data();
+			Mips = DecodedMips.data();
+		}
+
+		Image NewImage;
+		NewImage.RawImageHandle = RenderCommandService->AllocateImage(Spec);
+		NewImage.Spec = Spec;
+
+		RenderCommandService->MapImageMips(NewImage.RawImageHandle, Pixels, Mips, Spec.MipLevel);
+
+		return ImageStore->Add(NewImage);
+	}
+
 	void Chilli::Command::DestroyImage(const BackBone::AssetHandle<Image>& ImageHandle)
 	{
 		auto ImageStore = GetStore<Image>();
@@ -2030,6 +2236,7 @@ namespace Chilli
 
 		JPH::RegisterTypes();
 		JoltData->TempAllocator = std::make_unique<JPH::TempAllocatorImpl>(Config->UpFrontMemoryAllocated);
+		CH_MEMORY_TRACK_ALLOC(MemoryTag::PHYSICS, Config->UpFrontMemoryAllocated);
 		JoltData->JobSystem = std::make_unique<JPH::JobSystemThreadPool>(Config->MaxPhysicsJobs, Config->MaxPhysicsBarriers,
 			Config->NumThreads);
 
@@ -2376,13 +2583,77 @@ namespace Chilli
 		delete JPH::Factory::sInstance;
 		JPH::Factory::sInstance = nullptr;
 
+		CH_MEMORY_TRACK_FREE(MemoryTag::PHYSICS, Command.GetResource<JoltPhysicsExtensionConfig>()->UpFrontMemoryAllocated);
 		delete Resource->Data;
 	}
 
+	uint32_t ColliderCallbackRegistry::Register(const ColliderCallback& Callback)
+	{
+		uint32_t Slot = _Callbacks.Create(Callback);
+		CH_CORE_ASSERT(Slot < CH_COLLIDER_CALLBACK_SLOT_MASK, "Too many collider callbacks registered");
+		if (Slot >= _Generations.size())
+			_Generations.resize(Slot + 1, 0);
+
+		return (_Generations[Slot] << CH_COLLIDER_CALLBACK_SLOT_BITS) | Slot;
+	}
+
+	void ColliderCallbackRegistry::Unregister(uint32_t ID)
+	{
+		if (!IsValid(ID))
+			return;
+
+		const uint32_t Slot = _Slot(ID);
+		_Callbacks.Destroy(Slot);
+		_Generations[Slot] = (_Generations[Slot] + 1) & (UINT32_MAX >> CH_COLLIDER_CALLBACK_SLOT_BITS);
+	}
+
+	void ColliderCallbackRegistry::Flush(BackBone::SystemContext& Ctxt)
+	{
+		// A nested flush would swap out _Flushing and _Batch under the running one
+		if (_Pending.empty() || _InFlush)
+			return;
+
+		_InFlush = true;
+
+		// Callbacks may queue more contacts, those land in _Pending for the next flush
+		_Flushing.swap(_Pending);
+
+		// Stable so contacts keep their event order inside a batch
+		std::stable_sort(_Flushing.begin(), _Flushing.end(), [](const PendingContact& A, const PendingContact& B) {
+			return A.CallbackID < B.CallbackID;
+			});
+
+		size_t Start = 0;
+		while (Start < _Flushing.size())
+		{
+			uint32_t ID = _Flushing[Start].CallbackID;
+
+			_Batch.clear();
+			size_t End = Start;
+			while (End < _Flushing.size() && _Flushing[End].CallbackID == ID)
+				_Batch.push_back(_Flushing[End++].Contact);
+
+			// Checked again, an earlier callback may have unregistered this one. Called through a copy since
+			// the callback may register or unregister and move the registry storage under itself
+			auto Found = Get(ID);
+			if (Found && *Found)
+			{
+				ColliderCallback Callback = *Found;
+				Callback(_Batch.data(), uint32_t(_Batch.size()), Ctxt);
+			}
+
+			Start = End;
+		}
+
+		_Flushing.clear();
+		_InFlush = false;
+	}
+
 	void OnJoltHandleEvents(BackBone::SystemContext& Ctxt)
 	{
 		auto Command = Chilli::Command(Ctxt);
 		auto EventService = Command.GetService<EventHandler>();
+		auto Callbacks = Command.GetResource<ColliderCallbackRegistry>();
 
 		for (auto& Event : *EventService->GetEventStorage<CollisionEnterEvent>())
 		{
@@ -2391,42 +2662,46 @@ namespace Chilli
 
 			// A gets told it hit B
 			if (ColliderA)
-				ColliderA->OnEnter(Event.GetEntity2(), Ctxt);
+				Callbacks->Queue(ColliderA->OnEnter, Event.GetEntity1(), Event.GetEntity2());
 
 			// B gets told it hit A
 			if (ColliderB)
-				ColliderB->OnEnter(Event.GetEntity1(), Ctxt);
+				Callbacks->Queue(ColliderB->OnEnter, Event.GetEntity2(), Event.GetEntity1());
 		}
+		Callbacks->Flush(Ctxt);
 
 		for (auto& Event : *EventService->GetEventStorage<CollisionStayEvent>())
 		{
 			auto* ColliderA = Command.GetComponent<Collider>(Event.GetEntity1());
 			auto* ColliderB = Command.GetComponent<Collider>(Event.GetEntity2());
 
-			if (ColliderA && ColliderA->OnStay)
-				ColliderA->OnStay(Event.GetEntity2(), Ctxt);
+			if (ColliderA)
+				Callbacks->Queue(ColliderA->OnStay, Event.GetEntity1(), Event.GetEntity2());
 
-			if (ColliderB && ColliderB->OnStay)
-				ColliderB->OnStay(Event.GetEntity1(), Ctxt);
+			if (ColliderB)
+				Callbacks->Queue(ColliderB->OnStay, Event.GetEntity2(), Event.GetEntity1());
 		}
+		Callbacks->Flush(Ctxt);
 
 		for (auto& Event : *EventService->GetEventStorage<CollisionExitEvent>())
 		{
 			auto* ColliderA = Command.GetComponent<Collider>(Event.GetEntity1());
 			auto* ColliderB = Command.GetComponent<Collider>(Event.GetEntity2());
 
-			if (ColliderA && ColliderA->OnExit)
-				ColliderA->OnExit(Event.GetEntity2(), Ctxt);
+			if (ColliderA)
+				Callbacks->Queue(ColliderA->OnExit, Event.GetEntity1(), Event.GetEntity2());
 
-			if (ColliderB && ColliderB->OnExit)
-				ColliderB->OnExit(Event.GetEntity1(), Ctxt);
+			if (ColliderB)
+				Callbacks->Queue(ColliderB->OnExit, Event.GetEntity2(), Event.GetEntity1());
 		}
+		Callbacks->Flush(Ctxt);
 	}
 
 	void JoltPhysicsExtension::Build(BackBone::App& App)
 	{
 		App.Registry.AddResource<JoltPhysicsExtensionConfig>();
 		App.Registry.AddResource<JoltPhysicsResource>();
+		App.Registry.AddResource<ColliderCallbackRegistry>();
 		App.Registry.Register<Collider>();
 		App.Registry.Register<RigidBody>();
 		auto Command = Chilli::Command(App.Ctxt);
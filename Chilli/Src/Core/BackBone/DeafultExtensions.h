@@ -15,6 +15,7 @@
 #include <FastNoise/FastNoise.h>
 
 #include "BasicComponents.h"
+#include "SpatialIndex.h"
 #include "RenderExtension.h"
 #include "UIExtensions.h"
 
@@ -525,6 +526,11 @@ namespace Chilli
 		BackBone::Entity Entity1, Entity2;
 	};
 
+#define CH_COLLIDER_NO_CALLBACK UINT32_MAX
+// Callback ids keep the registry slot in the low bits and its generation in the rest
+#define CH_COLLIDER_CALLBACK_SLOT_BITS 20
+#define CH_COLLIDER_CALLBACK_SLOT_MASK ((1u << CH_COLLIDER_CALLBACK_SLOT_BITS) - 1)
+
 	struct Collider
 	{
 		ColliderType Type;
@@ -574,78 +580,88 @@ namespace Chilli
 			} TaperedCapsule;
 			// Explicit default constructor to initialize the union
 			ShapeUnion() : AABB{ {0,0,0} } {}
-
-			~ShapeUnion() {}
 		} Shape;
 
+		// Ids into the ColliderCallbackRegistry, CH_COLLIDER_NO_CALLBACK means nothing is called
 		// Collision STARTS - called once
-		std::function<void(BackBone::Entity, BackBone::SystemContext&)> OnEnter = [](BackBone::Entity, BackBone::SystemContext&) {};
+		uint32_t OnEnter = CH_COLLIDER_NO_CALLBACK;
 
 		// Collision CONTINUES - called every frame (usually unused)
-		std::function<void(BackBone::Entity, BackBone::SystemContext&)> OnStay = [](BackBone::Entity, BackBone::SystemContext&) {};;
+		uint32_t OnStay = CH_COLLIDER_NO_CALLBACK;
 
 		// Collision ENDS - called once
-		std::function<void(BackBone::Entity, BackBone::SystemContext&)> OnExit = [](BackBone::Entity, BackBone::SystemContext&) {};;
+		uint32_t OnExit = CH_COLLIDER_NO_CALLBACK;
 
-		// Helper method to handle Union Copying
-		void CopyShapeFrom(const Collider& other)
-		{
-			Type = other.Type;
-			switch (other.Type)
-			{
-			case ColliderType::BOX:              Shape.AABB = other.Shape.AABB; break;
-			case ColliderType::SPHERE:           Shape.Sphere = other.Shape.Sphere; break;
-			case ColliderType::CAPSULE:          Shape.Capsule = other.Shape.Capsule; break;
-			case ColliderType::CYLINDER:         Shape.Cylinder = other.Shape.Cylinder; break;
-			case ColliderType::TORUS:            Shape.Torus = other.Shape.Torus; break;
-			case ColliderType::CONE:             Shape.Cone = other.Shape.Cone; break;
-			case ColliderType::TAPERED_CYLINDER: Shape.TaperedCylinder = other.Shape.TaperedCylinder; break;
-			case ColliderType::TAPERED_CAPSULE:  Shape.TaperedCapsule = other.Shape.TaperedCapsule; break;
-			}
-		}
-		// Default constructor
 		Collider() : Type(ColliderType::BOX), IsTrigger(false), Shape() {}
-		~Collider() {}
+	};
+
+	// Collider is stored and swap-removed a lot, keep it plain data
+	static_assert(std::is_trivially_copyable_v<Collider>, "Collider must stay trivially copyable");
 
-		// Copy constructor
-		Collider(const Collider& other) : IsTrigger(other.IsTrigger), OnEnter(other.OnEnter), OnStay(other.OnStay), OnExit(other.OnExit)
+	struct ColliderContact
+	{
+		BackBone::Entity Self;
+		BackBone::Entity Other;
+	};
+
+	// Called once per frame per callback id with every contact that uses it
+	using ColliderCallback = std::function<void(const ColliderContact* Contacts, uint32_t Count, BackBone::SystemContext& Ctxt)>;
+	using ColliderContactCallback = std::function<void(BackBone::Entity Self, BackBone::Entity Other, BackBone::SystemContext& Ctxt)>;
+
+	class ColliderCallbackRegistry
+	{
+	public:
+		uint32_t Register(const ColliderCallback& Callback);
+
+		// Wraps a per contact callback so it can still be dispatched in a batch
+		uint32_t RegisterPerContact(const ColliderContactCallback& Callback)
 		{
-			CopyShapeFrom(other);
+			return Register([Callback](const ColliderContact* Contacts, uint32_t Count, BackBone::SystemContext& Ctxt) {
+				for (uint32_t i = 0; i < Count; i++)
+					Callback(Contacts[i].Self, Contacts[i].Other, Ctxt);
+				});
 		}
 
-		// Move constructor
-		Collider(Collider&& other) noexcept : IsTrigger(other.IsTrigger), OnEnter(std::move(other.OnEnter)), OnStay(std::move(other.OnStay)), OnExit(std::move(other.OnExit))
+		// The slot's generation moves on, colliders still holding the id call nothing even once the slot is reused
+		void Unregister(uint32_t ID);
+
+		// nullptr for an id that was unregistered
+		const ColliderCallback* Get(uint32_t ID) const { return IsValid(ID) ? _Callbacks.Get(_Slot(ID)) : nullptr; }
+		bool IsValid(uint32_t ID) const
 		{
-			CopyShapeFrom(other);
+			return ID != CH_COLLIDER_NO_CALLBACK && _Slot(ID) < _Generations.size() &&
+				_Generations[_Slot(ID)] == _Generation(ID) && _Callbacks.HasVal(_Slot(ID));
 		}
+		uint32_t GetActiveCount() const { return _Callbacks.GetActiveCount(); }
 
-		// Copy assignment operator
-		Collider& operator=(const Collider& other)
+		inline void Queue(uint32_t ID, BackBone::Entity Self, BackBone::Entity Other)
 		{
-			if (this != &other)
-			{
-				IsTrigger = other.IsTrigger;
-				OnEnter = other.OnEnter;
-				OnStay = other.OnStay;
-				OnExit = other.OnExit;
-				CopyShapeFrom(other);
-			}
-			return *this;
+			if (IsValid(ID))
+				_Pending.push_back({ ID, { Self, Other } });
 		}
 
-		// Move assignment operator
-		Collider& operator=(Collider&& other) noexcept
+		// Groups the queued contacts by callback id and calls each callback once. Callbacks may register,
+		// unregister and queue, contacts they queue wait for the next flush. Flushing from inside a
+		// callback does nothing
+		void Flush(BackBone::SystemContext& Ctxt);
+
+	private:
+		static uint32_t _Slot(uint32_t ID) { return ID & CH_COLLIDER_CALLBACK_SLOT_MASK; }
+		static uint32_t _Generation(uint32_t ID) { return ID >> CH_COLLIDER_CALLBACK_SLOT_BITS; }
+
+		struct PendingContact
 		{
-			if (this != &other)
-			{
-				IsTrigger = other.IsTrigger;
-				OnEnter = std::move(other.OnEnter);
-				OnStay = std::move(other.OnStay);
-				OnExit = std::move(other.OnExit);
-				CopyShapeFrom(other);
-			}
-			return *this;
-		}
+			uint32_t CallbackID;
+			ColliderContact Contact;
+		};
+
+		SparseSet<ColliderCallback> _Callbacks;
+		// By slot, bumped on every unregister
+		std::vector<uint32_t> _Generations;
+		std::vector<PendingContact> _Pending;
+		std::vector<PendingContact> _Flushing;
+		std::vector<ColliderContact> _Batch;
+		bool _InFlush = false;
 	};
 
 	struct JoltPhysicsExtensionConfig
@@ -779,12 +795,27 @@ namespace Chilli
 
 #pragma endregion JoltPhysics
 
+	struct MemoryTrackingConfig
+	{
+		// Seconds between memory reports in the log, 0 disables the periodic dump
+		float DumpInterval = 30.0f;
+		// Per tag budget in bytes, 0 means unbounded
+		std::array<size_t, size_t(MemoryTag::COUNT)> Budgets{};
+	};
+
+	struct MemoryTrackingResource
+	{
+		float DumpInterval = 0.0f;
+		Timer DumpTimer;
+	};
+
 	struct DeafultExtensionConfig
 	{
 		RenderExtensionConfig RenderConfig{};
 		WindowExtensionConfig WindowConfig{};
 		PepperExtensionConfig PepperConfig{};
 		JoltPhysicsExtensionConfig SimPhysicsConfig;
+		MemoryTrackingConfig MemoryConfig{};
 
 		struct {
 			bool EnableFastNoise2Provider = true;
@@ -837,6 +868,7 @@ namespace Chilli
 			const Chilli::RawMeshData& Raw,
 			const Chilli::VertexInputShaderLayout& Desired);
 
+		// Static meshes (MeshArena::CanHold) get ranges in a shared arena page, the rest own their buffers
 		BackBone::AssetHandle<Mesh> CreateMesh(const MeshCreateInfo& Info);
 		BackBone::AssetHandle<Mesh> CreateMesh(BasicShapes Shape);
 		BackBone::AssetHandle<Mesh> CreateMesh(BackBone::AssetHandle<RawMeshData> Data, const VertexInputShaderLayout& DesiredLayout);
@@ -998,9 +1030,10 @@ namespace Chilli
 		void DestroySampler(const BackBone::AssetHandle<Sampler>& sampler);
 
 		BackBone::AssetHandle<Image> AllocateImage(ImageSpec& Spec);
-		// -1 means the function will estimate the miplevel
+		// -1 means the function will estimate the miplevel, Streamed only uploads the low mips at first (see ImageSpec).
+		// Stored mip chains are uploaded in one copy, block compressed files (KTX2) keep their own format
 		std::pair<BackBone::AssetHandle<Image>, BackBone::AssetHandle<ImageData>> AllocateImage(const char* FilePath, ImageFormat Format, uint32_t Usage,
-			ImageType Type, uint32_t MipLevel = -1, bool YFlip = false);
+			ImageType Type, uint32_t MipLevel = -1, bool YFlip = false, bool Streamed = false);
 		void DestroyImage(const BackBone::AssetHandle<Image>& ImageHandle);
 		void MapImageData(const BackBone::AssetHandle<Image>& ImageHandle, void* Data, int Width, int Height);
 
@@ -1018,6 +1051,10 @@ namespace Chilli
 		void AttachShaderModule(const BackBone::AssetHandle<ShaderProgram>& Program,
 			const BackBone::AssetHandle<ShaderModule>& Module);
 		void LinkShaderProgram(const BackBone::AssetHandle<ShaderProgram>& Handle);
+		// A linked program specialized for the feature bits of Key, the backend compiles a key once. The
+		// returned handle is the same for every call with the key and is destroyed with the program it came from
+		BackBone::AssetHandle<ShaderProgram> GetShaderProgramVariant(const BackBone::AssetHandle<ShaderProgram>& Handle,
+			ShaderPermutationKey Key);
 		void DestroyShaderProgram(const BackBone::AssetHandle<ShaderProgram>& Handle);
 
 		BackBone::AssetHandle<Buffer> CreateBuffer(const BufferCreateInfo& Info, const char* DebugName = "");
@@ -1177,6 +1214,8 @@ namespace Chilli
 		Window* GetActiveWindow();
 	private:
 		void _Setup(const BackBone::SystemContext& Ctxt);
+		// Image with every level taken from the data's mip chain, decoded first when the device cannot sample it
+		BackBone::AssetHandle<Image> _AllocatePackedImage(ImageSpec& Spec, const Chilli::ImageData& Data);
 	private:
 		BackBone::SystemContext _Ctxt;
 	};
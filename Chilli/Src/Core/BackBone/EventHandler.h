@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Events/Events.h"
+#include "Profiling/MemoryTracker.h"
 #include <cstdint>
 
 namespace Chilli
@@ -18,7 +19,9 @@ namespace Chilli
 	struct PerEventStorage : __IPerEventStorage__
 	{
 	private:
-		std::vector< _EventType> Events;
+		using EventList = TrackedVector<_EventType, MemoryTag::EVENTS>;
+
+		EventList Events;
 		uint32_t ActiveSize = 0;
 
 	public:
@@ -34,11 +37,11 @@ namespace Chilli
 		_EventType* Data() { return Events.data(); }
 		const _EventType* Data() const { return Events.data(); }
 
-		std::vector< _EventType>::iterator begin() { return Events.begin(); }
-		std::vector< _EventType>::iterator end() { return Events.end(); }
+		EventList::iterator begin() { return Events.begin(); }
+		EventList::iterator end() { return Events.end(); }
 
-		std::vector< _EventType>::const_iterator begin()  const { return Events.begin(); }
-		std::vector< _EventType>::const_iterator end() const { return Events.end(); }
+		EventList::const_iterator begin()  const { return Events.begin(); }
+		EventList::const_iterator end() const { return Events.end(); }
 	};
 
 	uint32_t GetNewEventID();
@@ -1,6 +1,8 @@
 ﻿#include "Ch_PCH.h"
 #include "DeafultExtensions.h"
 #include "Profiling\Timer.h"
+#include "DrawList.h"
+#include "Culling.h"
 
 namespace Chilli
 {
@@ -204,6 +206,7 @@ namespace Chilli
 		Ctxt.ServiceRegistry->RegisterService<AssetLoader>(std::make_shared<AssetLoader>(Ctxt));
 
 		Command.AddLoader<Chilli::ImageLoader>();
+		Command.AddLoader<Chilli::Ktx2ImageLoader>();
 		Command.RegisterStore<Chilli::RawMeshData>();
 		Command.RegisterStore<Chilli::MeshLoaderData>();
 		Command.AddLoader<Chilli::CGLFTMeshLoader>();
@@ -214,6 +217,7 @@ namespace Chilli
 
 		Ctxt.ServiceRegistry->RegisterService<RenderCommand>(RenderService->CreateRenderCommand());
 		Ctxt.ServiceRegistry->RegisterService<MaterialSystem>(std::make_shared<MaterialSystem>(Ctxt));
+		Ctxt.ServiceRegistry->RegisterService<MeshArena>(std::make_shared<MeshArena>(Ctxt));
 
 		CH_CORE_TRACE("Graphcis Backend Using: {}", RenderService->GetName());
 		auto RenderCommandService = Ctxt.ServiceRegistry->GetService<RenderCommand>();
@@ -279,8 +283,14 @@ namespace Chilli
 		auto MeshStore = Command.GetStore<Mesh>();
 		for (auto& MeshInfo : *MeshStore)
 		{
-			Command.DestroyBuffer(MeshInfo->VertexBufferHandles[0]);
-			if (MeshInfo->IBHandle.ValPtr != nullptr)
+			// Arena pages are plain buffers, the buffer store below frees them. Destroyed meshes have
+			// their handles reset
+			if (MeshInfo->ArenaPage != UINT32_MAX)
+				continue;
+
+			if (MeshInfo->VertexBufferHandles[0].IsValid())
+				Command.DestroyBuffer(MeshInfo->VertexBufferHandles[0]);
+			if (MeshInfo->IBHandle.IsValid())
 				Command.DestroyBuffer(MeshInfo->IBHandle);
 		}
 
@@ -345,6 +355,7 @@ namespace Chilli
 				Pass->OnResize(Ctxt, ViewPort.x, ViewPort.y);
 				RenderService->PushFrameBufferResize(ViewPort);
 			}
+			RenderGraph->AliasTransientImages(Ctxt);
 		}
 	}
 
@@ -452,6 +463,8 @@ namespace Chilli
 			ColorMSAATargetImageSpec.State = ResourceState::RenderTarget;
 			ColorMSAATargetImageSpec.Type = ImageType::IMAGE_TYPE_2D;
 			ColorMSAATargetImageSpec.Usage = IMAGE_USAGE_COLOR_ATTACHMENT | IMAGE_USAGE_TRANSIENT_ATTACHMENT;
+			// Resolved and dropped within the pass, later passes can have the memory
+			ColorMSAATargetImageSpec.Aliasable = true;
 			_ColorMSAAImage = Command.AllocateImage(ColorMSAATargetImageSpec);
 
 			TextureSpec ColorMSAATargetTextureSpec;
@@ -556,6 +569,37 @@ namespace Chilli
 				)
 				.Build();
 
+			// Every command starts at its first draw's instance, without the feature the CPU commands are
+			// issued as direct draws, which take any FirstInstance
+			auto RenderService = Command.GetService<Renderer>();
+			const auto& Limits = RenderService->GetActiveRenderDeviceLimit();
+			_IndirectFirstInstance = Limits.bSupportsDrawIndirectFirstInstance;
+			// GPU culling compacts each batch into its own slice of the indirect buffer and needs the draw
+			// count sourced from a buffer, its commands go out indirectly so they need FirstInstance too.
+			// Without either the pass keeps culling on the CPU
+			_GpuCulling = Limits.bSupportsDrawIndirectCount && _IndirectFirstInstance;
+			_ValidateGpuCulling = _GpuCulling && Command.GetResource<RenderExtensionConfig>()->DefferedConfig.ValidateGpuCulling;
+			_ExpectedDrawCounts.assign(RenderService->GetMaxFramesInFlight(), {});
+			if (_GpuCulling)
+			{
+				auto CullComputeShader = Command.CreateShaderModule("Assets/Shaders/cull_comp.spv",
+					ShaderStageType::SHADER_STAGE_COMPUTE);
+
+				_CullShader = Command.CreateShaderProgram();
+				Command.AttachShaderModule(_CullShader, CullComputeShader);
+				Command.LinkShaderProgram(_CullShader);
+
+				auto MaterialSystem = Command.GetService<Chilli::MaterialSystem>();
+				_CullMaterial = MaterialSystem->CreateMaterial(_CullShader);
+				_RawCullMaterial = MaterialSystem->GetRawMaterialHandle(_CullMaterial);
+				_CullInputSlot = RenderService->FindMaterialBindingSlot(_RawCullMaterial, "CullInputSSBO");
+				_CullCommandSlot = RenderService->FindMaterialBindingSlot(_RawCullMaterial, "CullCommandSSBO");
+				_CullCountSlot = RenderService->FindMaterialBindingSlot(_RawCullMaterial, "CullCountSSBO");
+			}
+
+			_DrawCapacity = CH_OBJECT_SHADER_DATA_INITIAL_AMOUNT;
+			_CreateDrawBuffers(Command, RenderService);
+
 			//ChangeResolution(Ctxt, 400, 300);
 			return Desc;
 		}
@@ -585,6 +629,8 @@ namespace Chilli
 			ColorMSAATargetImageSpec.State = ResourceState::RenderTarget;
 			ColorMSAATargetImageSpec.Type = ImageType::IMAGE_TYPE_2D;
 			ColorMSAATargetImageSpec.Usage = IMAGE_USAGE_COLOR_ATTACHMENT | IMAGE_USAGE_TRANSIENT_ATTACHMENT;
+			// Resolved and dropped within the pass, later passes can have the memory
+			ColorMSAATargetImageSpec.Aliasable = true;
 			_ColorMSAAImage.ValPtr->RawImageHandle = RenderCommandService->AllocateImage(ColorMSAATargetImageSpec);
 			_ColorMSAAImage.ValPtr->Spec = ColorMSAATargetImageSpec;
 
@@ -705,9 +751,64 @@ namespace Chilli
 
 			RenderService->SetFullPipelineState(_PipelineState);
 			RenderService->SetVertexInputLayout(_MeshLayout);
-			//#define DO 1
+
+			// The cull material's buffer bindings only go live once the frame they were recorded in is
+			// translated, until then the frame is culled on the CPU
+			bool GpuCulling = _GpuCulling && !_CullBindingsPending;
+			_CullBindingsPending = false;
+
+			glm::mat4 ViewProjMat{ 1.0f };
+			float FarClip = 1.0f;
+			bool HasCamera = false;
+			// Pixels covered by one world unit at a view depth of one, sizes textures for streaming
+			float FocalPixels = 0.0f;
+			if (auto Camera = Command.GetComponent<CameraComponent>(RenderResource->ActiveSceneID.ValPtr->MainCamera))
+			{
+				ViewProjMat = Camera->ViewProjMat;
+				FarClip = Camera->Far_Clip;
+				HasCamera = true;
+				if (!Camera->Is_Orthro)
+					FocalPixels = float(Command.GetActiveWindow()->GetHeight()) / (2.0f * std::tan(glm::radians(Camera->Fov) * 0.5f));
+			}
+
+			_DrawList.Clear();
+			_DrawDatas.clear();
+			_CullCandidates.clear();
+			_Culler.Clear();
+
+			// 1. Gather world bounds of everything drawable and cull them against the camera before
+			// any shader data is touched or a command is recorded. With GPU culling every candidate is
+			// kept here and the compute pass rejects them against the object SSBO instead
 			for (auto [Entity, Transform, MeshComp] : BackBone::QueryWithEntities<TransformComponent, MeshComponent>(*Ctxt.Registry))
 			{
+				if (!GpuCulling || _ValidateGpuCulling)
+					_Culler.Push(MeshComp->MeshHandle.ValPtr->Bounds, Transform->GetWorldMatrix());
+				_CullCandidates.push_back({ Entity, Transform, MeshComp });
+			}
+
+			// Without a camera there is no frustum to test against, draw everything
+			if (HasCamera && !GpuCulling)
+				_Culler.Cull(Frustum::FromViewProj(ViewProjMat), _CullVisibility);
+			else
+				_CullVisibility.assign(_CullCandidates.size(), 1);
+
+			// What the compute pass is expected to keep, checked once the frame's counts can be read back
+			if (GpuCulling && _ValidateGpuCulling)
+			{
+				if (HasCamera)
+					_Culler.Cull(Frustum::FromViewProj(ViewProjMat), _ExpectedVisibility);
+				else
+					_ExpectedVisibility.assign(_CullCandidates.size(), 1);
+			}
+
+			// 2. Collect the survivors: resolve state, push pending material data updates and build the sort key
+			for (size_t CandidateIndex = 0; CandidateIndex < _CullCandidates.size(); CandidateIndex++)
+			{
+				if (!_CullVisibility[CandidateIndex])
+					continue;
+
+				auto [Entity, Transform, MeshComp] = _CullCandidates[CandidateIndex];
+
 				uint32_t RawMaterialHandle = 1;
 				BackBone::AssetHandle<Material> ActiveMaterial = MeshComp->MaterialHandle;
 				BackBone::AssetHandle<ShaderProgram> ActiveShader;
@@ -730,61 +831,151 @@ namespace Chilli
 					RenderService->UpdateMaterialShaderData(MaterialSystem->GetRawMaterialHandle(ActiveMaterial), MaterialData);
 				}
 
-				auto ActiveMesh = MeshComp->MeshHandle.ValPtr;
+				// Front to back within a state group, w is the view depth for perspective cameras
+				const auto& WorldMat = Transform->GetWorldMatrix();
+				glm::vec4 Clip = ViewProjMat * glm::vec4(WorldMat[3][0], WorldMat[3][1], WorldMat[3][2], 1.0f);
+				float Depth = Clip.w / FarClip;
 
-				RenderService->BindShaderProgram(ActiveShader.ValPtr->RawProgramHandle);
-				RenderService->BindMaterailData(RawMaterialHandle);
-
-				uint32_t Buffers[16] = { 0 };
-				uint32_t BindingCount = 0;
-
-				for (int i = 0; i < ActiveMesh->ActiveVBHandlesCount; i++)
+				// Projected diameter of the bounds, the backend keeps as many mips of a streamed albedo resident
+				const auto& Bounds = MeshComp->MeshHandle.ValPtr->Bounds;
+				auto AlbedoTexture = MaterialSystem->GetAlbedoTexture(ActiveMaterial);
+				if (FocalPixels > 0.0f && Bounds.IsValid && AlbedoTexture.IsValid())
 				{
-					Buffers[i] = ActiveMesh->VertexBufferHandles[i].ValPtr->RawBufferHandle;
-					BindingCount++;
+					float MaxScale = std::max(glm::length(glm::vec3(WorldMat[0])),
+						std::max(glm::length(glm::vec3(WorldMat[1])), glm::length(glm::vec3(WorldMat[2]))));
+					float ScreenSize = 2.0f * Bounds.Radius * MaxScale * FocalPixels / std::max(Clip.w, 0.001f);
+					RenderService->SetTextureScreenSize(AlbedoTexture.ValPtr->RawTextureHandle, ScreenSize);
 				}
 
-				RenderService->BindVertexBuffer(Buffers, BindingCount);
-				RenderService->BindIndexBuffer(ActiveMesh->IBHandle.ValPtr->RawBufferHandle, ActiveMesh->IBType);
+				GeometryDrawData DrawData;
+				DrawData.Transform = Transform;
+				DrawData.RawShaderProgram = ActiveShader.ValPtr->RawProgramHandle;
+				DrawData.RawMaterialHandle = RawMaterialHandle;
+				DrawData.DrawMesh = MeshComp->MeshHandle.ValPtr;
+
+				_DrawList.Push(DrawSortKey::Make(0, DrawData.RawShaderProgram, RawMaterialHandle, MeshComp->MeshHandle.Handle, Depth),
+					uint32_t(_DrawDatas.size()));
+				_DrawDatas.push_back(DrawData);
+			}
+
+			// 3. Sort so draws sharing shader/material/mesh end up next to each other
+			_DrawList.Sort();
+
+			const uint32_t DrawCount = uint32_t(_DrawList.Size());
+			if (DrawCount == 0)
+				return;
+
+			if (DrawCount > _DrawCapacity)
+			{
+				_GrowDrawBuffers(Command, RenderService, DrawCount);
+				// The new bindings go live with this frame's translation, the next frame culls on the GPU again
+				_CullBindingsPending = false;
+				GpuCulling = false;
+			}
+
+			// 4. Pack the object data in sorted order, one object per draw, so every run of identical
+			// shader/material/mesh reads a contiguous slice of the object SSBO through gl_InstanceIndex
+			uint32_t FirstObject = 0;
+			ObjectShaderData* Objects = RenderService->AllocateObjectShaderData(DrawCount, FirstObject);
+
+			_InstanceIndices.resize(DrawCount);
+			for (uint32_t i = 0; i < DrawCount; i++)
+			{
+				Objects[i].TransformationMat = _DrawDatas[_DrawList[i].Index].Transform->GetWorldMatrix();
+				_InstanceIndices[i] = FirstObject + i;
+			}
+
+			const uint32_t FrameIndex = RenderService->GetRecordingFrameIndex();
+			const uint32_t FrameOffset = FrameIndex * _DrawCapacity * sizeof(DrawIndexedIndirectCommand);
+
+			if (GpuCulling)
+			{
+				if (!_RecordGpuCulling(RenderService, RenderCommandService, ViewProjMat, HasCamera, FrameIndex))
+					return;
+			}
+			else
+			{
+				if (_GpuCulling)
+					CH_CORE_INFO("GeometryPass: cull buffers were (re)created this frame, culling it on the CPU");
+
+				if (!_BuildCpuIndirectCommands(RenderService, RenderCommandService, FrameOffset))
+					return;
+			}
 
-				auto OldTransform = RenderResource->LastTransformVersion.Get(Entity);
+			// 6. Emit, only binding state that actually changed from the previous batch
+			uint32_t SceneIndex = SceneManager->GetSceneShaderIndex(RenderResource->ActiveSceneID);
+			uint32_t LastShader = UINT32_MAX;
+			uint32_t LastMaterial = UINT32_MAX;
+			uint32_t MatIndex = 0;
+			Mesh* LastMesh = nullptr;
 
-				if (OldTransform == nullptr)
+			for (uint32_t BatchIndex = 0; BatchIndex < _IndirectBatches.size(); BatchIndex++)
+			{
+				auto& Batch = _IndirectBatches[BatchIndex];
+				auto& DrawData = _DrawDatas[Batch.DrawDataIndex];
+				auto ActiveMesh = DrawData.DrawMesh;
+
+				if (DrawData.RawShaderProgram != LastShader)
 				{
-					RenderResource::LastTransformStruct LastTransform;
-					LastTransform.GenerationVal = Command.GetEntityGeneration(Entity);
-					RenderResource->LastTransformVersion.Insert(Entity, LastTransform);
-					OldTransform = RenderResource->LastTransformVersion.Get(Entity);
+					RenderService->BindShaderProgram(DrawData.RawShaderProgram);
+					LastShader = DrawData.RawShaderProgram;
+					// Material sets are bound against the shader's layout, rebind after a shader change
+					LastMaterial = UINT32_MAX;
 				}
 
-				if (OldTransform->GenerationVal != Command.GetEntityGeneration(Entity))
+				if (DrawData.RawMaterialHandle != LastMaterial)
 				{
-					OldTransform->Version = UINT32_MAX;
-					OldTransform->GenerationVal = Command.GetEntityGeneration(Entity);
+					RenderService->BindMaterailData(DrawData.RawMaterialHandle);
+					MatIndex = RenderService->GetMaterialShaderIndex(DrawData.RawMaterialHandle);
+					LastMaterial = DrawData.RawMaterialHandle;
 				}
 
-				if (OldTransform->Version != Transform->GetVersion())
+				if (LastMesh == nullptr || !_SharesGeometryBuffers(ActiveMesh, LastMesh))
 				{
-					ObjectShaderData Data;
-					Data.TransformationMat = Transform->GetWorldMatrix();
+					uint32_t Buffers[16] = { 0 };
+					uint32_t BindingCount = 0;
 
-					OldTransform->GenerationVal = Command.GetEntityGeneration(Entity);
-					OldTransform->Version = Transform->GetVersion();
+					for (int i = 0; i < ActiveMesh->ActiveVBHandlesCount; i++)
+					{
+						Buffers[i] = ActiveMesh->VertexBufferHandles[i].ValPtr->RawBufferHandle;
+						BindingCount++;
+					}
 
-					RenderService->UpdateObjectShaderData(Entity, Data);
+					RenderService->BindVertexBuffer(Buffers, BindingCount);
+					RenderService->BindIndexBuffer(ActiveMesh->IBHandle.ValPtr->RawBufferHandle, ActiveMesh->IBType);
+					LastMesh = ActiveMesh;
 				}
 
-				auto MatIndex = RenderService->GetMaterialShaderIndex(RawMaterialHandle);
-
 				DrawPushShaderInlineUniformData PushData;
 				PushData.MaterialIndex = MatIndex;
-				PushData.SceneIndex = SceneManager->GetSceneShaderIndex(RenderResource->ActiveSceneID);
-				PushData.ObjectIndex = RenderService->GetObjectShaderIndex(Entity);
+				PushData.SceneIndex = SceneIndex;
 
-				RenderService->PushInlineUniformData(ActiveShader.ValPtr->RawProgramHandle,
+				RenderService->PushInlineUniformData(DrawData.RawShaderProgram,
 					SHADER_STAGE_VERTEX | SHADER_STAGE_FRAGMENT, &PushData, sizeof(PushData), 0);
 
-				RenderService->DrawIndexed(ActiveMesh->IndexCount, 1, 0, 0, 0);
+				if (GpuCulling)
+				{
+					// Up to every draw of the batch survived, the compute pass wrote how many actually did
+					RenderService->DrawIndexedIndirectCount(_IndirectBuffer.ValPtr->RawBufferHandle,
+						FrameOffset + Batch.FirstCommand * sizeof(DrawIndexedIndirectCommand),
+						_DrawCountBuffer.ValPtr->RawBufferHandle,
+						(FrameIndex * _DrawCapacity + BatchIndex) * sizeof(uint32_t),
+						Batch.CommandCount);
+				}
+				else if (_IndirectFirstInstance)
+				{
+					RenderService->DrawIndexedIndirect(_IndirectBuffer.ValPtr->RawBufferHandle,
+						FrameOffset + Batch.FirstCommand * sizeof(DrawIndexedIndirectCommand), Batch.CommandCount);
+				}
+				else
+				{
+					for (uint32_t i = Batch.FirstCommand; i < Batch.FirstCommand + Batch.CommandCount; i++)
+					{
+						const auto& Indirect = _IndirectCommands[i];
+						RenderService->DrawIndexed(Indirect.IndexCount, Indirect.InstanceCount, Indirect.FirstIndex,
+							Indirect.VertexOffset, Indirect.FirstInstance);
+					}
+				}
 			}
 		}
 
@@ -798,10 +989,270 @@ namespace Chilli
 
 		void Teardown(BackBone::SystemContext& Ctxt)
 		{
+			auto Command = Chilli::Command(Ctxt);
+			_DestroyDrawBuffers(Command, _IndirectBuffer, _CullInputBuffer, _DrawCountBuffer);
+		}
+
+	private:
+		// Indirect commands, cull inputs and draw counts all hold one _DrawCapacity region per frame in flight
+		void _CreateDrawBuffers(Chilli::Command& Command, Renderer* RenderService)
+		{
+			const uint32_t RegionCount = _DrawCapacity * RenderService->GetMaxFramesInFlight();
+
+			BufferCreateInfo IndirectBufferInfo{};
+			IndirectBufferInfo.Type = BUFFER_TYPE_INDIRECT | BUFFER_TYPE_STORAGE;
+			IndirectBufferInfo.SizeInBytes = sizeof(DrawIndexedIndirectCommand) * RegionCount;
+			IndirectBufferInfo.State = BufferState::STREAM_DRAW;
+			_IndirectBuffer = Command.CreateBuffer(IndirectBufferInfo, "GeometryIndirect");
+
+			if (!_GpuCulling)
+				return;
+
+			BufferCreateInfo CullInputBufferInfo{};
+			CullInputBufferInfo.Type = BUFFER_TYPE_STORAGE;
+			CullInputBufferInfo.SizeInBytes = sizeof(GpuCullDrawInput) * RegionCount;
+			CullInputBufferInfo.State = BufferState::STREAM_DRAW;
+			_CullInputBuffer = Command.CreateBuffer(CullInputBufferInfo, "GeometryCullInput");
+
+			// One count per batch, a frame never has more batches than draws. Validation reads it back
+			BufferCreateInfo DrawCountBufferInfo{};
+			DrawCountBufferInfo.Type = BUFFER_TYPE_INDIRECT | BUFFER_TYPE_STORAGE;
+			DrawCountBufferInfo.SizeInBytes = sizeof(uint32_t) * RegionCount;
+			DrawCountBufferInfo.State = _ValidateGpuCulling ? BufferState::DYNAMIC_READ : BufferState::STREAM_DRAW;
+			_DrawCountBuffer = Command.CreateBuffer(DrawCountBufferInfo, "GeometryDrawCount");
+
+			RenderService->UpdateMaterialBufferData(_RawCullMaterial, _CullInputBuffer.ValPtr->RawBufferHandle,
+				_CullInputSlot, CullInputBufferInfo.SizeInBytes, 0);
+			RenderService->UpdateMaterialBufferData(_RawCullMaterial, _IndirectBuffer.ValPtr->RawBufferHandle,
+				_CullCommandSlot, IndirectBufferInfo.SizeInBytes, 0);
+			RenderService->UpdateMaterialBufferData(_RawCullMaterial, _DrawCountBuffer.ValPtr->RawBufferHandle,
+				_CullCountSlot, DrawCountBufferInfo.SizeInBytes, 0);
+			_CullBindingsPending = true;
+		}
+
+		void _DestroyDrawBuffers(Chilli::Command& Command, const BackBone::AssetHandle<Buffer>& IndirectBuffer,
+			const BackBone::AssetHandle<Buffer>& CullInputBuffer, const BackBone::AssetHandle<Buffer>& DrawCountBuffer)
+		{
+			Command.DestroyBuffer(IndirectBuffer);
+			if (_GpuCulling)
+			{
+				Command.DestroyBuffer(CullInputBuffer);
+				Command.DestroyBuffer(DrawCountBuffer);
+			}
+		}
+
+		// The capacity doubles, so a growing scene only reallocates a handful of times. The new buffers
+		// are created before the old ones go away so the material binding cache never sees a reused handle.
+		// Frames in flight may still read the old ones, the backend holds their memory until those are done
+		void _GrowDrawBuffers(Chilli::Command& Command, Renderer* RenderService, uint32_t DrawCount)
+		{
+			while (_DrawCapacity < DrawCount)
+				_DrawCapacity *= 2;
+
+			auto OldIndirectBuffer = _IndirectBuffer;
+			auto OldCullInputBuffer = _CullInputBuffer;
+			auto OldDrawCountBuffer = _DrawCountBuffer;
 
+			_CreateDrawBuffers(Command, RenderService);
+			_DestroyDrawBuffers(Command, OldIndirectBuffer, OldCullInputBuffer, OldDrawCountBuffer);
+
+			// The counts of frames still in flight went with the old buffer
+			for (auto& Expected : _ExpectedDrawCounts)
+				Expected.clear();
+
+			CH_CORE_INFO("GeometryPass: draw capacity grown to {0} per frame", _DrawCapacity);
+		}
+
+		// 5. Build the indirect commands, commands sharing shader, material and geometry buffers
+		// are batched so the whole bucket goes out as a single indirect draw
+		bool _BuildCpuIndirectCommands(Renderer* RenderService, RenderCommand* RenderCommandService, uint32_t FrameOffset)
+		{
+			RenderService->UpdateInstanceIndexData(_InstanceIndices.data(), uint32_t(_InstanceIndices.size()));
+
+			_IndirectCommands.clear();
+			_IndirectBatches.clear();
+
+			const uint32_t DrawCount = uint32_t(_DrawList.Size());
+			for (uint32_t First = 0; First < DrawCount;)
+			{
+				uint32_t DataIndex = _DrawList[First].Index;
+				auto& DrawData = _DrawDatas[DataIndex];
+
+				uint32_t InstanceCount = 1;
+				while (First + InstanceCount < DrawCount)
+				{
+					auto& Next = _DrawDatas[_DrawList[First + InstanceCount].Index];
+					if (Next.RawShaderProgram != DrawData.RawShaderProgram ||
+						Next.RawMaterialHandle != DrawData.RawMaterialHandle || Next.DrawMesh != DrawData.DrawMesh)
+						break;
+					InstanceCount++;
+				}
+
+				DrawIndexedIndirectCommand IndirectCommand;
+				IndirectCommand.IndexCount = DrawData.DrawMesh->IndexCount;
+				IndirectCommand.InstanceCount = InstanceCount;
+				IndirectCommand.FirstIndex = DrawData.DrawMesh->FirstIndex;
+				IndirectCommand.VertexOffset = DrawData.DrawMesh->VertexOffset;
+				IndirectCommand.FirstInstance = First;
+
+				if (_StartsNewBatch(DataIndex))
+					_IndirectBatches.push_back({ uint32_t(_IndirectCommands.size()), 0, DataIndex });
+
+				_IndirectBatches.back().CommandCount++;
+				_IndirectCommands.push_back(IndirectCommand);
+				First += InstanceCount;
+			}
+
+			if (_IndirectCommands.empty())
+				return false;
+
+			// Drawn directly from _IndirectCommands then
+			if (!_IndirectFirstInstance)
+				return true;
+
+			RenderCommandService->MapBufferData(_IndirectBuffer.ValPtr->RawBufferHandle, _IndirectCommands.data(),
+				uint32_t(_IndirectCommands.size() * sizeof(DrawIndexedIndirectCommand)), FrameOffset);
+			return true;
+		}
+
+		// 5. Same batches as the CPU path but every draw gets its own command slot inside its batch, the
+		// culling compute pass fills the slots of the visible draws from the front and writes the count
+		bool _RecordGpuCulling(Renderer* RenderService, RenderCommand* RenderCommandService, const glm::mat4& ViewProjMat,
+			bool HasCamera, uint32_t FrameIndex)
+		{
+			if (_ValidateGpuCulling)
+				_ValidateGpuCullCounts(RenderCommandService, FrameIndex);
+
+			_IndirectBatches.clear();
+			_GpuCullInputs.clear();
+
+			const uint32_t DrawCount = uint32_t(_DrawList.Size());
+			if (DrawCount == 0)
+				return false;
+
+			for (uint32_t DrawIndex = 0; DrawIndex < DrawCount; DrawIndex++)
+			{
+				uint32_t DataIndex = _DrawList[DrawIndex].Index;
+				auto& DrawData = _DrawDatas[DataIndex];
+
+				if (_StartsNewBatch(DataIndex))
+					_IndirectBatches.push_back({ DrawIndex, 0, DataIndex });
+
+				auto& Batch = _IndirectBatches.back();
+				Batch.CommandCount++;
+
+				_GpuCullInputs.push_back(GpuCullDrawInput::Make(DrawData.DrawMesh->Bounds, _InstanceIndices[DrawIndex],
+					uint32_t(_IndirectBatches.size() - 1), Batch.FirstCommand, DrawData.DrawMesh->IndexCount,
+					DrawData.DrawMesh->FirstIndex, DrawData.DrawMesh->VertexOffset));
+			}
+
+			// Every candidate is drawn with GPU culling, so the draw data indices are candidate indices
+			if (_ValidateGpuCulling)
+			{
+				auto& Expected = _ExpectedDrawCounts[FrameIndex];
+				Expected.assign(_IndirectBatches.size(), 0);
+				for (uint32_t BatchIndex = 0; BatchIndex < _IndirectBatches.size(); BatchIndex++)
+				{
+					const auto& Batch = _IndirectBatches[BatchIndex];
+					for (uint32_t DrawIndex = Batch.FirstCommand; DrawIndex < Batch.FirstCommand + Batch.CommandCount; DrawIndex++)
+						Expected[BatchIndex] += _ExpectedVisibility[_DrawList[DrawIndex].Index];
+				}
+			}
+
+			const uint32_t FrameBase = FrameIndex * _DrawCapacity;
+
+			RenderCommandService->MapBufferData(_CullInputBuffer.ValPtr->RawBufferHandle, _GpuCullInputs.data(),
+				uint32_t(_GpuCullInputs.size() * sizeof(GpuCullDrawInput)), FrameBase * sizeof(GpuCullDrawInput));
+
+			// The counts are bumped atomically by the compute pass, start them from zero every frame
+			_ZeroDrawCounts.assign(_IndirectBatches.size(), 0);
+			RenderCommandService->MapBufferData(_DrawCountBuffer.ValPtr->RawBufferHandle, _ZeroDrawCounts.data(),
+				uint32_t(_ZeroDrawCounts.size() * sizeof(uint32_t)), FrameBase * sizeof(uint32_t));
+
+			GpuCullPushData PushData{};
+			if (HasCamera)
+			{
+				Frustum View = Frustum::FromViewProj(ViewProjMat);
+				for (int i = 0; i < Frustum::PLANE_COUNT; i++)
+					PushData.Planes[i] = View.Planes[i];
+			}
+			else
+			{
+				// Planes every point is in front of, nothing gets culled
+				for (auto& Plane : PushData.Planes)
+					Plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+			}
+			PushData.DrawCount = DrawCount;
+			PushData.FrameBase = FrameBase;
+
+			uint32_t RawCullShader = _CullShader.ValPtr->RawProgramHandle;
+
+			RenderService->BindComputeShaderProgram(RawCullShader);
+			RenderService->BindComputeMaterailData(_RawCullMaterial);
+			RenderService->PushComputeInlineUniformData(RawCullShader, &PushData, sizeof(PushData), 0);
+			RenderService->Dispatch((DrawCount + GPU_CULL_GROUP_SIZE - 1) / GPU_CULL_GROUP_SIZE);
+			return true;
+		}
+
+		// The frame slot's fence has been waited on, so the counts written the last time it was culled on the
+		// GPU are final. Draws right on a plane may land either way, so small differences can be precision
+		void _ValidateGpuCullCounts(RenderCommand* RenderCommandService, uint32_t FrameIndex)
+		{
+			auto& Expected = _ExpectedDrawCounts[FrameIndex];
+			if (Expected.empty())
+				return;
+
+			_ReadDrawCounts.resize(Expected.size());
+			RenderCommandService->ReadBufferData(_DrawCountBuffer.ValPtr->RawBufferHandle, _ReadDrawCounts.data(),
+				uint32_t(_ReadDrawCounts.size() * sizeof(uint32_t)), FrameIndex * _DrawCapacity * sizeof(uint32_t));
+
+			uint32_t Mismatches = 0;
+			uint32_t GpuDraws = 0;
+			uint32_t CpuDraws = 0;
+			for (size_t BatchIndex = 0; BatchIndex < Expected.size(); BatchIndex++)
+			{
+				GpuDraws += _ReadDrawCounts[BatchIndex];
+				CpuDraws += Expected[BatchIndex];
+				if (_ReadDrawCounts[BatchIndex] != Expected[BatchIndex])
+					Mismatches++;
+			}
+
+			if (Mismatches > 0)
+				CH_CORE_ERROR("GeometryPass: GPU culling differs from the CPU culler in {0} of {1} batches ({2} draws against {3})",
+					Mismatches, Expected.size(), GpuDraws, CpuDraws);
+			Expected.clear();
+		}
+
+		bool _StartsNewBatch(uint32_t DataIndex) const
+		{
+			if (_IndirectBatches.empty())
+				return true;
+
+			auto& DrawData = _DrawDatas[DataIndex];
+			auto& LastData = _DrawDatas[_IndirectBatches.back().DrawDataIndex];
+			return LastData.RawShaderProgram != DrawData.RawShaderProgram ||
+				LastData.RawMaterialHandle != DrawData.RawMaterialHandle ||
+				!_SharesGeometryBuffers(LastData.DrawMesh, DrawData.DrawMesh);
 		}
 
 	private:
+		// Meshes of one arena page bind the same buffers and only differ in their offsets, so geometry is
+		// shared when the bound buffers are the same
+		static bool _SharesGeometryBuffers(const Mesh* A, const Mesh* B)
+		{
+			if (A == B)
+				return true;
+
+			if (A->IBType != B->IBType || A->ActiveVBHandlesCount != B->ActiveVBHandlesCount ||
+				A->IBHandle.ValPtr->RawBufferHandle != B->IBHandle.ValPtr->RawBufferHandle)
+				return false;
+
+			for (uint32_t i = 0; i < A->ActiveVBHandlesCount; i++)
+				if (A->VertexBufferHandles[i].ValPtr->RawBufferHandle != B->VertexBufferHandles[i].ValPtr->RawBufferHandle)
+					return false;
+			return true;
+		}
+
 		BackBone::AssetHandle<Image> _ColorTargetImage;
 		BackBone::AssetHandle<Texture> _ColorTargetTexture;
 		BackBone::AssetHandle<Image> _DepthImage;
@@ -812,6 +1263,74 @@ namespace Chilli
 		SampleCount _ColorMSAACount = IMAGE_SAMPLE_COUNT_2_BIT;
 		PipelineStateInfo _PipelineState;
 		VertexInputShaderLayout _MeshLayout;
+
+		struct GeometryDrawData
+		{
+			TransformComponent* Transform;
+			uint32_t RawShaderProgram;
+			uint32_t RawMaterialHandle;
+			Mesh* DrawMesh;
+		};
+
+		// Rebuilt every frame, kept around so the storage is reused
+		DrawList _DrawList;
+		std::vector<GeometryDrawData> _DrawDatas;
+		std::vector<uint32_t> _InstanceIndices;
+
+		struct CullCandidate
+		{
+			BackBone::Entity Entity;
+			TransformComponent* Transform;
+			MeshComponent* MeshComp;
+		};
+
+		FrustumCuller _Culler;
+		std::vector<CullCandidate> _CullCandidates;
+		std::vector<uint8_t> _CullVisibility;
+
+		struct IndirectBatch
+		{
+			uint32_t FirstCommand;
+			uint32_t CommandCount;
+			uint32_t DrawDataIndex; // State of the batch is taken from this draw
+		};
+
+		std::vector<DrawIndexedIndirectCommand> _IndirectCommands;
+		std::vector<IndirectBatch> _IndirectBatches;
+		// Draws a single frame can hold before the buffers below grow
+		uint32_t _DrawCapacity = CH_OBJECT_SHADER_DATA_INITIAL_AMOUNT;
+		BackBone::AssetHandle<Buffer> _IndirectBuffer;
+
+		// Used when the device can source draw counts from a buffer, see cull.comp
+		static constexpr uint32_t GPU_CULL_GROUP_SIZE = 64;
+
+		struct GpuCullPushData
+		{
+			glm::vec4 Planes[Frustum::PLANE_COUNT];
+			uint32_t DrawCount;
+			uint32_t FrameBase;
+			uint32_t Padding[2];
+		};
+
+		bool _IndirectFirstInstance = false;
+		bool _GpuCulling = false;
+		bool _CullBindingsPending = false;
+		BackBone::AssetHandle<ShaderProgram> _CullShader;
+		BackBone::AssetHandle<Material> _CullMaterial;
+		uint32_t _RawCullMaterial = UINT32_MAX;
+		MaterialBindingSlot _CullInputSlot;
+		MaterialBindingSlot _CullCommandSlot;
+		MaterialBindingSlot _CullCountSlot;
+		BackBone::AssetHandle<Buffer> _CullInputBuffer;
+		BackBone::AssetHandle<Buffer> _DrawCountBuffer;
+		std::vector<GpuCullDrawInput> _GpuCullInputs;
+		std::vector<uint32_t> _ZeroDrawCounts;
+
+		// Per frame in flight, what the CPU culler kept of each batch the frame culled on the GPU
+		bool _ValidateGpuCulling = false;
+		std::vector<uint8_t> _ExpectedVisibility;
+		std::vector<std::vector<uint32_t>> _ExpectedDrawCounts;
+		std::vector<uint32_t> _ReadDrawCounts;
 		RGKey _ColorTargetTextureKey = "GeometryColor";
 		RGKey _DepthViewTextureKey = "GeometryDepthView";
 	};
@@ -949,7 +1468,8 @@ namespace Chilli
 			RenderService->BindVertexBuffer({ _ScreenMesh.ValPtr->VertexBufferHandles[0].ValPtr->RawBufferHandle });
 			RenderService->BindIndexBuffer(_ScreenMesh.ValPtr->IBHandle.ValPtr->RawBufferHandle,
 				_ScreenMesh.ValPtr->IBType);
-			RenderService->DrawIndexed(_ScreenMesh.ValPtr->IndexCount, 1, 0, 0, 0);
+			RenderService->DrawIndexed(_ScreenMesh.ValPtr->IndexCount, 1, _ScreenMesh.ValPtr->FirstIndex,
+				_ScreenMesh.ValPtr->VertexOffset, 0);
 		}
 
 		void Teardown(BackBone::SystemContext& Ctxt)
@@ -1004,6 +1524,8 @@ namespace Chilli
 			DepthImageSpec.Usage = IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT | IMAGE_USAGE_SAMPLED_IMAGE;
 			DepthImageSpec.State = ResourceState::ShaderRead;
 			DepthImageSpec.Sample = IMAGE_SAMPLE_COUNT_1_BIT;
+			// Cleared and never stored, nothing outside the pass reads it
+			DepthImageSpec.Aliasable = true;
 			this->_DepthImage = Command.AllocateImage(DepthImageSpec);
 
 			TextureSpec DepthTextureSpec;
@@ -1209,6 +1731,32 @@ namespace Chilli
 		std::unordered_map<uint32_t, ResourceState> CurrentBufferResourceStates;
 		CurrentImageResourceStates[SwapChainHandle] = ResourceState::Present;
 
+		// Aliasable images start every frame undefined, whatever used their memory last left nothing usable
+		auto FirstUseState = [](const BackBone::AssetHandle<Texture>& Texture) {
+			const auto& Spec = Texture.ValPtr->ImageHandle.ValPtr->Spec;
+			return Spec.Aliasable ? ResourceState::Undefined : Spec.State;
+			};
+
+		// First and last pass of every aliasable image, keyed by raw image handle
+		_TransientImages.clear();
+		std::unordered_map<uint32_t, size_t> TransientIndices;
+		std::unordered_set<uint32_t> TransientTextures;
+		auto TrackTransientImage = [&](const BackBone::AssetHandle<Texture>& Texture, uint32_t PassIndex) {
+			const auto& ImageHandle = Texture.ValPtr->ImageHandle;
+			if (!ImageHandle.ValPtr->Spec.Aliasable)
+				return;
+
+			TransientTextures.insert(Texture.ValPtr->RawTextureHandle);
+			auto Found = TransientIndices.find(ImageHandle.ValPtr->RawImageHandle);
+			if (Found != TransientIndices.end())
+			{
+				_TransientImages[Found->second].LastPass = PassIndex;
+				return;
+			}
+			TransientIndices[ImageHandle.ValPtr->RawImageHandle] = _TransientImages.size();
+			_TransientImages.push_back({ ImageHandle, PassIndex, PassIndex });
+			};
+
 		_PrePassChanges.resize(_Passes.size());
 		_PostPassChanges.resize(_Passes.size());
 
@@ -1229,12 +1777,14 @@ namespace Chilli
 				// -----------------------------------------------------------
 				uint32_t ColorTargetHandle = ColorAttachment.UseSwapChainImage ? SwapChainHandle : ColorAttachment.ColorTexture;
 				bool IsSwapChain = ColorAttachment.UseSwapChainImage;
+				if (!IsSwapChain)
+					TrackTransientImage(DescResources.ColorAttachments[x].Color, i);
 
 				// Initialize state tracking if key doesn't exist
 				if (CurrentImageResourceStates.find(ColorTargetHandle) == CurrentImageResourceStates.end()) {
 					CurrentImageResourceStates[ColorTargetHandle] = IsSwapChain ?
 						ResourceState::Undefined : // Swapchain usually starts undefined/presented
-						DescResources.ColorAttachments[x].Color.ValPtr->ImageHandle.ValPtr->Spec.State;
+						FirstUseState(DescResources.ColorAttachments[x].Color);
 				}
 
 				// Pre-Pass Barrier: Transition to InitialState
@@ -1277,11 +1827,11 @@ namespace Chilli
 				if (!IsSwapChain && ColorAttachment.ResolveTexture != UINT32_MAX)
 				{
 					uint32_t ResolveHandle = ColorAttachment.ResolveTexture;
+					TrackTransientImage(DescResources.ColorAttachments[x].Resolve, i);
 
 					// Initialize Resolve state tracking
 					if (CurrentImageResourceStates.find(ResolveHandle) == CurrentImageResourceStates.end()) {
-						CurrentImageResourceStates[ResolveHandle] =
-							DescResources.ColorAttachments[x].Resolve.ValPtr->ImageHandle.ValPtr->Spec.State;
+						CurrentImageResourceStates[ResolveHandle] = FirstUseState(DescResources.ColorAttachments[x].Resolve);
 					}
 
 					// Pre-Pass Barrier for Resolve: Transition to ResolveInitialState
@@ -1327,6 +1877,7 @@ namespace Chilli
 				auto& InputAttachment = Desc.InputAttachments[x];
 
 				auto Texture = DescResources.InputAttachments[x];
+				TrackTransientImage(Texture, i);
 
 				PipelineBarrier Barrier;
 				// check if key exists
@@ -1334,7 +1885,7 @@ namespace Chilli
 					// key exists
 				}
 				else {
-					CurrentImageResourceStates[InputAttachment] = DescResources.InputAttachments[x].ValPtr->ImageHandle.ValPtr->Spec.State;
+					CurrentImageResourceStates[InputAttachment] = FirstUseState(Texture);
 				}
 
 				if (CurrentImageResourceStates[InputAttachment] != ResourceState::ShaderRead)
@@ -1386,13 +1937,14 @@ namespace Chilli
 				auto& DepthAttachment = Desc.DepthStencil;
 
 				auto Texture = DescResources.DepthTexture;
+				TrackTransientImage(Texture, i);
 
 				// check if key exists
 				if (CurrentImageResourceStates.find(DepthAttachment.DepthTexture) != CurrentImageResourceStates.end()) {
 					// key exists
 				}
 				else {
-					CurrentImageResourceStates[DepthAttachment.DepthTexture] = DescResources.DepthTexture.ValPtr->ImageHandle.ValPtr->Spec.State;
+					CurrentImageResourceStates[DepthAttachment.DepthTexture] = FirstUseState(Texture);
 				}
 				if (CurrentImageResourceStates[DepthAttachment.DepthTexture] != ResourceState::DepthWrite)
 				{
@@ -1425,12 +1977,50 @@ namespace Chilli
 			}
 		}
 
+		// The first transition of an aliased image waits on all earlier graphics work, the image that had the
+		// memory before may have been used by any pass ahead of it or by the previous frame
+		for (auto& Pass : _Passes)
+		{
+			auto& Desc = Pass->GetDesc();
+			for (uint32_t x = 0; x < Desc.PrePassBarrierCount; x++)
+			{
+				auto& Barrier = Desc.PrePassBarriers[x];
+				if (!Barrier.IsImageBarrier() || Barrier.Image.IsSwapChain || Barrier.OldState != ResourceState::Undefined ||
+					TransientTextures.find(Barrier.Image.Handle) == TransientTextures.end())
+					continue;
+
+				Barrier.SrcStage = PipelineStage::ALL_GRAPHICS;
+				Barrier.SrcAccess = AccessType(uint32_t(AccessType::COLOR_ATTACHMENT_WRITE) |
+					uint32_t(AccessType::DEPTH_STENCIL_WRITE) | uint32_t(AccessType::SHADER_WRITE));
+			}
+		}
+
+		AliasTransientImages(Ctxt);
+
 		for (auto& Pass : _Passes)
 		{
 			CH_CORE_INFO("Name: {}", Pass->GetDesc().Name);
 		}
 	}
 
+	void RenderGraph::AliasTransientImages(BackBone::SystemContext& Ctxt)
+	{
+		if (_TransientImages.empty())
+			return;
+
+		// Handles are read again, a pass may have reallocated the image behind the same asset
+		std::vector<ImageAliasRange> Ranges;
+		for (const auto& Transient : _TransientImages)
+		{
+			ImageAliasRange Range;
+			Range.ImageHandle = Transient.ImageHandle.ValPtr->RawImageHandle;
+			Range.FirstPass = Transient.FirstPass;
+			Range.LastPass = Transient.LastPass;
+			Ranges.push_back(Range);
+		}
+		Chilli::Command(Ctxt).GetService<RenderCommand>()->AliasImages(Ranges);
+	}
+
 	RenderGraphErrorCodes RenderGraph::_IsPassValid(const RenderGraphPass* Pass)
 	{
 		auto Desc = Pass->GetDesc();
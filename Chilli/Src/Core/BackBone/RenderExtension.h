@@ -5,6 +5,7 @@
 #include "Renderer/RenderClasses.h"
 #include "Renderer/Mesh.h"
 #include "Material.h"
+#include "MeshArena.h"
 #include "AssetLoader.h"
 #include <cstdint>
 #include "EventHandler.h"
@@ -103,6 +104,9 @@ namespace Chilli
 		bool GeometryPass = true;
 		bool ScenePass = true;
 		bool UIPass = true;
+		// Reads the GPU culled draw counts back and compares them with the CPU culler, meant for
+		// headless runs (e.g. on lavapipe), it makes the draw count buffer host visible
+		bool ValidateGpuCulling = false;
 	};
 
 
@@ -156,15 +160,6 @@ namespace Chilli
 		bool ContinueRender = false;
 		CommandBufferAllocInfo ActiveCommandBuffer;
 
-		struct LastTransformStruct
-		{
-			uint32_t GenerationVal = 0;
-			uint32_t Version = UINT32_MAX;
-			LastTransformStruct() :Version(UINT32_MAX) {}
-		};
-
-		SparseSet<LastTransformStruct> LastTransformVersion;
-
 		BackBone::AssetHandle<ShaderProgram> DeafultShaderProgram;
 		BackBone::AssetHandle<Material> DeafultMaterial;
 		BackBone::AssetHandle<Image> DeafultImage;
@@ -440,6 +435,9 @@ namespace Chilli
 		}
 
 		void Build(BackBone::SystemContext& Ctxt);
+		// Hands the pass ranges of the aliasable images to the backend, done by Build and again whenever a
+		// pass may have reallocated its images
+		void AliasTransientImages(BackBone::SystemContext& Ctxt);
 
 		std::vector<std::shared_ptr<RenderGraphPass>>& GetPasses()
 		{
@@ -478,11 +476,20 @@ namespace Chilli
 			bool                      Before;
 		};
 
+		// An aliasable image and the first and last pass that declare it
+		struct TransientImage
+		{
+			BackBone::AssetHandle<Image> ImageHandle;
+			uint32_t FirstPass = 0;
+			uint32_t LastPass = 0;
+		};
+
 		RenderGraphRegistry _Registry;
 		std::vector<std::shared_ptr<RenderGraphPass>> _Passes;
 		std::vector<ResourceStateChange> _PrePassChanges;
 		std::vector<ResourceStateChange> _PostPassChanges;
 		std::vector<OrderOverride>               _OrderOverrides;
+		std::vector<TransientImage> _TransientImages;
 	};
 
 	class Renderer;
@@ -0,0 +1,779 @@
+#include "Ch_PCH.h"
+#include "SpatialIndex.h"
+#include "DeafultExtensions.h"
+
+#include <algorithm>
+
+namespace Chilli
+{
+	namespace
+	{
+		enum class FrustumTest { OUTSIDE, INTERSECT, INSIDE };
+
+		// The six planes packed into two groups of four so one box is tested against all of
+		// them with a handful of SSE instructions, the two padding planes accept everything
+		struct PackedFrustum
+		{
+#if CH_CULLING_SSE
+			__m128 NX[2], NY[2], NZ[2], D[2];
+			__m128 AX[2], AY[2], AZ[2];
+#endif
+			float Planes[8][4];
+
+			PackedFrustum(const Frustum& View)
+			{
+				for (int p = 0; p < 8; p++)
+				{
+					if (p < Frustum::PLANE_COUNT)
+					{
+						Planes[p][0] = View.Planes[p].x; Planes[p][1] = View.Planes[p].y;
+						Planes[p][2] = View.Planes[p].z; Planes[p][3] = View.Planes[p].w;
+					}
+					else
+					{
+						Planes[p][0] = 0.0f; Planes[p][1] = 0.0f; Planes[p][2] = 0.0f; Planes[p][3] = 1e30f;
+					}
+				}
+#if CH_CULLING_SSE
+				for (int g = 0; g < 2; g++)
+				{
+					const float (*P)[4] = &Planes[g * 4];
+					NX[g] = _mm_setr_ps(P[0][0], P[1][0], P[2][0], P[3][0]);
+					NY[g] = _mm_setr_ps(P[0][1], P[1][1], P[2][1], P[3][1]);
+					NZ[g] = _mm_setr_ps(P[0][2], P[1][2], P[2][2], P[3][2]);
+					D[g] = _mm_setr_ps(P[0][3], P[1][3], P[2][3], P[3][3]);
+					AX[g] = _mm_setr_ps(std::fabs(P[0][0]), std::fabs(P[1][0]), std::fabs(P[2][0]), std::fabs(P[3][0]));
+					AY[g] = _mm_setr_ps(std::fabs(P[0][1]), std::fabs(P[1][1]), std::fabs(P[2][1]), std::fabs(P[3][1]));
+					AZ[g] = _mm_setr_ps(std::fabs(P[0][2]), std::fabs(P[1][2]), std::fabs(P[2][2]), std::fabs(P[3][2]));
+				}
+#endif
+			}
+
+			FrustumTest Test(const BoundingBox& Box) const
+			{
+				glm::vec3 C = Box.GetCenter();
+				glm::vec3 E = Box.GetExtent();
+#if CH_CULLING_SSE
+				__m128 CX = _mm_set1_ps(C.x), CY = _mm_set1_ps(C.y), CZ = _mm_set1_ps(C.z);
+				__m128 EX = _mm_set1_ps(E.x), EY = _mm_set1_ps(E.y), EZ = _mm_set1_ps(E.z);
+				__m128 Zero = _mm_setzero_ps();
+
+				int OutsideMask = 0, InsideMask = 0;
+				for (int g = 0; g < 2; g++)
+				{
+					__m128 Distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(CX, NX[g]), _mm_mul_ps(CY, NY[g])),
+						_mm_add_ps(_mm_mul_ps(CZ, NZ[g]), D[g]));
+					__m128 Radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(EX, AX[g]), _mm_mul_ps(EY, AY[g])),
+						_mm_mul_ps(EZ, AZ[g]));
+
+					OutsideMask |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(Distance, Radius), Zero));
+					InsideMask |= _mm_movemask_ps(_mm_cmpge_ps(_mm_sub_ps(Distance, Radius), Zero)) << (g * 4);
+				}
+
+				if (OutsideMask != 0)
+					return FrustumTest::OUTSIDE;
+				return InsideMask == 0xFF ? FrustumTest::INSIDE : FrustumTest::INTERSECT;
+#else
+				bool FullyInside = true;
+				for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+				{
+					float Distance = C.x * Planes[p][0] + C.y * Planes[p][1] + C.z * Planes[p][2] + Planes[p][3];
+					float Radius = E.x * std::fabs(Planes[p][0]) + E.y * std::fabs(Planes[p][1]) + E.z * std::fabs(Planes[p][2]);
+					if (Distance + Radius < 0.0f)
+						return FrustumTest::OUTSIDE;
+					if (Distance - Radius < 0.0f)
+						FullyInside = false;
+				}
+				return FullyInside ? FrustumTest::INSIDE : FrustumTest::INTERSECT;
+#endif
+			}
+		};
+
+#if CH_CULLING_SSE
+		inline __m128 LoadVec3(const glm::vec3& V) { return _mm_setr_ps(V.x, V.y, V.z, 0.0f); }
+#endif
+
+		inline bool Overlaps(const BoundingBox& A, const BoundingBox& B)
+		{
+#if CH_CULLING_SSE
+			__m128 Separated = _mm_or_ps(_mm_cmpgt_ps(LoadVec3(A.Min), LoadVec3(B.Max)),
+				_mm_cmpgt_ps(LoadVec3(B.Min), LoadVec3(A.Max)));
+			return (_mm_movemask_ps(Separated) & 0x7) == 0;
+#else
+			return A.Min.x <= B.Max.x && A.Min.y <= B.Max.y && A.Min.z <= B.Max.z &&
+				B.Min.x <= A.Max.x && B.Min.y <= A.Max.y && B.Min.z <= A.Max.z;
+#endif
+		}
+
+		inline bool OverlapsSphere(const BoundingBox& Box, const glm::vec3& Center, float RadiusSq)
+		{
+#if CH_CULLING_SSE
+			__m128 C = LoadVec3(Center);
+			__m128 Zero = _mm_setzero_ps();
+			// Distance from the center to the box along each axis, zero inside the slab
+			__m128 Delta = _mm_add_ps(_mm_max_ps(_mm_sub_ps(LoadVec3(Box.Min), C), Zero),
+				_mm_max_ps(_mm_sub_ps(C, LoadVec3(Box.Max)), Zero));
+			__m128 Sq = _mm_mul_ps(Delta, Delta);
+			float Lanes[4];
+			_mm_storeu_ps(Lanes, Sq);
+			return Lanes[0] + Lanes[1] + Lanes[2] <= RadiusSq;
+#else
+			float DistanceSq = 0.0f;
+			for (int Axis = 0; Axis < 3; Axis++)
+			{
+				float Delta = std::fmax(Box.Min[Axis] - Center[Axis], 0.0f) + std::fmax(Center[Axis] - Box.Max[Axis], 0.0f);
+				DistanceSq += Delta * Delta;
+			}
+			return DistanceSq <= RadiusSq;
+#endif
+		}
+
+		// Slab test, returns the entry distance or a negative value on a miss
+		inline float IntersectRay(const BoundingBox& Box, const glm::vec3& Origin, const glm::vec3& InvDirection,
+			float MaxDistance)
+		{
+			float Enter = 0.0f, Exit = MaxDistance;
+			for (int Axis = 0; Axis < 3; Axis++)
+			{
+				float T0 = (Box.Min[Axis] - Origin[Axis]) * InvDirection[Axis];
+				float T1 = (Box.Max[Axis] - Origin[Axis]) * InvDirection[Axis];
+				// Parallel rays produce 0 * inf, treat the slab as a pass when the origin is inside it
+				if (T0 != T0 || T1 != T1)
+					continue;
+				if (T0 > T1)
+					std::swap(T0, T1);
+				Enter = std::fmax(Enter, T0);
+				Exit = std::fmin(Exit, T1);
+				if (Enter > Exit)
+					return -1.0f;
+			}
+			return Enter;
+		}
+
+		inline glm::vec3 InverseDirection(const glm::vec3& Direction)
+		{
+			return glm::vec3(Direction.x != 0.0f ? 1.0f / Direction.x : FLT_MAX,
+				Direction.y != 0.0f ? 1.0f / Direction.y : FLT_MAX,
+				Direction.z != 0.0f ? 1.0f / Direction.z : FLT_MAX);
+		}
+	}
+
+	BoundingBox BoundingBox::FromTransformedBounds(const MeshBounds& Local, const glm::mat4& World)
+	{
+		glm::vec3 LocalCenter(Local.Center.x, Local.Center.y, Local.Center.z);
+		glm::vec3 LocalExtent((Local.Max.x - Local.Min.x) * 0.5f, (Local.Max.y - Local.Min.y) * 0.5f,
+			(Local.Max.z - Local.Min.z) * 0.5f);
+
+		glm::vec3 Center = glm::vec3(World * glm::vec4(LocalCenter, 1.0f));
+		glm::vec3 Extent;
+		for (int Row = 0; Row < 3; Row++)
+			Extent[Row] = std::fabs(World[0][Row]) * LocalExtent.x + std::fabs(World[1][Row]) * LocalExtent.y +
+			std::fabs(World[2][Row]) * LocalExtent.z;
+
+		return { Center - Extent, Center + Extent };
+	}
+
+#pragma region Dynamic BVH
+	uint32_t DynamicBVH::_AllocateNode()
+	{
+		uint32_t Index;
+		if (!_FreeNodes.empty())
+		{
+			Index = _FreeNodes.back();
+			_FreeNodes.pop_back();
+		}
+		else
+		{
+			Index = uint32_t(_Nodes.size());
+			_Nodes.emplace_back();
+		}
+
+		_Nodes[Index] = Node();
+		_Nodes[Index].Height = 0;
+		return Index;
+	}
+
+	void DynamicBVH::_FreeNode(uint32_t Index)
+	{
+		_Nodes[Index].Height = -1;
+		_Nodes[Index].Moved = false;
+		_FreeNodes.push_back(Index);
+	}
+
+	uint32_t DynamicBVH::CreateProxy(const BoundingBox& Box, uint32_t UserData)
+	{
+		uint32_t Leaf = _AllocateNode();
+		_Nodes[Leaf].Box = Box.Expanded(_Config.FatMargin);
+		_Nodes[Leaf].UserData = UserData;
+
+		_InsertLeaf(Leaf);
+		_ProxyCount++;
+		return Leaf;
+	}
+
+	void DynamicBVH::DestroyProxy(uint32_t Proxy)
+	{
+		if (Proxy >= _Nodes.size() || _Nodes[Proxy].Height != 0 || !_Nodes[Proxy].IsLeaf())
+		{
+			CH_CORE_ERROR("DynamicBVH: DestroyProxy called with an invalid proxy {0}", Proxy);
+			return;
+		}
+
+		_RemoveLeaf(Proxy);
+		_FreeNode(Proxy);
+		_ProxyCount--;
+	}
+
+	bool DynamicBVH::MoveProxy(uint32_t Proxy, const BoundingBox& Box)
+	{
+		Node& Leaf = _Nodes[Proxy];
+		if (Leaf.Box.Contains(Box))
+			return false;
+
+		Leaf.Box = Box.Expanded(_Config.FatMargin);
+		if (!Leaf.Moved)
+		{
+			Leaf.Moved = true;
+			_MovedLeaves.push_back(Proxy);
+		}
+		return true;
+	}
+
+	void DynamicBVH::_InsertLeaf(uint32_t Leaf)
+	{
+		if (_Root == NULL_NODE)
+		{
+			_Root = Leaf;
+			_Nodes[Leaf].Parent = NULL_NODE;
+			return;
+		}
+
+		// Walk down picking the child with the lowest surface area heuristic cost, stop when
+		// pairing with the current node is cheaper than descending any further
+		BoundingBox LeafBox = _Nodes[Leaf].Box;
+		uint32_t Index = _Root;
+		while (!_Nodes[Index].IsLeaf())
+		{
+			const Node& Current = _Nodes[Index];
+			float Area = Current.Box.SurfaceArea();
+			float CombinedArea = BoundingBox::Union(Current.Box, LeafBox).SurfaceArea();
+
+			float Cost = 2.0f * CombinedArea;
+			float InheritanceCost = 2.0f * (CombinedArea - Area);
+
+			auto ChildCost = [&](uint32_t Child) {
+				const Node& ChildNode = _Nodes[Child];
+				float NewArea = BoundingBox::Union(ChildNode.Box, LeafBox).SurfaceArea();
+				if (ChildNode.IsLeaf())
+					return NewArea + InheritanceCost;
+				return (NewArea - ChildNode.Box.SurfaceArea()) + InheritanceCost;
+				};
+
+			float Cost0 = ChildCost(Current.Child[0]);
+			float Cost1 = ChildCost(Current.Child[1]);
+
+			if (Cost < Cost0 && Cost < Cost1)
+				break;
+
+			Index = Cost0 < Cost1 ? Current.Child[0] : Current.Child[1];
+		}
+
+		uint32_t Sibling = Index;
+		uint32_t OldParent = _Nodes[Sibling].Parent;
+		uint32_t NewParent = _AllocateNode();
+
+		_Nodes[NewParent].Parent = OldParent;
+		_Nodes[NewParent].Box = BoundingBox::Union(LeafBox, _Nodes[Sibling].Box);
+		_Nodes[NewParent].Height = _Nodes[Sibling].Height + 1;
+		_Nodes[NewParent].Child[0] = Sibling;
+		_Nodes[NewParent].Child[1] = Leaf;
+		_Nodes[Sibling].Parent = NewParent;
+		_Nodes[Leaf].Parent = NewParent;
+		_InternalArea += _Nodes[NewParent].Box.SurfaceArea();
+
+		if (OldParent != NULL_NODE)
+		{
+			Node& Parent = _Nodes[OldParent];
+			Parent.Child[Parent.Child[0] == Sibling ? 0 : 1] = NewParent;
+		}
+		else
+			_Root = NewParent;
+
+		_Refit(OldParent, false);
+	}
+
+	void DynamicBVH::_RemoveLeaf(uint32_t Leaf)
+	{
+		if (Leaf == _Root)
+		{
+			_Root = NULL_NODE;
+			return;
+		}
+
+		uint32_t Parent = _Nodes[Leaf].Parent;
+		uint32_t GrandParent = _Nodes[Parent].Parent;
+		uint32_t Sibling = _Nodes[Parent].Child[0] == Leaf ? _Nodes[Parent].Child[1] : _Nodes[Parent].Child[0];
+
+		_InternalArea -= _Nodes[Parent].Box.SurfaceArea();
+
+		if (GrandParent != NULL_NODE)
+		{
+			Node& Grand = _Nodes[GrandParent];
+			Grand.Child[Grand.Child[0] == Parent ? 0 : 1] = Sibling;
+			_Nodes[Sibling].Parent = GrandParent;
+			_FreeNode(Parent);
+			_Refit(GrandParent, false);
+		}
+		else
+		{
+			_Root = Sibling;
+			_Nodes[Sibling].Parent = NULL_NODE;
+			_FreeNode(Parent);
+		}
+	}
+
+	void DynamicBVH::_Refit(uint32_t Index, bool EarlyOut)
+	{
+		while (Index != NULL_NODE)
+		{
+			Node& Current = _Nodes[Index];
+			const Node& Left = _Nodes[Current.Child[0]];
+			const Node& Right = _Nodes[Current.Child[1]];
+
+			BoundingBox NewBox = BoundingBox::Union(Left.Box, Right.Box);
+			int32_t NewHeight = 1 + std::max(Left.Height, Right.Height);
+
+			if (EarlyOut && NewBox == Current.Box && NewHeight == Current.Height)
+				return;
+
+			_InternalArea += NewBox.SurfaceArea() - Current.Box.SurfaceArea();
+			Current.Box = NewBox;
+			Current.Height = NewHeight;
+			Index = Current.Parent;
+		}
+	}
+
+	void DynamicBVH::_RefitAll()
+	{
+		if (_Root == NULL_NODE)
+			return;
+
+		// Pre order puts every parent before its children, walking it backwards refits bottom up
+		std::vector<uint32_t>& Order = _Stack;
+		Order.clear();
+		Order.push_back(_Root);
+		for (size_t i = 0; i < Order.size(); i++)
+		{
+			const Node& Current = _Nodes[Order[i]];
+			if (!Current.IsLeaf())
+			{
+				Order.push_back(Current.Child[0]);
+				Order.push_back(Current.Child[1]);
+			}
+		}
+
+		_InternalArea = 0.0f;
+		for (size_t i = Order.size(); i-- > 0;)
+		{
+			Node& Current = _Nodes[Order[i]];
+			if (Current.IsLeaf())
+				continue;
+
+			Current.Box = BoundingBox::Union(_Nodes[Current.Child[0]].Box, _Nodes[Current.Child[1]].Box);
+			_InternalArea += Current.Box.SurfaceArea();
+		}
+	}
+
+	void DynamicBVH::Update()
+	{
+		if (_MovedLeaves.empty())
+			return;
+
+		// Walking up from every moved leaf visits shared ancestors again and again, once enough
+		// leaves moved a single pass over the whole tree is cheaper
+		if (float(_MovedLeaves.size()) > float(_ProxyCount) * _Config.FullRefitMoveFraction)
+		{
+			for (uint32_t Leaf : _MovedLeaves)
+				_Nodes[Leaf].Moved = false;
+			_RefitAll();
+		}
+		else
+		{
+			for (uint32_t Leaf : _MovedLeaves)
+			{
+				// Destroyed after moving in the same frame
+				if (!_Nodes[Leaf].Moved)
+					continue;
+
+				_Nodes[Leaf].Moved = false;
+				_Refit(_Nodes[Leaf].Parent, true);
+			}
+		}
+		_MovedLeaves.clear();
+		_RefitCount++;
+
+		// Refitting never changes the topology so the tree loosens as things move, rebuild once
+		// it got noticeably worse than right after the last rebuild. A tree that was only ever
+		// built by insertion uses its first refit as the baseline.
+		if (_RebuildAreaRatio == 0.0f)
+			_RebuildAreaRatio = _GetAreaRatio();
+		else if (_GetAreaRatio() > _RebuildAreaRatio * _Config.RebuildQualityThreshold)
+			Rebuild();
+	}
+
+	void DynamicBVH::Rebuild()
+	{
+		std::vector<uint32_t> Leaves;
+		Leaves.reserve(_ProxyCount);
+
+		for (uint32_t i = 0; i < _Nodes.size(); i++)
+		{
+			Node& Current = _Nodes[i];
+			if (Current.Height < 0)
+				continue;
+
+			Current.Moved = false;
+			if (Current.IsLeaf())
+				Leaves.push_back(i);
+			else
+				_FreeNode(i);
+		}
+
+		_MovedLeaves.clear();
+		_InternalArea = 0.0f;
+		_Root = NULL_NODE;
+
+		if (!Leaves.empty())
+		{
+			_Root = _BuildTopDown(Leaves.data(), uint32_t(Leaves.size()));
+			_Nodes[_Root].Parent = NULL_NODE;
+		}
+
+		_RebuildAreaRatio = _GetAreaRatio();
+		_RebuildCount++;
+	}
+
+	uint32_t DynamicBVH::_BuildTopDown(uint32_t* Leaves, uint32_t Count)
+	{
+		if (Count == 1)
+			return Leaves[0];
+
+		// Median split along the widest axis of the leaf centers
+		glm::vec3 CenterMin(FLT_MAX), CenterMax(-FLT_MAX);
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			glm::vec3 C = _Nodes[Leaves[i]].Box.GetCenter();
+			CenterMin = glm::vec3(std::fmin(CenterMin.x, C.x), std::fmin(CenterMin.y, C.y), std::fmin(CenterMin.z, C.z));
+			CenterMax = glm::vec3(std::fmax(CenterMax.x, C.x), std::fmax(CenterMax.y, C.y), std::fmax(CenterMax.z, C.z));
+		}
+
+		glm::vec3 Spread = CenterMax - CenterMin;
+		int Axis = Spread.x > Spread.y ? (Spread.x > Spread.z ? 0 : 2) : (Spread.y > Spread.z ? 1 : 2);
+
+		uint32_t Mid = Count / 2;
+		std::nth_element(Leaves, Leaves + Mid, Leaves + Count, [&](uint32_t A, uint32_t B) {
+			return _Nodes[A].Box.Min[Axis] + _Nodes[A].Box.Max[Axis] < _Nodes[B].Box.Min[Axis] + _Nodes[B].Box.Max[Axis];
+			});
+
+		uint32_t Left = _BuildTopDown(Leaves, Mid);
+		uint32_t Right = _BuildTopDown(Leaves + Mid, Count - Mid);
+
+		// Allocated after the children, _Nodes may have grown while building them
+		uint32_t Index = _AllocateNode();
+		Node& Parent = _Nodes[Index];
+		Parent.Child[0] = Left;
+		Parent.Child[1] = Right;
+		Parent.Box = BoundingBox::Union(_Nodes[Left].Box, _Nodes[Right].Box);
+		Parent.Height = 1 + std::max(_Nodes[Left].Height, _Nodes[Right].Height);
+		_Nodes[Left].Parent = Index;
+		_Nodes[Right].Parent = Index;
+
+		_InternalArea += Parent.Box.SurfaceArea();
+		return Index;
+	}
+
+	void DynamicBVH::Clear()
+	{
+		_Nodes.clear();
+		_FreeNodes.clear();
+		_MovedLeaves.clear();
+		_Root = NULL_NODE;
+		_ProxyCount = 0;
+		_InternalArea = 0.0f;
+		_RebuildAreaRatio = 0.0f;
+	}
+
+	float DynamicBVH::_GetAreaRatio() const
+	{
+		if (_Root == NULL_NODE || _Nodes[_Root].IsLeaf())
+			return 0.0f;
+
+		float RootArea = _Nodes[_Root].Box.SurfaceArea();
+		return RootArea > 0.0f ? _InternalArea / RootArea : 0.0f;
+	}
+
+	void DynamicBVH::_CollectLeaves(uint32_t Index, std::vector<uint32_t>& OutUserData) const
+	{
+		// Uses the tail of the shared stack, the caller's entries below Base are left alone
+		size_t Base = _Stack.size();
+		_Stack.push_back(Index);
+		while (_Stack.size() > Base)
+		{
+			const Node& Current = _Nodes[_Stack.back()];
+			_Stack.pop_back();
+
+			if (Current.IsLeaf())
+				OutUserData.push_back(Current.UserData);
+			else
+			{
+				_Stack.push_back(Current.Child[0]);
+				_Stack.push_back(Current.Child[1]);
+			}
+		}
+	}
+
+	void DynamicBVH::QueryFrustum(const Frustum& View, std::vector<uint32_t>& OutUserData) const
+	{
+		if (_Root == NULL_NODE)
+			return;
+
+		PackedFrustum Planes(View);
+
+		_Stack.clear();
+		_Stack.push_back(_Root);
+		while (!_Stack.empty())
+		{
+			uint32_t Index = _Stack.back();
+			_Stack.pop_back();
+			const Node& Current = _Nodes[Index];
+
+			FrustumTest Result = Planes.Test(Current.Box);
+			if (Result == FrustumTest::OUTSIDE)
+				continue;
+
+			// Whole subtree is visible, no more plane tests needed below here
+			if (Result == FrustumTest::INSIDE || Current.IsLeaf())
+			{
+				_CollectLeaves(Index, OutUserData);
+				continue;
+			}
+
+			_Stack.push_back(Current.Child[0]);
+			_Stack.push_back(Current.Child[1]);
+		}
+	}
+
+	void DynamicBVH::QueryBox(const BoundingBox& Box, std::vector<uint32_t>& OutUserData) const
+	{
+		if (_Root == NULL_NODE)
+			return;
+
+		_Stack.clear();
+		_Stack.push_back(_Root);
+		while (!_Stack.empty())
+		{
+			const Node& Current = _Nodes[_Stack.back()];
+			_Stack.pop_back();
+
+			if (!Overlaps(Current.Box, Box))
+				continue;
+
+			if (Current.IsLeaf())
+				OutUserData.push_back(Current.UserData);
+			else
+			{
+				_Stack.push_back(Current.Child[0]);
+				_Stack.push_back(Current.Child[1]);
+			}
+		}
+	}
+
+	void DynamicBVH::QuerySphere(const glm::vec3& Center, float Radius, std::vector<uint32_t>& OutUserData) const
+	{
+		if (_Root == NULL_NODE)
+			return;
+
+		const float RadiusSq = Radius * Radius;
+
+		_Stack.clear();
+		_Stack.push_back(_Root);
+		while (!_Stack.empty())
+		{
+			const Node& Current = _Nodes[_Stack.back()];
+			_Stack.pop_back();
+
+			if (!OverlapsSphere(Current.Box, Center, RadiusSq))
+				continue;
+
+			if (Current.IsLeaf())
+				OutUserData.push_back(Current.UserData);
+			else
+			{
+				_Stack.push_back(Current.Child[0]);
+				_Stack.push_back(Current.Child[1]);
+			}
+		}
+	}
+
+	void DynamicBVH::QueryRay(const Ray& InRay, std::vector<uint32_t>& OutUserData) const
+	{
+		if (_Root == NULL_NODE)
+			return;
+
+		glm::vec3 InvDirection = InverseDirection(InRay.Direction);
+
+		_Stack.clear();
+		_Stack.push_back(_Root);
+		while (!_Stack.empty())
+		{
+			const Node& Current = _Nodes[_Stack.back()];
+			_Stack.pop_back();
+
+			if (IntersectRay(Current.Box, InRay.Origin, InvDirection, InRay.MaxDistance) < 0.0f)
+				continue;
+
+			if (Current.IsLeaf())
+				OutUserData.push_back(Current.UserData);
+			else
+			{
+				_Stack.push_back(Current.Child[0]);
+				_Stack.push_back(Current.Child[1]);
+			}
+		}
+	}
+
+	bool DynamicBVH::RayCast(const Ray& InRay, RayHit& OutHit) const
+	{
+		OutHit = RayHit();
+		if (_Root == NULL_NODE)
+			return false;
+
+		glm::vec3 InvDirection = InverseDirection(InRay.Direction);
+		float Closest = InRay.MaxDistance;
+
+		_Stack.clear();
+		_Stack.push_back(_Root);
+		while (!_Stack.empty())
+		{
+			const Node& Current = _Nodes[_Stack.back()];
+			_Stack.pop_back();
+
+			float Enter = IntersectRay(Current.Box, InRay.Origin, InvDirection, Closest);
+			if (Enter < 0.0f)
+				continue;
+
+			if (Current.IsLeaf())
+			{
+				Closest = Enter;
+				OutHit.UserData = Current.UserData;
+				OutHit.Distance = Enter;
+				continue;
+			}
+
+			// Push the farther child first so the nearer one is visited first and shrinks Closest
+			float Enter0 = IntersectRay(_Nodes[Current.Child[0]].Box, InRay.Origin, InvDirection, Closest);
+			float Enter1 = IntersectRay(_Nodes[Current.Child[1]].Box, InRay.Origin, InvDirection, Closest);
+			bool NearIsFirst = Enter1 < 0.0f || (Enter0 >= 0.0f && Enter0 <= Enter1);
+
+			uint32_t Near = NearIsFirst ? Current.Child[0] : Current.Child[1];
+			uint32_t Far = NearIsFirst ? Current.Child[1] : Current.Child[0];
+			if ((NearIsFirst ? Enter1 : Enter0) >= 0.0f)
+				_Stack.push_back(Far);
+			if ((NearIsFirst ? Enter0 : Enter1) >= 0.0f)
+				_Stack.push_back(Near);
+		}
+
+		return OutHit.UserData != UINT32_MAX;
+	}
+
+	DynamicBVHStats DynamicBVH::GetStats() const
+	{
+		DynamicBVHStats Stats;
+		Stats.ProxyCount = _ProxyCount;
+		Stats.NodeCount = uint32_t(_Nodes.size() - _FreeNodes.size());
+		Stats.Height = _Root == NULL_NODE ? 0 : uint32_t(_Nodes[_Root].Height);
+		Stats.AreaRatio = _GetAreaRatio();
+		Stats.RebuildCount = _RebuildCount;
+		Stats.RefitCount = _RefitCount;
+		return Stats;
+	}
+#pragma endregion
+
+#pragma region Spatial Index System
+	static BoundingBox GetEntityWorldBox(const MeshComponent* MeshComp, TransformComponent* Transform)
+	{
+		const glm::mat4& World = Transform->GetWorldMatrix();
+
+		if (MeshComp != nullptr && MeshComp->MeshHandle.IsValid() && MeshComp->MeshHandle.ValPtr->Bounds.IsValid)
+			return BoundingBox::FromTransformedBounds(MeshComp->MeshHandle.ValPtr->Bounds, World);
+
+		glm::vec3 Position(World[3][0], World[3][1], World[3][2]);
+		return { Position, Position };
+	}
+
+	void OnSpatialIndexUpdate(BackBone::SystemContext& Ctxt)
+	{
+		auto Command = Chilli::Command(Ctxt);
+		auto Index = Command.GetResource<SpatialIndexResource>();
+
+		const uint32_t Frame = ++Index->FrameCounter;
+
+		for (auto [Entity, Transform] : BackBone::QueryWithEntities<TransformComponent>(*Ctxt.Registry))
+		{
+			uint32_t Generation = Command.GetEntityGeneration(Entity);
+			auto Proxy = Index->EntityProxies.Get(Entity);
+			auto MeshComp = Command.GetComponent<MeshComponent>(Entity);
+			uint32_t MeshHandle = MeshComp != nullptr ? MeshComp->MeshHandle.Handle : BackBone::npos;
+
+			// Entity id was recycled since the proxy was made
+			if (Proxy != nullptr && Proxy->Generation != Generation)
+			{
+				Index->Tree.DestroyProxy(Proxy->Proxy);
+				Index->EntityProxies.Destroy(Entity);
+				Proxy = nullptr;
+			}
+
+			if (Proxy == nullptr)
+			{
+				SpatialIndexResource::EntityProxy NewProxy;
+				NewProxy.Proxy = Index->Tree.CreateProxy(GetEntityWorldBox(MeshComp, Transform), Entity);
+				NewProxy.TransformVersion = Transform->GetVersion();
+				NewProxy.MeshHandle = MeshHandle;
+				NewProxy.Generation = Generation;
+				NewProxy.LastSeenFrame = Frame;
+				Index->EntityProxies.Insert(Entity, NewProxy);
+				continue;
+			}
+
+			Proxy->LastSeenFrame = Frame;
+			if (Proxy->MeshHandle != MeshHandle)
+			{
+				// A swapped mesh changes the bounds without touching the transform, the fat box of the old
+				// mesh may be far too large for the new one so the proxy is made again
+				Index->Tree.DestroyProxy(Proxy->Proxy);
+				Proxy->Proxy = Index->Tree.CreateProxy(GetEntityWorldBox(MeshComp, Transform), Entity);
+				Proxy->TransformVersion = Transform->GetVersion();
+				Proxy->MeshHandle = MeshHandle;
+			}
+			else if (Proxy->TransformVersion != Transform->GetVersion())
+			{
+				Index->Tree.MoveProxy(Proxy->Proxy, GetEntityWorldBox(MeshComp, Transform));
+				Proxy->TransformVersion = Transform->GetVersion();
+			}
+		}
+
+		// Anything not visited lost its transform or was destroyed. Walking backwards means the
+		// entry swapped into a destroyed slot has already been checked.
+		for (uint32_t i = Index->EntityProxies.size(); i-- > 0;)
+		{
+			if (Index->EntityProxies.GetDataBuffer()[i].LastSeenFrame == Frame)
+				continue;
+
+			Index->Tree.DestroyProxy(Index->EntityProxies.GetDataBuffer()[i].Proxy);
+			Index->EntityProxies.Destroy(Index->EntityProxies.GetIdAtDenseIndex(i));
+		}
+
+		Index->Tree.Update();
+	}
+#pragma endregion
+}
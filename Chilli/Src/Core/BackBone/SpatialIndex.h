@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstdint>
+#include <cfloat>
+#include <vector>
+
+#include "BackBone.h"
+#include "SparseSet.h"
+#include "Culling.h"
+
+namespace Chilli
+{
+	struct BoundingBox
+	{
+		glm::vec3 Min{ 0.0f };
+		glm::vec3 Max{ 0.0f };
+
+		BoundingBox() = default;
+		BoundingBox(const glm::vec3& InMin, const glm::vec3& InMax) : Min(InMin), Max(InMax) {}
+
+		static BoundingBox Union(const BoundingBox& A, const BoundingBox& B)
+		{
+			return { glm::vec3(std::fmin(A.Min.x, B.Min.x), std::fmin(A.Min.y, B.Min.y), std::fmin(A.Min.z, B.Min.z)),
+				glm::vec3(std::fmax(A.Max.x, B.Max.x), std::fmax(A.Max.y, B.Max.y), std::fmax(A.Max.z, B.Max.z)) };
+		}
+
+		// Local bounds moved to world space, the extent follows Arvo's abs matrix method
+		static BoundingBox FromTransformedBounds(const MeshBounds& Local, const glm::mat4& World);
+
+		inline glm::vec3 GetCenter() const { return (Min + Max) * 0.5f; }
+		inline glm::vec3 GetExtent() const { return (Max - Min) * 0.5f; }
+
+		inline float SurfaceArea() const
+		{
+			glm::vec3 D = Max - Min;
+			return 2.0f * (D.x * D.y + D.y * D.z + D.z * D.x);
+		}
+
+		inline bool Contains(const BoundingBox& Other) const
+		{
+			return Min.x <= Other.Min.x && Min.y <= Other.Min.y && Min.z <= Other.Min.z &&
+				Max.x >= Other.Max.x && Max.y >= Other.Max.y && Max.z >= Other.Max.z;
+		}
+
+		inline BoundingBox Expanded(float Margin) const
+		{
+			return { Min - glm::vec3(Margin), Max + glm::vec3(Margin) };
+		}
+
+		inline bool operator==(const BoundingBox& Other) const { return Min == Other.Min && Max == Other.Max; }
+	};
+
+	struct Ray
+	{
+		glm::vec3 Origin{ 0.0f };
+		// Does not need to be normalized, hit distances are in units of its length
+		glm::vec3 Direction{ 0.0f, 0.0f, -1.0f };
+		float MaxDistance = FLT_MAX;
+	};
+
+	struct RayHit
+	{
+		uint32_t UserData = UINT32_MAX;
+		float Distance = FLT_MAX;
+	};
+
+	struct DynamicBVHStats
+	{
+		uint32_t ProxyCount = 0;
+		uint32_t NodeCount = 0;
+		uint32_t Height = 0;
+		// Sum of internal node surface areas over the root's, lower is a better tree
+		float AreaRatio = 0.0f;
+		uint32_t RebuildCount = 0;
+		uint32_t RefitCount = 0;
+	};
+
+	struct DynamicBVHConfig
+	{
+		// Leaves are stored enlarged by this much so small moves don't touch the tree at all
+		float FatMargin = 0.1f;
+		// Moving more than this fraction of the leaves in a frame refits every node in one pass
+		// instead of walking up from each moved leaf
+		float FullRefitMoveFraction = 0.25f;
+		// Refitting loosens the tree, once the area ratio grows past this factor of the last
+		// rebuild's ratio the tree is rebuilt
+		float RebuildQualityThreshold = 1.5f;
+	};
+
+	// Dynamic AABB tree. Proxies are leaf node indices and stay valid across refits and rebuilds
+	// until DestroyProxy, UserData is handed back from every query.
+	class DynamicBVH
+	{
+	public:
+		static constexpr uint32_t NULL_NODE = UINT32_MAX;
+
+		DynamicBVH(const DynamicBVHConfig& Config = DynamicBVHConfig()) : _Config(Config) {}
+
+		uint32_t CreateProxy(const BoundingBox& Box, uint32_t UserData);
+		void DestroyProxy(uint32_t Proxy);
+		// Returns false when the box still fits inside the proxy's fat box and nothing changed.
+		// The tree itself is only refit on the next Update.
+		bool MoveProxy(uint32_t Proxy, const BoundingBox& Box);
+
+		// Refits the tree around moved proxies, then rebuilds it if refitting degraded it too much
+		void Update();
+		void Rebuild();
+		void Clear();
+
+		void QueryFrustum(const Frustum& View, std::vector<uint32_t>& OutUserData) const;
+		void QueryBox(const BoundingBox& Box, std::vector<uint32_t>& OutUserData) const;
+		void QuerySphere(const glm::vec3& Center, float Radius, std::vector<uint32_t>& OutUserData) const;
+		// Every proxy whose fat box the ray passes through
+		void QueryRay(const Ray& InRay, std::vector<uint32_t>& OutUserData) const;
+		// Closest fat box along the ray, callers refine against the real shape if needed
+		bool RayCast(const Ray& InRay, RayHit& OutHit) const;
+
+		inline const BoundingBox& GetFatBox(uint32_t Proxy) const { return _Nodes[Proxy].Box; }
+		inline uint32_t GetUserData(uint32_t Proxy) const { return _Nodes[Proxy].UserData; }
+		inline uint32_t GetProxyCount() const { return _ProxyCount; }
+		inline uint32_t GetPendingMoveCount() const { return uint32_t(_MovedLeaves.size()); }
+
+		DynamicBVHStats GetStats() const;
+		inline DynamicBVHConfig& GetConfig() { return _Config; }
+
+	private:
+		struct Node
+		{
+			BoundingBox Box;
+			uint32_t Parent = NULL_NODE;
+			uint32_t Child[2] = { NULL_NODE, NULL_NODE };
+			uint32_t UserData = UINT32_MAX;
+			// -1 marks a node on the free list, leaves are 0
+			int32_t Height = -1;
+			bool Moved = false;
+
+			inline bool IsLeaf() const { return Child[0] == NULL_NODE; }
+		};
+
+		uint32_t _AllocateNode();
+		void _FreeNode(uint32_t Index);
+
+		void _InsertLeaf(uint32_t Leaf);
+		void _RemoveLeaf(uint32_t Leaf);
+		// Recomputes boxes and heights from Index to the root, stopping early when a box doesn't change
+		void _Refit(uint32_t Index, bool EarlyOut);
+		void _RefitAll();
+		uint32_t _BuildTopDown(uint32_t* Leaves, uint32_t Count);
+
+		void _CollectLeaves(uint32_t Index, std::vector<uint32_t>& OutUserData) const;
+		float _GetAreaRatio() const;
+
+	private:
+		DynamicBVHConfig _Config;
+		std::vector<Node> _Nodes;
+		std::vector<uint32_t> _FreeNodes;
+		std::vector<uint32_t> _MovedLeaves;
+		uint32_t _Root = NULL_NODE;
+		uint32_t _ProxyCount = 0;
+
+		// Sum of internal node areas, kept up to date on every change so the heuristic is O(1)
+		float _InternalArea = 0.0f;
+		float _RebuildAreaRatio = 0.0f;
+		uint32_t _RebuildCount = 0;
+		uint32_t _RefitCount = 0;
+
+		mutable std::vector<uint32_t> _Stack;
+	};
+
+	// World resource keeping one proxy per entity with a TransformComponent, UserData is the Entity.
+	// Entities with a MeshComponent use the mesh bounds, the rest are a point at their position.
+	struct SpatialIndexResource
+	{
+		struct EntityProxy
+		{
+			uint32_t Proxy = DynamicBVH::NULL_NODE;
+			uint32_t TransformVersion = UINT32_MAX;
+			// Asset id of the mesh the bounds came from, npos without one
+			uint32_t MeshHandle = BackBone::npos;
+			uint32_t Generation = 0;
+			uint32_t LastSeenFrame = 0;
+		};
+
+		DynamicBVH Tree;
+		SparseSet<EntityProxy> EntityProxies;
+		uint32_t FrameCounter = 0;
+	};
+
+	// Runs after the transform hierarchy so world matrices are final for the frame
+	void OnSpatialIndexUpdate(BackBone::SystemContext& Ctxt);
+}
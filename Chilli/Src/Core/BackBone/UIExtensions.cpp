@@ -160,7 +160,8 @@ namespace Chilli
 		Chilli::BufferCreateInfo VertexBufferInfo{};
 		VertexBufferInfo.Data = nullptr;
 		VertexBufferInfo.SizeInBytes = sizeof(FlameVertex) * IntiailCharacterCount * 6;
-		VertexBufferInfo.State = BufferState::DYNAMIC_DRAW;
+		// Rebuilt every frame and written through the frame's staging ring
+		VertexBufferInfo.State = BufferState::DYNAMIC_COPY;
 		VertexBufferInfo.Type = BUFFER_TYPE_VERTEX;
 		FlameResource->VertexBuffer = Command.CreateBuffer(VertexBufferInfo);
 
@@ -188,7 +189,7 @@ namespace Chilli
 	}
 
 	void BuildVertexData(FlameTextComponent& text, const PepperTransform& transform,
-		std::vector<FlameVertex>& OutVertices, FlameResource* Resource)
+		TrackedVector<FlameVertex, MemoryTag::UI>& OutVertices, FlameResource* Resource)
 	{
 		auto& fontAsset = text.Font.ValPtr;
 		auto& msdf = fontAsset->RawFontData.ValPtr;
@@ -561,6 +562,10 @@ namespace Chilli
 		Command.LinkShaderProgram(PepperResource->PepperShaderProgram);
 
 		PepperResource->ContextMaterial = Command.CreateMaterial(PepperResource->PepperShaderProgram);
+		// Rebound every frame, the name is only looked up here
+		PepperResource->MaterialSSBOSlot = Command.GetService<Renderer>()->FindMaterialBindingSlot(
+			Command.GetService<Chilli::MaterialSystem>()->GetRawMaterialHandle(PepperResource->ContextMaterial),
+			"PepperMaterialSSBO");
 
 		// Create a Basic Image
 		ImageSpec BasicImageSpec;
@@ -586,8 +591,9 @@ namespace Chilli
 		SamplerSpec.Mode = Chilli::SamplerMode::REPEAT;
 		PepperResource->PepperDeafultSampler = Command.CreateSampler(SamplerSpec);
 
+		// The quads are rebuilt every frame and written through the frame's staging ring
 		VertexInputShaderLayout Layout;
-		Layout.BeginBinding(0, false, BufferState::DYNAMIC_DRAW);
+		Layout.BeginBinding(0, false, BufferState::DYNAMIC_COPY);
 		Layout.AddAttribute(ShaderObjectTypes::FLOAT3, "InPosition", 0);
 		Layout.AddAttribute(ShaderObjectTypes::FLOAT2, "InTexCoords", 1);
 		Layout.AddAttribute(ShaderObjectTypes::INT1, "InPepperMaterialIndex", 2);
@@ -596,7 +602,7 @@ namespace Chilli
 		RenderMeshInfo.IndexCount = PepperResource->MeshQuadCount * 6;
 		RenderMeshInfo.VertCount = PepperResource->MeshQuadCount * 4;
 		RenderMeshInfo.IndexType = IndexBufferType::UINT32_T;
-		RenderMeshInfo.IndexBufferState = BufferState::DYNAMIC_DRAW;
+		RenderMeshInfo.IndexBufferState = BufferState::DYNAMIC_COPY;
 		RenderMeshInfo.MeshLayout = Layout;
 		PepperResource->RenderMesh = Command.CreateMesh(RenderMeshInfo);
 
@@ -786,8 +792,8 @@ namespace Chilli
 	void GeneratePepperQuad(
 		const PepperTransform& transform,
 		const IVec2& screenSize, // Pass current swapchain/window size
-		std::vector<PepperVertex>& outVertices,
-		std::vector<uint32_t>& outIndices, uint32_t MaterialIndex)
+		TrackedVector<PepperVertex, MemoryTag::UI>& outVertices,
+		TrackedVector<uint32_t, MemoryTag::UI>& outIndices, uint32_t MaterialIndex)
 	{
 		// 1. Calculate pixel boundaries (as before)
 		float pixelX0 = transform.ActualPosition.x - static_cast<float>(transform.Pivot.x);
@@ -1467,7 +1473,7 @@ namespace Chilli
 
 		RenderService->UpdateMaterialBufferData(MaterialSystem->GetRawMaterialHandle(PepperResource->ContextMaterial),
 			PepperResource->PepperMaterialSSBO[RenderService->GetCurrentFrameIndex()].ValPtr->RawBufferHandle,
-			"PepperMaterialSSBO",
+			PepperResource->MaterialSSBOSlot,
 			PepperResource->PepperMaterialSSBO[RenderService->GetCurrentFrameIndex()].ValPtr->CreateInfo.SizeInBytes,
 			0);
 
@@ -79,8 +79,8 @@ namespace Chilli
 		BackBone::AssetHandle<Buffer> VertexBuffer;
 		std::vector<BackBone::AssetHandle<Buffer>> MaterialSSBOs;
 
-		std::vector<FlameVertex> Vertices;
-		std::vector<uint32_t> Indicies;
+		TrackedVector<FlameVertex, MemoryTag::UI> Vertices;
+		TrackedVector<uint32_t, MemoryTag::UI> Indicies;
 		uint32_t MaterialCount = 0;
 
 		struct ShaderArrayFontAtlasMetaData
@@ -584,6 +584,7 @@ namespace Chilli
 		BackBone::AssetHandle<Image> PepperDeafultImage;
 		BackBone::AssetHandle<ShaderProgram> PepperShaderProgram;
 		BackBone::AssetHandle<Material> ContextMaterial;
+		MaterialBindingSlot MaterialSSBOSlot;
 		std::vector< BackBone::AssetHandle<Buffer>> PepperMaterialSSBO;
 		std::vector< PepperShaderMaterialData> PepperMaterialData;
 		std::vector<uint32_t> EntityToPCMap;
@@ -601,8 +602,8 @@ namespace Chilli
 		IVec2 CursorPos{ 0,0 };
 
 		uint32_t QuadCount = 0;
-		std::vector<PepperVertex> QuadVertices;
-		std::vector<uint32_t> QuadIndicies;
+		TrackedVector<PepperVertex, MemoryTag::UI> QuadVertices;
+		TrackedVector<uint32_t, MemoryTag::UI> QuadIndicies;
 		Timer CursorTimer;
 
 		struct {
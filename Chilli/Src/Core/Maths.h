@@ -182,13 +182,8 @@ namespace Chilli
 		Vec3 operator-() const { return Vec3(-x, -y, -z); }
 		Vec3 operator+() const { return *this; }
 
-		Vec3& operator=(const Vec3& other)
-		{
-			x = other.x;
-			y = other.y;
-			z = other.z;
-			return *this;
-		}
+		// Defaulted so Vec3 (and anything holding it) stays trivially copyable
+		Vec3& operator=(const Vec3& other) = default;
 
 		Vec3& operator+=(const Vec3& rhs) { x += rhs.x; y += rhs.y; z += rhs.z; return *this; }
 		Vec3& operator-=(const Vec3& rhs) { x -= rhs.x; y -= rhs.y; z -= rhs.z; return *this; }
@@ -0,0 +1,131 @@
+#include "Ch_PCH.h"
+#include "MemoryTracker.h"
+
+#include <atomic>
+
+namespace Chilli
+{
+	const char* MemoryTagToString(MemoryTag Tag)
+	{
+		switch (Tag)
+		{
+		case MemoryTag::ECS: return "ECS";
+		case MemoryTag::ASSETS: return "Assets";
+		case MemoryTag::RENDERER_CPU: return "Renderer-CPU";
+		case MemoryTag::PHYSICS: return "Physics";
+		case MemoryTag::UI: return "UI";
+		case MemoryTag::EVENTS: return "Events";
+		default: return "Unknown";
+		}
+	}
+
+#if CHILLI_ENABLE_MEMORY_TRACKING == true
+	namespace
+	{
+		// Allocations can come from Jolt worker threads as well, so every counter is atomic
+		struct AtomicTagStats
+		{
+			std::atomic<size_t> LiveBytes{ 0 };
+			std::atomic<size_t> PeakBytes{ 0 };
+			std::atomic<size_t> Budget{ 0 };
+			std::atomic<uint64_t> AllocationCount{ 0 };
+			std::atomic<uint64_t> FreeCount{ 0 };
+		};
+
+		AtomicTagStats& GetTagStats(MemoryTag Tag)
+		{
+			static AtomicTagStats Stats[int(MemoryTag::COUNT)];
+			return Stats[int(Tag)];
+		}
+
+		float BytesToMB(size_t Bytes) { return float(Bytes) / (1024.0f * 1024.0f); }
+	}
+
+	void MemoryTracker::OnAlloc(MemoryTag Tag, size_t Size)
+	{
+		auto& Stats = GetTagStats(Tag);
+		size_t Previous = Stats.LiveBytes.fetch_add(Size, std::memory_order_relaxed);
+		size_t Live = Previous + Size;
+		Stats.AllocationCount.fetch_add(1, std::memory_order_relaxed);
+
+		size_t Peak = Stats.PeakBytes.load(std::memory_order_relaxed);
+		while (Live > Peak && !Stats.PeakBytes.compare_exchange_weak(Peak, Live, std::memory_order_relaxed))
+		{
+		}
+
+		// Only warn on the allocation that crosses the budget, not on every one after it
+		size_t Budget = Stats.Budget.load(std::memory_order_relaxed);
+		if (Budget != 0 && Previous <= Budget && Live > Budget)
+			CH_CORE_WARN("Memory budget exceeded for {0}: {1:.2f} MB / {2:.2f} MB", MemoryTagToString(Tag),
+				BytesToMB(Live), BytesToMB(Budget));
+	}
+
+	void MemoryTracker::OnFree(MemoryTag Tag, size_t Size)
+	{
+		auto& Stats = GetTagStats(Tag);
+		Stats.LiveBytes.fetch_sub(Size, std::memory_order_relaxed);
+		Stats.FreeCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void MemoryTracker::SetBudget(MemoryTag Tag, size_t Bytes)
+	{
+		GetTagStats(Tag).Budget.store(Bytes, std::memory_order_relaxed);
+	}
+
+	MemoryTagStats MemoryTracker::GetStats(MemoryTag Tag)
+	{
+		auto& Stats = GetTagStats(Tag);
+
+		MemoryTagStats Out;
+		Out.LiveBytes = Stats.LiveBytes.load(std::memory_order_relaxed);
+		Out.PeakBytes = Stats.PeakBytes.load(std::memory_order_relaxed);
+		Out.Budget = Stats.Budget.load(std::memory_order_relaxed);
+		Out.AllocationCount = Stats.AllocationCount.load(std::memory_order_relaxed);
+		Out.FreeCount = Stats.FreeCount.load(std::memory_order_relaxed);
+		return Out;
+	}
+
+	size_t MemoryTracker::GetTotalLiveBytes()
+	{
+		size_t Total = 0;
+		for (int i = 0; i < int(MemoryTag::COUNT); i++)
+			Total += GetTagStats(MemoryTag(i)).LiveBytes.load(std::memory_order_relaxed);
+		return Total;
+	}
+
+	size_t MemoryTracker::GetTotalPeakBytes()
+	{
+		size_t Total = 0;
+		for (int i = 0; i < int(MemoryTag::COUNT); i++)
+			Total += GetTagStats(MemoryTag(i)).PeakBytes.load(std::memory_order_relaxed);
+		return Total;
+	}
+
+	void MemoryTracker::Dump()
+	{
+		CH_CORE_INFO("---- Memory Report ----");
+		for (int i = 0; i < int(MemoryTag::COUNT); i++)
+		{
+			auto Stats = GetStats(MemoryTag(i));
+			if (Stats.Budget != 0)
+				CH_CORE_INFO("{0:<14} Live: {1:>9.2f} MB Peak: {2:>9.2f} MB Budget: {3:>9.2f} MB Allocs: {4} Frees: {5}",
+					MemoryTagToString(MemoryTag(i)), BytesToMB(Stats.LiveBytes), BytesToMB(Stats.PeakBytes),
+					BytesToMB(Stats.Budget), Stats.AllocationCount, Stats.FreeCount);
+			else
+				CH_CORE_INFO("{0:<14} Live: {1:>9.2f} MB Peak: {2:>9.2f} MB Allocs: {3} Frees: {4}",
+					MemoryTagToString(MemoryTag(i)), BytesToMB(Stats.LiveBytes), BytesToMB(Stats.PeakBytes),
+					Stats.AllocationCount, Stats.FreeCount);
+		}
+		CH_CORE_INFO("Total Live: {0:.2f} MB", BytesToMB(GetTotalLiveBytes()));
+	}
+
+	void MemoryTracker::ResetPeaks()
+	{
+		for (int i = 0; i < int(MemoryTag::COUNT); i++)
+		{
+			auto& Stats = GetTagStats(MemoryTag(i));
+			Stats.PeakBytes.store(Stats.LiveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+	}
+#endif
+}
@@ -0,0 +1,102 @@
+/*
+	Tagged allocation tracking for engine subsystems.
+	Keeps live and peak bytes per tag, warns when a tag goes over its budget and can dump a report.
+	Everything here compiles away unless CHILLI_ENABLE_MEMORY_TRACKING is true.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+
+namespace Chilli
+{
+	enum class MemoryTag : uint8_t
+	{
+		ECS,
+		ASSETS,
+		RENDERER_CPU,
+		PHYSICS,
+		UI,
+		EVENTS,
+		COUNT
+	};
+
+	struct MemoryTagStats
+	{
+		size_t LiveBytes = 0;
+		size_t PeakBytes = 0;
+		size_t Budget = 0; // 0 means no budget
+		uint64_t AllocationCount = 0;
+		uint64_t FreeCount = 0;
+	};
+
+	const char* MemoryTagToString(MemoryTag Tag);
+
+#if CHILLI_ENABLE_MEMORY_TRACKING == true
+	class MemoryTracker
+	{
+	public:
+		static void OnAlloc(MemoryTag Tag, size_t Size);
+		static void OnFree(MemoryTag Tag, size_t Size);
+
+		static void SetBudget(MemoryTag Tag, size_t Bytes);
+		static MemoryTagStats GetStats(MemoryTag Tag);
+		static size_t GetTotalLiveBytes();
+		static size_t GetTotalPeakBytes();
+
+		// Logs every tag with live/peak/budget
+		static void Dump();
+		static void ResetPeaks();
+	};
+
+	// Stateless std allocator that reports its traffic to the MemoryTracker
+	template<typename T, MemoryTag Tag>
+	struct TrackingAllocator
+	{
+		using value_type = T;
+
+		template<typename U>
+		struct rebind { using other = TrackingAllocator<U, Tag>; };
+
+		TrackingAllocator() noexcept = default;
+		template<typename U>
+		TrackingAllocator(const TrackingAllocator<U, Tag>&) noexcept {}
+
+		T* allocate(size_t Count)
+		{
+			MemoryTracker::OnAlloc(Tag, Count * sizeof(T));
+			return std::allocator<T>().allocate(Count);
+		}
+
+		void deallocate(T* Ptr, size_t Count) noexcept
+		{
+			MemoryTracker::OnFree(Tag, Count * sizeof(T));
+			std::allocator<T>().deallocate(Ptr, Count);
+		}
+
+		template<typename U>
+		bool operator==(const TrackingAllocator<U, Tag>&) const noexcept { return true; }
+		template<typename U>
+		bool operator!=(const TrackingAllocator<U, Tag>&) const noexcept { return false; }
+	};
+
+	template<typename T, MemoryTag Tag>
+	using TrackedVector = std::vector<T, TrackingAllocator<T, Tag>>;
+
+#define CH_MEMORY_TRACK_ALLOC(Tag, Size) ::Chilli::MemoryTracker::OnAlloc(Tag, Size)
+#define CH_MEMORY_TRACK_FREE(Tag, Size)  ::Chilli::MemoryTracker::OnFree(Tag, Size)
+#define CH_MEMORY_SET_BUDGET(Tag, Bytes) ::Chilli::MemoryTracker::SetBudget(Tag, Bytes)
+#define CH_MEMORY_DUMP()                 ::Chilli::MemoryTracker::Dump()
+#else
+	template<typename T, MemoryTag Tag>
+	using TrackedVector = std::vector<T>;
+
+#define CH_MEMORY_TRACK_ALLOC(Tag, Size)
+#define CH_MEMORY_TRACK_FREE(Tag, Size)
+#define CH_MEMORY_SET_BUDGET(Tag, Bytes)
+#define CH_MEMORY_DUMP()
+#endif
+}
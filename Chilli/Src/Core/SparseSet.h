@@ -19,11 +19,12 @@ namespace Chilli
 			if (!_FreeList.empty()) {
 				id = _FreeList.back();
 				_FreeList.pop_back();
+				_FreeSlot[id] = npos;
 			}
 			else {
 				id = NextId++;
 				if (id >= _Sparse.size())
-					_Sparse.resize(id + 1, npos);
+					_Resize(id + 1);
 			}
 
 			_Sparse[id] = static_cast<uint32_t>(_Dense.size());
@@ -50,6 +51,7 @@ namespace Chilli
 			_Dense.pop_back();
 			_Data.pop_back();
 			_Sparse[id] = npos;
+			_FreeSlot[id] = static_cast<uint32_t>(_FreeList.size());
 			_FreeList.push_back(id);
 		}
 
@@ -58,12 +60,15 @@ namespace Chilli
 		void Insert(uint32_t id, const T& val)
 		{
 			if (id >= _Sparse.size())
-				_Sparse.resize(id + 1, npos);
+				_Resize(id + 1);
 
-			// 1. If ID is already in the FreeList, remove it so Create() doesn't reuse it
-			auto it = std::find(_FreeList.begin(), _FreeList.end(), id);
-			if (it != _FreeList.end()) {
-				_FreeList.erase(it);
+			// 1. Take the ID out of the FreeList, its slot there is known so the last entry fills it
+			if (_FreeSlot[id] != npos) {
+				uint32_t lastFree = _FreeList.back();
+				_FreeList[_FreeSlot[id]] = lastFree;
+				_FreeSlot[lastFree] = _FreeSlot[id];
+				_FreeList.pop_back();
+				_FreeSlot[id] = npos;
 			}
 
 			// 2. Advance NextId to prevent future collisions
@@ -102,6 +107,7 @@ namespace Chilli
 			_Dense.clear();
 			_Data.clear();
 			_FreeList.clear();
+			_FreeSlot.clear();
 			NextId = 0;
 		}
 
@@ -122,11 +128,20 @@ namespace Chilli
 		const uint32_t GetActiveCount() const { return static_cast<uint32_t>(_Dense.size()); }
 		const uint32_t GetSparseCount() const { return static_cast<uint32_t>(_Sparse.size()); }
 
+	private:
+		void _Resize(uint32_t count)
+		{
+			_Sparse.resize(count, npos);
+			_FreeSlot.resize(count, npos);
+		}
+
 	private:
 		uint32_t NextId = 0;
 		std::vector<uint32_t> _Sparse;
 		std::vector<uint32_t> _Dense;
 		std::vector<T> _Data;
 		std::vector<uint32_t> _FreeList;
+		// Position of a freed ID in _FreeList, npos while the ID is in use or was never freed
+		std::vector<uint32_t> _FreeSlot;
 	};
 }
@@ -17,7 +17,7 @@ namespace Chilli
 
 		// Internal Copy (GPU -> GPU)
 		STATIC_COPY,   // GPU writes once, GPU reads
-		DYNAMIC_COPY   // GPU writes often, GPU reads
+		DYNAMIC_COPY   // GPU writes often, GPU reads, CPU rewrites go through the frame staging ring
 	};
 
 	enum class IndexBufferType
@@ -35,7 +35,8 @@ namespace Chilli
 		BUFFER_TYPE_STORAGE = 1 << 2,
 		BUFFER_TYPE_UNIFORM = 1 << 3,
 		BUFFER_TYPE_TRANSFER_DST = 1 << 4,
-		BUFFER_TYPE_TRANSFER_SRC = 1 << 5
+		BUFFER_TYPE_TRANSFER_SRC = 1 << 5,
+		BUFFER_TYPE_INDIRECT = 1 << 6
 	};
 
 	struct BufferCreateInfo
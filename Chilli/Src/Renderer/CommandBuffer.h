@@ -3,13 +3,23 @@
 #include "RenderCore.h"
 #include "Pipeline.h"
 #include "RenderPass.h"
+#include "Profiling/MemoryTracker.h"
+#include "MemoryArena.h"
 
 namespace Chilli
 {
+	enum RenderCommandFlags : uint16_t
+	{
+		// The inline payload is a pointer to the real one, used once a payload is too large for a page
+		RENDER_COMMAND_FLAG_BLOB = 1 << 0,
+	};
+
 	struct RenderCommandHeader
 	{
 		RenderOpCode Code;
-		uint16_t Size;
+		uint16_t Flags;
+		// Size of the payload itself, excluding padding and wherever it lives
+		uint32_t Size;
 	};
 
 	struct CopyBufferCmdPayload
@@ -26,6 +36,8 @@ namespace Chilli
 	{
 		uint32_t MaterialHandle = UINT32_MAX;
 		char Name[SHADER_UNIFORM_BINDING_NAME_SIZE] = { 0 };
+		// Used instead of Name when valid
+		MaterialBindingSlot Slot;
 		uint32_t DstArrayIndex = UINT32_MAX;
 
 		bool Persistent = false;
@@ -48,12 +60,12 @@ namespace Chilli
 		uint32_t RawMaterialHandle = UINT32_MAX;
 	};
 
+	// Per batch, objects are found through gl_InstanceIndex and the instance index buffer
 	struct DrawPushShaderInlineUniformData
 	{
-		uint32_t ObjectIndex;
 		uint32_t MaterialIndex;
 		uint32_t SceneIndex;
-		uint32_t Padding = { 0 };
+		uint32_t Padding[2] = { 0, 0 };
 	};
 
 	struct PushShaderInlineUniformDataCmdPayload
@@ -211,20 +223,162 @@ namespace Chilli
 		return payload;
 	}
 
-	struct RenderCommandBuffer
+	// Every command starts on this boundary so payloads can be read in place
+	constexpr uint32_t CH_RENDER_COMMAND_ALIGNMENT = 8;
+	constexpr uint32_t CH_RENDER_COMMAND_PAGE_SIZE = 64 * 1024;
+
+	inline constexpr uint32_t AlignRenderCommandSize(uint32_t Size)
 	{
-	protected:
-		std::vector<uint8_t> _Stream;
+		return (Size + CH_RENDER_COMMAND_ALIGNMENT - 1) & ~(CH_RENDER_COMMAND_ALIGNMENT - 1);
+	}
+
+	// Fixed size block of encoded commands, the commands follow the struct directly. Pages of a
+	// stream are chained and a command never crosses a page
+	struct alignas(CH_RENDER_COMMAND_ALIGNMENT) RenderCommandPage
+	{
+		RenderCommandPage* Next = nullptr;
+		uint32_t Used = 0;
+
+		inline uint8_t* Data() { return reinterpret_cast<uint8_t*>(this + 1); }
+		inline const uint8_t* Data() const { return reinterpret_cast<const uint8_t*>(this + 1); }
+	};
+
+	constexpr uint32_t CH_RENDER_COMMAND_PAGE_CAPACITY = CH_RENDER_COMMAND_PAGE_SIZE - sizeof(RenderCommandPage);
+	// Larger payloads go to a blob so a page never ends with a big unused tail
+	constexpr uint32_t CH_RENDER_COMMAND_MAX_INLINE_PAYLOAD = CH_RENDER_COMMAND_PAGE_CAPACITY / 4;
+
+	// Hands out command pages, carved from a MemoryArena while it has room and from the heap after.
+	// Pages are recycled but never given back, so streams stop allocating once they reached their peak.
+	// Not thread safe, streams are only ever encoded on the thread that owns the pool.
+	class RenderCommandPagePool
+	{
+	public:
+		RenderCommandPagePool() {}
+		~RenderCommandPagePool() { Free(); }
+
+		RenderCommandPagePool(const RenderCommandPagePool&) = delete;
+		RenderCommandPagePool& operator=(const RenderCommandPagePool&) = delete;
+
+		// Pool shared by every stream not given one, pages only ever come from the heap
+		static RenderCommandPagePool& Default()
+		{
+			static RenderCommandPagePool Pool;
+			return Pool;
+		}
+
+		inline void Init(MemoryArena& Arena, uint32_t PageCount)
+		{
+			for (uint32_t i = 0; i < PageCount; i++)
+			{
+				void* Memory = Arena.Alloc(CH_RENDER_COMMAND_PAGE_SIZE);
+				if (Memory == nullptr)
+					break;
+				_Push(new (Memory) RenderCommandPage());
+			}
+		}
+
+		inline RenderCommandPage* Acquire()
+		{
+			if (_FreePages == nullptr)
+			{
+				void* Memory = malloc(CH_RENDER_COMMAND_PAGE_SIZE);
+				CH_MEMORY_TRACK_ALLOC(MemoryTag::RENDERER_CPU, CH_RENDER_COMMAND_PAGE_SIZE);
+				_HeapPages.push_back(Memory);
+				return new (Memory) RenderCommandPage();
+			}
+
+			RenderCommandPage* Page = _FreePages;
+			_FreePages = Page->Next;
+			Page->Next = nullptr;
+			Page->Used = 0;
+			return Page;
+		}
+
+		// Takes back a whole chain
+		inline void Release(RenderCommandPage* First)
+		{
+			while (First != nullptr)
+			{
+				RenderCommandPage* Next = First->Next;
+				_Push(First);
+				First = Next;
+			}
+		}
+
+		inline void Free()
+		{
+			for (void* Memory : _HeapPages)
+			{
+				free(Memory);
+				CH_MEMORY_TRACK_FREE(MemoryTag::RENDERER_CPU, CH_RENDER_COMMAND_PAGE_SIZE);
+			}
+			_HeapPages.clear();
+			_FreePages = nullptr;
+		}
+
+		inline uint32_t GetHeapPageCount() const { return uint32_t(_HeapPages.size()); }
+
+	private:
+		inline void _Push(RenderCommandPage* Page)
+		{
+			Page->Next = _FreePages;
+			_FreePages = Page;
+		}
+
+	private:
+		RenderCommandPage* _FreePages = nullptr;
+		std::vector<void*> _HeapPages;
+	};
+
+	struct RenderCommand
+	{
+		RenderOpCode Code;
+		uint32_t Size;
+		const uint8_t* Payload;
+	};
+
+	class RenderCommandReader;
 
+	struct RenderCommandBuffer
+	{
 	public:
+		RenderCommandBuffer(RenderCommandPagePool* Pool = nullptr)
+			: _Pool(Pool != nullptr ? Pool : &RenderCommandPagePool::Default()) {}
+		~RenderCommandBuffer() { _ReleaseMemory(); }
+
+		RenderCommandBuffer(const RenderCommandBuffer& Other) : _Pool(Other._Pool) { PushCommandBuffer(Other); }
+		RenderCommandBuffer(RenderCommandBuffer&& Other) noexcept { _Steal(Other); }
+
+		RenderCommandBuffer& operator=(const RenderCommandBuffer& Other)
+		{
+			if (this != &Other)
+			{
+				Clear();
+				PushCommandBuffer(Other);
+			}
+			return *this;
+		}
+
+		RenderCommandBuffer& operator=(RenderCommandBuffer&& Other) noexcept
+		{
+			if (this != &Other)
+			{
+				_ReleaseMemory();
+				_Steal(Other);
+			}
+			return *this;
+		}
+
+		// Only valid while the buffer is empty, the pages already owned go back to the old pool
+		void SetPagePool(RenderCommandPagePool* Pool)
+		{
+			_ReleaseMemory();
+			_Pool = Pool != nullptr ? Pool : &RenderCommandPagePool::Default();
+		}
+
 		template<typename T>
 		void PushCommand(RenderOpCode op, const T& payload) {
-			RenderCommandHeader header{ op, (uint16_t)sizeof(T) };
-			size_t current_size = _Stream.size();
-			_Stream.resize(current_size + sizeof(header) + sizeof(T));
-
-			memcpy(&_Stream[current_size], &header, sizeof(header));
-			memcpy(&_Stream[current_size + sizeof(header)], &payload, sizeof(T));
+			memcpy(_AllocateCommand(op, sizeof(T)), &payload, sizeof(T));
 		}
 
 		void PushCopyBuffer(uint32_t Src, uint32_t Dst, uint32_t Size, uint32_t SrcOffset = 0,
@@ -241,18 +395,8 @@ namespace Chilli
 
 		void PushInlineUniformData(uint32_t ShaderProgram, uint32_t Stage, void* Data, uint32_t Size, uint32_t Offset)
 		{
-			size_t current_size = _Stream.size();
-			const uint16_t payload_size = sizeof(PushShaderInlineUniformDataCmdPayload) + (Size);
-
-			// Write Header
-			RenderCommandHeader header{ RenderOpCode::PUSH_SHADER_INLINE_UNIFORM_DATA, payload_size };
-			_Stream.resize(current_size + sizeof(header) + payload_size);
-
-			uint8_t* Dst = _Stream.data() + current_size;
-
-			memcpy(Dst, &header, sizeof(header));
-
-			Dst += sizeof(header);
+			const uint32_t payload_size = sizeof(PushShaderInlineUniformDataCmdPayload) + (Size);
+			uint8_t* Dst = _AllocateCommand(RenderOpCode::PUSH_SHADER_INLINE_UNIFORM_DATA, payload_size);
 
 			PushShaderInlineUniformDataCmdPayload Payload;
 			Payload.ShaderProgram = ShaderProgram;
@@ -308,20 +452,55 @@ namespace Chilli
 			PushCommand<MaterialDataUpdateCmdPayload>(RenderOpCode::UPDATE_MATERIL_DATA, Info);
 		}
 
-		void BindMaterailData(uint32_t MaterialHandle)
+		void UpdateMaterialBufferData(uint32_t MaterialHandle, uint32_t Buffer,
+			MaterialBindingSlot Slot, size_t Size, size_t Offset, uint32_t DstArrayIndex = 0)
 		{
-			PushCommand<BindMaterialDataCmdPayload>(RenderOpCode::BIND_MATERIAL_DATA, { MaterialHandle });
+			MaterialDataUpdateCmdPayload Info{};
+			Info.MaterialHandle = MaterialHandle;
+			Info.DstArrayIndex = DstArrayIndex;
+			Info.Slot = Slot;
+			Info.Persistent = false;
+			Info.BufferInfo.Handle = Buffer;
+			Info.BufferInfo.Range = Size;
+			Info.BufferInfo.Offset = Offset;
+
+			PushCommand<MaterialDataUpdateCmdPayload>(RenderOpCode::UPDATE_MATERIL_DATA, Info);
+		}
+
+		void UpdateMaterialTextureData(uint32_t MaterialHandle,
+			uint32_t Tex, MaterialBindingSlot Slot, ResourceState State, uint32_t DstArrayIndex = 0)
+		{
+			MaterialDataUpdateCmdPayload Info{};
+			Info.MaterialHandle = MaterialHandle;
+			Info.DstArrayIndex = DstArrayIndex;
+			Info.Slot = Slot;
+			Info.Persistent = false;
+			Info.ImageInfo.Handle = Tex;
+			Info.ImageInfo.State = State;
+
+			PushCommand<MaterialDataUpdateCmdPayload>(RenderOpCode::UPDATE_MATERIL_DATA, Info);
 		}
 
-		void PushCommandBuffer(const RenderCommandBuffer& other) {
-			if (other._Stream.empty()) return;
+		void UpdateMaterialSamplerData(uint32_t MaterialHandle, uint32_t Sampler, MaterialBindingSlot Slot,
+			uint32_t DstArrayIndex = 0)
+		{
+			MaterialDataUpdateCmdPayload Info{};
+			Info.MaterialHandle = MaterialHandle;
+			Info.DstArrayIndex = DstArrayIndex;
+			Info.Slot = Slot;
+			Info.Persistent = false;
+			Info.ImageInfo.Sampler = Sampler;
+
+			PushCommand<MaterialDataUpdateCmdPayload>(RenderOpCode::UPDATE_MATERIL_DATA, Info);
+		}
 
-			// This is a high-speed bulk memory copy
-			size_t current_size = _Stream.size();
-			_Stream.resize(current_size + other._Stream.size());
-			memcpy(&_Stream[current_size], other._Stream.data(), other._Stream.size());
+		void BindMaterailData(uint32_t MaterialHandle)
+		{
+			PushCommand<BindMaterialDataCmdPayload>(RenderOpCode::BIND_MATERIAL_DATA, { MaterialHandle });
 		}
 
+		void PushCommandBuffer(const RenderCommandBuffer& other);
+
 		void PushImagePipelineBarrier(
 			uint32_t TextureHandle,
 			bool IsSwapChain,
@@ -355,18 +534,8 @@ namespace Chilli
 
 		void PushPipelineBarriers(const PipelineBarrier* Barriers, uint8_t BarrierCount)
 		{
-			size_t current_size = _Stream.size();
-			const uint16_t payload_size = sizeof(PipelineBarrierCmdPayload) + (sizeof(PipelineBarrier) * BarrierCount);
-
-			// Write Header
-			RenderCommandHeader header{ RenderOpCode::PIPELINE_BARRIER, payload_size };
-			_Stream.resize(current_size + sizeof(header) + payload_size);
-
-			uint8_t* Dst = _Stream.data() + current_size;
-
-			memcpy(Dst, &header, sizeof(header));
-
-			Dst += sizeof(header);
+			const uint32_t payload_size = sizeof(PipelineBarrierCmdPayload) + (sizeof(PipelineBarrier) * BarrierCount);
+			uint8_t* Dst = _AllocateCommand(RenderOpCode::PIPELINE_BARRIER, payload_size);
 
 			PipelineBarrierCmdPayload BarrierPayload;
 			BarrierPayload.BarriersCount = BarrierCount;
@@ -378,11 +547,210 @@ namespace Chilli
 			memcpy(Dst, Barriers, sizeof(PipelineBarrier) * BarrierCount);
 		}
 
-		void Clear() { _Stream.clear(); }
-		const uint8_t* Data() const { return _Stream.data(); }
-		size_t Size() const { return _Stream.size(); }
+		// Keeps every page and blob for the next recording
+		void Clear()
+		{
+			for (RenderCommandPage* Page = _FirstPage; Page != nullptr; Page = Page->Next)
+				Page->Used = 0;
+			_CurrentPage = _FirstPage;
+			_Size = 0;
+			_CommandCount = 0;
+			_BlobCount = 0;
+		}
+
+		// Encoded bytes including headers and padding
+		size_t Size() const { return _Size; }
+		bool Empty() const { return _CommandCount == 0; }
+		uint32_t GetCommandCount() const { return _CommandCount; }
+
+	protected:
+		// Writes the header and returns where the payload's PayloadSize bytes go
+		inline uint8_t* _AllocateCommand(RenderOpCode Op, uint32_t PayloadSize)
+		{
+			_CommandCount++;
+			if (PayloadSize <= CH_RENDER_COMMAND_MAX_INLINE_PAYLOAD)
+			{
+				uint8_t* Dst = _Reserve(sizeof(RenderCommandHeader) + AlignRenderCommandSize(PayloadSize));
+				RenderCommandHeader Header{ Op, 0, PayloadSize };
+				memcpy(Dst, &Header, sizeof(Header));
+				return Dst + sizeof(Header);
+			}
+
+			uint8_t* Blob = _AllocateBlob(PayloadSize);
+			uint8_t* Dst = _Reserve(sizeof(RenderCommandHeader) + AlignRenderCommandSize(sizeof(uint8_t*)));
+			RenderCommandHeader Header{ Op, RENDER_COMMAND_FLAG_BLOB, PayloadSize };
+			memcpy(Dst, &Header, sizeof(Header));
+			memcpy(Dst + sizeof(Header), &Blob, sizeof(Blob));
+			return Blob;
+		}
+
+	private:
+		struct BlobAllocation
+		{
+			uint8_t* Data = nullptr;
+			uint32_t Capacity = 0;
+		};
+
+		inline uint8_t* _Reserve(uint32_t Size)
+		{
+			if (_CurrentPage == nullptr || _CurrentPage->Used + Size > CH_RENDER_COMMAND_PAGE_CAPACITY)
+				_NextPage();
+
+			uint8_t* Dst = _CurrentPage->Data() + _CurrentPage->Used;
+			_CurrentPage->Used += Size;
+			_Size += Size;
+			return Dst;
+		}
+
+		inline void _NextPage()
+		{
+			// Pages kept from earlier recordings come first
+			if (_CurrentPage != nullptr && _CurrentPage->Next != nullptr)
+			{
+				_CurrentPage = _CurrentPage->Next;
+				return;
+			}
+
+			RenderCommandPage* Page = _Pool->Acquire();
+			if (_CurrentPage == nullptr)
+				_FirstPage = Page;
+			else
+				_CurrentPage->Next = Page;
+			_CurrentPage = Page;
+		}
+
+		inline uint8_t* _AllocateBlob(uint32_t Size)
+		{
+			if (_BlobCount == _Blobs.size())
+				_Blobs.emplace_back();
+
+			auto& Entry = _Blobs[_BlobCount++];
+			if (Entry.Capacity < Size)
+			{
+				if (Entry.Data != nullptr)
+				{
+					free(Entry.Data);
+					CH_MEMORY_TRACK_FREE(MemoryTag::RENDERER_CPU, Entry.Capacity);
+				}
+				Entry.Data = (uint8_t*)malloc(Size);
+				Entry.Capacity = Size;
+				CH_MEMORY_TRACK_ALLOC(MemoryTag::RENDERER_CPU, Entry.Capacity);
+			}
+			return Entry.Data;
+		}
+
+		inline void _ReleaseMemory()
+		{
+			if (_Pool != nullptr)
+				_Pool->Release(_FirstPage);
+			for (auto& Entry : _Blobs)
+			{
+				free(Entry.Data);
+				CH_MEMORY_TRACK_FREE(MemoryTag::RENDERER_CPU, Entry.Capacity);
+			}
+			_Blobs.clear();
+			_FirstPage = _CurrentPage = nullptr;
+			_Size = 0;
+			_CommandCount = 0;
+			_BlobCount = 0;
+		}
+
+		inline void _Steal(RenderCommandBuffer& Other)
+		{
+			_Pool = Other._Pool;
+			_FirstPage = Other._FirstPage;
+			_CurrentPage = Other._CurrentPage;
+			_Size = Other._Size;
+			_CommandCount = Other._CommandCount;
+			_Blobs = std::move(Other._Blobs);
+			_BlobCount = Other._BlobCount;
+
+			Other._FirstPage = Other._CurrentPage = nullptr;
+			Other._Size = 0;
+			Other._CommandCount = 0;
+			Other._Blobs.clear();
+			Other._BlobCount = 0;
+		}
+
+	private:
+		RenderCommandPagePool* _Pool = nullptr;
+		RenderCommandPage* _FirstPage = nullptr;
+		RenderCommandPage* _CurrentPage = nullptr;
+		size_t _Size = 0;
+		uint32_t _CommandCount = 0;
+
+		std::vector<BlobAllocation> _Blobs;
+		uint32_t _BlobCount = 0;
+
+		friend class RenderCommandReader;
+	};
+
+	// Walks a stream in recording order. Blob payloads are resolved, Payload always points at Size bytes
+	class RenderCommandReader
+	{
+	public:
+		RenderCommandReader(const RenderCommandBuffer& Buffer) : _Page(Buffer._FirstPage) {}
+
+		inline bool Next(RenderCommand& Out)
+		{
+			// Pages past the last used one were emptied by Clear
+			while (_Page != nullptr && _Offset >= _Page->Used)
+			{
+				_Page = _Page->Next;
+				_Offset = 0;
+			}
+			if (_Page == nullptr)
+				return false;
+
+			const uint8_t* Src = _Page->Data() + _Offset;
+			RenderCommandHeader Header;
+			memcpy(&Header, Src, sizeof(Header));
+			Src += sizeof(Header);
+
+			Out.Code = Header.Code;
+			Out.Size = Header.Size;
+			if (Header.Flags & RENDER_COMMAND_FLAG_BLOB)
+			{
+				memcpy(&Out.Payload, Src, sizeof(Out.Payload));
+				_Offset += sizeof(Header) + AlignRenderCommandSize(sizeof(uint8_t*));
+			}
+			else
+			{
+				Out.Payload = Src;
+				_Offset += sizeof(Header) + AlignRenderCommandSize(Header.Size);
+			}
+			return true;
+		}
+
+	private:
+		const RenderCommandPage* _Page = nullptr;
+		uint32_t _Offset = 0;
 	};
 
+	inline void RenderCommandBuffer::PushCommandBuffer(const RenderCommandBuffer& other)
+	{
+		if (other.Empty())
+			return;
+
+		// Without blobs whole pages are copied in bulk, commands never cross a page so each fits a fresh one
+		if (other._BlobCount == 0)
+		{
+			for (const RenderCommandPage* Page = other._FirstPage; Page != nullptr && Page->Used > 0; Page = Page->Next)
+			{
+				memcpy(_Reserve(Page->Used), Page->Data(), Page->Used);
+				if (Page == other._CurrentPage)
+					break;
+			}
+			_CommandCount += other._CommandCount;
+			return;
+		}
+
+		RenderCommandReader Reader(other);
+		RenderCommand Command;
+		while (Reader.Next(Command))
+			memcpy(_AllocateCommand(Command.Code, Command.Size), Command.Payload, Command.Size);
+	}
+
 	struct BeginFrameCmdPayload
 	{
 		uint32_t FrameIndex;
@@ -391,6 +759,9 @@ namespace Chilli
 	struct BeginRenderPassCmdPayload
 	{
 		RenderPassDesc Pass;
+		// Index into RenderFramePacket::Pass_Streams holding the pass's commands, which the backend
+		// records into their own secondary command buffer. UINT32_MAX keeps them inline in this stream
+		uint32_t PassStream = UINT32_MAX;
 	};
 
 	struct EndRenderPassCmdPayload
@@ -428,6 +799,31 @@ namespace Chilli
 		uint32_t FirstInstance; // ID of the first instance to draw
 	};
 
+	// Same layout as VkDrawIndexedIndirectCommand, this is what indirect buffers hold
+	struct DrawIndexedIndirectCommand {
+		uint32_t IndexCount;
+		uint32_t InstanceCount;
+		uint32_t FirstIndex;
+		int32_t  VertexOffset;
+		uint32_t FirstInstance;
+	};
+
+	struct DrawIndexedIndirectCmdPayload {
+		uint32_t Buffer = UINT32_MAX;  // Buffer holding DrawIndexedIndirectCommand's
+		uint32_t Offset = 0;          // Byte offset of the first command
+		uint32_t DrawCount = 0;
+		uint32_t Stride = sizeof(DrawIndexedIndirectCommand);
+	};
+
+	struct DrawIndexedIndirectCountCmdPayload {
+		uint32_t Buffer = UINT32_MAX;
+		uint32_t Offset = 0;
+		uint32_t CountBuffer = UINT32_MAX; // Buffer holding a single uint32_t draw count written by the GPU
+		uint32_t CountOffset = 0;
+		uint32_t MaxDrawCount = 0;
+		uint32_t Stride = sizeof(DrawIndexedIndirectCommand);
+	};
+
 	struct DrawArrayCmdPayload {
 		uint32_t ElementCount;    // Number of indices to draw
 		uint32_t InstanceCount; // Number of instances to draw (1 if not instancing)
@@ -529,8 +925,7 @@ namespace Chilli
 	class GraphicsCommandBuffer : public RenderCommandBuffer
 	{
 	public:
-		GraphicsCommandBuffer() {}
-		~GraphicsCommandBuffer() {}
+		GraphicsCommandBuffer(RenderCommandPagePool* Pool = nullptr) : RenderCommandBuffer(Pool) {}
 
 		void BeginFrame(uint32_t FrameIndex)
 		{
@@ -552,9 +947,9 @@ namespace Chilli
 			PushCommand<ResolveImageCmdPayload>(RenderOpCode::RESOLVE_IMAGE, Payload);
 		}
 
-		void BeginRenderPass(const RenderPassDesc& Pass)
+		void BeginRenderPass(const RenderPassDesc& Pass, uint32_t PassStream = UINT32_MAX)
 		{
-			PushCommand<BeginRenderPassCmdPayload>(RenderOpCode::BEGIN_RENDER_PASS, { Pass });
+			PushCommand<BeginRenderPassCmdPayload>(RenderOpCode::BEGIN_RENDER_PASS, { Pass, PassStream });
 		}
 
 		void EndRenderPass()
@@ -599,18 +994,8 @@ namespace Chilli
 				AttribsCount += Binding.Attribs.size();
 			}
 
-			size_t current_size = _Stream.size();
-			const uint16_t payload_size = sizeof(SetVertexLayoutCmdPayload) + LayoutBindingSize;
-
-			// Write Header
-			RenderCommandHeader header{ RenderOpCode::SET_VERTEX_LAYOUT, payload_size };
-			_Stream.resize(current_size + sizeof(header) + payload_size);
-
-			uint8_t* Dst = _Stream.data() + current_size;
-
-			memcpy(Dst, &header, sizeof(header));
-
-			Dst += sizeof(header);
+			const uint32_t payload_size = sizeof(SetVertexLayoutCmdPayload) + LayoutBindingSize;
+			uint8_t* Dst = _AllocateCommand(RenderOpCode::SET_VERTEX_LAYOUT, payload_size);
 
 			SetVertexLayoutCmdPayload Payload;
 			Payload.AttribsCount = AttribsCount;
@@ -723,18 +1108,8 @@ namespace Chilli
 		void BindVertexBuffer(uint32_t* Buffers, uint32_t BindingCount)
 		{
 			const uint8_t Count = BindingCount;
-			size_t current_size = _Stream.size();
-			const uint16_t payload_size = sizeof(BindVertexBuffersCmdPayload) + (sizeof(uint32_t) * Count);
-
-			// Write Header
-			RenderCommandHeader header{ RenderOpCode::BIND_VERTEX_BUFFERS, payload_size };
-			_Stream.resize(current_size + sizeof(header) + payload_size);
-
-			uint8_t* Dst = _Stream.data() + current_size;
-
-			memcpy(Dst, &header, sizeof(header));
-
-			Dst += sizeof(header);
+			const uint32_t payload_size = sizeof(BindVertexBuffersCmdPayload) + (sizeof(uint32_t) * Count);
+			uint8_t* Dst = _AllocateCommand(RenderOpCode::BIND_VERTEX_BUFFERS, payload_size);
 
 			BindVertexBuffersCmdPayload BufferPayload;
 			BufferPayload.VertexBufferCount = BindingCount;
@@ -749,18 +1124,8 @@ namespace Chilli
 		void BindVertexBuffer(const std::vector<uint32_t>& Buffers)
 		{
 			const uint8_t Count = Buffers.size();
-			size_t current_size = _Stream.size();
-			const uint16_t payload_size = sizeof(BindVertexBuffersCmdPayload) + (sizeof(uint32_t) * Count);
-
-			// Write Header
-			RenderCommandHeader header{ RenderOpCode::BIND_VERTEX_BUFFERS, payload_size };
-			_Stream.resize(current_size + sizeof(header) + payload_size);
-
-			uint8_t* Dst = _Stream.data() + current_size;
-
-			memcpy(Dst, &header, sizeof(header));
-
-			Dst += sizeof(header);
+			const uint32_t payload_size = sizeof(BindVertexBuffersCmdPayload) + (sizeof(uint32_t) * Count);
+			uint8_t* Dst = _AllocateCommand(RenderOpCode::BIND_VERTEX_BUFFERS, payload_size);
 
 			BindVertexBuffersCmdPayload BufferPayload;
 			BufferPayload.VertexBufferCount = Buffers.size();
@@ -788,6 +1153,30 @@ namespace Chilli
 			PushCommand<DrawIndexedCmdPayload>(RenderOpCode::DRAW_INDEXED, Payload);
 		}
 
+		void DrawIndexedIndirect(uint32_t Buffer, uint32_t Offset, uint32_t DrawCount,
+			uint32_t Stride = sizeof(DrawIndexedIndirectCommand))
+		{
+			DrawIndexedIndirectCmdPayload Payload;
+			Payload.Buffer = Buffer;
+			Payload.Offset = Offset;
+			Payload.DrawCount = DrawCount;
+			Payload.Stride = Stride;
+			PushCommand<DrawIndexedIndirectCmdPayload>(RenderOpCode::DRAW_INDEXED_INDIRECT, Payload);
+		}
+
+		void DrawIndexedIndirectCount(uint32_t Buffer, uint32_t Offset, uint32_t CountBuffer, uint32_t CountOffset,
+			uint32_t MaxDrawCount, uint32_t Stride = sizeof(DrawIndexedIndirectCommand))
+		{
+			DrawIndexedIndirectCountCmdPayload Payload;
+			Payload.Buffer = Buffer;
+			Payload.Offset = Offset;
+			Payload.CountBuffer = CountBuffer;
+			Payload.CountOffset = CountOffset;
+			Payload.MaxDrawCount = MaxDrawCount;
+			Payload.Stride = Stride;
+			PushCommand<DrawIndexedIndirectCountCmdPayload>(RenderOpCode::DRAW_INDEXED_INDIRECT_COUNT, Payload);
+		}
+
 		void DrawArray(uint32_t ElementCount, uint32_t InstanceCount, uint32_t FirstElement, uint32_t VertexOffset, uint32_t FirstInstance)
 		{
 			DrawArrayCmdPayload Payload;
@@ -822,8 +1211,7 @@ namespace Chilli
 	class ComputeCommandBuffer : public RenderCommandBuffer
 	{
 	public:
-		ComputeCommandBuffer() {}
-		~ComputeCommandBuffer() {}
+		ComputeCommandBuffer(RenderCommandPagePool* Pool = nullptr) : RenderCommandBuffer(Pool) {}
 
 		void BindShaderPrgoram(uint32_t Program)
 		{
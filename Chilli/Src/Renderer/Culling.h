@@ -0,0 +1,291 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <cfloat>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "Maths.h"
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define CH_CULLING_SSE 1
+#include <xmmintrin.h>
+#else
+#define CH_CULLING_SSE 0
+#endif
+
+namespace Chilli
+{
+	// Local space bounds of a mesh, computed once when the mesh is created
+	struct MeshBounds
+	{
+		Vec3 Min{ 0.0f };
+		Vec3 Max{ 0.0f };
+		Vec3 Center{ 0.0f };
+		float Radius = 0.0f;
+		// Meshes created without vertex data (filled later) have no bounds and are never culled
+		bool IsValid = false;
+
+		// Positions are expected to be 3 floats at PositionOffset inside each Stride sized vertex
+		static MeshBounds FromPositions(const void* Vertices, uint32_t VertexCount, uint32_t Stride,
+			uint32_t PositionOffset = 0)
+		{
+			MeshBounds Bounds;
+			if (Vertices == nullptr || VertexCount == 0 || Stride < PositionOffset + sizeof(float) * 3)
+				return Bounds;
+
+			const uint8_t* Src = (const uint8_t*)Vertices + PositionOffset;
+
+			Bounds.Min = Vec3(FLT_MAX);
+			Bounds.Max = Vec3(-FLT_MAX);
+			for (uint32_t i = 0; i < VertexCount; i++, Src += Stride)
+			{
+				const float* P = (const float*)Src;
+				Bounds.Min = Vec3(std::fmin(Bounds.Min.x, P[0]), std::fmin(Bounds.Min.y, P[1]), std::fmin(Bounds.Min.z, P[2]));
+				Bounds.Max = Vec3(std::fmax(Bounds.Max.x, P[0]), std::fmax(Bounds.Max.y, P[1]), std::fmax(Bounds.Max.z, P[2]));
+			}
+
+			Bounds.Center = Vec3((Bounds.Min.x + Bounds.Max.x) * 0.5f, (Bounds.Min.y + Bounds.Max.y) * 0.5f,
+				(Bounds.Min.z + Bounds.Max.z) * 0.5f);
+
+			// Second pass so the sphere is around the box center and tighter than the box's own sphere
+			float RadiusSq = 0.0f;
+			Src = (const uint8_t*)Vertices + PositionOffset;
+			for (uint32_t i = 0; i < VertexCount; i++, Src += Stride)
+			{
+				const float* P = (const float*)Src;
+				float X = P[0] - Bounds.Center.x, Y = P[1] - Bounds.Center.y, Z = P[2] - Bounds.Center.z;
+				RadiusSq = std::fmax(RadiusSq, X * X + Y * Y + Z * Z);
+			}
+
+			Bounds.Radius = std::sqrt(RadiusSq);
+			Bounds.IsValid = true;
+			return Bounds;
+		}
+	};
+
+	// One draw handed to the culling compute shader (CullDrawInput in cull.comp), the world bounds are
+	// computed on the GPU from the object's transform
+	struct GpuCullDrawInput
+	{
+		float Center[3];
+		// Negative for meshes without bounds, those are never culled
+		float Radius;
+		float Extent[3];
+		float Padding0;
+		uint32_t ObjectIndex;
+		uint32_t BatchIndex;
+		uint32_t BatchFirst;
+		uint32_t IndexCount;
+		uint32_t FirstIndex;
+		int32_t VertexOffset;
+		uint32_t Padding1[2];
+
+		static GpuCullDrawInput Make(const MeshBounds& Bounds, uint32_t ObjectIndex, uint32_t BatchIndex,
+			uint32_t BatchFirst, uint32_t IndexCount, uint32_t FirstIndex, int32_t VertexOffset)
+		{
+			GpuCullDrawInput Input{};
+			if (Bounds.IsValid)
+			{
+				Input.Center[0] = Bounds.Center.x; Input.Center[1] = Bounds.Center.y; Input.Center[2] = Bounds.Center.z;
+				Input.Extent[0] = (Bounds.Max.x - Bounds.Min.x) * 0.5f;
+				Input.Extent[1] = (Bounds.Max.y - Bounds.Min.y) * 0.5f;
+				Input.Extent[2] = (Bounds.Max.z - Bounds.Min.z) * 0.5f;
+				Input.Radius = Bounds.Radius;
+			}
+			else
+				Input.Radius = -1.0f;
+
+			Input.ObjectIndex = ObjectIndex;
+			Input.BatchIndex = BatchIndex;
+			Input.BatchFirst = BatchFirst;
+			Input.IndexCount = IndexCount;
+			Input.FirstIndex = FirstIndex;
+			Input.VertexOffset = VertexOffset;
+			return Input;
+		}
+	};
+	static_assert(sizeof(GpuCullDrawInput) == 64, "GpuCullDrawInput must match the std430 layout in cull.comp");
+
+	// Six normalized planes, inside is Dot(Normal, P) + D >= 0
+	struct Frustum
+	{
+		enum { PLANE_LEFT, PLANE_RIGHT, PLANE_BOTTOM, PLANE_TOP, PLANE_NEAR, PLANE_FAR, PLANE_COUNT };
+		glm::vec4 Planes[PLANE_COUNT];
+
+		// Gribb/Hartmann extraction, works for the -1..1 depth range glm uses by default
+		static Frustum FromViewProj(const glm::mat4& ViewProj)
+		{
+			glm::vec4 Row0(ViewProj[0][0], ViewProj[1][0], ViewProj[2][0], ViewProj[3][0]);
+			glm::vec4 Row1(ViewProj[0][1], ViewProj[1][1], ViewProj[2][1], ViewProj[3][1]);
+			glm::vec4 Row2(ViewProj[0][2], ViewProj[1][2], ViewProj[2][2], ViewProj[3][2]);
+			glm::vec4 Row3(ViewProj[0][3], ViewProj[1][3], ViewProj[2][3], ViewProj[3][3]);
+
+			Frustum Out;
+			Out.Planes[PLANE_LEFT] = Row3 + Row0;
+			Out.Planes[PLANE_RIGHT] = Row3 - Row0;
+			Out.Planes[PLANE_BOTTOM] = Row3 + Row1;
+			Out.Planes[PLANE_TOP] = Row3 - Row1;
+			Out.Planes[PLANE_NEAR] = Row3 + Row2;
+			Out.Planes[PLANE_FAR] = Row3 - Row2;
+
+			for (auto& Plane : Out.Planes)
+			{
+				float Length = glm::length(glm::vec3(Plane));
+				if (Length > 0.0f)
+					Plane /= Length;
+			}
+			return Out;
+		}
+	};
+
+	// World space bounds stored as structure of arrays so four objects are tested per SSE instruction.
+	// An object is rejected when either its box or its sphere is fully behind one plane.
+	class FrustumCuller
+	{
+	public:
+		inline void Clear()
+		{
+			_CenterX.clear(); _CenterY.clear(); _CenterZ.clear();
+			_ExtentX.clear(); _ExtentY.clear(); _ExtentZ.clear();
+			_Radius.clear();
+		}
+
+		inline void Reserve(size_t Count)
+		{
+			_CenterX.reserve(Count); _CenterY.reserve(Count); _CenterZ.reserve(Count);
+			_ExtentX.reserve(Count); _ExtentY.reserve(Count); _ExtentZ.reserve(Count);
+			_Radius.reserve(Count);
+		}
+
+		inline size_t Size() const { return _Radius.size(); }
+
+		// Transforms the local bounds by World and appends them, returns the index to read visibility from
+		uint32_t Push(const MeshBounds& Local, const glm::mat4& World)
+		{
+			uint32_t Index = uint32_t(_Radius.size());
+
+			if (!Local.IsValid)
+			{
+				// Centered on the object with infinite size, never rejected
+				_Append(World[3][0], World[3][1], World[3][2], FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX);
+				return Index;
+			}
+
+			glm::vec3 LocalCenter(Local.Center.x, Local.Center.y, Local.Center.z);
+			glm::vec3 LocalExtent((Local.Max.x - Local.Min.x) * 0.5f, (Local.Max.y - Local.Min.y) * 0.5f,
+				(Local.Max.z - Local.Min.z) * 0.5f);
+
+			glm::vec3 Center = glm::vec3(World * glm::vec4(LocalCenter, 1.0f));
+
+			// Arvo: the world extent on each axis is the abs rotated/scaled local extent
+			glm::vec3 Extent;
+			for (int Row = 0; Row < 3; Row++)
+				Extent[Row] = std::fabs(World[0][Row]) * LocalExtent.x + std::fabs(World[1][Row]) * LocalExtent.y +
+				std::fabs(World[2][Row]) * LocalExtent.z;
+
+			float MaxScale = std::fmax(glm::length(glm::vec3(World[0])),
+				std::fmax(glm::length(glm::vec3(World[1])), glm::length(glm::vec3(World[2]))));
+
+			_Append(Center.x, Center.y, Center.z, Extent.x, Extent.y, Extent.z, Local.Radius * MaxScale);
+			return Index;
+		}
+
+		// Writes 1 for visible and 0 for culled into OutVisible[i], returns the visible count
+		uint32_t Cull(const Frustum& View, std::vector<uint8_t>& OutVisible)
+		{
+			const size_t Count = _Radius.size();
+			OutVisible.resize(Count);
+			if (Count == 0)
+				return 0;
+
+			// Pad to a multiple of four with never culled entries so the SIMD loop has no tail
+			const size_t Padded = (Count + 3) & ~size_t(3);
+			while (_Radius.size() < Padded)
+				_Append(0.0f, 0.0f, 0.0f, FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX);
+
+			uint32_t VisibleCount = 0;
+
+#if CH_CULLING_SSE
+			__m128 PlaneNX[Frustum::PLANE_COUNT], PlaneNY[Frustum::PLANE_COUNT], PlaneNZ[Frustum::PLANE_COUNT], PlaneD[Frustum::PLANE_COUNT];
+			__m128 PlaneAX[Frustum::PLANE_COUNT], PlaneAY[Frustum::PLANE_COUNT], PlaneAZ[Frustum::PLANE_COUNT];
+			for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+			{
+				const glm::vec4& Plane = View.Planes[p];
+				PlaneNX[p] = _mm_set1_ps(Plane.x); PlaneNY[p] = _mm_set1_ps(Plane.y); PlaneNZ[p] = _mm_set1_ps(Plane.z);
+				PlaneD[p] = _mm_set1_ps(Plane.w);
+				PlaneAX[p] = _mm_set1_ps(std::fabs(Plane.x)); PlaneAY[p] = _mm_set1_ps(std::fabs(Plane.y));
+				PlaneAZ[p] = _mm_set1_ps(std::fabs(Plane.z));
+			}
+
+			for (size_t i = 0; i < Padded; i += 4)
+			{
+				__m128 CX = _mm_loadu_ps(&_CenterX[i]), CY = _mm_loadu_ps(&_CenterY[i]), CZ = _mm_loadu_ps(&_CenterZ[i]);
+				__m128 EX = _mm_loadu_ps(&_ExtentX[i]), EY = _mm_loadu_ps(&_ExtentY[i]), EZ = _mm_loadu_ps(&_ExtentZ[i]);
+				__m128 R = _mm_loadu_ps(&_Radius[i]);
+
+				__m128 Outside = _mm_setzero_ps();
+				for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+				{
+					__m128 Distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(CX, PlaneNX[p]), _mm_mul_ps(CY, PlaneNY[p])),
+						_mm_add_ps(_mm_mul_ps(CZ, PlaneNZ[p]), PlaneD[p]));
+					__m128 BoxRadius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(EX, PlaneAX[p]), _mm_mul_ps(EY, PlaneAY[p])),
+						_mm_mul_ps(EZ, PlaneAZ[p]));
+					__m128 ProjectedRadius = _mm_min_ps(BoxRadius, R);
+
+					// Distance + Radius < 0 -> fully behind this plane
+					Outside = _mm_or_ps(Outside, _mm_cmplt_ps(_mm_add_ps(Distance, ProjectedRadius), _mm_setzero_ps()));
+				}
+
+				int Mask = _mm_movemask_ps(Outside);
+				for (size_t Lane = 0; Lane < 4 && i + Lane < Count; Lane++)
+				{
+					uint8_t Visible = (Mask & (1 << Lane)) == 0;
+					OutVisible[i + Lane] = Visible;
+					VisibleCount += Visible;
+				}
+			}
+#else
+			for (size_t i = 0; i < Count; i++)
+			{
+				bool Outside = false;
+				for (int p = 0; p < Frustum::PLANE_COUNT && !Outside; p++)
+				{
+					const glm::vec4& Plane = View.Planes[p];
+					float Distance = _CenterX[i] * Plane.x + _CenterY[i] * Plane.y + _CenterZ[i] * Plane.z + Plane.w;
+					float BoxRadius = _ExtentX[i] * std::fabs(Plane.x) + _ExtentY[i] * std::fabs(Plane.y) +
+						_ExtentZ[i] * std::fabs(Plane.z);
+					Outside = Distance + std::fmin(BoxRadius, _Radius[i]) < 0.0f;
+				}
+				OutVisible[i] = !Outside;
+				VisibleCount += !Outside;
+			}
+#endif
+			// Drop the padding again so Push indices stay valid
+			_Resize(Count);
+			return VisibleCount;
+		}
+
+	private:
+		inline void _Append(float CX, float CY, float CZ, float EX, float EY, float EZ, float R)
+		{
+			_CenterX.push_back(CX); _CenterY.push_back(CY); _CenterZ.push_back(CZ);
+			_ExtentX.push_back(EX); _ExtentY.push_back(EY); _ExtentZ.push_back(EZ);
+			_Radius.push_back(R);
+		}
+
+		inline void _Resize(size_t Count)
+		{
+			_CenterX.resize(Count); _CenterY.resize(Count); _CenterZ.resize(Count);
+			_ExtentX.resize(Count); _ExtentY.resize(Count); _ExtentZ.resize(Count);
+			_Radius.resize(Count);
+		}
+
+	private:
+		std::vector<float> _CenterX, _CenterY, _CenterZ;
+		std::vector<float> _ExtentX, _ExtentY, _ExtentZ;
+		std::vector<float> _Radius;
+	};
+}
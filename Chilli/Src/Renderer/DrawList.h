@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <utility>
+
+namespace Chilli
+{
+	// 64 bit draw sort key, most significant field first:
+	// | Pass 4 | Shader 12 | Material 16 | Mesh 16 | Depth 16 |
+	// Sorting by the key groups draws by state so binds only change at group boundaries
+	struct DrawSortKey
+	{
+		static constexpr uint32_t DEPTH_BITS = 16;
+		static constexpr uint32_t MESH_BITS = 16;
+		static constexpr uint32_t MATERIAL_BITS = 16;
+		static constexpr uint32_t SHADER_BITS = 12;
+		static constexpr uint32_t PASS_BITS = 4;
+
+		static constexpr uint32_t DEPTH_SHIFT = 0;
+		static constexpr uint32_t MESH_SHIFT = DEPTH_SHIFT + DEPTH_BITS;
+		static constexpr uint32_t MATERIAL_SHIFT = MESH_SHIFT + MESH_BITS;
+		static constexpr uint32_t SHADER_SHIFT = MATERIAL_SHIFT + MATERIAL_BITS;
+		static constexpr uint32_t PASS_SHIFT = SHADER_SHIFT + SHADER_BITS;
+
+		// Depth is expected in [0, 1], 0 being closest to the camera
+		static inline uint64_t Make(uint32_t Pass, uint32_t Shader, uint32_t Material, uint32_t Mesh, float Depth)
+		{
+			Depth = Depth < 0.0f ? 0.0f : (Depth > 1.0f ? 1.0f : Depth);
+			uint64_t QuantizedDepth = uint64_t(Depth * float((1u << DEPTH_BITS) - 1));
+
+			return (uint64_t(Pass & ((1u << PASS_BITS) - 1)) << PASS_SHIFT) |
+				(uint64_t(Shader & ((1u << SHADER_BITS) - 1)) << SHADER_SHIFT) |
+				(uint64_t(Material & ((1u << MATERIAL_BITS) - 1)) << MATERIAL_SHIFT) |
+				(uint64_t(Mesh & ((1u << MESH_BITS) - 1)) << MESH_SHIFT) |
+				(QuantizedDepth << DEPTH_SHIFT);
+		}
+	};
+
+	struct DrawItem
+	{
+		uint64_t SortKey;
+		// Index into whatever per draw data the pass keeps next to the list
+		uint32_t Index;
+	};
+
+	class DrawList
+	{
+	public:
+		inline void Clear() { _Items.clear(); }
+		inline void Reserve(size_t Count) { _Items.reserve(Count); _Scratch.reserve(Count); }
+
+		inline void Push(uint64_t SortKey, uint32_t Index) { _Items.push_back({ SortKey, Index }); }
+
+		// LSD radix sort, 8 bits per pass, stable so equal keys keep submission order
+		void Sort()
+		{
+			const size_t Count = _Items.size();
+			if (Count < 2)
+				return;
+
+			_Scratch.resize(Count);
+
+			DrawItem* Src = _Items.data();
+			DrawItem* Dst = _Scratch.data();
+
+			for (uint32_t Shift = 0; Shift < 64; Shift += 8)
+			{
+				uint32_t Histogram[256] = { 0 };
+				for (size_t i = 0; i < Count; i++)
+					Histogram[(Src[i].SortKey >> Shift) & 0xFF]++;
+
+				// Every key shares this byte, nothing would move
+				if (Histogram[(Src[0].SortKey >> Shift) & 0xFF] == Count)
+					continue;
+
+				uint32_t Offset = 0;
+				for (uint32_t i = 0; i < 256; i++)
+				{
+					uint32_t BucketCount = Histogram[i];
+					Histogram[i] = Offset;
+					Offset += BucketCount;
+				}
+
+				for (size_t i = 0; i < Count; i++)
+					Dst[Histogram[(Src[i].SortKey >> Shift) & 0xFF]++] = Src[i];
+
+				std::swap(Src, Dst);
+			}
+
+			if (Src != _Items.data())
+				_Items.swap(_Scratch);
+		}
+
+		inline size_t Size() const { return _Items.size(); }
+		inline bool Empty() const { return _Items.empty(); }
+
+		inline const DrawItem& operator[](size_t Index) const { return _Items[Index]; }
+
+		auto begin() const { return _Items.begin(); }
+		auto end() const { return _Items.end(); }
+
+	private:
+		std::vector<DrawItem> _Items;
+		std::vector<DrawItem> _Scratch;
+	};
+}
@@ -72,6 +72,13 @@ namespace Chilli
 		IVec2 ViewPortSize = { 800, 600 };
 		bool ViewPortResized = true;
 		uint32_t MaxFrameInFlight = 3;
+		// Threads translating render pass streams next to the submitting one, UINT32_MAX picks one less
+		// than the hardware thread count and 0 translates every pass on the submitting thread
+		uint32_t RecordingThreadCount = UINT32_MAX;
+		// Host memory per frame in flight for the frame's writes to DYNAMIC_COPY buffers
+		uint32_t StagingRingSizePerFrame = 4 * 1024 * 1024;
+		// Shader object binaries are kept here between runs, nullptr compiles every shader from SPIR-V
+		const char* ShaderBinaryCachePath = "ShaderBinaryCache.bin";
 	};
 
 	struct BufferCopyInfo
@@ -94,7 +101,8 @@ namespace Chilli
 		Vec4 AlbedoColor;
 	};
 
-	const uint32_t CH_OBJECT_SHADER_DATA_AMOUNT = 1000;
+	// Starting capacity of each frame's object ring, it doubles whenever a frame needs more
+	const uint32_t CH_OBJECT_SHADER_DATA_INITIAL_AMOUNT = 1024;
 
 	struct ObjectShaderData
 	{
@@ -102,11 +110,23 @@ namespace Chilli
 		glm::mat4 InverseTransformationMat;
 	};
 
+	// Commands of one render pass, translated independently of the other passes of the frame
+	struct RenderPassStream
+	{
+		RenderPassDesc Pass;
+		GraphicsCommandBuffer Stream;
+	};
+
 	struct RenderFramePacket
 	{
 		GraphicsCommandBuffer Graphics_Stream;
-		RenderCommandBuffer Compute_Stream;
+		// Recorded into the frame's graphics command buffer ahead of the first render pass
+		ComputeCommandBuffer Compute_Stream;
 		RenderCommandBuffer Transfer_Stream;
+
+		// Only the first Pass_StreamCount are used this frame, the rest keep their memory for later frames
+		std::vector<RenderPassStream> Pass_Streams;
+		uint32_t Pass_StreamCount = 0;
 	};
 
 	struct RenderCommandInfoInlineUniformData
@@ -176,8 +196,21 @@ namespace Chilli
 		bool bSupportsMeshShaders;
 		bool bSupportsBindlessTextures; // Resource Heap in DX12 / Descriptor Indexing in VK
 		bool bSupportsVariableRateShading;
+		bool bSupportsMultiDrawIndirect; // DrawCount > 1 in a single indirect draw
+		bool bSupportsDrawIndirectCount; // GPU sourced draw count
+		bool bSupportsDrawIndirectFirstInstance; // Indirect commands may have a non zero FirstInstance
+		bool bSupportsTextureCompressionBC; // Every BC1-BC7 format can be sampled
+
+		// Bit (Format - ImageFormat::BC1_RGBA) is set for each block compressed format that can be sampled
+		uint32_t SampledCompressedFormats;
 
 		GraphicsMemoryStats MemoryLimits;
+
+		inline bool CanSampleFormat(ImageFormat Format) const {
+			if (!IsBlockCompressedFormat(Format))
+				return true;
+			return (SampledCompressedFormats >> (uint32_t(Format) - uint32_t(ImageFormat::BC1_RGBA))) & 1;
+		}
 	};
 
 	struct RenderDeviceStats
@@ -192,8 +225,29 @@ namespace Chilli
 		uint32_t IndiciesRendered = 0;
 		uint32_t VerticesRendered = 0;
 		uint32_t DrawCallsPerFrame = 0;
+		uint32_t IndirectDrawCallsPerFrame = 0; // Also counted in DrawCallsPerFrame
 		uint32_t TrianglesPerFrame = 0;
 		uint32_t DescriptorSetBinds = 0;
+		uint32_t DescriptorWritesPerFrame = 0;
+		uint32_t DispatchesPerFrame = 0;
+		uint32_t DynamicStateCallsPerFrame = 0;
+		uint32_t DynamicStateCallsSkipped = 0; // Redundant vkCmdSet* calls filtered out
+		uint32_t ParallelPassesPerFrame = 0; // Passes translated into their own secondary command buffer
+		uint32_t ObjectsPerFrame = 0;
+		uint32_t ObjectCapacityPerFrame = 0;
+		uint32_t UploadBatchesInFlight = 0; // Upload batches submitted but not yet finished by the GPU
+		uint32_t PendingDeletions = 0; // Destructions waiting on the fence of a frame in flight
+		uint32_t DeletionsPerFrame = 0;
+		uint32_t StagingRingBytesPerFrame = 0; // Frame staging ring space used by DYNAMIC_COPY writes
+		uint32_t StagingRingCapacityPerFrame = 0;
+		uint32_t StagingRingOverflows = 0; // Writes that did not fit and went through the uploader
+		uint32_t StreamedTextures = 0;
+		uint32_t StreamedMipsRaisedPerFrame = 0;
+		uint32_t StreamedMipsEvictedPerFrame = 0;
+		uint64_t StreamedTextureBytes = 0; // Resident mips of every streamed texture
+		uint32_t AliasedImages = 0; // Images placed on memory shared with others by the render graph
+		uint64_t AliasedImageBytes = 0; // Memory behind the aliased images
+		uint64_t AliasedImageBytesSaved = 0; // What they would take on their own minus AliasedImageBytes
 
 		GraphicsMemoryStats MemoryUsed;
 	};
@@ -219,9 +273,14 @@ namespace Chilli
 
 		virtual uint32_t AllocateBuffer(const BufferCreateInfo& Info) = 0;
 		virtual void MapBufferData(uint32_t BufferHandle, void* Data, uint32_t Size, uint32_t Offset = 0) = 0;
+		// Copies out of a STATIC_READ or DYNAMIC_READ buffer, the GPU writes have to be finished
+		virtual void ReadBufferData(uint32_t BufferHandle, void* Data, uint32_t Size, uint32_t Offset = 0) = 0;
 		virtual void FreeBuffer(uint32_t BufferHandle) = 0;
+		// Runs Fn once the frames in flight that were recorded so far are done on the GPU
+		virtual void DeferDestroy(std::function<void()>&& Fn) = 0;
 
 		virtual void PrepareForShutDown() = 0;
+		virtual void WaitIdle() = 0;
 
 		virtual ShaderModule CreateShaderModule(const char* FilePath, ShaderStageType Type) = 0;
 		virtual void DestroyShaderModule(const ShaderModule& Module) = 0;
@@ -230,6 +289,8 @@ namespace Chilli
 		virtual void AttachShader(uint32_t ProgramHandle, const ShaderModule& Shader) = 0;
 		virtual void ClearShaderProgram(uint32_t ProgramHandle) = 0;
 		virtual void LinkShaderProgram(uint32_t ProgramHandle) = 0;
+		// Specialized on the first request for a key and cached, cleared together with ProgramHandle
+		virtual uint32_t GetShaderProgramVariant(uint32_t ProgramHandle, ShaderPermutationKey Key) = 0;
 
 		virtual void UpdateGlobalShaderData(const GlobalShaderData& Data) = 0;
 		virtual void UpdateSceneShaderData(uint32_t Index, const SceneData& Data) = 0;
@@ -243,20 +304,30 @@ namespace Chilli
 		virtual uint32_t AllocateImage(ImageSpec& Spec) = 0;
 		virtual void DestroyImage(uint32_t ImageHandle) = 0;
 		virtual void MapImageData(uint32_t ImageHandle, void* Data, int Width, int Height) = 0;
+		// Every level of the image from a packed chain, no mips are generated
+		virtual void MapImageMips(uint32_t ImageHandle, const void* Data, const ImageMipRegion* Mips, uint32_t MipCount) = 0;
 
 		virtual uint32_t CreateTexture(uint32_t ImageHandle, TextureSpec& Spec) = 0;
 		virtual void DestroyTexture(uint32_t TextureHandle) = 0;
+		// Images whose ranges do not overlap are placed on one shared allocation, their contents are undefined
+		// at the start of their range. Images sharing memory from an earlier call are placed again
+		virtual void AliasImages(const ImageAliasRange* Ranges, uint32_t Count) = 0;
 
 		virtual uint32_t CreateSampler(const SamplerSpec& Spec) = 0;
 		virtual void DestroySampler(uint32_t SamplerHandle) = 0;
 
 		virtual uint32_t GetTextureShaderIndex(uint32_t RawTextureHandle) = 0;
+		// Largest size in pixels the texture covers on screen this frame, decides how many mips a streamed
+		// texture wants resident. Ignored for textures that are not streamed
+		virtual void SetTextureScreenSize(uint32_t RawTextureHandle, float ScreenSize) = 0;
 		virtual uint32_t GetSamplerShaderIndex(uint32_t RawSamplerHandle) = 0;
 		virtual uint32_t GetMaterialShaderIndex(uint32_t RawMaterialHandle) = 0;
-		virtual uint32_t GetObjectShaderIndex(uint32_t Entity) = 0;
+		virtual MaterialBindingSlot FindMaterialBindingSlot(uint32_t RawMaterialHandle, const char* Name) = 0;
 
 		virtual void UpdateMaterialShaderData(uint32_t MaterialHandle, const MaterialShaderData& Data) = 0;
-		virtual void UpdateObjectShaderData(BackBone::Entity Entity, const ObjectShaderData& Data) = 0;
+		// Persistently mapped, the pointer stays valid until the next allocation for the same frame
+		virtual ObjectShaderData* AllocateObjectShaderData(uint32_t FrameIndex, uint32_t Count, uint32_t& OutFirstIndex) = 0;
+		virtual void UpdateInstanceIndexData(uint32_t FrameIndex, const uint32_t* Indices, uint32_t Count, uint32_t Offset = 0) = 0;
 
 		virtual const std::vector<RenderDeviceInfo>& GetRenderDevices() = 0;
 		// Takes in the raw render device handle that is inside the info
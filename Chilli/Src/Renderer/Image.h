@@ -30,7 +30,52 @@ namespace Chilli
 
 		S8I,
 		D32F,
-		D32F_S8I
+		D32F_S8I,
+
+		// Block compressed, every 4x4 texel block is 8 (BC1, BC4) or 16 bytes
+		BC1_RGBA,
+		BC1_SRGBA,
+		BC2_RGBA,
+		BC2_SRGBA,
+		BC3_RGBA,
+		BC3_SRGBA,
+		BC4_R,
+		BC5_RG,
+		BC6H_RGBF,
+		BC7_RGBA,
+		BC7_SRGBA
+	};
+
+	inline bool IsBlockCompressedFormat(ImageFormat Format)
+	{
+		return Format >= ImageFormat::BC1_RGBA && Format <= ImageFormat::BC7_SRGBA;
+	}
+
+	inline uint32_t GetBlockCompressedBlockSize(ImageFormat Format)
+	{
+		switch (Format)
+		{
+		case ImageFormat::BC1_RGBA:
+		case ImageFormat::BC1_SRGBA:
+		case ImageFormat::BC4_R:
+			return 8;
+		default:
+			return IsBlockCompressedFormat(Format) ? 16 : 0;
+		}
+	}
+
+	// Bytes one Width x Height level of a block compressed format takes, rounded up to whole 4x4 blocks
+	inline uint64_t GetBlockCompressedLevelSize(ImageFormat Format, uint32_t Width, uint32_t Height)
+	{
+		return ((uint64_t(Width) + 3) / 4) * ((uint64_t(Height) + 3) / 4) * GetBlockCompressedBlockSize(Format);
+	}
+
+	// Where one mip level sits inside a packed mip chain
+	struct ImageMipRegion
+	{
+		uint64_t Offset = 0;
+		uint64_t Size = 0;
+		uint32_t Width = 0, Height = 0;
 	};
 
     // The ASpect of the image the texture allows to be viewed
@@ -78,6 +123,21 @@ namespace Chilli
 		uint32_t MipLevel = 1;
 		ResourceState State = ResourceState::Undefined;
 		SampleCount Sample = IMAGE_SAMPLE_COUNT_1_BIT;
+		// Only the low mips are uploaded at first, the rest are raised and evicted by the backend against the
+		// memory budget. Sampled 2D RGBA8 images with mips only, anything else is allocated fully
+		bool Streamed = false;
+		// Contents only matter between the first and last render graph pass that declares the image, the graph
+		// may place it on memory shared with other aliasable images whose passes do not overlap. Every read has
+		// to be a declared attachment, an image also sampled through a material must not set this
+		bool Aliasable = false;
+	};
+
+	// Passes of the built render graph order, inclusive
+	struct ImageAliasRange
+	{
+		uint32_t ImageHandle = UINT32_MAX;
+		uint32_t FirstPass = 0;
+		uint32_t LastPass = 0;
 	};
 
 	struct Image
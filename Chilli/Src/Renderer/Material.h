@@ -82,6 +82,12 @@ namespace Chilli
 			Mat->Version++;
 		}
 
+		BackBone::AssetHandle<Texture> GetAlbedoTexture(BackBone::AssetHandle<Material> Handle)
+		{
+			auto Mat = GetMaterial(Handle);
+			return Mat->AlbedoTextureHandle;
+		}
+
 		void SetAlbedoSampler(BackBone::AssetHandle<Material> Handle, BackBone::AssetHandle <Sampler> SamplerHandle)
 		{
 			auto Mat = GetMaterial(Handle);
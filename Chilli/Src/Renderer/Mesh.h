@@ -3,6 +3,7 @@
 #include "Buffers.h"
 #include "Maths.h"
 #include "Pipeline.h"
+#include "Culling.h"
 
 namespace Chilli
 {
@@ -43,9 +44,20 @@ namespace Chilli
 		uint32_t InstanceCount = 0;
 		uint32_t IndexCount = 0;
 
+		// Where the mesh starts in its buffers, only non zero for meshes in a MeshArena page
+		uint32_t FirstIndex = 0;
+		int32_t VertexOffset = 0;
+		// UINT32_MAX when the mesh owns its buffers, the counts are the size of its arena ranges
+		uint32_t ArenaPage = UINT32_MAX;
+		uint32_t ArenaVertexCount = 0;
+		uint32_t ArenaIndexCount = 0;
+
 		IndexBufferType IBType = IndexBufferType::NONE;
 		VertexInputShaderLayout MeshLayout;
 		BufferState IndexBufferState;
+
+		// Local space, used for culling
+		MeshBounds Bounds;
 	};
 
 	struct Vertex2D
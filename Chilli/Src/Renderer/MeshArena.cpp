@@ -0,0 +1,244 @@
+#include "Ch_PCH.h"
+#include "MeshArena.h"
+#include "DeafultExtensions.h"
+#include <algorithm>
+
+namespace Chilli
+{
+	static uint32_t GetIndexSize(IndexBufferType Type)
+	{
+		return Type == IndexBufferType::UINT16_T ? sizeof(uint16_t) : sizeof(uint32_t);
+	}
+
+	void RangeAllocator::Init(uint32_t Capacity)
+	{
+		_Capacity = Capacity;
+		_Used = 0;
+		_FreeRanges.clear();
+		_FreeRanges.push_back({ 0, Capacity });
+	}
+
+	uint32_t RangeAllocator::Allocate(uint32_t Size)
+	{
+		size_t Best = _FreeRanges.size();
+		for (size_t i = 0; i < _FreeRanges.size(); i++)
+		{
+			if (_FreeRanges[i].Size < Size)
+				continue;
+			if (Best == _FreeRanges.size() || _FreeRanges[i].Size < _FreeRanges[Best].Size)
+				Best = i;
+			if (_FreeRanges[i].Size == Size)
+				break;
+		}
+
+		if (Best == _FreeRanges.size())
+			return UINT32_MAX;
+
+		auto& Found = _FreeRanges[Best];
+		uint32_t Offset = Found.Offset;
+		Found.Offset += Size;
+		Found.Size -= Size;
+		if (Found.Size == 0)
+			_FreeRanges.erase(_FreeRanges.begin() + Best);
+
+		_Used += Size;
+		return Offset;
+	}
+
+	void RangeAllocator::Free(uint32_t Offset, uint32_t Size)
+	{
+		auto Next = std::lower_bound(_FreeRanges.begin(), _FreeRanges.end(), Offset,
+			[](const Range& A, uint32_t Offset) { return A.Offset < Offset; });
+		Next = _FreeRanges.insert(Next, { Offset, Size });
+		_Used -= Size;
+
+		// Merge with the range after, then with the one before
+		if (Next + 1 != _FreeRanges.end() && Next->Offset + Next->Size == (Next + 1)->Offset)
+		{
+			Next->Size += (Next + 1)->Size;
+			_FreeRanges.erase(Next + 1);
+		}
+		if (Next != _FreeRanges.begin() && (Next - 1)->Offset + (Next - 1)->Size == Next->Offset)
+		{
+			(Next - 1)->Size += Next->Size;
+			_FreeRanges.erase(Next);
+		}
+	}
+
+	bool MeshArena::CanHold(const MeshCreateInfo& Info)
+	{
+		if (Info.IndexCount == 0 || Info.IndexType == IndexBufferType::NONE ||
+			Info.IndexBufferState != BufferState::STATIC_DRAW || Info.MeshLayout.Bindings.empty())
+			return false;
+
+		for (const auto& Binding : Info.MeshLayout.Bindings)
+			if (Binding.IsInstanced || Binding.State != BufferState::STATIC_DRAW || Binding.BindingIndex >= 16)
+				return false;
+		return true;
+	}
+
+	// Only what decides the buffer contents, attributes can differ between meshes of one page
+	uint64_t MeshArena::_LayoutKey(const MeshCreateInfo& Info)
+	{
+		uint64_t Key = 1469598103934665603ull;
+		auto Combine = [&Key](uint64_t Value) {
+			Key ^= Value;
+			Key *= 1099511628211ull;
+		};
+
+		Combine(uint64_t(Info.IndexType));
+		for (const auto& Binding : Info.MeshLayout.Bindings)
+		{
+			Combine(Binding.BindingIndex);
+			Combine(Binding.Stride);
+		}
+		return Key;
+	}
+
+	uint32_t MeshArena::_CreatePage(const MeshCreateInfo& Info, uint64_t LayoutKey, uint32_t VertexCapacity,
+		uint32_t IndexCapacity)
+	{
+		auto Command = Chilli::Command(_Ctxt);
+
+		Page NewPage;
+		NewPage.LayoutKey = LayoutKey;
+		NewPage.IndexType = Info.IndexType;
+		NewPage.Vertices.Init(VertexCapacity);
+		NewPage.Indices.Init(IndexCapacity);
+
+		for (const auto& Binding : Info.MeshLayout.Bindings)
+		{
+			BufferCreateInfo VBInfo;
+			VBInfo.State = BufferState::STATIC_DRAW;
+			VBInfo.Type = BufferType::BUFFER_TYPE_VERTEX;
+			VBInfo.SizeInBytes = Binding.Stride * VertexCapacity;
+
+			NewPage.VertexBuffers[Binding.BindingIndex] = Command.CreateBuffer(VBInfo,
+				std::string("MeshArena_VB_Slot_" + std::to_string(Binding.BindingIndex)).c_str());
+			NewPage.Strides[Binding.BindingIndex] = Binding.Stride;
+			NewPage.BindingCount = std::max(NewPage.BindingCount, Binding.BindingIndex + 1);
+		}
+
+		BufferCreateInfo IBInfo;
+		IBInfo.State = BufferState::STATIC_DRAW;
+		IBInfo.Type = BufferType::BUFFER_TYPE_INDEX;
+		IBInfo.SizeInBytes = GetIndexSize(Info.IndexType) * IndexCapacity;
+		NewPage.IndexBuffer = Command.CreateBuffer(IBInfo, "MeshArena_IB");
+
+		_Pages.push_back(NewPage);
+		CH_CORE_INFO("MeshArena: page {0} created for {1} vertices and {2} indices", _Pages.size() - 1,
+			VertexCapacity, IndexCapacity);
+		return uint32_t(_Pages.size() - 1);
+	}
+
+	void MeshArena::Allocate(const MeshCreateInfo& Info, Mesh& NewMesh)
+	{
+		auto Command = Chilli::Command(_Ctxt);
+		const uint64_t LayoutKey = _LayoutKey(Info);
+
+		uint32_t PageIndex = UINT32_MAX;
+		uint32_t VertexOffset = UINT32_MAX;
+		uint32_t FirstIndex = UINT32_MAX;
+
+		for (uint32_t i = 0; i < _Pages.size() && PageIndex == UINT32_MAX; i++)
+		{
+			auto& Candidate = _Pages[i];
+			if (Candidate.LayoutKey != LayoutKey)
+				continue;
+
+			VertexOffset = Candidate.Vertices.Allocate(Info.VertCount);
+			if (VertexOffset == UINT32_MAX)
+				continue;
+
+			FirstIndex = Candidate.Indices.Allocate(Info.IndexCount);
+			if (FirstIndex == UINT32_MAX)
+			{
+				Candidate.Vertices.Free(VertexOffset, Info.VertCount);
+				continue;
+			}
+			PageIndex = i;
+		}
+
+		if (PageIndex == UINT32_MAX)
+		{
+			PageIndex = _CreatePage(Info, LayoutKey, std::max(Info.VertCount, CH_MESH_ARENA_PAGE_VERTICES),
+				std::max(Info.IndexCount, CH_MESH_ARENA_PAGE_INDICES));
+			VertexOffset = _Pages[PageIndex].Vertices.Allocate(Info.VertCount);
+			FirstIndex = _Pages[PageIndex].Indices.Allocate(Info.IndexCount);
+		}
+
+		auto& ArenaPage = _Pages[PageIndex];
+		ArenaPage.MeshCount++;
+
+		NewMesh.VertexBufferHandles = ArenaPage.VertexBuffers;
+		NewMesh.ActiveVBHandlesCount = ArenaPage.BindingCount;
+		NewMesh.IBHandle = ArenaPage.IndexBuffer;
+		NewMesh.ArenaPage = PageIndex;
+		NewMesh.ArenaVertexCount = Info.VertCount;
+		NewMesh.ArenaIndexCount = Info.IndexCount;
+		NewMesh.VertexOffset = int32_t(VertexOffset);
+		NewMesh.FirstIndex = FirstIndex;
+
+		// Same as owned buffers, only binding 0 gets initial data
+		if (Info.Vertices != nullptr && ArenaPage.VertexBuffers[0].IsValid())
+		{
+			const size_t Stride = ArenaPage.Strides[0];
+			Command.MapBufferData(ArenaPage.VertexBuffers[0], Info.Vertices, Stride * Info.VertCount,
+				Stride * VertexOffset);
+		}
+
+		if (Info.Indicies != nullptr)
+		{
+			const size_t IndexSize = GetIndexSize(Info.IndexType);
+			Command.MapBufferData(ArenaPage.IndexBuffer, Info.Indicies, IndexSize * Info.IndexCount,
+				IndexSize * FirstIndex);
+		}
+	}
+
+	void MeshArena::Free(Mesh& OldMesh)
+	{
+		CH_CORE_ASSERT(OldMesh.ArenaPage < _Pages.size(), "Mesh does not live in the arena");
+
+		auto RenderCommandService = Chilli::Command(_Ctxt).GetService<RenderCommand>();
+		RenderCommandService->DeferDestroy([this, PageIndex = OldMesh.ArenaPage, VertexOffset = uint32_t(OldMesh.VertexOffset),
+			VertexCount = OldMesh.ArenaVertexCount, FirstIndex = OldMesh.FirstIndex, IndexCount = OldMesh.ArenaIndexCount]() {
+			auto& ArenaPage = _Pages[PageIndex];
+			ArenaPage.Vertices.Free(VertexOffset, VertexCount);
+			ArenaPage.Indices.Free(FirstIndex, IndexCount);
+			ArenaPage.MeshCount--;
+			});
+
+		// The handles point at the page's shared buffers, a later destroy of the mesh must not free them
+		OldMesh.VertexBufferHandles = {};
+		OldMesh.ActiveVBHandlesCount = 0;
+		OldMesh.IBHandle = {};
+		OldMesh.ArenaPage = UINT32_MAX;
+	}
+
+	MeshArenaStats MeshArena::GetStats() const
+	{
+		MeshArenaStats Stats;
+		Stats.PageCount = uint32_t(_Pages.size());
+
+		for (const auto& ArenaPage : _Pages)
+		{
+			uint64_t VertexStride = 0;
+			for (uint32_t i = 0; i < ArenaPage.BindingCount; i++)
+			{
+				if (!ArenaPage.VertexBuffers[i].IsValid())
+					continue;
+				VertexStride += ArenaPage.Strides[i];
+				Stats.BufferCount++;
+			}
+			Stats.BufferCount++;
+
+			const uint64_t IndexSize = GetIndexSize(ArenaPage.IndexType);
+			Stats.MeshCount += ArenaPage.MeshCount;
+			Stats.VertexBytesUsed += VertexStride * ArenaPage.Vertices.GetUsed();
+			Stats.VertexBytesCapacity += VertexStride * ArenaPage.Vertices.GetCapacity();
+			Stats.IndexBytesUsed += IndexSize * ArenaPage.Indices.GetUsed();
+			Stats.IndexBytesCapacity += IndexSize * ArenaPage.Indices.GetCapacity();
+		}
+		return Stats;
+	}
+}
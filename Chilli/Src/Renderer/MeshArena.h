@@ -0,0 +1,89 @@
+#pragma once
+
+#include "BackBone\BackBone.h"
+#include "Mesh.h"
+
+// Size of a shared page, a mesh larger than this gets a page of its own size
+#define CH_MESH_ARENA_PAGE_VERTICES (1u << 20)
+#define CH_MESH_ARENA_PAGE_INDICES (3u << 20)
+
+namespace Chilli
+{
+	// Best fit over an offset sorted free list, freed ranges are merged with their neighbours
+	class RangeAllocator
+	{
+	public:
+		void Init(uint32_t Capacity);
+
+		// UINT32_MAX when no free range is large enough
+		uint32_t Allocate(uint32_t Size);
+		void Free(uint32_t Offset, uint32_t Size);
+
+		uint32_t GetCapacity() const { return _Capacity; }
+		uint32_t GetUsed() const { return _Used; }
+		uint32_t GetFreeRangeCount() const { return uint32_t(_FreeRanges.size()); }
+	private:
+		struct Range
+		{
+			uint32_t Offset;
+			uint32_t Size;
+		};
+
+		std::vector<Range> _FreeRanges;
+		uint32_t _Capacity = 0;
+		uint32_t _Used = 0;
+	};
+
+	struct MeshArenaStats
+	{
+		uint32_t PageCount = 0;
+		// Buffer allocations behind every page, vertex bindings and index buffers
+		uint32_t BufferCount = 0;
+		uint32_t MeshCount = 0;
+		uint64_t VertexBytesUsed = 0;
+		uint64_t VertexBytesCapacity = 0;
+		uint64_t IndexBytesUsed = 0;
+		uint64_t IndexBytesCapacity = 0;
+	};
+
+	// Static meshes share one set of vertex buffers and an index buffer per layout class (binding strides
+	// and index type), each mesh only owns a vertex and an index range in them. Meshes of a page bind the
+	// same buffers, so their draws batch into one multi draw indirect call
+	class MeshArena
+	{
+	public:
+		MeshArena(BackBone::SystemContext& Ctxt) { _Ctxt = Ctxt; }
+
+		// Every binding per vertex and STATIC_DRAW with STATIC_DRAW indices, anything written often keeps
+		// its own buffers
+		static bool CanHold(const MeshCreateInfo& Info);
+
+		// Finds ranges for the mesh in a page of its layout class, fills its buffer handles, FirstIndex and
+		// VertexOffset and uploads the initial vertices and indices
+		void Allocate(const MeshCreateInfo& Info, Mesh& NewMesh);
+		// The ranges go back to the page through the backend's deletion queue, so they are reused once the
+		// frames in flight that may still draw the mesh are done. The mesh's buffer handles are reset
+		void Free(Mesh& OldMesh);
+
+		MeshArenaStats GetStats() const;
+	private:
+		struct Page
+		{
+			uint64_t LayoutKey = 0;
+			std::array<BackBone::AssetHandle<Buffer>, 16> VertexBuffers;
+			std::array<uint32_t, 16> Strides{};
+			uint32_t BindingCount = 0;
+			BackBone::AssetHandle<Buffer> IndexBuffer;
+			IndexBufferType IndexType = IndexBufferType::NONE;
+			RangeAllocator Vertices;
+			RangeAllocator Indices;
+			uint32_t MeshCount = 0;
+		};
+
+		static uint64_t _LayoutKey(const MeshCreateInfo& Info);
+		uint32_t _CreatePage(const MeshCreateInfo& Info, uint64_t LayoutKey, uint32_t VertexCapacity, uint32_t IndexCapacity);
+	private:
+		BackBone::SystemContext _Ctxt;
+		std::vector<Page> _Pages;
+	};
+}
@@ -0,0 +1,191 @@
+#include "Ch_PCH.h"
+#include "MipChain.h"
+#include <algorithm>
+#include <cmath>
+
+#define CH_MIP_KAISER_WIDTH 3.0f
+#define CH_MIP_KAISER_ALPHA 4.0f
+
+namespace Chilli
+{
+	namespace
+	{
+		const float Pi = 3.14159265358979f;
+
+		float SRGBToLinear(float Value)
+		{
+			return Value <= 0.04045f ? Value / 12.92f : std::pow((Value + 0.055f) / 1.055f, 2.4f);
+		}
+
+		float LinearToSRGB(float Value)
+		{
+			return Value <= 0.0031308f ? Value * 12.92f : 1.055f * std::pow(Value, 1.0f / 2.4f) - 0.055f;
+		}
+
+		// Zeroth order modified Bessel function of the first kind, for the Kaiser window
+		float BesselI0(float x)
+		{
+			float Sum = 1.0f, Term = 1.0f;
+			for (int k = 1; k < 32; k++)
+			{
+				Term *= (x / (2.0f * k)) * (x / (2.0f * k));
+				Sum += Term;
+				if (Term < Sum * 1e-7f)
+					break;
+			}
+			return Sum;
+		}
+
+		float Kaiser(float t)
+		{
+			float x = t / CH_MIP_KAISER_WIDTH;
+			if (x <= -1.0f || x >= 1.0f)
+				return 0.0f;
+
+			float Sinc = t == 0.0f ? 1.0f : std::sin(Pi * t) / (Pi * t);
+			return Sinc * BesselI0(CH_MIP_KAISER_ALPHA * std::sqrt(1.0f - x * x)) / BesselI0(CH_MIP_KAISER_ALPHA);
+		}
+
+		// Weights of every destination texel over the source, each row holds TapCount taps starting at First
+		struct FilterKernel
+		{
+			std::vector<int32_t> First;
+			std::vector<float> Weights;
+			uint32_t TapCount = 0;
+		};
+
+		FilterKernel BuildKernel(uint32_t SrcSize, uint32_t DstSize, MipFilter Filter)
+		{
+			const float Scale = float(SrcSize) / float(DstSize);
+			const float Radius = Filter == MipFilter::BOX ? Scale * 0.5f : CH_MIP_KAISER_WIDTH * Scale;
+
+			FilterKernel Kernel;
+			Kernel.First.resize(DstSize);
+			Kernel.TapCount = uint32_t(std::ceil(Radius * 2.0f)) + 1;
+			Kernel.Weights.assign(size_t(DstSize) * Kernel.TapCount, 0.0f);
+
+			for (uint32_t x = 0; x < DstSize; x++)
+			{
+				const float Center = (float(x) + 0.5f) * Scale;
+				const int32_t First = int32_t(std::floor(Center - Radius));
+				Kernel.First[x] = First;
+
+				float* Weights = &Kernel.Weights[size_t(x) * Kernel.TapCount];
+				float Total = 0.0f;
+				for (uint32_t Tap = 0; Tap < Kernel.TapCount; Tap++)
+				{
+					const float Texel = float(First + int32_t(Tap));
+					float Weight;
+					if (Filter == MipFilter::BOX)
+						Weight = std::max(0.0f, std::min(Texel + 1.0f, Center + Radius) - std::max(Texel, Center - Radius));
+					else
+						Weight = Kaiser((Texel + 0.5f - Center) / Scale);
+					Weights[Tap] = Weight;
+					Total += Weight;
+				}
+				for (uint32_t Tap = 0; Tap < Kernel.TapCount; Tap++)
+					Weights[Tap] /= Total;
+			}
+			return Kernel;
+		}
+
+		// Separable downsample of a 4 channel float image, taps past the edges clamp to the border texel
+		void Downsample(const std::vector<float>& Src, uint32_t SrcWidth, uint32_t SrcHeight,
+			std::vector<float>& Dst, uint32_t DstWidth, uint32_t DstHeight, MipFilter Filter)
+		{
+			const FilterKernel Horizontal = BuildKernel(SrcWidth, DstWidth, Filter);
+			const FilterKernel Vertical = BuildKernel(SrcHeight, DstHeight, Filter);
+
+			std::vector<float> Rows(size_t(DstWidth) * SrcHeight * 4, 0.0f);
+			for (uint32_t y = 0; y < SrcHeight; y++)
+			{
+				const float* SrcRow = &Src[size_t(y) * SrcWidth * 4];
+				for (uint32_t x = 0; x < DstWidth; x++)
+				{
+					const float* Weights = &Horizontal.Weights[size_t(x) * Horizontal.TapCount];
+					float* Out = &Rows[(size_t(y) * DstWidth + x) * 4];
+					for (uint32_t Tap = 0; Tap < Horizontal.TapCount; Tap++)
+					{
+						int32_t Texel = std::clamp(Horizontal.First[x] + int32_t(Tap), 0, int32_t(SrcWidth) - 1);
+						for (uint32_t c = 0; c < 4; c++)
+							Out[c] += SrcRow[Texel * 4 + c] * Weights[Tap];
+					}
+				}
+			}
+
+			Dst.assign(size_t(DstWidth) * DstHeight * 4, 0.0f);
+			for (uint32_t y = 0; y < DstHeight; y++)
+			{
+				const float* Weights = &Vertical.Weights[size_t(y) * Vertical.TapCount];
+				float* Out = &Dst[size_t(y) * DstWidth * 4];
+				for (uint32_t Tap = 0; Tap < Vertical.TapCount; Tap++)
+				{
+					int32_t Row = std::clamp(Vertical.First[y] + int32_t(Tap), 0, int32_t(SrcHeight) - 1);
+					const float* In = &Rows[size_t(Row) * DstWidth * 4];
+					for (uint32_t i = 0; i < DstWidth * 4; i++)
+						Out[i] += In[i] * Weights[Tap];
+				}
+			}
+		}
+	}
+
+	uint32_t GetFullMipCount(uint32_t Width, uint32_t Height)
+	{
+		uint32_t Count = 1;
+		for (uint32_t Largest = std::max(Width, Height); Largest > 1; Largest >>= 1)
+			Count++;
+		return Count;
+	}
+
+	uint64_t LayoutMipChainRGBA8(uint32_t Width, uint32_t Height, uint32_t MipCount, std::vector<ImageMipRegion>& Mips)
+	{
+		uint64_t Size = 0;
+		Mips.resize(MipCount);
+		for (uint32_t Mip = 0; Mip < MipCount; Mip++)
+		{
+			auto& Region = Mips[Mip];
+			Region.Width = std::max(Width >> Mip, 1u);
+			Region.Height = std::max(Height >> Mip, 1u);
+			Region.Offset = Size;
+			Region.Size = uint64_t(Region.Width) * Region.Height * 4;
+			Size += Region.Size;
+		}
+		return Size;
+	}
+
+	void GenerateMipChainRGBA8(void* Chain, const ImageMipRegion* Mips, uint32_t MipCount, const MipChainSpec& Spec)
+	{
+		if (MipCount < 2)
+			return;
+
+		uint8_t* Bytes = static_cast<uint8_t*>(Chain);
+
+		float ToLinear[256];
+		for (uint32_t i = 0; i < 256; i++)
+			ToLinear[i] = Spec.SRGB ? SRGBToLinear(float(i) / 255.0f) : float(i) / 255.0f;
+
+		// Every level is filtered from the float copy of the one above so the error does not build up
+		std::vector<float> Level(size_t(Mips[0].Width) * Mips[0].Height * 4);
+		const uint8_t* Top = Bytes + Mips[0].Offset;
+		for (size_t i = 0; i < Level.size(); i++)
+			Level[i] = (i & 3) == 3 ? float(Top[i]) / 255.0f : ToLinear[Top[i]];
+
+		std::vector<float> Next;
+		for (uint32_t Mip = 1; Mip < MipCount; Mip++)
+		{
+			Downsample(Level, Mips[Mip - 1].Width, Mips[Mip - 1].Height, Next, Mips[Mip].Width, Mips[Mip].Height,
+				Spec.Filter);
+
+			uint8_t* Out = Bytes + Mips[Mip].Offset;
+			for (size_t i = 0; i < Next.size(); i++)
+			{
+				// The Kaiser lobes can overshoot
+				float Value = std::clamp(Next[i], 0.0f, 1.0f);
+				if (Spec.SRGB && (i & 3) != 3)
+					Value = LinearToSRGB(Value);
+				Out[i] = uint8_t(Value * 255.0f + 0.5f);
+			}
+			std::swap(Level, Next);
+		}
+	}
+}
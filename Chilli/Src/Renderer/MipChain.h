@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Image.h"
+
+namespace Chilli
+{
+	enum class MipFilter
+	{
+		BOX,
+		// Kaiser windowed sinc, sharper than the box at the cost of a wider kernel
+		KAISER
+	};
+
+	struct MipChainSpec
+	{
+		MipFilter Filter = MipFilter::KAISER;
+		// Color channels are filtered in linear space and stored back as sRGB, alpha is always linear
+		bool SRGB = false;
+	};
+
+	// Levels of a full chain down to 1x1
+	uint32_t GetFullMipCount(uint32_t Width, uint32_t Height);
+
+	// Lays the levels of a 4 byte per texel image out one after another, level 0 first. Returns the total size
+	uint64_t LayoutMipChainRGBA8(uint32_t Width, uint32_t Height, uint32_t MipCount, std::vector<ImageMipRegion>& Mips);
+
+	// Fills every level after the first from the one above it, level 0 has to be in place already
+	void GenerateMipChainRGBA8(void* Chain, const ImageMipRegion* Mips, uint32_t MipCount, const MipChainSpec& Spec);
+}
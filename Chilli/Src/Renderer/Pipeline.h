@@ -242,6 +242,15 @@ namespace Chilli
 		Chilli::ShaderStageType Stage;
 	};
 
+	// A user set binding of a program resolved from its name once, material updates carrying it index the
+	// program's bindings instead of searching them by name
+	struct MaterialBindingSlot
+	{
+		uint32_t ID = UINT32_MAX;
+
+		bool IsValid() const { return ID != UINT32_MAX; }
+	};
+
 	struct ReflectedSetUniformInput
 	{
 		uint32_t Set = 0;
@@ -274,9 +283,26 @@ namespace Chilli
 		uint64_t BinaryHash = 0;
 	};
 
+	// One bit per feature, bit N is the bool specialization constant with constant_id N. Shaders declare
+	// features as layout(constant_id = N) const bool NAME = false and branch on them
+	using ShaderPermutationKey = uint32_t;
+#define CH_SHADER_PERMUTATION_MAX_FEATURES 32
+
+	enum ShaderPermutationFeatures : ShaderPermutationKey
+	{
+		SHADER_FEATURE_ALPHA_TEST = 1 << 0,
+		SHADER_FEATURE_VERTEX_COLOR = 1 << 1,
+	};
+
 	struct ShaderProgram
 	{
 		uint32_t RawProgramHandle = -1;
+		ShaderPermutationKey Permutation = 0;
+		// Set on variants, the raw program belongs to the one they were specialized from
+		bool IsVariant = false;
+		BackBone::AssetHandle<ShaderProgram> BaseProgram;
+		// Variant assets handed out for this program, one per key
+		std::unordered_map<ShaderPermutationKey, BackBone::AssetHandle<ShaderProgram>> Variants;
 	};
 
 	enum ShaderDynamicStates {
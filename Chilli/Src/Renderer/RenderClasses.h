@@ -20,8 +20,12 @@ namespace Chilli
 		void MapBufferData(uint32_t BufferHandle, void* Data, uint32_t Size, uint32_t Offset = 0) {
 			_Api.lock()->MapBufferData(BufferHandle, Data, Size, Offset);
 		}
+		void ReadBufferData(uint32_t BufferHandle, void* Data, uint32_t Size, uint32_t Offset = 0) {
+			_Api.lock()->ReadBufferData(BufferHandle, Data, Size, Offset);
+		}
 
 		void FreeBuffer(uint32_t BufferHandle) { _Api.lock()->FreeBuffer(BufferHandle); }
+		void DeferDestroy(std::function<void()>&& Fn) { _Api.lock()->DeferDestroy(std::move(Fn)); }
 
 		inline uint32_t CreateSampler(const SamplerSpec& Spec) {
 			return _Api.lock()->CreateSampler(Spec);
@@ -34,6 +38,11 @@ namespace Chilli
 			_Api.lock()->PrepareForShutDown();
 		}
 
+		// Blocks until the GPU is done with everything submitted, only meant for rare resizes of shared resources
+		inline void WaitIdle() {
+			_Api.lock()->WaitIdle();
+		}
+
 		inline ShaderModule CreateShaderModule(const char* FilePath, ShaderStageType Type) {
 			return _Api.lock()->CreateShaderModule(FilePath, Type);
 		}
@@ -54,6 +63,9 @@ namespace Chilli
 		inline void LinkShaderProgram(uint32_t ProgramHandle) {
 			_Api.lock()->LinkShaderProgram(ProgramHandle);
 		}
+		inline uint32_t GetShaderProgramVariant(uint32_t ProgramHandle, ShaderPermutationKey Key) {
+			return _Api.lock()->GetShaderProgramVariant(ProgramHandle, Key);
+		}
 
 		inline uint32_t PrepareMaterialData(uint32_t ShaderProgramHandle)
 		{
@@ -80,6 +92,9 @@ namespace Chilli
 		inline void MapImageData(uint32_t ImageHandle, void* Data, int Width, int Height) {
 			_Api.lock()->MapImageData(ImageHandle, Data, Width, Height);
 		}
+		inline void MapImageMips(uint32_t ImageHandle, const void* Data, const ImageMipRegion* Mips, uint32_t MipCount) {
+			_Api.lock()->MapImageMips(ImageHandle, Data, Mips, MipCount);
+		}
 
 		inline uint32_t CreateTexture(uint32_t ImageHandle, TextureSpec& Spec) {
 			return _Api.lock()->CreateTexture(ImageHandle, Spec);
@@ -88,6 +103,10 @@ namespace Chilli
 		{
 			_Api.lock()->DestroyTexture(TextureHandle);
 		}
+		inline void AliasImages(const std::vector<ImageAliasRange>& Ranges)
+		{
+			_Api.lock()->AliasImages(Ranges.data(), uint32_t(Ranges.size()));
+		}
 
 	private:
 		std::weak_ptr<GraphicsBackendApi> _Api;
@@ -116,18 +135,13 @@ namespace Chilli
 		GraphicsBackendType GetType() const { return _Api->GetType(); }
 
 		void PushGraphicsCommandBuffer(const GraphicsCommandBuffer& Buffer) {
-			_FramePackets[_FrameIndex].Graphics_Stream.PushCommandBuffer(Buffer);
+			_GetGraphicsStream().PushCommandBuffer(Buffer);
 		}
 
-		void BeginRenderPass(const RenderPassDesc& Pass)
-		{
-			_FramePackets[_FrameIndex].Graphics_Stream.BeginRenderPass(Pass);
-		}
-
-		void EndRenderPass()
-		{
-			_FramePackets[_FrameIndex].Graphics_Stream.EndRenderPass();
-		}
+		// Everything recorded until EndRenderPass goes into a stream of its own, which the backend can
+		// translate on another thread. Barriers and shader data updates still go to the frame's stream
+		void BeginRenderPass(const RenderPassDesc& Pass);
+		void EndRenderPass();
 
 		void  PushPipelineBarriers(const PipelineBarrier* Barriers, uint32_t Count, RenderStreamTypes Stream)
 		{
@@ -151,88 +165,125 @@ namespace Chilli
 
 		void BindVertexBuffer(uint32_t* Buffers, uint32_t BindingCount)
 		{
-			_FramePackets[_FrameIndex].Graphics_Stream.BindVertexBuffer(Buffers, BindingCount);
+			_GetGraphicsStream().BindVertexBuffer(Buffers, BindingCount);
 		}
 
 		void BindVertexBuffer(const std::vector<uint32_t>& Buffers)
 		{
-			_FramePackets[_FrameIndex].Graphics_Stream.BindVertexBuffer(Buffers);
+			_GetGraphicsStream().BindVertexBuffer(Buffers);
 		}
 
 		void BindIndexBuffer(uint32_t Handle, IndexBufferType Type)
 		{
-			_FramePackets[_FrameIndex].Graphics_Stream.BindIndexBuffer(Handle, Type);
+			_GetGraphicsStream().BindIndexBuffer(Handle, Type);
 		}
 
 		void DrawIndexed(uint32_t ElementCount, uint32_t InstanceCount, uint32_t FirstElement, uint32_t VertexOffset, uint32_t FirstInstance)
 		{
-			_FramePackets[_FrameIndex].Graphics_Stream.DrawIndexed(ElementCount, InstanceCount, FirstElement,
+			_GetGraphicsStream().DrawIndexed(ElementCount, InstanceCount, FirstElement,
 				VertexOffset, FirstInstance);
 		}
 
+		void DrawIndexedIndirect(uint32_t Buffer, uint32_t Offset, uint32_t DrawCount,
+			uint32_t Stride = sizeof(DrawIndexedIndirectCommand))
+		{
+			_GetGraphicsStream().DrawIndexedIndirect(Buffer, Offset, DrawCount, Stride);
+		}
+
+		// Needs RenderDeviceLimits::bSupportsDrawIndirectCount
+		void DrawIndexedIndirectCount(uint32_t Buffer, uint32_t Offset, uint32_t CountBuffer, uint32_t CountOffset,
+			uint32_t MaxDrawCount, uint32_t Stride = sizeof(DrawIndexedIndirectCommand))
+		{
+			_GetGraphicsStream().DrawIndexedIndirectCount(Buffer, Offset, CountBuffer, CountOffset,
+				MaxDrawCount, Stride);
+		}
+
+		// Compute commands run at the start of the frame, before any render pass, and their writes are
+		// visible to indirect draws and vertex shaders of the same frame
+		void BindComputeShaderProgram(uint32_t ShaderProgram)
+		{
+			_FramePackets[_FrameIndex].Compute_Stream.BindShaderPrgoram(ShaderProgram);
+		}
+
+		void BindComputeMaterailData(uint32_t MaterialHandle)
+		{
+			_FramePackets[_FrameIndex].Compute_Stream.BindMaterailData(MaterialHandle);
+		}
+
+		void PushComputeInlineUniformData(uint32_t ShaderProgram, void* Data, uint32_t Size, uint32_t Offset)
+		{
+			_FramePackets[_FrameIndex].Compute_Stream.PushInlineUniformData(ShaderProgram, SHADER_STAGE_COMPUTE,
+				Data, Size, Offset);
+		}
+
+		void Dispatch(uint32_t GroupCountX, uint32_t GroupCountY = 1, uint32_t GroupCountZ = 1)
+		{
+			_FramePackets[_FrameIndex].Compute_Stream.Dispatch(GroupCountX, GroupCountY, GroupCountZ);
+		}
+
 		void DrawArray(uint32_t ElementCount, uint32_t InstanceCount, uint32_t FirstElement, uint32_t VertexOffset, uint32_t FirstInstance)
 		{
-			_FramePackets[_FrameIndex].Graphics_Stream.DrawArray(ElementCount, InstanceCount, FirstElement,
+			_GetGraphicsStream().DrawArray(ElementCount, InstanceCount, FirstElement,
 				VertexOffset, FirstInstance);
 		}
 
 		void BindShaderProgram(uint32_t ShaderProgramHandle)
 		{
-			_FramePackets[_FrameIndex].Graphics_Stream.BindShaderPrgoram(ShaderProgramHandle);
+			_GetGraphicsStream().BindShaderPrgoram(ShaderProgramHandle);
 		}
 
 		void SetFullPipelineState(const PipelineStateInfo& Info)
 		{
-			_FramePackets[_FrameIndex].Graphics_Stream.SetFullPipelineState(Info);
+			_GetGraphicsStream().SetFullPipelineState(Info);
 			_ActiveInfo = Info;
 		}
 
 		void SetVertexInputLayout(const VertexInputShaderLayout& Info)
 		{
-			_FramePackets[_FrameIndex].Graphics_Stream.SetVertexInputLayout(Info);
+			_GetGraphicsStream().SetVertexInputLayout(Info);
 			_ActiveVertexShaderLayout = Info;
 		}
 
 		void SetTopologyMode(InputTopologyMode Mode)
 		{
-			_FramePackets[_FrameIndex].Graphics_Stream.SetTopologyMode(Mode);
+			_GetGraphicsStream().SetTopologyMode(Mode);
 			_ActiveInfo.TopologyMode = Mode;
 		}
 
 		void SetCullMode(CullMode Mode)
 		{
-			_FramePackets[_FrameIndex].Graphics_Stream.SetCullMode(Mode);
+			_GetGraphicsStream().SetCullMode(Mode);
 		}
 
 		void SetFillMode(PolygonMode Mode)
 		{
-			_FramePackets[_FrameIndex].Graphics_Stream.SetFillMode(Mode);
+			_GetGraphicsStream().SetFillMode(Mode);
 		}
 
 		void SetFrontFace(FrontFaceMode Mode)
 		{
-			_FramePackets[_FrameIndex].Graphics_Stream.SetFrontFace(Mode);
+			_GetGraphicsStream().SetFrontFace(Mode);
 		}
 
 		void SetLineWidth(float Width)
 		{
-			_FramePackets[_FrameIndex].Graphics_Stream.SetLineWidth(Width);
+			_GetGraphicsStream().SetLineWidth(Width);
 			_ActiveInfo.LineWidth = Width;
 		}
 
 		void SetRasterizerDiscard(bool Enable)
 		{
-			_FramePackets[_FrameIndex].Graphics_Stream.SetRasterizerDiscard(Enable);
+			_GetGraphicsStream().SetRasterizerDiscard(Enable);
 		}
 
 		void SetDepthBiasEnable(bool Enable)
 		{
-			_FramePackets[_FrameIndex].Graphics_Stream.SetDepthBiasEnable(Enable);
+			_GetGraphicsStream().SetDepthBiasEnable(Enable);
 		}
 
 		void SetDepthBias(float ConstantFactor, float Clamp, float SlopeFactor)
 		{
-			_FramePackets[_FrameIndex].Graphics_Stream.SetDepthBias(
+			_GetGraphicsStream().SetDepthBias(
 				ConstantFactor,
 				Clamp,
 				SlopeFactor
@@ -241,13 +292,17 @@ namespace Chilli
 
 		void DisableDepthBias()
 		{
-			_FramePackets[_FrameIndex].Graphics_Stream.DisableDepthBias();
+			_GetGraphicsStream().DisableDepthBias();
 		}
 
 		uint32_t GetTextureShaderIndex(uint32_t RawTextureHandle) {
 			return _Api->GetTextureShaderIndex(RawTextureHandle);
 		}
 
+		void SetTextureScreenSize(uint32_t RawTextureHandle, float ScreenSize) {
+			_Api->SetTextureScreenSize(RawTextureHandle, ScreenSize);
+		}
+
 		uint32_t GetSamplerShaderIndex(uint32_t RawSamplerHandle) {
 			return _Api->GetSamplerShaderIndex(RawSamplerHandle);
 		}
@@ -260,8 +315,15 @@ namespace Chilli
 			_Api->UpdateMaterialShaderData(MaterialHandle, Data);
 		}
 
-		void UpdateObjectShaderData(BackBone::Entity Entity, const ObjectShaderData& Data) {
-			_Api->UpdateObjectShaderData(Entity, Data);
+		// Packs Count objects into the ring of the frame being recorded, OutFirstIndex is the first one's
+		// index in the object SSBO. Only valid for this frame, write through the pointer before allocating again
+		ObjectShaderData* AllocateObjectShaderData(uint32_t Count, uint32_t& OutFirstIndex) {
+			return _Api->AllocateObjectShaderData(_FrameIndex, Count, OutFirstIndex);
+		}
+
+		// Writes object shader indices for the frame being recorded, Offset is used as the draw's first instance
+		void UpdateInstanceIndexData(const uint32_t* Indices, uint32_t Count, uint32_t Offset = 0) {
+			_Api->UpdateInstanceIndexData(_FrameIndex, Indices, Count, Offset);
 		}
 
 		void UpdateMaterialBufferData(uint32_t MaterialHandle, uint32_t Buffer,
@@ -283,14 +345,40 @@ namespace Chilli
 			_FramePackets[_FrameIndex].Graphics_Stream.UpdateMaterialSamplerData(MaterialHandle, Sampler, Name, DstArrayIndex);
 		}
 
+		// Resolve the binding once when the material is set up, updates written every frame should pass the
+		// slot instead of the name. Invalid if the material's program has no such user binding
+		MaterialBindingSlot FindMaterialBindingSlot(uint32_t RawMaterialHandle, const char* Name) {
+			return _Api->FindMaterialBindingSlot(RawMaterialHandle, Name);
+		}
+
+		void UpdateMaterialBufferData(uint32_t MaterialHandle, uint32_t Buffer,
+			MaterialBindingSlot Slot, size_t Size, size_t Offset, uint32_t DstArrayIndex = 0)
+		{
+			_FramePackets[_FrameIndex].Graphics_Stream.UpdateMaterialBufferData(MaterialHandle, Buffer,
+				Slot, Size, Offset, DstArrayIndex);
+		}
+
+		void UpdateMaterialTextureData(uint32_t MaterialHandle,
+			uint32_t Tex, MaterialBindingSlot Slot, ResourceState State, uint32_t DstArrayIndex = 0)
+		{
+			_FramePackets[_FrameIndex].Graphics_Stream.UpdateMaterialTextureData(MaterialHandle,
+				Tex, Slot, State, DstArrayIndex);
+		}
+
+		void UpdateMaterialSamplerData(uint32_t MaterialHandle, uint32_t Sampler, MaterialBindingSlot Slot,
+			uint32_t DstArrayIndex = 0)
+		{
+			_FramePackets[_FrameIndex].Graphics_Stream.UpdateMaterialSamplerData(MaterialHandle, Sampler, Slot, DstArrayIndex);
+		}
+
 		void BindMaterailData(uint32_t MaterialHandle)
 		{
-			_FramePackets[_FrameIndex].Graphics_Stream.BindMaterailData(MaterialHandle);
+			_GetGraphicsStream().BindMaterailData(MaterialHandle);
 		}
 
 		void PushInlineUniformData(uint32_t ShaderProgram, uint32_t Stage, void* Data, uint32_t Size, uint32_t Offset)
 		{
-			_FramePackets[_FrameIndex].Graphics_Stream.PushInlineUniformData(ShaderProgram, Stage, Data, Size, Offset);
+			_GetGraphicsStream().PushInlineUniformData(ShaderProgram, Stage, Data, Size, Offset);
 		}
 
 		void PushUpdateGlobalShaderData(const GlobalShaderData& Data)
@@ -307,9 +395,9 @@ namespace Chilli
 			return _Api->GetCurrentFrameIndex();
 		}
 
-		uint32_t GetObjectShaderIndex(uint32_t Entity) {
-			return _Api->GetObjectShaderIndex(Entity);
-		}
+		// Frame slot being recorded, GetCurrentFrameIndex only catches up once the frame is translated
+		uint32_t GetRecordingFrameIndex() const { return _FrameIndex; }
+		uint32_t GetMaxFramesInFlight() const { return _MaxFramesInFlight; }
 
 		void PushFrameBufferResize(const IVec2& NewSize)
 		{
@@ -342,8 +430,20 @@ namespace Chilli
 
 		const ShaderProgram& GetDeafultShaderProgram() { return _DeafultShaderProgram; }
 
+	private:
+		GraphicsCommandBuffer& _GetGraphicsStream()
+		{
+			auto& Packet = _FramePackets[_FrameIndex];
+			if (_ActivePassStream != UINT32_MAX)
+				return Packet.Pass_Streams[_ActivePassStream].Stream;
+			return Packet.Graphics_Stream;
+		}
+
 	private:
 		std::shared_ptr<GraphicsBackendApi> _Api;
+		// Declared ahead of the packets, their streams hand pages back into arena memory on destruction
+		MemoryArena _RenderPerFrameArena;
+		RenderCommandPagePool _CommandPagePool;
 		std::vector<RenderFramePacket> _FramePackets;
 
 		VertexInputShaderLayout _ActiveVertexShaderLayout;
@@ -353,8 +453,8 @@ namespace Chilli
 		// Separate data storage (also contiguous)
 		FrameAllocator _InlineUniformDataAllocator;
 
-		MemoryArena _RenderPerFrameArena;
 		uint32_t _FrameIndex = 0;
+		uint32_t _ActivePassStream = UINT32_MAX;
 		uint32_t _MaxFramesInFlight = 0;
 	};
 }
@@ -54,6 +54,7 @@ namespace Chilli
 		DRAW_ARRAY,
 		DRAW_INDEXED,
 		DRAW_INDEXED_INDIRECT,
+		DRAW_INDEXED_INDIRECT_COUNT,
 		DISPATCH,
 		DISPATCH_INDIRECT,
 
@@ -7,11 +7,21 @@ namespace Chilli
 	{
 		_Api = std::shared_ptr<GraphicsBackendApi>(GraphicsBackendApi::Create(Spec));
 		_RenderPerFrameArena.Prepare(5 * 1024 * 1024);
+		CH_MEMORY_TRACK_ALLOC(MemoryTag::RENDERER_CPU, _RenderPerFrameArena.Capacity());
 		_InlineUniformDataAllocator.Ref(_RenderPerFrameArena, 1 * 1024 * 128);
 
+		// Command pages come out of the frame arena once and are recycled by every stream after
+		_CommandPagePool.Init(_RenderPerFrameArena, 48);
+
 		_MaxFramesInFlight = Spec.MaxFrameInFlight;
 		_FrameIndex = 0;
 		_FramePackets.resize(_MaxFramesInFlight);
+		for (auto& Packet : _FramePackets)
+		{
+			Packet.Graphics_Stream.SetPagePool(&_CommandPagePool);
+			Packet.Compute_Stream.SetPagePool(&_CommandPagePool);
+			Packet.Transfer_Stream.SetPagePool(&_CommandPagePool);
+		}
 
 		auto VertexShader = _Api->CreateShaderModule("Assets/Shaders/shader_vert.spv",
 			Chilli::ShaderStageType::SHADER_STAGE_VERTEX);
@@ -29,18 +39,48 @@ namespace Chilli
 	void Renderer::Terminate()
 	{
 		GraphicsBackendApi::Terminate(_Api.get(), false);
+		CH_MEMORY_TRACK_FREE(MemoryTag::RENDERER_CPU, _RenderPerFrameArena.Capacity());
 	}
 
 	void Renderer::BeginFrame()
 	{
+		_Api->BeginFrame(_FrameIndex);
 		_FramePackets[_FrameIndex].Graphics_Stream.BeginFrame(_FrameIndex);
 	}
 
 	void Renderer::Clear()
 	{
-		_FramePackets[_FrameIndex].Graphics_Stream.Clear();
-		_FramePackets[_FrameIndex].Compute_Stream.Clear();
-		_FramePackets[_FrameIndex].Transfer_Stream.Clear();
+		auto& Packet = _FramePackets[_FrameIndex];
+		Packet.Graphics_Stream.Clear();
+		Packet.Compute_Stream.Clear();
+		Packet.Transfer_Stream.Clear();
+
+		for (uint32_t i = 0; i < Packet.Pass_StreamCount; i++)
+			Packet.Pass_Streams[i].Stream.Clear();
+		Packet.Pass_StreamCount = 0;
+		_ActivePassStream = UINT32_MAX;
+	}
+
+	void Renderer::BeginRenderPass(const RenderPassDesc& Pass)
+	{
+		CH_CORE_ASSERT(_ActivePassStream == UINT32_MAX, "Render passes can not be nested!");
+
+		auto& Packet = _FramePackets[_FrameIndex];
+		if (Packet.Pass_StreamCount == Packet.Pass_Streams.size())
+		{
+			Packet.Pass_Streams.emplace_back();
+			Packet.Pass_Streams.back().Stream.SetPagePool(&_CommandPagePool);
+		}
+
+		_ActivePassStream = Packet.Pass_StreamCount++;
+		Packet.Pass_Streams[_ActivePassStream].Pass = Pass;
+		Packet.Graphics_Stream.BeginRenderPass(Pass, _ActivePassStream);
+	}
+
+	void Renderer::EndRenderPass()
+	{
+		_ActivePassStream = UINT32_MAX;
+		_FramePackets[_FrameIndex].Graphics_Stream.EndRenderPass();
 	}
 
 	void Renderer::EndFrame()
@@ -0,0 +1,411 @@
+#include "Ch_PCH.h"
+#include "TextureCompression.h"
+#include <algorithm>
+
+namespace Chilli
+{
+	namespace
+	{
+		// Reads the bits of a 16 byte block from the least significant one up
+		struct BlockBitReader
+		{
+			uint64_t Low, High;
+			uint32_t Position = 0;
+
+			BlockBitReader(const uint8_t* Block)
+			{
+				memcpy(&Low, Block, 8);
+				memcpy(&High, Block + 8, 8);
+			}
+
+			uint32_t Read(uint32_t Count)
+			{
+				uint64_t Value;
+				if (Position >= 64)
+					Value = High >> (Position - 64);
+				else if (Position + Count <= 64)
+					Value = Low >> Position;
+				else
+					Value = (Low >> Position) | (High << (64 - Position));
+				Position += Count;
+				return uint32_t(Value) & ((1u << Count) - 1);
+			}
+		};
+
+		void Expand565(uint16_t Color, uint8_t* Texel)
+		{
+			uint32_t R = (Color >> 11) & 31, G = (Color >> 5) & 63, B = Color & 31;
+			Texel[0] = uint8_t((R << 3) | (R >> 2));
+			Texel[1] = uint8_t((G << 2) | (G >> 4));
+			Texel[2] = uint8_t((B << 3) | (B >> 2));
+			Texel[3] = 255;
+		}
+
+		// The BC1 color block, BC2 and BC3 always use it in four color mode
+		void DecodeColorBlock(const uint8_t* Block, uint8_t* Texels, bool AllowPunchThrough)
+		{
+			uint16_t C0 = uint16_t(Block[0] | (Block[1] << 8));
+			uint16_t C1 = uint16_t(Block[2] | (Block[3] << 8));
+
+			uint8_t Palette[4][4];
+			Expand565(C0, Palette[0]);
+			Expand565(C1, Palette[1]);
+			for (uint32_t Channel = 0; Channel < 3; Channel++)
+			{
+				uint32_t A = Palette[0][Channel], B = Palette[1][Channel];
+				if (C0 > C1 || !AllowPunchThrough)
+				{
+					Palette[2][Channel] = uint8_t((2 * A + B) / 3);
+					Palette[3][Channel] = uint8_t((A + 2 * B) / 3);
+				}
+				else
+				{
+					Palette[2][Channel] = uint8_t((A + B) / 2);
+					Palette[3][Channel] = 0;
+				}
+			}
+			Palette[2][3] = 255;
+			Palette[3][3] = (C0 > C1 || !AllowPunchThrough) ? 255 : 0;
+
+			uint32_t Indices = Block[4] | (Block[5] << 8) | (Block[6] << 16) | (uint32_t(Block[7]) << 24);
+			for (uint32_t i = 0; i < 16; i++)
+				memcpy(Texels + i * 4, Palette[(Indices >> (i * 2)) & 3], 4);
+		}
+
+		// BC4 block, also the alpha of BC3 and both channels of BC5
+		void DecodeChannelBlock(const uint8_t* Block, uint8_t* Texels, uint32_t Channel)
+		{
+			uint32_t A0 = Block[0], A1 = Block[1];
+
+			uint8_t Palette[8];
+			Palette[0] = uint8_t(A0);
+			Palette[1] = uint8_t(A1);
+			if (A0 > A1)
+			{
+				for (uint32_t i = 1; i < 7; i++)
+					Palette[i + 1] = uint8_t(((7 - i) * A0 + i * A1) / 7);
+			}
+			else
+			{
+				for (uint32_t i = 1; i < 5; i++)
+					Palette[i + 1] = uint8_t(((5 - i) * A0 + i * A1) / 5);
+				Palette[6] = 0;
+				Palette[7] = 255;
+			}
+
+			uint64_t Indices = 0;
+			for (uint32_t i = 0; i < 6; i++)
+				Indices |= uint64_t(Block[2 + i]) << (i * 8);
+			for (uint32_t i = 0; i < 16; i++)
+				Texels[i * 4 + Channel] = Palette[(Indices >> (i * 3)) & 7];
+		}
+
+		void DecodeBC2AlphaBlock(const uint8_t* Block, uint8_t* Texels)
+		{
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				uint32_t Alpha = (Block[i / 2] >> ((i & 1) * 4)) & 15;
+				Texels[i * 4 + 3] = uint8_t(Alpha | (Alpha << 4));
+			}
+		}
+
+		struct BC7ModeInfo
+		{
+			uint8_t Subsets, PartitionBits, RotationBits, IndexSelectionBits;
+			uint8_t ColorBits, AlphaBits, EndpointPBits, SharedPBits;
+			uint8_t IndexBits, SecondaryIndexBits;
+		};
+
+		const BC7ModeInfo BC7Modes[8] = {
+			{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+			{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+			{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+			{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+			{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+			{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+			{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+			{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+		};
+
+		// Bit i is the subset of texel i
+		const uint16_t BC7Partitions2[64] = {
+			0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+			0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+			0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+			0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+			0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+			0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+			0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+			0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+		};
+
+		const uint8_t BC7Partitions3[64][16] = {
+			{ 0,0,1,1, 0,0,1,1, 0,2,2,1, 2,2,2,2 }, { 0,0,0,1, 0,0,1,1, 2,2,1,1, 2,2,2,1 },
+			{ 0,0,0,0, 2,0,0,1, 2,2,1,1, 2,2,1,1 }, { 0,2,2,2, 0,0,2,2, 0,0,1,1, 0,1,1,1 },
+			{ 0,0,0,0, 0,0,0,0, 1,1,2,2, 1,1,2,2 }, { 0,0,1,1, 0,0,1,1, 0,0,2,2, 0,0,2,2 },
+			{ 0,0,2,2, 0,0,2,2, 1,1,1,1, 1,1,1,1 }, { 0,0,1,1, 0,0,1,1, 2,2,1,1, 2,2,1,1 },
+			{ 0,0,0,0, 0,0,0,0, 1,1,1,1, 2,2,2,2 }, { 0,0,0,0, 1,1,1,1, 1,1,1,1, 2,2,2,2 },
+			{ 0,0,0,0, 1,1,1,1, 2,2,2,2, 2,2,2,2 }, { 0,0,1,2, 0,0,1,2, 0,0,1,2, 0,0,1,2 },
+			{ 0,1,1,2, 0,1,1,2, 0,1,1,2, 0,1,1,2 }, { 0,1,2,2, 0,1,2,2, 0,1,2,2, 0,1,2,2 },
+			{ 0,0,1,1, 0,1,1,2, 1,1,2,2, 1,2,2,2 }, { 0,0,1,1, 2,0,0,1, 2,2,0,0, 2,2,2,0 },
+			{ 0,0,0,1, 0,0,1,1, 0,1,1,2, 1,1,2,2 }, { 0,1,1,1, 0,0,1,1, 2,0,0,1, 2,2,0,0 },
+			{ 0,0,0,0, 1,1,2,2, 1,1,2,2, 1,1,2,2 }, { 0,0,2,2, 0,0,2,2, 0,0,2,2, 1,1,1,1 },
+			{ 0,1,1,1, 0,1,1,1, 0,2,2,2, 0,2,2,2 }, { 0,0,0,1, 0,0,0,1, 2,2,2,1, 2,2,2,1 },
+			{ 0,0,0,0, 0,0,1,1, 0,1,2,2, 0,1,2,2 }, { 0,0,0,0, 1,1,0,0, 2,2,1,0, 2,2,1,0 },
+			{ 0,1,2,2, 0,1,2,2, 0,0,1,1, 0,0,0,0 }, { 0,0,1,2, 0,0,1,2, 1,1,2,2, 2,2,2,2 },
+			{ 0,1,1,0, 1,2,2,1, 1,2,2,1, 0,1,1,0 }, { 0,0,0,0, 0,1,1,0, 1,2,2,1, 1,2,2,1 },
+			{ 0,0,2,2, 1,1,0,2, 1,1,0,2, 0,0,2,2 }, { 0,1,1,0, 0,1,1,0, 2,0,0,2, 2,2,2,2 },
+			{ 0,0,1,1, 0,1,2,2, 0,1,2,2, 0,0,1,1 }, { 0,0,0,0, 2,0,0,0, 2,2,1,1, 2,2,2,1 },
+			{ 0,0,0,0, 0,0,0,2, 1,1,2,2, 1,2,2,2 }, { 0,2,2,2, 0,0,2,2, 0,0,1,2, 0,0,1,1 },
+			{ 0,0,1,1, 0,0,1,2, 0,0,2,2, 0,2,2,2 }, { 0,1,2,0, 0,1,2,0, 0,1,2,0, 0,1,2,0 },
+			{ 0,0,0,0, 1,1,1,1, 2,2,2,2, 0,0,0,0 }, { 0,1,2,0, 1,2,0,1, 2,0,1,2, 0,1,2,0 },
+			{ 0,1,2,0, 2,0,1,2, 1,2,0,1, 0,1,2,0 }, { 0,0,1,1, 2,2,0,0, 1,1,2,2, 0,0,1,1 },
+			{ 0,0,1,1, 1,1,2,2, 2,2,0,0, 0,0,1,1 }, { 0,1,0,1, 0,1,0,1, 2,2,2,2, 2,2,2,2 },
+			{ 0,0,0,0, 0,0,0,0, 2,1,2,1, 2,1,2,1 }, { 0,0,2,2, 1,1,2,2, 0,0,2,2, 1,1,2,2 },
+			{ 0,0,2,2, 0,0,1,1, 0,0,2,2, 0,0,1,1 }, { 0,2,2,0, 1,2,2,1, 0,2,2,0, 1,2,2,1 },
+			{ 0,1,0,1, 2,2,2,2, 2,2,2,2, 0,1,0,1 }, { 0,0,0,0, 2,1,2,1, 2,1,2,1, 2,1,2,1 },
+			{ 0,1,0,1, 0,1,0,1, 0,1,0,1, 2,2,2,2 }, { 0,2,2,2, 0,1,1,1, 0,2,2,2, 0,1,1,1 },
+			{ 0,0,0,2, 1,1,1,2, 0,0,0,2, 1,1,1,2 }, { 0,0,0,0, 2,1,1,2, 2,1,1,2, 2,1,1,2 },
+			{ 0,2,2,2, 0,1,1,1, 0,1,1,1, 0,2,2,2 }, { 0,0,0,2, 1,1,1,2, 1,1,1,2, 0,0,0,2 },
+			{ 0,1,1,0, 0,1,1,0, 0,1,1,0, 2,2,2,2 }, { 0,0,0,0, 0,0,0,0, 2,1,1,2, 2,1,1,2 },
+			{ 0,1,1,0, 0,1,1,0, 2,2,2,2, 2,2,2,2 }, { 0,0,2,2, 0,0,1,1, 0,0,1,1, 0,0,2,2 },
+			{ 0,0,2,2, 1,1,2,2, 1,1,2,2, 0,0,2,2 }, { 0,0,0,0, 0,0,0,0, 0,0,0,0, 2,1,1,2 },
+			{ 0,0,0,2, 0,0,0,1, 0,0,0,2, 0,0,0,1 }, { 0,2,2,2, 1,2,2,2, 0,2,2,2, 1,2,2,2 },
+			{ 0,1,0,1, 2,2,2,2, 2,2,2,2, 2,2,2,2 }, { 0,1,1,1, 2,0,1,1, 2,2,0,1, 2,2,2,0 },
+		};
+
+		// Texel holding the implicit high bit of the second subset's indices
+		const uint8_t BC7Anchors2[64] = {
+			15,15,15,15,15,15,15,15, 15,15,15,15,15,15,15,15,
+			15, 2, 8, 2, 2, 8, 8,15,  2, 8, 2, 2, 8, 8, 2, 2,
+			15,15, 6, 8, 2, 8,15,15,  2, 8, 2, 2, 2,15,15, 6,
+			 6, 2, 6, 8,15,15, 2, 2, 15,15,15,15,15, 2, 2,15,
+		};
+
+		// Same for the second and third subsets of the three subset partitions
+		const uint8_t BC7Anchors3[2][64] = {
+			{
+				 3, 3,15,15, 8, 3,15,15,  8, 8, 6, 6, 6, 5, 3, 3,
+				 3, 3, 8,15, 3, 3, 6,10,  5, 8, 8, 6, 8, 5,15,15,
+				 8,15, 3, 5, 6,10, 8,15, 15, 3,15, 5,15,15,15,15,
+				 3,15, 5, 5, 5, 8, 5,10,  5,10, 8,13,15,12, 3, 3,
+			},
+			{
+				15, 8, 8, 3,15,15, 3, 8, 15,15,15,15,15,15,15, 8,
+				15, 8,15, 3,15, 8,15, 8,  3,15, 6,10,15,15,10, 8,
+				15, 3,15,10,10, 8, 9,10,  6,15, 8,15, 3, 6, 6, 8,
+				15, 3,15,15,15,15,15,15, 15,15,15,15, 3,15,15, 8,
+			},
+		};
+
+		const uint8_t BC7Weights2[4] = { 0, 21, 43, 64 };
+		const uint8_t BC7Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+		const uint8_t BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		uint8_t BC7Interpolate(uint32_t E0, uint32_t E1, uint32_t Index, uint32_t IndexBits)
+		{
+			const uint8_t* Weights = IndexBits == 2 ? BC7Weights2 : (IndexBits == 3 ? BC7Weights3 : BC7Weights4);
+			uint32_t Weight = Weights[Index];
+			return uint8_t(((64 - Weight) * E0 + Weight * E1 + 32) >> 6);
+		}
+
+		uint32_t BC7Unquantize(uint32_t Value, uint32_t Bits)
+		{
+			Value <<= 8 - Bits;
+			return Value | (Value >> Bits);
+		}
+
+		void DecodeBC7Block(const uint8_t* Block, uint8_t* Texels)
+		{
+			uint32_t Mode = 0;
+			while (Mode < 8 && !(Block[0] & (1 << Mode)))
+				Mode++;
+
+			// Reserved mode, decodes to transparent black
+			if (Mode == 8)
+			{
+				memset(Texels, 0, 64);
+				return;
+			}
+
+			const auto& Info = BC7Modes[Mode];
+			BlockBitReader Bits(Block);
+			Bits.Position = Mode + 1;
+
+			uint32_t Partition = Bits.Read(Info.PartitionBits);
+			uint32_t Rotation = Bits.Read(Info.RotationBits);
+			uint32_t IndexSelection = Bits.Read(Info.IndexSelectionBits);
+
+			// Two endpoints per subset, channels are stored planar
+			uint32_t Endpoints[6][4] = {};
+			const uint32_t EndpointCount = Info.Subsets * 2u;
+			for (uint32_t Channel = 0; Channel < 3; Channel++)
+				for (uint32_t Endpoint = 0; Endpoint < EndpointCount; Endpoint++)
+					Endpoints[Endpoint][Channel] = Bits.Read(Info.ColorBits);
+			for (uint32_t Endpoint = 0; Endpoint < EndpointCount; Endpoint++)
+				Endpoints[Endpoint][3] = Bits.Read(Info.AlphaBits);
+
+			uint32_t ColorBits = Info.ColorBits, AlphaBits = Info.AlphaBits;
+			if (Info.EndpointPBits || Info.SharedPBits)
+			{
+				uint32_t PBits[6];
+				if (Info.EndpointPBits)
+					for (uint32_t Endpoint = 0; Endpoint < EndpointCount; Endpoint++)
+						PBits[Endpoint] = Bits.Read(1);
+				else
+					for (uint32_t Subset = 0; Subset < Info.Subsets; Subset++)
+						PBits[Subset * 2] = PBits[Subset * 2 + 1] = Bits.Read(1);
+
+				for (uint32_t Endpoint = 0; Endpoint < EndpointCount; Endpoint++)
+					for (uint32_t Channel = 0; Channel < 4; Channel++)
+						Endpoints[Endpoint][Channel] = (Endpoints[Endpoint][Channel] << 1) | PBits[Endpoint];
+				ColorBits++;
+				if (AlphaBits)
+					AlphaBits++;
+			}
+
+			for (uint32_t Endpoint = 0; Endpoint < EndpointCount; Endpoint++)
+			{
+				for (uint32_t Channel = 0; Channel < 3; Channel++)
+					Endpoints[Endpoint][Channel] = BC7Unquantize(Endpoints[Endpoint][Channel], ColorBits);
+				Endpoints[Endpoint][3] = AlphaBits ? BC7Unquantize(Endpoints[Endpoint][3], AlphaBits) : 255;
+			}
+
+			uint8_t Subsets[16];
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				if (Info.Subsets == 1)
+					Subsets[i] = 0;
+				else if (Info.Subsets == 2)
+					Subsets[i] = uint8_t((BC7Partitions2[Partition] >> i) & 1);
+				else
+					Subsets[i] = BC7Partitions3[Partition][i];
+			}
+
+			auto IsAnchor = [&](uint32_t i) {
+				if (i == 0)
+					return true;
+				if (Info.Subsets == 2)
+					return i == BC7Anchors2[Partition];
+				if (Info.Subsets == 3)
+					return i == BC7Anchors3[0][Partition] || i == BC7Anchors3[1][Partition];
+				return false;
+				};
+
+			uint8_t Indices[16], SecondaryIndices[16] = {};
+			for (uint32_t i = 0; i < 16; i++)
+				Indices[i] = uint8_t(Bits.Read(Info.IndexBits - (IsAnchor(i) ? 1 : 0)));
+			if (Info.SecondaryIndexBits)
+				for (uint32_t i = 0; i < 16; i++)
+					SecondaryIndices[i] = uint8_t(Bits.Read(Info.SecondaryIndexBits - (i == 0 ? 1 : 0)));
+
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				const uint32_t* E0 = Endpoints[Subsets[i] * 2];
+				const uint32_t* E1 = Endpoints[Subsets[i] * 2 + 1];
+				uint8_t* Texel = Texels + i * 4;
+
+				uint32_t ColorIndex = Indices[i], ColorIndexBits = Info.IndexBits;
+				uint32_t AlphaIndex = Indices[i], AlphaIndexBits = Info.IndexBits;
+				if (Info.SecondaryIndexBits)
+				{
+					AlphaIndex = SecondaryIndices[i];
+					AlphaIndexBits = Info.SecondaryIndexBits;
+					if (IndexSelection)
+					{
+						std::swap(ColorIndex, AlphaIndex);
+						std::swap(ColorIndexBits, AlphaIndexBits);
+					}
+				}
+
+				for (uint32_t Channel = 0; Channel < 3; Channel++)
+					Texel[Channel] = BC7Interpolate(E0[Channel], E1[Channel], ColorIndex, ColorIndexBits);
+				Texel[3] = BC7Interpolate(E0[3], E1[3], AlphaIndex, AlphaIndexBits);
+
+				if (Rotation)
+					std::swap(Texel[3], Texel[Rotation - 1]);
+			}
+		}
+	}
+
+	ImageFormat GetDecodedFormat(ImageFormat Format)
+	{
+		switch (Format)
+		{
+		case ImageFormat::BC1_RGBA:
+		case ImageFormat::BC2_RGBA:
+		case ImageFormat::BC3_RGBA:
+		case ImageFormat::BC4_R:
+		case ImageFormat::BC5_RG:
+		case ImageFormat::BC7_RGBA:
+			return ImageFormat::RGBA8;
+		case ImageFormat::BC1_SRGBA:
+		case ImageFormat::BC2_SRGBA:
+		case ImageFormat::BC3_SRGBA:
+		case ImageFormat::BC7_SRGBA:
+			return ImageFormat::SRGBA8;
+		default:
+			return ImageFormat::NONE;
+		}
+	}
+
+	bool DecodeBlockCompressedImage(ImageFormat Format, const void* Src, uint64_t SrcSize, uint32_t Width, uint32_t Height,
+		void* Dst)
+	{
+		if (GetDecodedFormat(Format) == ImageFormat::NONE)
+			return false;
+		if (SrcSize < GetBlockCompressedLevelSize(Format, Width, Height))
+			return false;
+
+		const uint32_t BlockSize = GetBlockCompressedBlockSize(Format);
+		const uint32_t BlocksX = (Width + 3) / 4, BlocksY = (Height + 3) / 4;
+		const uint8_t* Block = static_cast<const uint8_t*>(Src);
+		uint8_t* Out = static_cast<uint8_t*>(Dst);
+
+		for (uint32_t BlockY = 0; BlockY < BlocksY; BlockY++)
+		{
+			for (uint32_t BlockX = 0; BlockX < BlocksX; BlockX++, Block += BlockSize)
+			{
+				uint8_t Texels[16 * 4];
+				switch (Format)
+				{
+				case ImageFormat::BC1_RGBA:
+				case ImageFormat::BC1_SRGBA:
+					DecodeColorBlock(Block, Texels, true);
+					break;
+				case ImageFormat::BC2_RGBA:
+				case ImageFormat::BC2_SRGBA:
+					DecodeColorBlock(Block + 8, Texels, false);
+					DecodeBC2AlphaBlock(Block, Texels);
+					break;
+				case ImageFormat::BC3_RGBA:
+				case ImageFormat::BC3_SRGBA:
+					DecodeColorBlock(Block + 8, Texels, false);
+					DecodeChannelBlock(Block, Texels, 3);
+					break;
+				case ImageFormat::BC4_R:
+				case ImageFormat::BC5_RG:
+					for (uint32_t i = 0; i < 16; i++)
+					{
+						Texels[i * 4 + 1] = Texels[i * 4 + 2] = 0;
+						Texels[i * 4 + 3] = 255;
+					}
+					DecodeChannelBlock(Block, Texels, 0);
+					if (Format == ImageFormat::BC5_RG)
+						DecodeChannelBlock(Block + 8, Texels, 1);
+					break;
+				default:
+					DecodeBC7Block(Block, Texels);
+					break;
+				}
+
+				// Edge blocks of levels that are not a multiple of 4 are cropped
+				uint32_t CopyWidth = std::min(4u, Width - BlockX * 4);
+				uint32_t CopyHeight = std::min(4u, Height - BlockY * 4);
+				for (uint32_t Row = 0; Row < CopyHeight; Row++)
+					memcpy(Out + ((size_t(BlockY) * 4 + Row) * Width + BlockX * 4) * 4, Texels + Row * 16, CopyWidth * 4);
+			}
+		}
+		return true;
+	}
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Image.h"
+
+namespace Chilli
+{
+	// CPU decoding of block compressed images, used when the device cannot sample the format.
+	// BC1-BC5 and BC7 decode to RGBA8 (SRGBA8 for the sRGB variants), BC4 and BC5 fill the
+	// missing channels the way the sampler does (0 for G/B, 1 for alpha). BC6H has no decoder.
+
+	// Format the image decodes into, NONE when it cannot be decoded
+	ImageFormat GetDecodedFormat(ImageFormat Format);
+
+	// Decodes one Width x Height level into tightly packed texels of GetDecodedFormat(Format),
+	// fails when SrcSize bytes do not cover every block of the level
+	bool DecodeBlockCompressedImage(ImageFormat Format, const void* Src, uint64_t SrcSize, uint32_t Width, uint32_t Height,
+		void* Dst);
+}
@@ -86,6 +86,8 @@ namespace Chilli
 		_CreateLogicalDevice(DeviceExtensions);
 
 		_CommandManager.Init(_Data.Device);
+		_ShaderBinaryCache.Init(_Data.Device, _Spec.ShaderBinaryCachePath);
+		_ShaderManager.SetBinaryCache(&_ShaderBinaryCache);
 
 		_CreateVulkanDataUploader();
 
@@ -96,7 +98,18 @@ namespace Chilli
 		_CreateVulkanImageDataManager();
 
 		_BufferManager.Init(_Data.Device, _Data.Allocator, &_Uploader, 1e6);
+		_BufferManager.InitFrameStaging(_Data.Device.GetHandle(), _Spec.MaxFrameInFlight, _Spec.StagingRingSizePerFrame);
 		_CreateFrameResources();
+		_DeletionQueue.Init(_Spec.MaxFrameInFlight);
+		_BufferManager.PrepareFrameStaging(0, _FrameResource.InFlightFences[0]);
+
+		// One pool per recording slot and frame, the submitting thread is always a slot of its own
+		uint32_t RecordingThreads = _Spec.RecordingThreadCount;
+		if (RecordingThreads == UINT32_MAX)
+			RecordingThreads = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+		_ParallelRecorder.Init(_Data.Device.GetHandle(),
+			_Data.Device.GetPhysicalDevice()->Info.QueueIndicies.Queues[int(QueueFamilies::GRAPHICS)].value(),
+			_Spec.MaxFrameInFlight, RecordingThreads);
 
 		_BindlessCreateInfo.Device = &_Data.Device;
 		_BindlessCreateInfo.MaxFrameInFlight = _Spec.MaxFrameInFlight;
@@ -115,7 +128,17 @@ namespace Chilli
 			this->MapBufferData(BufferHandle, Data, Size, Offset);
 			};
 
+		_BindlessCreateInfo.GetMappedBuffer = [&](uint32_t id) {
+			return this->_BufferManager.Get(id)->AllocationInfo.pMappedData;
+			};
+
+		_BindlessCreateInfo.FlushBuffer = [&](uint32_t id, uint32_t Offset, uint32_t Size) {
+			// No-op on host coherent memory
+			vmaFlushAllocation(_Data.Allocator, this->_BufferManager.Get(id)->Allocation, Offset, Size);
+			};
+
 		_BindlessManager.Init(_BindlessCreateInfo);
+		_ShaderManager.SetEngineSetLayoutHash(_BindlessManager.GetSetLayoutHash());
 		_CreateGeneralDescriptorPool();
 
 		VULKAN_PRINTLN("Vulkan Backend Initiaed!");
@@ -123,6 +146,10 @@ namespace Chilli
 
 	void VulkanGraphicsBackend::Terminate()
 	{
+		// The device is idle after PrepareForShutDown, whatever the managers free from here on goes at once
+		_DeletionQueue.Destroy();
+		_ShaderBinaryCache.Save();
+		_ParallelRecorder.Destroy();
 		_CommandManager.Free(_Data.Device.GetHandle());
 		_DestroyVulkanDataUploader();
 		_BindlessManager.Destroy(_BindlessCreateInfo);
@@ -142,9 +169,14 @@ namespace Chilli
 		VULKAN_PRINTLN("Vulkan ShutDown!");
 	}
 
+	// Called before the frame is recorded, the frame's object ring gets rewritten while recording so the
+	// previous submission using the same slot has to be retired first
 	void VulkanGraphicsBackend::BeginFrame(uint32_t Index)
 	{
-		_FrameResource.CurrentFrameIndex = Index;
+		vkWaitForFences(_Data.Device.GetHandle(), 1, &_FrameResource.InFlightFences[Index], VK_TRUE, UINT64_MAX);
+		_DeletionQueue.BeginFrame(Index);
+		_BindlessManager.ResetObjectShaderData(Index);
+		_BufferManager.BeginFrameStaging(Index);
 	}
 
 	VkCommandBuffer VulkanGraphicsBackend::_BeginFrame(const BeginFrameCmdPayload& Payload)
@@ -155,6 +187,10 @@ namespace Chilli
 
 		_FrameResource.CurrentFrameIndex = Payload.FrameIndex;
 
+		// Resizes and suboptimal presents only flag the swapchain, it is replaced here before an image of
+		// this frame has been acquired from it
+		_ReCreateSwapChainKHR();
+
 		VkResult result = vkAcquireNextImageKHR(_Data.Device.GetHandle(), _Data.SwapChainKHR.GetHandle(), UINT64_MAX,
 			_FrameResource.ImageAvailableSemaphores[_FrameResource.CurrentFrameIndex], VK_NULL_HANDLE,
 			&_FrameResource.CurrentImageIndex);
@@ -183,6 +219,8 @@ namespace Chilli
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		beginInfo.flags = 0;
 		vkBeginCommandBuffer(CmdBuffer, &beginInfo);
+		// Dynamic state is undefined at the start of every command buffer
+		_PrimaryContext.Begin(CmdBuffer);
 		return CmdBuffer;
 	}
 
@@ -191,7 +229,8 @@ namespace Chilli
 		vkEndCommandBuffer(CmdBuffer);
 	}
 
-	void VulkanGraphicsBackend::_BeginRenderPass(const BeginRenderPassCmdPayload& PassPayload, VkCommandBuffer CmdBuffer)
+	void VulkanGraphicsBackend::_BeginRenderPass(const BeginRenderPassCmdPayload& PassPayload, VkCommandBuffer CmdBuffer,
+		bool SecondaryContents)
 	{
 		auto& Payload = PassPayload.Pass;
 
@@ -265,6 +304,14 @@ namespace Chilli
 		RenderingInfo.colorAttachmentCount = static_cast<uint32_t>(Payload.ColorAttachmentCount);
 		RenderingInfo.pColorAttachments = ColorAttachments;
 
+		// A pass recorded into secondaries may only execute them, the secondaries set their own viewport
+		if (SecondaryContents)
+		{
+			RenderingInfo.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
+			vkCmdBeginRendering(CmdBuffer, &RenderingInfo);
+			return;
+		}
+
 		vkCmdBeginRendering(CmdBuffer, &RenderingInfo);
 		_SetViewPortSize(CmdBuffer, Payload.RenderArea.x, Payload.RenderArea.y);
 		_SetScissorSize(CmdBuffer, Payload.RenderArea.x, Payload.RenderArea.y);
@@ -323,28 +370,21 @@ namespace Chilli
 		}
 	}
 
-	VkCommandBuffer VulkanGraphicsBackend::_TranslateGraphicsCommandBuffer(const GraphicsCommandBuffer& CmdBuffer)
+	VkCommandBuffer VulkanGraphicsBackend::_TranslateGraphicsCommandBuffer(const RenderFramePacket& Packet)
 	{
-		volatile int Offset = (int)0;
-		volatile auto Dst = (uint8_t*)CmdBuffer.Data();
-		volatile auto Buffasda = (const GraphicsCommandBuffer*)&CmdBuffer;
+		const GraphicsCommandBuffer& CmdBuffer = Packet.Graphics_Stream;
+		const ComputeCommandBuffer& ComputeStream = Packet.Compute_Stream;
 
-		volatile VkCommandBuffer ActiveCommandBuffer = (VkCommandBuffer)VK_NULL_HANDLE;
+		VkCommandBuffer ActiveCommandBuffer = VK_NULL_HANDLE;
 
-		while (Offset < CmdBuffer.Size())
+		RenderCommandReader Reader(CmdBuffer);
+		RenderCommand Command;
+		while (Reader.Next(Command))
 		{
-			RenderCommandHeader Header;
-			std::memcpy(&Header, Dst, sizeof(Header));
-
-			Dst += sizeof(Header);
-			Offset += sizeof(Header);
-
-			size_t PayloadSize = Header.Size;
+			// Payloads are 8 byte aligned and read in place
+			const uint8_t* Dst = Command.Payload;
 
-			if (Offset + PayloadSize > CmdBuffer.Size())
-				break;
-
-			switch (Header.Code)
+			switch (Command.Code)
 			{
 			case RenderOpCode::BEGIN_FRAME:
 			{
@@ -356,12 +396,27 @@ namespace Chilli
 				_Stats.IndiciesRendered = 0;
 				_Stats.VerticesRendered = 0;
 				_Stats.DrawCallsPerFrame = 0;
+				_Stats.IndirectDrawCallsPerFrame = 0;
 				_Stats.TrianglesPerFrame = 0;
 				_Stats.DescriptorSetBinds = 0;
+				_Stats.DispatchesPerFrame = 0;
+				_Stats.DynamicStateCallsPerFrame = 0;
+				_Stats.DynamicStateCallsSkipped = 0;
+
+				// Everything the frame packed into its object ring is visible before the submit, and the
+				// frame's material region catches up with every update since it last ran
+				const uint32_t RecordedFrame = ((BeginFrameCmdPayload*)(Dst))->FrameIndex;
+				_BindlessManager.FlushObjectShaderData(RecordedFrame);
+				_BindlessManager.FlushMaterialShaderData(RecordedFrame);
+				_Stats.ObjectsPerFrame = _BindlessManager.GetObjectShaderDataCount(RecordedFrame);
+				_Stats.ObjectCapacityPerFrame = _BindlessManager.GetObjectShaderDataCapacity(RecordedFrame);
 
 				_Stats.TotalImagesAllocated = _ImageDataManager.GetImageAllocatedCount();
 				_Stats.TotalTexturesCreated = _ImageDataManager.GetTextureAllocatedCount();
 				_Stats.TotalBuffersCreated = _BufferManager.GetActiveCount();
+				_Stats.UploadBatchesInFlight = _Uploader.GetPendingBatchCount();
+				_Stats.PendingDeletions = _DeletionQueue.GetPendingCount();
+				_Stats.DeletionsPerFrame = _DeletionQueue.GetFlushedCount();
 
 				const VkPhysicalDeviceMemoryProperties* memProps = nullptr;
 				vmaGetMemoryProperties(_Data.Allocator, &memProps);
@@ -376,30 +431,77 @@ namespace Chilli
 				FillVmaMemoryUsageHeaps(_Data.Allocator, memProps, _Stats.MemoryUsed.GpuLocal, _Stats.MemoryUsed.Upload,
 					_Stats.MemoryUsed.CpuReadback);
 
+				// Streamed textures follow the device local heaps
+				uint64_t DeviceLocalUsage = 0, DeviceLocalBudget = 0;
+				for (uint32_t i = 0; i < memProps->memoryHeapCount; i++)
+					if (memProps->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+					{
+						DeviceLocalUsage += budgets[i].usage;
+						DeviceLocalBudget += budgets[i].budget;
+					}
+				_ImageDataManager.UpdateStreaming(DeviceLocalUsage, DeviceLocalBudget);
+				_Stats.StreamedTextures = _ImageDataManager.GetStreamedImageCount();
+				_Stats.StreamedMipsRaisedPerFrame = _ImageDataManager.GetStreamedMipsRaised();
+				_Stats.StreamedMipsEvictedPerFrame = _ImageDataManager.GetStreamedMipsEvicted();
+				_Stats.StreamedTextureBytes = _ImageDataManager.GetStreamedResidentBytes();
+				_Stats.AliasedImages = _ImageDataManager.GetAliasedImageCount();
+				_Stats.AliasedImageBytes = _ImageDataManager.GetAliasedMemoryBytes();
+				_Stats.AliasedImageBytesSaved = _ImageDataManager.GetAliasedBytesSaved();
+
 				_UpdateAllMaterialUpdateData();
+				_BindlessManager.AppendPendingWrites(RecordedFrame, _FrameResource.WritingSets);
+				_Stats.DescriptorWritesPerFrame = uint32_t(_FrameResource.WritingSets.size());
 
-				// This is the function that must be called after the loop completes
-				vkUpdateDescriptorSets(
-					_Data.Device.GetHandle(),
-					static_cast<uint32_t>(_FrameResource.WritingSets.size()),
-					_FrameResource.WritingSets.data(),
-					0,
-					nullptr // No copies are being performed here
-				);
+				// Every descriptor write of the frame goes out in this one call
+				if (!_FrameResource.WritingSets.empty())
+				{
+					vkUpdateDescriptorSets(
+						_Data.Device.GetHandle(),
+						static_cast<uint32_t>(_FrameResource.WritingSets.size()),
+						_FrameResource.WritingSets.data(),
+						0,
+						nullptr // No copies are being performed here
+					);
+				}
 				_FrameResource.MaterailWritingDatas.clear();
+				_BindlessManager.ClearPendingWrites();
 
 				auto Payload = (BeginFrameCmdPayload*)(Dst);
 				ActiveCommandBuffer = _BeginFrame(*Payload);
 
 				if (ActiveCommandBuffer == VK_NULL_HANDLE)
+				{
+					_BufferManager.SubmitFrameCopies();
 					return ActiveCommandBuffer;
+				}
+
+				// DYNAMIC_COPY writes made for the frame land before anything of the frame reads them
+				_Stats.StagingRingBytesPerFrame = uint32_t(_BufferManager.GetFrameStagingUsed());
+				_Stats.StagingRingCapacityPerFrame = uint32_t(_BufferManager.GetFrameStagingCapacity());
+				_Stats.StagingRingOverflows = _BufferManager.GetFrameStagingOverflows();
+				_BufferManager.RecordFrameCopies(ActiveCommandBuffer);
+
+				// Compute work shares the graphics queue and runs before the first render pass
+				_TranslateComputeCommandBuffer(ComputeStream, ActiveCommandBuffer);
+
+				// Passes that recorded into their own stream are translated into secondaries on the
+				// recording threads while the rest of the frame is walked here
+				if (Packet.Pass_StreamCount > 0)
+				{
+					if (_PassContexts.size() < Packet.Pass_StreamCount)
+						_PassContexts.resize(Packet.Pass_StreamCount);
+
+					_ParallelRecorder.Dispatch(_FrameResource.CurrentFrameIndex, Packet.Pass_StreamCount,
+						[this, &Packet](uint32_t Job, VkCommandBuffer Secondary) {
+							_RecordPassStream(Packet.Pass_Streams[Job], Secondary, _PassContexts[Job]);
+						});
+				}
 				break;
 			}
 			case RenderOpCode::FRAME_BUFFER_RESIZE:
 			{
 				auto Payload = (FrameBufferResizeCmdPayload*)(Dst);
 				_Spec.ViewPortResized = true;
-				this->_ReCreateSwapChainKHR();
 				break;
 			}
 			case RenderOpCode::UPDATE_GLOBAL_SHADER_DATA:
@@ -500,7 +602,15 @@ namespace Chilli
 			case RenderOpCode::BEGIN_RENDER_PASS:
 			{
 				auto Payload = (BeginRenderPassCmdPayload*)(Dst);
-				_BeginRenderPass(*Payload, ActiveCommandBuffer);
+				if (Payload->PassStream == UINT32_MAX)
+				{
+					_BeginRenderPass(*Payload, ActiveCommandBuffer);
+					break;
+				}
+
+				_BeginRenderPass(*Payload, ActiveCommandBuffer, true);
+				VkCommandBuffer Secondary = _ParallelRecorder.Wait(Payload->PassStream);
+				vkCmdExecuteCommands(ActiveCommandBuffer, 1, &Secondary);
 				break;
 			}
 			case RenderOpCode::END_RENDER_PASS:
@@ -516,202 +626,495 @@ namespace Chilli
 				_ExecutePipelineBarriers(BarrierPtr, Payload->BarriersCount, ActiveCommandBuffer);
 				break;
 			}
-			case RenderOpCode::PATCH_DYNAMIC_STATE:
+			case RenderOpCode::UPDATE_MATERIL_DATA:
 			{
-				const auto* Payload =
-					reinterpret_cast<const SetDynamicPipleineStateCmdPayload*>(Dst);
+				auto Payload = (MaterialDataUpdateCmdPayload*)(Dst);
+				_AppendMaterialUpdateData(*Payload);
+				break;
+			}
+			default:
+				if (!_TranslateDrawCommand(Command.Code, Dst, _PrimaryContext))
+					CH_CORE_ERROR("Opcode {0} is not supported on the graphics stream!", int(Command.Code));
+				break;
+			}
+		}
 
-				// ─────────────────────────────────────────────
-				// Primitive topology
-				// ─────────────────────────────────────────────
-				// if (Payload->TopologyMode != InputTopologyMode::None)
-				{
-					SetPrimitiveTopology(ActiveCommandBuffer, Payload->TopologyMode);
+		_ParallelRecorder.WaitAll();
+		_MergeRecordingStats(_PrimaryContext.Stats);
+		for (uint32_t i = 0; i < Packet.Pass_StreamCount; i++)
+			_MergeRecordingStats(_PassContexts[i].Stats);
+		_Stats.ParallelPassesPerFrame = Packet.Pass_StreamCount;
 
-					// Primitive Restart is only useful for Strips and Fans
-					// It allows a special index (0xFFFF or 0xFFFFFFFF) to break the strip
-					const ChBool8 restart = (
-						Payload->TopologyMode == InputTopologyMode::Line_Strip ||
-						Payload->TopologyMode == InputTopologyMode::Triangle_Strip ||
-						Payload->TopologyMode == InputTopologyMode::Triangle_Fan
-						) ? CH_TRUE : CH_FALSE;
+		return ActiveCommandBuffer;
+	}
 
-					SetPrimitiveRestartEnable(ActiveCommandBuffer, restart);
-				}
+	void VulkanGraphicsBackend::_RecordPassStream(const RenderPassStream& PassStream, VkCommandBuffer CmdBuffer,
+		VulkanRecordingContext& Ctx)
+	{
+		auto& Pass = PassStream.Pass;
 
-				// ─────────────────────────────────────────────
-				// Rasterization
-				// ─────────────────────────────────────────────
-				if (Payload->ShaderCullMode != CullMode::None)
-					SetCullMode(ActiveCommandBuffer, Payload->ShaderCullMode);
+		// The secondary has to declare the attachment formats of the pass it executes in
+		VkFormat ColorFormats[CHILLI_MAX_COLOR_ATTACHMENT];
+		VkSampleCountFlagBits Samples = VK_SAMPLE_COUNT_1_BIT;
+		for (int i = 0; i < Pass.ColorAttachmentCount; i++)
+		{
+			auto& Attachment = Pass.ColorAttachments[i];
+			if (Attachment.UseSwapChainImage)
+			{
+				ColorFormats[i] = _Data.SwapChainKHR.GetFormat();
+				continue;
+			}
 
-				if (Payload->FrontFace != FrontFaceMode::None)
-					SetFrontFace(ActiveCommandBuffer, Payload->FrontFace);
+			auto Texture = _ImageDataManager.GetTexture(Attachment.ColorTexture);
+			auto& ImgSpec = _ImageDataManager.GetImage(Texture->GetImageHandle())->GetSpec();
+			ImageFormat Format = Texture->GetSpec().Format != ImageFormat::NONE ? Texture->GetSpec().Format : ImgSpec.Format;
+			ColorFormats[i] = FormatToVk(Format);
+			Samples = SampleCountToVk(uint32_t(ImgSpec.Sample));
+		}
 
-				if (Payload->ShaderFillMode != PolygonMode::None)
-					SetPolygonMode(ActiveCommandBuffer, Payload->ShaderFillMode);
+		VkFormat DepthFormat = VK_FORMAT_UNDEFINED;
+		if (Pass.HasDepthStencil)
+		{
+			auto Texture = _ImageDataManager.GetTexture(Pass.DepthStencil.DepthTexture);
+			auto& ImgSpec = _ImageDataManager.GetImage(Texture->GetImageHandle())->GetSpec();
+			ImageFormat Format = Texture->GetSpec().Format != ImageFormat::NONE ? Texture->GetSpec().Format : ImgSpec.Format;
+			DepthFormat = FormatToVk(Format);
+			Samples = SampleCountToVk(uint32_t(ImgSpec.Sample));
+		}
+
+		VkCommandBufferInheritanceRenderingInfo RenderingInheritance{};
+		RenderingInheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+		RenderingInheritance.colorAttachmentCount = uint32_t(Pass.ColorAttachmentCount);
+		RenderingInheritance.pColorAttachmentFormats = ColorFormats;
+		RenderingInheritance.depthAttachmentFormat = DepthFormat;
+		RenderingInheritance.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+		RenderingInheritance.rasterizationSamples = Samples;
+
+		VkCommandBufferInheritanceInfo Inheritance{};
+		Inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		Inheritance.pNext = &RenderingInheritance;
+
+		VkCommandBufferBeginInfo BeginInfo{};
+		BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		BeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		BeginInfo.pInheritanceInfo = &Inheritance;
+		vkBeginCommandBuffer(CmdBuffer, &BeginInfo);
+
+		// Secondaries inherit no dynamic state from the primary
+		Ctx.Begin(CmdBuffer);
+		_SetViewPortSize(CmdBuffer, Pass.RenderArea.x, Pass.RenderArea.y);
+		_SetScissorSize(CmdBuffer, Pass.RenderArea.x, Pass.RenderArea.y);
+
+		RenderCommandReader Reader(PassStream.Stream);
+		RenderCommand Command;
+		while (Reader.Next(Command))
+		{
+			if (!_TranslateDrawCommand(Command.Code, Command.Payload, Ctx))
+				CH_CORE_ERROR("Opcode {0} is not supported inside a render pass stream!", int(Command.Code));
+		}
 
-				if (Payload->LineWidth != SetDynamicPipleineStateCmdPayload::UNCHANGE_FLOAT_VALUE)
-					SetLineWidth(ActiveCommandBuffer, Payload->LineWidth);
+		vkEndCommandBuffer(CmdBuffer);
+	}
 
-				if (Payload->RasterizerDiscardEnable != CH_NONE)
-					SetRasterizerDiscardEnable(ActiveCommandBuffer,
-						Payload->RasterizerDiscardEnable);
+	void VulkanGraphicsBackend::_MergeRecordingStats(const RenderDeviceStats& Stats)
+	{
+		_Stats.IndiciesRendered += Stats.IndiciesRendered;
+		_Stats.VerticesRendered += Stats.VerticesRendered;
+		_Stats.DrawCallsPerFrame += Stats.DrawCallsPerFrame;
+		_Stats.IndirectDrawCallsPerFrame += Stats.IndirectDrawCallsPerFrame;
+		_Stats.TrianglesPerFrame += Stats.TrianglesPerFrame;
+		_Stats.DynamicStateCallsPerFrame += Stats.DynamicStateCallsPerFrame;
+		_Stats.DynamicStateCallsSkipped += Stats.DynamicStateCallsSkipped;
+	}
 
-				// ─────────────────────────────────────────────
-				// Depth bias
-				// ─────────────────────────────────────────────
-				if (Payload->DepthBiasEnable != CH_NONE)
-					SetDepthBiasEnable(ActiveCommandBuffer, Payload->DepthBiasEnable);
+	bool VulkanGraphicsBackend::_TranslateDrawCommand(RenderOpCode Code, const uint8_t* Dst, VulkanRecordingContext& Ctx)
+	{
+		switch (Code)
+		{
+		case RenderOpCode::PATCH_DYNAMIC_STATE:
+		{
+			const auto* Payload =
+				reinterpret_cast<const SetDynamicPipleineStateCmdPayload*>(Dst);
 
-				// Only apply depth bias values if at least one is provided
-				const bool hasDepthBiasValues =
-					Payload->DepthBiasConstantFactor != SetDynamicPipleineStateCmdPayload::UNCHANGE_FLOAT_VALUE ||
-					Payload->DepthBiasClamp != SetDynamicPipleineStateCmdPayload::UNCHANGE_FLOAT_VALUE ||
-					Payload->DepthBiasSlopeFactor != SetDynamicPipleineStateCmdPayload::UNCHANGE_FLOAT_VALUE;
+			// ─────────────────────────────────────────────
+			// Primitive topology
+			// ─────────────────────────────────────────────
+			// if (Payload->TopologyMode != InputTopologyMode::None)
+			{
+				SetPrimitiveTopology(Ctx, Payload->TopologyMode);
 
-				if (hasDepthBiasValues)
-				{
-					SetDepthBias(
-						ActiveCommandBuffer,
-						Payload->DepthBiasConstantFactor != SetDynamicPipleineStateCmdPayload::UNCHANGE_FLOAT_VALUE
-						? Payload->DepthBiasConstantFactor
-						: 0.0f,
-						Payload->DepthBiasClamp != SetDynamicPipleineStateCmdPayload::UNCHANGE_FLOAT_VALUE
-						? Payload->DepthBiasClamp
-						: 0.0f,
-						Payload->DepthBiasSlopeFactor != SetDynamicPipleineStateCmdPayload::UNCHANGE_FLOAT_VALUE
-						? Payload->DepthBiasSlopeFactor
-						: 0.0f
-					);
-				}
+				// Primitive Restart is only useful for Strips and Fans
+				// It allows a special index (0xFFFF or 0xFFFFFFFF) to break the strip
+				const ChBool8 restart = (
+					Payload->TopologyMode == InputTopologyMode::Line_Strip ||
+					Payload->TopologyMode == InputTopologyMode::Triangle_Strip ||
+					Payload->TopologyMode == InputTopologyMode::Triangle_Fan
+					) ? CH_TRUE : CH_FALSE;
 
-				break;
+				SetPrimitiveRestartEnable(Ctx, restart);
 			}
-			case RenderOpCode::SET_VERTEX_LAYOUT:
+
+			// ─────────────────────────────────────────────
+			// Rasterization
+			// ─────────────────────────────────────────────
+			if (Payload->ShaderCullMode != CullMode::None)
+				SetCullMode(Ctx, Payload->ShaderCullMode);
+
+			if (Payload->FrontFace != FrontFaceMode::None)
+				SetFrontFace(Ctx, Payload->FrontFace);
+
+			if (Payload->ShaderFillMode != PolygonMode::None)
+				SetPolygonMode(Ctx, Payload->ShaderFillMode);
+
+			if (Payload->LineWidth != SetDynamicPipleineStateCmdPayload::UNCHANGE_FLOAT_VALUE)
+				SetLineWidth(Ctx, Payload->LineWidth);
+
+			if (Payload->RasterizerDiscardEnable != CH_NONE)
+				SetRasterizerDiscardEnable(Ctx,
+					Payload->RasterizerDiscardEnable);
+
+			// ─────────────────────────────────────────────
+			// Depth bias
+			// ─────────────────────────────────────────────
+			if (Payload->DepthBiasEnable != CH_NONE)
+				SetDepthBiasEnable(Ctx, Payload->DepthBiasEnable);
+
+			// Only apply depth bias values if at least one is provided
+			const bool hasDepthBiasValues =
+				Payload->DepthBiasConstantFactor != SetDynamicPipleineStateCmdPayload::UNCHANGE_FLOAT_VALUE ||
+				Payload->DepthBiasClamp != SetDynamicPipleineStateCmdPayload::UNCHANGE_FLOAT_VALUE ||
+				Payload->DepthBiasSlopeFactor != SetDynamicPipleineStateCmdPayload::UNCHANGE_FLOAT_VALUE;
+
+			if (hasDepthBiasValues)
 			{
-				auto Payload = (SetVertexLayoutCmdPayload*)(Dst);
+				SetDepthBias(
+					Ctx.CmdBuffer,
+					Payload->DepthBiasConstantFactor != SetDynamicPipleineStateCmdPayload::UNCHANGE_FLOAT_VALUE
+					? Payload->DepthBiasConstantFactor
+					: 0.0f,
+					Payload->DepthBiasClamp != SetDynamicPipleineStateCmdPayload::UNCHANGE_FLOAT_VALUE
+					? Payload->DepthBiasClamp
+					: 0.0f,
+					Payload->DepthBiasSlopeFactor != SetDynamicPipleineStateCmdPayload::UNCHANGE_FLOAT_VALUE
+					? Payload->DepthBiasSlopeFactor
+					: 0.0f
+				);
+			}
+
+			break;
+		}
+		case RenderOpCode::SET_VERTEX_LAYOUT:
+		{
+			auto Payload = (SetVertexLayoutCmdPayload*)(Dst);
 
-				size_t BindingCount = Payload->BindingCount;
-				size_t AttribCount = Payload->AttribsCount;
+			size_t BindingCount = Payload->BindingCount;
+			size_t AttribCount = Payload->AttribsCount;
 
-				std::vector< VkVertexInputBindingDescription2EXT> BindingDescVector(BindingCount);
-				VkVertexInputBindingDescription2EXT* BindingDescriptions = BindingDescVector.data();
+			std::vector< VkVertexInputBindingDescription2EXT> BindingDescVector(BindingCount);
+			VkVertexInputBindingDescription2EXT* BindingDescriptions = BindingDescVector.data();
 
-				std::vector< VkVertexInputAttributeDescription2EXT> AttribDescVector(AttribCount);
-				VkVertexInputAttributeDescription2EXT* AttribDescriptions = AttribDescVector.data();
+			std::vector< VkVertexInputAttributeDescription2EXT> AttribDescVector(AttribCount);
+			VkVertexInputAttributeDescription2EXT* AttribDescriptions = AttribDescVector.data();
 
-				int ioffset = 0;
-				int DstOffset = sizeof(SetVertexLayoutCmdPayload);
+			int ioffset = 0;
+			int DstOffset = sizeof(SetVertexLayoutCmdPayload);
 
-				for (int i = 0; i < BindingCount; i++)
-				{
-					auto ActiveBinding = (SetVertexLayoutBindingCmdPayload*)(Dst + DstOffset);
-					// 1. Define empty descriptions
-					VkVertexInputBindingDescription2EXT bindingDescriptions{};
-					bindingDescriptions.sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_BINDING_DESCRIPTION_2_EXT;
-					bindingDescriptions.binding = ActiveBinding->BindingIndex;
-
-					// INSTANCING LOGIC HERE:
-					if (ActiveBinding->IsInstanced) {
-						bindingDescriptions.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
-						bindingDescriptions.divisor = 1; // Step once per instance (1 character)
-					}
-					else {
-						bindingDescriptions.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-						bindingDescriptions.divisor = 1; // Standard vertex stepping
-					}
+			for (int i = 0; i < BindingCount; i++)
+			{
+				auto ActiveBinding = (SetVertexLayoutBindingCmdPayload*)(Dst + DstOffset);
+				// 1. Define empty descriptions
+				VkVertexInputBindingDescription2EXT bindingDescriptions{};
+				bindingDescriptions.sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_BINDING_DESCRIPTION_2_EXT;
+				bindingDescriptions.binding = ActiveBinding->BindingIndex;
+
+				// INSTANCING LOGIC HERE:
+				if (ActiveBinding->IsInstanced) {
+					bindingDescriptions.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+					bindingDescriptions.divisor = 1; // Step once per instance (1 character)
+				}
+				else {
+					bindingDescriptions.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+					bindingDescriptions.divisor = 1; // Standard vertex stepping
+				}
 
-					bindingDescriptions.stride = ActiveBinding->Stride;
+				bindingDescriptions.stride = ActiveBinding->Stride;
 
-					BindingDescriptions[i] = bindingDescriptions;
+				BindingDescriptions[i] = bindingDescriptions;
 
-					DstOffset += sizeof(SetVertexLayoutBindingCmdPayload);
+				DstOffset += sizeof(SetVertexLayoutBindingCmdPayload);
 
-					for (int x = 0; x < ActiveBinding->AttribsCount; x++)
-					{
-						auto ActiveAttrib = (VertexInputShaderAttribute*)(Dst + DstOffset);
-
-						VkVertexInputAttributeDescription2EXT attributeDescriptions{};
-						attributeDescriptions.sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_ATTRIBUTE_DESCRIPTION_2_EXT;
-						attributeDescriptions.binding = ActiveBinding->BindingIndex;
-						attributeDescriptions.location = ActiveAttrib->Location;
-						attributeDescriptions.format = ShaderObjectTypeToVkFormat(ActiveAttrib->Type);
-						attributeDescriptions.offset = ActiveAttrib->Offset;
-						AttribDescriptions[ioffset] = attributeDescriptions;
-						ioffset++;
-
-						DstOffset += sizeof(VertexInputShaderAttribute);
-					}
+				for (int x = 0; x < ActiveBinding->AttribsCount; x++)
+				{
+					auto ActiveAttrib = (VertexInputShaderAttribute*)(Dst + DstOffset);
+
+					VkVertexInputAttributeDescription2EXT attributeDescriptions{};
+					attributeDescriptions.sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_ATTRIBUTE_DESCRIPTION_2_EXT;
+					attributeDescriptions.binding = ActiveBinding->BindingIndex;
+					attributeDescriptions.location = ActiveAttrib->Location;
+					attributeDescriptions.format = ShaderObjectTypeToVkFormat(ActiveAttrib->Type);
+					attributeDescriptions.offset = ActiveAttrib->Offset;
+					AttribDescriptions[ioffset] = attributeDescriptions;
+					ioffset++;
+
+					DstOffset += sizeof(VertexInputShaderAttribute);
 				}
+			}
 
-				// 2. Call the dynamic command with zero counts
-				pfn_vkCmdSetVertexInputEXT(
-					ActiveCommandBuffer,
-					BindingCount, // bindingCount must be 0
-					BindingDescriptions,
-					AttribCount, // attributeCount must be 0
-					AttribDescriptions
-				);
+			// 2. Call the dynamic command with zero counts
+			pfn_vkCmdSetVertexInputEXT(
+				Ctx.CmdBuffer,
+				BindingCount, // bindingCount must be 0
+				BindingDescriptions,
+				AttribCount, // attributeCount must be 0
+				AttribDescriptions
+			);
 
-				break;
+			break;
+		}
+		case RenderOpCode::BIND_MATERIAL_DATA:
+		{
+			auto Payload = (BindMaterialDataCmdPayload*)(Dst);
+
+			auto ActiveMaterial = _MaterialManager.Get(Payload->RawMaterialHandle);
+
+			_ShaderManager.BindUserSets(Ctx.CmdBuffer,
+				ActiveMaterial->ProgramID,
+				ActiveMaterial->Sets[_FrameResource.CurrentFrameIndex]);
+			break;
+		}
+		case RenderOpCode::SET_FULL_PIPELINE_STATE:
+		{
+			auto Payload = (SetFullPipelineStateCmdPayload*)(Dst);
+			SetActiveGraphicsPipelineState(Ctx, Payload->Info);
+			break;
+		}
+		case RenderOpCode::BIND_SHADER_PROGRAM:
+		{
+			auto Payload = (BindShaderProgramCmdPayload*)(Dst);
+			_ShaderManager.BindShaderProgram(Ctx.CmdBuffer, Payload->ShaderProgram);
+			_ShaderManager.BindBindlessSets(Ctx.CmdBuffer, Payload->ShaderProgram,
+				_FrameResource.CurrentFrameIndex, _BindlessManager);
+
+			break;
+		}
+		case RenderOpCode::BIND_VERTEX_BUFFERS:
+		{
+			auto Payload = (BindVertexBuffersCmdPayload*)(Dst);
+
+			VkBuffer Handles[100] = { VK_NULL_HANDLE };
+
+			int Offset = sizeof(BindVertexBuffersCmdPayload);
+			int i = 0;
+			while (i < Payload->VertexBufferCount)
+			{
+				uint32_t BufferHandle = *(uint32_t*)(Dst + Offset);
+				Handles[i] = _BufferManager.Get(BufferHandle)->Buffer;
+				Offset += sizeof(uint32_t);
+				i++;
 			}
-			case RenderOpCode::UPDATE_MATERIL_DATA:
+
+			VkDeviceSize offsets[100] = { 0 };
+			vkCmdBindVertexBuffers(Ctx.CmdBuffer, 0, Payload->VertexBufferCount, Handles, offsets);
+
+			break;
+		}
+		case RenderOpCode::PUSH_SHADER_INLINE_UNIFORM_DATA:
+		{
+			auto Payload = (PushShaderInlineUniformDataCmdPayload*)(Dst);
+
+			void* PushConstantDataPtr = (void*)(Dst + sizeof(PushShaderInlineUniformDataCmdPayload));
+
+			_ShaderManager.PushConstants(Ctx.CmdBuffer,
+				Payload->ShaderProgram,
+				Payload->Stage,
+				PushConstantDataPtr,
+				Payload->Size,
+				Payload->Offset);
+
+			break;
+		}
+		case RenderOpCode::BIND_INDEX_BUFFER:
+		{
+			auto Payload = (BindIndexBufferCmdPayload*)(Dst);
+			vkCmdBindIndexBuffer(
+				Ctx.CmdBuffer,
+				_BufferManager.Get(Payload->IndexBufferHandle)->Buffer,
+				0,
+				Payload->Type == IndexBufferType::UINT32_T ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16);
+			break;
+		}
+		case RenderOpCode::DRAW_INDEXED:
+		{
+			auto Payload = (DrawIndexedCmdPayload*)(Dst);
+
+			vkCmdDrawIndexed(
+				Ctx.CmdBuffer,
+				Payload->ElementCount,
+				Payload->InstanceCount,
+				Payload->FirstElement,
+				Payload->VertexOffset,
+				Payload->FirstInstance
+			);
+
+			Ctx.Stats.DrawCallsPerFrame++;
+
+			uint64_t trianglesPerInstance = 0;
+
+			switch (Ctx.DynamicState.State.TopologyMode)
 			{
-				auto Payload = (MaterialDataUpdateCmdPayload*)(Dst);
-				_AppendMaterialUpdateData(*Payload);
+			case InputTopologyMode::Triangle_List:
+				trianglesPerInstance = Payload->ElementCount / 3;
+				break;
+
+			case InputTopologyMode::Triangle_Strip:
+				trianglesPerInstance =
+					Payload->ElementCount >= 3 ?
+					Payload->ElementCount - 2 : 0;
 				break;
-			}case RenderOpCode::BIND_MATERIAL_DATA:
+
+			default:
+				trianglesPerInstance = 0;
+				break;
+			}
+
+			uint64_t instanceCount = Payload->InstanceCount;
+
+			Ctx.Stats.TrianglesPerFrame +=
+				trianglesPerInstance * instanceCount;
+
+			Ctx.Stats.IndiciesRendered +=
+				uint64_t(Payload->ElementCount) * instanceCount;
+
+			break;
+		}case RenderOpCode::DRAW_INDEXED_INDIRECT:
+		{
+			auto Payload = (DrawIndexedIndirectCmdPayload*)(Dst);
+			VkBuffer IndirectBuffer = _BufferManager.Get(Payload->Buffer)->Buffer;
+
+			// Triangle/index counts live in GPU memory here, only draw calls are tracked
+			if (GetActiveRenderDeviceLimit().bSupportsMultiDrawIndirect)
 			{
-				auto Payload = (BindMaterialDataCmdPayload*)(Dst);
+				vkCmdDrawIndexedIndirect(Ctx.CmdBuffer, IndirectBuffer, Payload->Offset,
+					Payload->DrawCount, Payload->Stride);
+			}
+			else
+			{
+				for (uint32_t i = 0; i < Payload->DrawCount; i++)
+					vkCmdDrawIndexedIndirect(Ctx.CmdBuffer, IndirectBuffer,
+						Payload->Offset + VkDeviceSize(i) * Payload->Stride, 1, Payload->Stride);
+			}
 
-				auto ActiveMaterial = _MaterialManager.Get(Payload->RawMaterialHandle);
+			Ctx.Stats.DrawCallsPerFrame++;
+			Ctx.Stats.IndirectDrawCallsPerFrame++;
+			break;
+		}case RenderOpCode::DRAW_INDEXED_INDIRECT_COUNT:
+		{
+			auto Payload = (DrawIndexedIndirectCountCmdPayload*)(Dst);
 
-				_ShaderManager.BindUserSets(ActiveCommandBuffer,
-					ActiveMaterial->ProgramID,
-					ActiveMaterial->Sets[_FrameResource.CurrentFrameIndex]);
+			if (!GetActiveRenderDeviceLimit().bSupportsDrawIndirectCount)
+			{
+				CH_CORE_ERROR("DrawIndexedIndirectCount is not supported by the active device!");
 				break;
 			}
-			case RenderOpCode::SET_FULL_PIPELINE_STATE:
+
+			vkCmdDrawIndexedIndirectCount(Ctx.CmdBuffer,
+				_BufferManager.Get(Payload->Buffer)->Buffer, Payload->Offset,
+				_BufferManager.Get(Payload->CountBuffer)->Buffer, Payload->CountOffset,
+				Payload->MaxDrawCount, Payload->Stride);
+
+			Ctx.Stats.DrawCallsPerFrame++;
+			Ctx.Stats.IndirectDrawCallsPerFrame++;
+			break;
+		}case RenderOpCode::DRAW_ARRAY:
+		{
+			// 1. Use the correct payload for non-indexed drawing
+			auto Payload = (DrawArrayCmdPayload*)(Dst);
+
+			// 2. Call the non-indexed Vulkan draw command
+			vkCmdDraw(
+				Ctx.CmdBuffer,
+				Payload->ElementCount,    // Number of vertices to draw
+				Payload->InstanceCount,  // Number of instances
+				Payload->FirstElement,    // First vertex index
+				Payload->FirstInstance   // First instance ID
+			);
+
+			Ctx.Stats.DrawCallsPerFrame++;
+
+			// 3. Calculate primitive count based on VertexCount (instead of ElementCount)
+			uint64_t trianglesPerInstance = 0;
+
+			switch (Ctx.DynamicState.State.TopologyMode)
 			{
-				auto Payload = (SetFullPipelineStateCmdPayload*)(Dst);
-				SetActiveGraphicsPipelineState(ActiveCommandBuffer, Payload->Info);
+			case InputTopologyMode::Triangle_List:
+				trianglesPerInstance = Payload->ElementCount / 3;
+				break;
+
+			case InputTopologyMode::Triangle_Strip:
+				trianglesPerInstance =
+					Payload->ElementCount >= 3 ?
+					Payload->ElementCount - 2 : 0;
+				break;
+
+			default:
+				trianglesPerInstance = 0;
 				break;
 			}
+
+			uint64_t instanceCount = Payload->InstanceCount;
+
+			Ctx.Stats.TrianglesPerFrame += trianglesPerInstance * instanceCount;
+
+			// Note: 'IndicesRendered' usually refers to index buffer usage. 
+			// For arrays, you might want to track 'VerticesRendered' instead.
+			Ctx.Stats.VerticesRendered += uint64_t(Payload->ElementCount) * instanceCount;
+
+			break;
+		}
+		default:
+			return false;
+		}
+
+		return true;
+	}
+
+	void VulkanGraphicsBackend::_TranslateComputeCommandBuffer(const ComputeCommandBuffer& CmdBuffer,
+		VkCommandBuffer ActiveCommandBuffer)
+	{
+		if (CmdBuffer.Empty())
+			return;
+
+		bool HasDispatched = false;
+
+		RenderCommandReader Reader(CmdBuffer);
+		RenderCommand Command;
+		while (Reader.Next(Command))
+		{
+			const uint8_t* Dst = Command.Payload;
+
+			switch (Command.Code)
+			{
 			case RenderOpCode::BIND_SHADER_PROGRAM:
 			{
 				auto Payload = (BindShaderProgramCmdPayload*)(Dst);
 				_ShaderManager.BindShaderProgram(ActiveCommandBuffer, Payload->ShaderProgram);
 				_ShaderManager.BindBindlessSets(ActiveCommandBuffer, Payload->ShaderProgram,
 					_FrameResource.CurrentFrameIndex, _BindlessManager);
-
 				break;
 			}
-			case RenderOpCode::BIND_VERTEX_BUFFERS:
+			case RenderOpCode::BIND_MATERIAL_DATA:
 			{
-				auto Payload = (BindVertexBuffersCmdPayload*)(Dst);
-
-				VkBuffer Handles[100] = { VK_NULL_HANDLE };
-
-				int Offset = sizeof(BindVertexBuffersCmdPayload);
-				int i = 0;
-				while (i < Payload->VertexBufferCount)
-				{
-					uint32_t BufferHandle = *(uint32_t*)(Dst + Offset);
-					Handles[i] = _BufferManager.Get(BufferHandle)->Buffer;
-					Offset += sizeof(uint32_t);
-					i++;
-				}
-
-				VkDeviceSize offsets[100] = { 0 };
-				vkCmdBindVertexBuffers(ActiveCommandBuffer, 0, Payload->VertexBufferCount, Handles, offsets);
+				auto Payload = (BindMaterialDataCmdPayload*)(Dst);
+				auto ActiveMaterial = _MaterialManager.Get(Payload->RawMaterialHandle);
 
+				_ShaderManager.BindUserSets(ActiveCommandBuffer,
+					ActiveMaterial->ProgramID,
+					ActiveMaterial->Sets[_FrameResource.CurrentFrameIndex]);
 				break;
 			}
 			case RenderOpCode::PUSH_SHADER_INLINE_UNIFORM_DATA:
 			{
 				auto Payload = (PushShaderInlineUniformDataCmdPayload*)(Dst);
-
 				void* PushConstantDataPtr = (void*)(Dst + sizeof(PushShaderInlineUniformDataCmdPayload));
 
 				_ShaderManager.PushConstants(ActiveCommandBuffer,
@@ -720,124 +1123,59 @@ namespace Chilli
 					PushConstantDataPtr,
 					Payload->Size,
 					Payload->Offset);
-
 				break;
 			}
-			case RenderOpCode::BIND_INDEX_BUFFER:
+			case RenderOpCode::PIPELINE_BARRIER:
 			{
-				auto Payload = (BindIndexBufferCmdPayload*)(Dst);
-				vkCmdBindIndexBuffer(
-					ActiveCommandBuffer,
-					_BufferManager.Get(Payload->IndexBufferHandle)->Buffer,
-					0,
-					Payload->Type == IndexBufferType::UINT32_T ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16);
+				auto Payload = (PipelineBarrierCmdPayload*)(Dst);
+				PipelineBarrier* BarrierPtr = (PipelineBarrier*)(Dst + sizeof(PipelineBarrierCmdPayload));
+				_ExecutePipelineBarriers(BarrierPtr, Payload->BarriersCount, ActiveCommandBuffer);
 				break;
 			}
-			case RenderOpCode::DRAW_INDEXED:
+			case RenderOpCode::DISPATCH:
 			{
-				auto Payload = (DrawIndexedCmdPayload*)(Dst);
-
-				vkCmdDrawIndexed(
-					ActiveCommandBuffer,
-					Payload->ElementCount,
-					Payload->InstanceCount,
-					Payload->FirstElement,
-					Payload->VertexOffset,
-					Payload->FirstInstance
-				);
-
-				_Stats.DrawCallsPerFrame++;
-
-				uint64_t trianglesPerInstance = 0;
-
-				switch (this->_ActivePipelineState.TopologyMode)
-				{
-				case InputTopologyMode::Triangle_List:
-					trianglesPerInstance = Payload->ElementCount / 3;
-					break;
-
-				case InputTopologyMode::Triangle_Strip:
-					trianglesPerInstance =
-						Payload->ElementCount >= 3 ?
-						Payload->ElementCount - 2 : 0;
-					break;
-
-				default:
-					trianglesPerInstance = 0;
-					break;
-				}
-
-				uint64_t instanceCount = Payload->InstanceCount;
-
-				_Stats.TrianglesPerFrame +=
-					trianglesPerInstance * instanceCount;
-
-				_Stats.IndiciesRendered +=
-					uint64_t(Payload->ElementCount) * instanceCount;
-
-				break;
-			}case RenderOpCode::DRAW_ARRAY:
-			{
-				// 1. Use the correct payload for non-indexed drawing
-				auto Payload = (DrawArrayCmdPayload*)(Dst);
-
-				// 2. Call the non-indexed Vulkan draw command
-				vkCmdDraw(
-					ActiveCommandBuffer,
-					Payload->ElementCount,    // Number of vertices to draw
-					Payload->InstanceCount,  // Number of instances
-					Payload->FirstElement,    // First vertex index
-					Payload->FirstInstance   // First instance ID
-				);
-
-				_Stats.DrawCallsPerFrame++;
-
-				// 3. Calculate primitive count based on VertexCount (instead of ElementCount)
-				uint64_t trianglesPerInstance = 0;
-
-				switch (this->_ActivePipelineState.TopologyMode)
-				{
-				case InputTopologyMode::Triangle_List:
-					trianglesPerInstance = Payload->ElementCount / 3;
-					break;
-
-				case InputTopologyMode::Triangle_Strip:
-					trianglesPerInstance =
-						Payload->ElementCount >= 3 ?
-						Payload->ElementCount - 2 : 0;
-					break;
-
-				default:
-					trianglesPerInstance = 0;
-					break;
-				}
-
-				uint64_t instanceCount = Payload->InstanceCount;
-
-				_Stats.TrianglesPerFrame += trianglesPerInstance * instanceCount;
-
-				// Note: 'IndicesRendered' usually refers to index buffer usage. 
-				// For arrays, you might want to track 'VerticesRendered' instead.
-				_Stats.VerticesRendered += uint64_t(Payload->ElementCount) * instanceCount;
+				auto Payload = (DispatchCmdPayload*)(Dst);
+				vkCmdDispatch(ActiveCommandBuffer, Payload->GroupCountX, Payload->GroupCountY, Payload->GroupCountZ);
 
+				_Stats.DispatchesPerFrame++;
+				HasDispatched = true;
 				break;
 			}
+			default:
+				CH_CORE_ERROR("Opcode {0} is not supported on the compute stream!", int(Command.Code));
+				break;
 			}
-
-			Dst += PayloadSize;
-			Offset += PayloadSize;
 		}
-		return ActiveCommandBuffer;
+
+		if (!HasDispatched)
+			return;
+
+		// Whatever the dispatches wrote (indirect commands, draw counts, instance indices) is consumed
+		// by the graphics work recorded after this point, and may be read back once the frame's fence is waited on
+		VkMemoryBarrier2 MemoryBarrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+		MemoryBarrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+		MemoryBarrier.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+		MemoryBarrier.dstStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT |
+			VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_HOST_BIT;
+		MemoryBarrier.dstAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_SHADER_READ_BIT |
+			VK_ACCESS_2_HOST_READ_BIT;
+
+		VkDependencyInfo DepInfo = { VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+		DepInfo.memoryBarrierCount = 1;
+		DepInfo.pMemoryBarriers = &MemoryBarrier;
+		vkCmdPipelineBarrier2(ActiveCommandBuffer, &DepInfo);
 	}
 
 	void VulkanGraphicsBackend::EndFrame(const RenderFramePacket& Packet)
 	{
-		_ActivePipelineState = PipelineStateInfo();
+		auto VkGraphicsCmdBuffer = _TranslateGraphicsCommandBuffer(Packet);
 
-		auto VkGraphicsCmdBuffer = _TranslateGraphicsCommandBuffer(Packet.Graphics_Stream);
+		// Updates made before the next BeginFrame already write into that frame's staging region
+		const uint32_t NextFrameIndex = (_FrameResource.CurrentFrameIndex + 1) % _Spec.MaxFrameInFlight;
 
 		// CRITICAL: If a resize happened during translation, abort submission!
 		if (VkGraphicsCmdBuffer == VK_NULL_HANDLE) {
+			_BufferManager.PrepareFrameStaging(NextFrameIndex, _FrameResource.InFlightFences[NextFrameIndex]);
 			return;
 		}
 
@@ -845,9 +1183,12 @@ namespace Chilli
 			VkSubmitInfo submitInfo{};
 			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-			VkSemaphore waitSemaphores[] = { _FrameResource.ImageAvailableSemaphores[_FrameResource.CurrentFrameIndex] };
-			VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-			submitInfo.waitSemaphoreCount = 1;
+			// The frame also waits on every upload submitted so far, nothing it reads is still being copied
+			VkSemaphore waitSemaphores[] = { _FrameResource.ImageAvailableSemaphores[_FrameResource.CurrentFrameIndex],
+				_Uploader.GetTimelineSemaphore() };
+			VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
+			submitInfo.waitSemaphoreCount = 2;
 			submitInfo.pWaitSemaphores = waitSemaphores;
 			submitInfo.pWaitDstStageMask = waitStages;
 			submitInfo.commandBufferCount = 1;
@@ -857,9 +1198,22 @@ namespace Chilli
 			submitInfo.signalSemaphoreCount = 1;
 			submitInfo.pSignalSemaphores = signalSemaphores;
 
+			// Binary semaphores ignore their value
+			uint64_t waitValues[] = { 0, _Uploader.GetLatestTicket() };
+			uint64_t signalValues[] = { 0 };
+
+			VkTimelineSemaphoreSubmitInfo timelineInfo{};
+			timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+			timelineInfo.waitSemaphoreValueCount = 2;
+			timelineInfo.pWaitSemaphoreValues = waitValues;
+			timelineInfo.signalSemaphoreValueCount = 1;
+			timelineInfo.pSignalSemaphoreValues = signalValues;
+			submitInfo.pNext = &timelineInfo;
+
 
 			VULKAN_SUCCESS_ASSERT(vkQueueSubmit(_Data.Device.GetQueue(QueueFamilies::GRAPHICS), 1, &submitInfo, _FrameResource.InFlightFences[_FrameResource.CurrentFrameIndex]), "Failed to Submit Graphics Queue");
 		}
+		_BufferManager.PrepareFrameStaging(NextFrameIndex, _FrameResource.InFlightFences[NextFrameIndex]);
 
 		{
 
@@ -987,8 +1341,9 @@ namespace Chilli
 				else if (bar.Image.Handle != UINT32_MAX) {
 					auto Image = _ImageDataManager.GetImage(_ImageDataManager.GetTexture(bar.Image.Handle)->GetImageHandle());
 
-					// State Validation
-					if (bar.OldState != Image->GetSpec().State)
+					// State Validation, undefined drops the contents and is valid from any state. Aliased images
+					// start every frame with it
+					if (bar.OldState != ResourceState::Undefined && bar.OldState != Image->GetSpec().State)
 						VULKAN_ERROR("The given state does not match images current state!");
 					if (!ValidateImageState(Image->GetSpec().Usage, bar.NewState))
 						VULKAN_ERROR("Usage and State not valid!");
@@ -1082,20 +1437,20 @@ namespace Chilli
 			auto* ActiveMaterial = _MaterialManager.Get(UpdateInfo.MaterialHandle);
 			const auto& ProgramInfo = _ShaderManager.GetProgramInfo(ActiveMaterial->ProgramID);
 
-			// 3. Find the binding slot using your 32-char fixed name
-			// Internally this uses memcmp(Name, UpdateInfo.Name, 32)
-			auto BindingLocation = _ShaderManager.FindUserShaderDataLocation(
-				ActiveMaterial->ProgramID,
-				UpdateInfo.Name
-			);
+			// 3. Find the binding, updates carrying a slot resolved at setup index the program's bindings
+			// directly, the rest still search them by their 32-char fixed name
+			MaterialBindingSlot Slot = UpdateInfo.Slot;
+			if (!Slot.IsValid())
+				Slot = _ShaderManager.FindUserBindingSlot(ActiveMaterial->ProgramID, UpdateInfo.Name);
 
-			if (!BindingLocation.ReturnState) {
+			if (!Slot.IsValid()) {
 				VULKAN_ERROR("Uniform '%s' not found in shader!" << UpdateInfo.Name);
 				continue;
 			}
+			const auto& BindingInfo = _ShaderManager.GetUserBinding(ActiveMaterial->ProgramID, Slot);
 
-			uint32_t SetIdx = BindingLocation.BindingInfo.Set - int(BindlessSetTypes::USER_0);
-			uint32_t BindingSlot = BindingLocation.BindingInfo.Binding;
+			uint32_t SetIdx = BindingInfo.Set - int(BindlessSetTypes::USER_0);
+			uint32_t BindingSlot = BindingInfo.Binding;
 
 			// 4. Ensure Cache Capacity (No-op after first run per material)
 			auto& CurrentSetCache = ActiveMaterial->SetBindingsStates[SetIdx];
@@ -1105,8 +1460,8 @@ namespace Chilli
 			bool Skip = false;
 
 			// ----- Uniform / Storage Buffer -----
-			if (BindingLocation.BindingInfo.Type == ShaderUniformTypes::UNIFORM_BUFFER ||
-				BindingLocation.BindingInfo.Type == ShaderUniformTypes::STORAGE_BUFFER)
+			if (BindingInfo.Type == ShaderUniformTypes::UNIFORM_BUFFER ||
+				BindingInfo.Type == ShaderUniformTypes::STORAGE_BUFFER)
 			{
 				if ((CurrentSetCache[BindingSlot] & 0xFFFFFFFF) == UpdateInfo.BufferInfo.Handle) {
 					Skip = true;
@@ -1118,7 +1473,7 @@ namespace Chilli
 			}
 
 			// ----- Sampled Image -----
-			else if (BindingLocation.BindingInfo.Type == ShaderUniformTypes::SAMPLED_IMAGE)
+			else if (BindingInfo.Type == ShaderUniformTypes::SAMPLED_IMAGE)
 			{
 				if ((CurrentSetCache[BindingSlot] & 0xFFFFFFFF) == UpdateInfo.ImageInfo.Handle) {
 					Skip = true;
@@ -1129,7 +1484,7 @@ namespace Chilli
 			}
 
 			// ----- Sampler -----
-			else if (BindingLocation.BindingInfo.Type == ShaderUniformTypes::SAMPLER)
+			else if (BindingInfo.Type == ShaderUniformTypes::SAMPLER)
 			{
 				if ((CurrentSetCache[BindingSlot] & 0xFFFFFFFF) == UpdateInfo.ImageInfo.Sampler) {
 					Skip = true;
@@ -1140,7 +1495,7 @@ namespace Chilli
 			}
 
 			// ----- Combined Image + Sampler -----
-			else if (BindingLocation.BindingInfo.Type == ShaderUniformTypes::COMBINED_IMAGE_SAMPLER)
+			else if (BindingInfo.Type == ShaderUniformTypes::COMBINED_IMAGE_SAMPLER)
 			{
 				uint64_t combined = (uint64_t(UpdateInfo.ImageInfo.Sampler) << 32) |
 					uint64_t(UpdateInfo.ImageInfo.Handle);
@@ -1158,8 +1513,8 @@ namespace Chilli
 				continue;
 
 			// 7. Handle Buffer Types (Uniform / Storage)
-			if (BindingLocation.BindingInfo.Type == ShaderUniformTypes::UNIFORM_BUFFER ||
-				BindingLocation.BindingInfo.Type == ShaderUniformTypes::STORAGE_BUFFER)
+			if (BindingInfo.Type == ShaderUniformTypes::UNIFORM_BUFFER ||
+				BindingInfo.Type == ShaderUniformTypes::STORAGE_BUFFER)
 			{
 				if (UpdateInfo.BufferInfo.Handle == UINT32_MAX) continue;
 
@@ -1173,9 +1528,9 @@ namespace Chilli
 			}
 
 			// 7. Handle Buffer Types (Uniform / Storage)
-			if (BindingLocation.BindingInfo.Type == ShaderUniformTypes::SAMPLED_IMAGE ||
-				BindingLocation.BindingInfo.Type == ShaderUniformTypes::SAMPLER ||
-				BindingLocation.BindingInfo.Type == ShaderUniformTypes::COMBINED_IMAGE_SAMPLER)
+			if (BindingInfo.Type == ShaderUniformTypes::SAMPLED_IMAGE ||
+				BindingInfo.Type == ShaderUniformTypes::SAMPLER ||
+				BindingInfo.Type == ShaderUniformTypes::COMBINED_IMAGE_SAMPLER)
 			{
 
 				VkDescriptorImageInfo ImageInfo{};
@@ -1184,6 +1539,8 @@ namespace Chilli
 				ImageInfo.imageView = VK_NULL_HANDLE;
 
 				if (UpdateInfo.ImageInfo.Handle != UINT32_MAX) {
+					// Material sets are not retargeted when a streamed image is replaced
+					_ImageDataManager.PinStreamedTexture(UpdateInfo.ImageInfo.Handle);
 					auto ActiveTexture = _ImageDataManager.GetTexture(UpdateInfo.ImageInfo.Handle);
 					ImageInfo.imageView = ActiveTexture->GetHandle();
 
@@ -1208,19 +1565,19 @@ namespace Chilli
 				descriptorWrite.dstBinding = BindingSlot;
 				descriptorWrite.dstArrayElement = UpdateInfo.DstArrayIndex;
 				descriptorWrite.descriptorCount = 1;
-				descriptorWrite.descriptorType = ShaderUniformTypeToVk(BindingLocation.BindingInfo.Type);
+				descriptorWrite.descriptorType = ShaderUniformTypeToVk(BindingInfo.Type);
 
 				// 7. Handle Buffer Types (Uniform / Storage)
-				if (BindingLocation.BindingInfo.Type == ShaderUniformTypes::UNIFORM_BUFFER ||
-					BindingLocation.BindingInfo.Type == ShaderUniformTypes::STORAGE_BUFFER)
+				if (BindingInfo.Type == ShaderUniformTypes::UNIFORM_BUFFER ||
+					BindingInfo.Type == ShaderUniformTypes::STORAGE_BUFFER)
 				{
 					descriptorWrite.pBufferInfo = &_FrameResource.WritingBufferInfos.back();
 				}
 
 				// 7. Handle Buffer Types (Uniform / Storage)
-				if (BindingLocation.BindingInfo.Type == ShaderUniformTypes::SAMPLED_IMAGE ||
-					BindingLocation.BindingInfo.Type == ShaderUniformTypes::SAMPLER ||
-					BindingLocation.BindingInfo.Type == ShaderUniformTypes::COMBINED_IMAGE_SAMPLER)
+				if (BindingInfo.Type == ShaderUniformTypes::SAMPLED_IMAGE ||
+					BindingInfo.Type == ShaderUniformTypes::SAMPLER ||
+					BindingInfo.Type == ShaderUniformTypes::COMBINED_IMAGE_SAMPLER)
 				{
 					descriptorWrite.pImageInfo = &_FrameResource.WritingImageInfos.back();
 				}
@@ -1231,62 +1588,80 @@ namespace Chilli
 		}
 	}
 
-	void VulkanGraphicsBackend::SetActiveGraphicsPipelineState(VkCommandBuffer CmdBuffer, const PipelineStateInfo& State)
+	void VulkanGraphicsBackend::SetActiveGraphicsPipelineState(VulkanRecordingContext& Ctx, const PipelineStateInfo& State)
 	{
-		VULKAN_ASSERT(CmdBuffer != VK_NULL_HANDLE, "Valid Command Buffer Not Given!");
+		VULKAN_ASSERT(Ctx.CmdBuffer != VK_NULL_HANDLE, "Valid Command Buffer Not Given!");
 
-		// Dynamic (changed on whenever user desires)
-		vkCmdSetPrimitiveTopology(CmdBuffer, TopologyToVk(State.TopologyMode));
+		// Every setter below only records when the value differs from what the context already has bound
+		SetPrimitiveTopology(Ctx, State.TopologyMode);
 
-		SetCullMode(CmdBuffer, State.ShaderCullMode);
-		SetFrontFace(CmdBuffer, State.FrontFace);
-		SetPolygonMode(CmdBuffer, State.ShaderFillMode);
-		SetLineWidth(CmdBuffer, State.LineWidth);
-		SetRasterizerDiscardEnable(CmdBuffer, State.RasterizerDiscardEnable);
+		SetCullMode(Ctx, State.ShaderCullMode);
+		SetFrontFace(Ctx, State.FrontFace);
+		SetPolygonMode(Ctx, State.ShaderFillMode);
+		SetLineWidth(Ctx, State.LineWidth);
+		SetRasterizerDiscardEnable(Ctx, State.RasterizerDiscardEnable);
 
-		SetDepthTestEnable(CmdBuffer, State.DepthTestEnable);
-		SetDepthWriteEnable(CmdBuffer, State.DepthWriteEnable);
-		SetDepthCompareOp(CmdBuffer, State.DepthCompareOp);
+		SetDepthTestEnable(Ctx, State.DepthTestEnable);
+		SetDepthWriteEnable(Ctx, State.DepthWriteEnable);
+		SetDepthCompareOp(Ctx, State.DepthCompareOp);
 
-		SetStencilTestEnable(CmdBuffer, State.StencilTestEnable);
+		SetStencilTestEnable(Ctx, State.StencilTestEnable);
 
-		SetStencilFrontOp(CmdBuffer, State.StencilFront);
-		SetStencilBackOp(CmdBuffer, State.StencilBack);
+		SetStencilFrontOp(Ctx, State.StencilFront);
+		SetStencilBackOp(Ctx, State.StencilBack);
 
-		SetDepthBiasEnable(CmdBuffer, State.DepthBiasEnable);
-		SetDepthBias(CmdBuffer, State.DepthBiasConstantFactor, State.DepthBiasClamp, State.DepthBiasSlopeFactor);
+		SetDepthBiasEnable(Ctx, State.DepthBiasEnable);
+		SetDepthBias(Ctx, State.DepthBiasConstantFactor, State.DepthBiasClamp, State.DepthBiasSlopeFactor);
 
-		SetAlphaToCoverageEnable(CmdBuffer, State.AlphaToCoverageEnable);
+		SetAlphaToCoverageEnable(Ctx, State.AlphaToCoverageEnable);
 
 		// Static (Changed on New Pipelien state)
-		SetPrimitiveRestartEnable(CmdBuffer, State.PrimitiveRestartEnable);
+		SetPrimitiveRestartEnable(Ctx, State.PrimitiveRestartEnable);
 
-		SetColorBlendState(CmdBuffer, &State.ColorBlendAttachments[0], State.ColorBlendAttachmentsCount);
+		SetColorBlendState(Ctx, &State.ColorBlendAttachments[0], State.ColorBlendAttachmentsCount);
 
-		SetRasterizationSamples(CmdBuffer, State.SampleCount); // Or your actual MSAA count
+		SetRasterizationSamples(Ctx, State.SampleCount); // Or your actual MSAA count
 
 		uint32_t sampleMask = State.SampleMask & 0xFFFFFFFF;
-		SetSampleMask(CmdBuffer, State.SampleCount, sampleMask);
+		SetSampleMask(Ctx, State.SampleCount, sampleMask);
 
 		ChBool8 colorWriteEnables[] = { CH_TRUE };
-		SetColorWriteEnable(CmdBuffer, 1, colorWriteEnables);
+		SetColorWriteEnable(Ctx, 1, colorWriteEnables);
 
-		//SetVertexInputState(CmdBuffer, State.VertexInputLayout);
-
-		_ActivePipelineState = State;
+		//SetVertexInputState(Ctx.CmdBuffer, State.VertexInputLayout);
 	}
 
-	void VulkanGraphicsBackend::SetColorBlendState(VkCommandBuffer CmdBuffer,
+	void VulkanGraphicsBackend::SetColorBlendState(VulkanRecordingContext& Ctx,
 		const ColorBlendAttachmentState* ColorBlendAttachments, uint32_t ColorBlendAttachmentCount)
 	{
-		// The number of attachments being set dynamically
-		// Arrays to hold the values for the simultaneous Vulkan calls
+		VULKAN_ASSERT(ColorBlendAttachmentCount <= CH_MAX_COLOR_ATTACHMENT_COUNT, "Too Many Color Blend Attachments Given!");
 
+		auto& Shadow = Ctx.DynamicState;
 		const uint32_t attachmentCount = ColorBlendAttachmentCount;
 
-		std::vector<VkBool32> blendEnables(attachmentCount);
-		std::vector<VkColorComponentFlags> colorWriteMasks(attachmentCount);
-		std::vector<VkColorBlendEquationEXT> blendEquations(attachmentCount);
+		// A different attachment count redefines the whole range, otherwise each of the three
+		// calls is compared on its own fields
+		bool CountChanged = Shadow.State.ColorBlendAttachmentsCount != attachmentCount;
+		bool EnablesChanged = CountChanged, MasksChanged = CountChanged, EquationsChanged = CountChanged;
+
+		for (uint32_t i = 0; i < attachmentCount && !CountChanged; ++i)
+		{
+			const auto& New = ColorBlendAttachments[i];
+			const auto& Old = Shadow.State.ColorBlendAttachments[i];
+
+			EnablesChanged |= New.BlendEnable != Old.BlendEnable;
+			MasksChanged |= New.ColorWriteMask != Old.ColorWriteMask;
+			EquationsChanged |= New.SrcColorFactor != Old.SrcColorFactor ||
+				New.DstColorFactor != Old.DstColorFactor ||
+				New.ColorBlendOp != Old.ColorBlendOp ||
+				New.SrcAlphaFactor != Old.SrcAlphaFactor ||
+				New.DstAlphaFactor != Old.DstAlphaFactor ||
+				New.AlphaBlendOp != Old.AlphaBlendOp;
+		}
+
+		VkBool32 blendEnables[CH_MAX_COLOR_ATTACHMENT_COUNT];
+		VkColorComponentFlags colorWriteMasks[CH_MAX_COLOR_ATTACHMENT_COUNT];
+		VkColorBlendEquationEXT blendEquations[CH_MAX_COLOR_ATTACHMENT_COUNT];
 
 		for (uint32_t i = 0; i < attachmentCount; ++i)
 		{
@@ -1319,196 +1694,218 @@ namespace Chilli
 		uint32_t firstAttachment = 0; // Assuming we always start at slot 0
 
 		// 1. Set Blend Enable for all attachments
-		pfn_vkCmdSetColorBlendEnableEXT(CmdBuffer, firstAttachment, attachmentCount, blendEnables.data());
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::ColorBlendEnable, EnablesChanged))
+			pfn_vkCmdSetColorBlendEnableEXT(Ctx.CmdBuffer, firstAttachment, attachmentCount, blendEnables);
 
 		// 2. Set Color Write Mask for all attachments
-		pfn_vkCmdSetColorWriteMaskEXT(CmdBuffer, firstAttachment, attachmentCount, colorWriteMasks.data());
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::ColorWriteMask, MasksChanged))
+			pfn_vkCmdSetColorWriteMaskEXT(Ctx.CmdBuffer, firstAttachment, attachmentCount, colorWriteMasks);
 
 		// 3. Set Blend Equation for all attachments
 		// This command covers the factors (Src, Dst) and the operators (Add, Subtract, etc.)
-		pfn_vkCmdSetColorBlendEquationEXT(CmdBuffer, firstAttachment, attachmentCount, blendEquations.data());
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::ColorBlendEquation, EquationsChanged))
+			pfn_vkCmdSetColorBlendEquationEXT(Ctx.CmdBuffer, firstAttachment, attachmentCount, blendEquations);
+
+		Shadow.State.ColorBlendAttachmentsCount = attachmentCount;
+		for (uint32_t i = 0; i < attachmentCount; ++i)
+			Shadow.State.ColorBlendAttachments[i] = ColorBlendAttachments[i];
 	}
 
-	void VulkanGraphicsBackend::SetPrimitiveTopology(VkCommandBuffer CmdBuffer, InputTopologyMode mode)
+	void VulkanGraphicsBackend::SetPrimitiveTopology(VulkanRecordingContext& Ctx, InputTopologyMode mode)
 	{
-		if (_ActivePipelineState.TopologyMode != mode)
+		auto& Shadow = Ctx.DynamicState;
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::TopologyMode, Shadow.State.TopologyMode != mode))
 		{
 			// vkCmdSetPrimitiveTopology requires VK_EXT_extended_dynamic_state2
-			vkCmdSetPrimitiveTopology(CmdBuffer, TopologyToVk(mode));
-			_ActivePipelineState.TopologyMode = mode;
+			vkCmdSetPrimitiveTopology(Ctx, TopologyToVk(mode));
+			Shadow.State.TopologyMode = mode;
 		}
 	}
 
-	void VulkanGraphicsBackend::SetPrimitiveRestartEnable(VkCommandBuffer CmdBuffer, ChBool8 enable)
+	void VulkanGraphicsBackend::SetPrimitiveRestartEnable(VulkanRecordingContext& Ctx, ChBool8 enable)
 	{
 		bool bEnable = ChBoolToBool(enable);
-		if (_ActivePipelineState.PrimitiveRestartEnable != enable)
+		auto& Shadow = Ctx.DynamicState;
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::PrimitiveRestartEnable, Shadow.State.PrimitiveRestartEnable != enable))
 		{
 			// vkCmdSetPrimitiveRestartEnable requires VK_EXT_extended_dynamic_state2
-			vkCmdSetPrimitiveRestartEnable(CmdBuffer, bEnable);
-			_ActivePipelineState.PrimitiveRestartEnable = enable;
+			vkCmdSetPrimitiveRestartEnable(Ctx, bEnable);
+			Shadow.State.PrimitiveRestartEnable = enable;
 		}
 	}
 
-	void VulkanGraphicsBackend::SetCullMode(VkCommandBuffer CmdBuffer, CullMode mode)
+	void VulkanGraphicsBackend::SetCullMode(VulkanRecordingContext& Ctx, CullMode mode)
 	{
-		if (_ActivePipelineState.ShaderCullMode != mode)
+		auto& Shadow = Ctx.DynamicState;
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::ShaderCullMode, Shadow.State.ShaderCullMode != mode))
 		{
 			// vkCmdSetCullMode requires VK_EXT_extended_dynamic_state
-			vkCmdSetCullMode(CmdBuffer, CullModeToVk(mode));
-			_ActivePipelineState.ShaderCullMode = mode;
+			vkCmdSetCullMode(Ctx, CullModeToVk(mode));
+			Shadow.State.ShaderCullMode = mode;
 		}
 	}
 
-	void VulkanGraphicsBackend::SetFrontFace(VkCommandBuffer CmdBuffer, FrontFaceMode mode)
+	void VulkanGraphicsBackend::SetFrontFace(VulkanRecordingContext& Ctx, FrontFaceMode mode)
 	{
-		if (_ActivePipelineState.FrontFace != mode)
+		auto& Shadow = Ctx.DynamicState;
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::FrontFace, Shadow.State.FrontFace != mode))
 		{
 			// vkCmdSetFrontFace requires VK_EXT_extended_dynamic_state
-			vkCmdSetFrontFace(CmdBuffer, FrontFaceToVk(mode));
-			_ActivePipelineState.FrontFace = mode;
+			vkCmdSetFrontFace(Ctx, FrontFaceToVk(mode));
+			Shadow.State.FrontFace = mode;
 		}
 	}
 
-	void VulkanGraphicsBackend::SetPolygonMode(VkCommandBuffer CmdBuffer, PolygonMode mode)
+	void VulkanGraphicsBackend::SetPolygonMode(VulkanRecordingContext& Ctx, PolygonMode mode)
 	{
-		if (_ActivePipelineState.ShaderFillMode != mode)
+		auto& Shadow = Ctx.DynamicState;
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::ShaderFillMode, Shadow.State.ShaderFillMode != mode))
 		{
 			// pfn_vkCmdSetPolygonModeEXT requires VK_EXT_extended_dynamic_state3
-			pfn_vkCmdSetPolygonModeEXT(CmdBuffer, PolygonModeToVk(mode));
-			_ActivePipelineState.ShaderFillMode = mode;
+			pfn_vkCmdSetPolygonModeEXT(Ctx.CmdBuffer, PolygonModeToVk(mode));
+			Shadow.State.ShaderFillMode = mode;
 		}
 	}
 
-	void VulkanGraphicsBackend::SetLineWidth(VkCommandBuffer CmdBuffer, float width)
+	void VulkanGraphicsBackend::SetLineWidth(VulkanRecordingContext& Ctx, float width)
 	{
-		if (_ActivePipelineState.LineWidth != width)
+		auto& Shadow = Ctx.DynamicState;
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::LineWidth, Shadow.State.LineWidth != width))
 		{
 			// vkCmdSetLineWidth is core dynamic state
-			vkCmdSetLineWidth(CmdBuffer, width);
-			_ActivePipelineState.LineWidth = width;
+			vkCmdSetLineWidth(Ctx, width);
+			Shadow.State.LineWidth = width;
 		}
 	}
 
-	void VulkanGraphicsBackend::SetRasterizerDiscardEnable(VkCommandBuffer CmdBuffer, ChBool8 enable)
+	void VulkanGraphicsBackend::SetRasterizerDiscardEnable(VulkanRecordingContext& Ctx, ChBool8 enable)
 	{
 		bool bEnable = ChBoolToBool(enable);
-		if (_ActivePipelineState.RasterizerDiscardEnable != enable)
+		auto& Shadow = Ctx.DynamicState;
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::RasterizerDiscardEnable, Shadow.State.RasterizerDiscardEnable != enable))
 		{
 			// vkCmdSetRasterizerDiscardEnable requires VK_EXT_extended_dynamic_state3
-			vkCmdSetRasterizerDiscardEnable(CmdBuffer, bEnable);
-			_ActivePipelineState.RasterizerDiscardEnable = enable;
+			vkCmdSetRasterizerDiscardEnable(Ctx, bEnable);
+			Shadow.State.RasterizerDiscardEnable = enable;
 		}
 	}
 
-	void VulkanGraphicsBackend::SetDepthBiasEnable(VkCommandBuffer CmdBuffer, ChBool8 enable)
+	void VulkanGraphicsBackend::SetDepthBiasEnable(VulkanRecordingContext& Ctx, ChBool8 enable)
 	{
 		bool bEnable = ChBoolToBool(enable);
-		if (_ActivePipelineState.DepthBiasEnable != enable)
+		auto& Shadow = Ctx.DynamicState;
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::DepthBiasEnable, Shadow.State.DepthBiasEnable != enable))
 		{
 			// vkCmdSetDepthBiasEnable requires VK_EXT_extended_dynamic_state
-			vkCmdSetDepthBiasEnable(CmdBuffer, bEnable);
-			_ActivePipelineState.DepthBiasEnable = enable;
+			vkCmdSetDepthBiasEnable(Ctx, bEnable);
+			Shadow.State.DepthBiasEnable = enable;
 		}
 	}
 
-	void VulkanGraphicsBackend::SetDepthBias(VkCommandBuffer CmdBuffer, float constantFactor, float clamp, float slopeFactor)
+	void VulkanGraphicsBackend::SetDepthBias(VulkanRecordingContext& Ctx, float constantFactor, float clamp, float slopeFactor)
 	{
 		// vkCmdSetDepthBias is core dynamic state
-		if (_ActivePipelineState.DepthBiasConstantFactor != constantFactor ||
-			_ActivePipelineState.DepthBiasClamp != clamp ||
-			_ActivePipelineState.DepthBiasSlopeFactor != slopeFactor)
+		auto& Shadow = Ctx.DynamicState;
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::DepthBias,
+			Shadow.State.DepthBiasConstantFactor != constantFactor ||
+			Shadow.State.DepthBiasClamp != clamp ||
+			Shadow.State.DepthBiasSlopeFactor != slopeFactor))
 		{
-			vkCmdSetDepthBias(CmdBuffer, constantFactor, clamp, slopeFactor);
-			_ActivePipelineState.DepthBiasConstantFactor = constantFactor;
-			_ActivePipelineState.DepthBiasClamp = clamp;
-			_ActivePipelineState.DepthBiasSlopeFactor = slopeFactor;
+			vkCmdSetDepthBias(Ctx, constantFactor, clamp, slopeFactor);
+			Shadow.State.DepthBiasConstantFactor = constantFactor;
+			Shadow.State.DepthBiasClamp = clamp;
+			Shadow.State.DepthBiasSlopeFactor = slopeFactor;
 		}
 	}
 
-	void VulkanGraphicsBackend::SetDepthTestEnable(VkCommandBuffer CmdBuffer, ChBool8 enable)
+	void VulkanGraphicsBackend::SetDepthTestEnable(VulkanRecordingContext& Ctx, ChBool8 enable)
 	{
 		bool bEnable = ChBoolToBool(enable);
-		if (_ActivePipelineState.DepthTestEnable != enable)
+		auto& Shadow = Ctx.DynamicState;
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::DepthTestEnable, Shadow.State.DepthTestEnable != enable))
 		{
 			// vkCmdSetDepthTestEnable requires VK_EXT_extended_dynamic_state
-			vkCmdSetDepthTestEnable(CmdBuffer, bEnable);
-			_ActivePipelineState.DepthTestEnable = enable;
+			vkCmdSetDepthTestEnable(Ctx, bEnable);
+			Shadow.State.DepthTestEnable = enable;
 		}
 	}
 
-	void VulkanGraphicsBackend::SetDepthWriteEnable(VkCommandBuffer CmdBuffer, ChBool8 enable)
+	void VulkanGraphicsBackend::SetDepthWriteEnable(VulkanRecordingContext& Ctx, ChBool8 enable)
 	{
 		bool bEnable = ChBoolToBool(enable);
-		if (_ActivePipelineState.DepthWriteEnable != enable)
+		auto& Shadow = Ctx.DynamicState;
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::DepthWriteEnable, Shadow.State.DepthWriteEnable != enable))
 		{
 			// vkCmdSetDepthWriteEnable requires VK_EXT_extended_dynamic_state
-			vkCmdSetDepthWriteEnable(CmdBuffer, bEnable);
-			_ActivePipelineState.DepthWriteEnable = enable;
+			vkCmdSetDepthWriteEnable(Ctx, bEnable);
+			Shadow.State.DepthWriteEnable = enable;
 		}
 	}
 
-	void VulkanGraphicsBackend::SetDepthCompareOp(VkCommandBuffer CmdBuffer, CompareOp op)
+	void VulkanGraphicsBackend::SetDepthCompareOp(VulkanRecordingContext& Ctx, CompareOp op)
 	{
-		if (_ActivePipelineState.DepthCompareOp != op)
+		auto& Shadow = Ctx.DynamicState;
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::DepthCompareOp, Shadow.State.DepthCompareOp != op))
 		{
 			// vkCmdSetDepthCompareOp requires VK_EXT_extended_dynamic_state
-			vkCmdSetDepthCompareOp(CmdBuffer, CompareOpToVk(op));
-			_ActivePipelineState.DepthCompareOp = op;
+			vkCmdSetDepthCompareOp(Ctx, CompareOpToVk(op));
+			Shadow.State.DepthCompareOp = op;
 		}
 	}
 
-	void VulkanGraphicsBackend::SetStencilTestEnable(VkCommandBuffer CmdBuffer, ChBool8 enable)
+	void VulkanGraphicsBackend::SetStencilTestEnable(VulkanRecordingContext& Ctx, ChBool8 enable)
 	{
 		bool bEnable = ChBoolToBool(enable);
-		if (_ActivePipelineState.StencilTestEnable != enable)
+		auto& Shadow = Ctx.DynamicState;
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::StencilTestEnable, Shadow.State.StencilTestEnable != enable))
 		{
 			// vkCmdSetStencilTestEnable requires VK_EXT_extended_dynamic_state
-			vkCmdSetStencilTestEnable(CmdBuffer, bEnable);
-			_ActivePipelineState.StencilTestEnable = enable;
+			vkCmdSetStencilTestEnable(Ctx, bEnable);
+			Shadow.State.StencilTestEnable = enable;
 		}
 	}
 
-	void VulkanGraphicsBackend::SetStencilFrontOp(VkCommandBuffer CmdBuffer, const StencilOpState& state)
+	void VulkanGraphicsBackend::SetStencilFrontOp(VulkanRecordingContext& Ctx, const StencilOpState& state)
 	{
-		// NOTE: Requires a full comparison if StencilOpState doesn't have an operator==
-		if (state != _ActivePipelineState.StencilFront)
+		auto& Shadow = Ctx.DynamicState;
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::StencilFront, state != Shadow.State.StencilFront))
 		{
 			// vkCmdSetStencilOp requires VK_EXT_extended_dynamic_state
-			vkCmdSetStencilOp(CmdBuffer, VK_STENCIL_FACE_FRONT_BIT,
+			vkCmdSetStencilOp(Ctx.CmdBuffer, VK_STENCIL_FACE_FRONT_BIT,
 				StencilOpToVulkan(state.FailOp),
 				StencilOpToVulkan(state.PassOp),
 				StencilOpToVulkan(state.DepthFailOp),
 				CompareOpToVk(state.CompareFunction));
 
-			_ActivePipelineState.StencilFront = state;
+			Shadow.State.StencilFront = state;
 		}
 	}
 
-	void VulkanGraphicsBackend::SetStencilBackOp(VkCommandBuffer CmdBuffer, const StencilOpState& state)
+	void VulkanGraphicsBackend::SetStencilBackOp(VulkanRecordingContext& Ctx, const StencilOpState& state)
 	{
-		// NOTE: Requires a full comparison if StencilOpState doesn't have an operator==
-		if (state != _ActivePipelineState.StencilBack)
+		auto& Shadow = Ctx.DynamicState;
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::StencilBack, state != Shadow.State.StencilBack))
 		{
 			// vkCmdSetStencilOp requires VK_EXT_extended_dynamic_state
-			vkCmdSetStencilOp(CmdBuffer, VK_STENCIL_FACE_BACK_BIT,
+			vkCmdSetStencilOp(Ctx.CmdBuffer, VK_STENCIL_FACE_BACK_BIT,
 				StencilOpToVulkan(state.FailOp),
 				StencilOpToVulkan(state.PassOp),
 				StencilOpToVulkan(state.DepthFailOp),
 				CompareOpToVk(state.CompareFunction));
 
-			_ActivePipelineState.StencilBack = state;
+			Shadow.State.StencilBack = state;
 		}
 	}
 
-	void VulkanGraphicsBackend::SetAlphaToCoverageEnable(VkCommandBuffer CmdBuffer, ChBool8 enable)
+	void VulkanGraphicsBackend::SetAlphaToCoverageEnable(VulkanRecordingContext& Ctx, ChBool8 enable)
 	{
 		bool bEnable = ChBoolToBool(enable);
-		if (_ActivePipelineState.AlphaToCoverageEnable != enable)
+		auto& Shadow = Ctx.DynamicState;
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::AlphaToCoverageEnable, Shadow.State.AlphaToCoverageEnable != enable))
 		{
 			// pfn_vkCmdSetAlphaToCoverageEnableEXT requires VK_EXT_extended_dynamic_state3
-			pfn_vkCmdSetAlphaToCoverageEnableEXT(CmdBuffer, bEnable);
-			_ActivePipelineState.AlphaToCoverageEnable = enable;
+			pfn_vkCmdSetAlphaToCoverageEnableEXT(Ctx.CmdBuffer, bEnable);
+			Shadow.State.AlphaToCoverageEnable = enable;
 		}
 	}
 
@@ -1567,37 +1964,40 @@ namespace Chilli
 
 	}
 
-	void VulkanGraphicsBackend::SetSampleMask(VkCommandBuffer CmdBuffer, uint32_t sampleCount,
+	void VulkanGraphicsBackend::SetSampleMask(VulkanRecordingContext& Ctx, uint32_t sampleCount,
 		uint32_t sampleMask)
 	{
-		if (_ActivePipelineState.SampleMask != sampleMask ||
-			_ActivePipelineState.SampleCount != sampleCount)
+		// The mask array is sized by the sample count, so a new count needs the mask again
+		auto& Shadow = Ctx.DynamicState;
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::SampleMask,
+			Shadow.State.SampleMask != sampleMask || Shadow.SampleMaskCount != sampleCount))
 		{
 			VkSampleMask vkMask = sampleMask & 0xFFFFFFFF;
 
 			// Requires VK_EXT_extended_dynamic_state3
 			pfn_vkCmdSetSampleMaskEXT(
-				CmdBuffer,
+				Ctx.CmdBuffer,
 				SampleCountToVk(sampleCount),
 				&vkMask
 			);
 
-			_ActivePipelineState.SampleMask = sampleMask;
-			_ActivePipelineState.SampleCount = sampleCount;
+			Shadow.State.SampleMask = sampleMask;
+			Shadow.SampleMaskCount = sampleCount;
 		}
 	}
 
-	void VulkanGraphicsBackend::SetRasterizationSamples(VkCommandBuffer CmdBuffer, uint32_t sampleCount)
+	void VulkanGraphicsBackend::SetRasterizationSamples(VulkanRecordingContext& Ctx, uint32_t sampleCount)
 	{
-		if (_ActivePipelineState.SampleCount != sampleCount)
+		auto& Shadow = Ctx.DynamicState;
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::SampleCount, Shadow.State.SampleCount != sampleCount))
 		{
 			// Requires VK_EXT_extended_dynamic_state3
 			pfn_vkCmdSetRasterizationSamplesEXT(
-				CmdBuffer,
+				Ctx.CmdBuffer,
 				SampleCountToVk(sampleCount)
 			);
 
-			_ActivePipelineState.SampleCount = sampleCount;
+			Shadow.State.SampleCount = sampleCount;
 		}
 	}
 
@@ -1685,6 +2085,12 @@ namespace Chilli
 	}
 
 	void VulkanGraphicsBackend::ClearMaterialData(uint32_t RawMaterialHandle)
+	{
+		// The sets may still be bound by a frame in flight
+		_DeletionQueue.Push([this, RawMaterialHandle]() { _ClearMaterialData(RawMaterialHandle); });
+	}
+
+	void VulkanGraphicsBackend::_ClearMaterialData(uint32_t RawMaterialHandle)
 	{
 		auto Mat = _MaterialManager.Get(RawMaterialHandle);
 
@@ -1713,8 +2119,10 @@ namespace Chilli
 
 	void VulkanGraphicsBackend::DestroySampler(uint32_t SamplerHandle)
 	{
-		_SamplerSet.Get(SamplerHandle)->Destroy(_Data.Device.GetHandle());
-		_SamplerSet.Destroy(SamplerHandle);
+		_DeletionQueue.Push([this, SamplerHandle]() {
+			_SamplerSet.Get(SamplerHandle)->Destroy(_Data.Device.GetHandle());
+			_SamplerSet.Destroy(SamplerHandle);
+		});
 	}
 
 	uint32_t VulkanGraphicsBackend::GetTextureShaderIndex(uint32_t RawTextureHandle)
@@ -1734,9 +2142,21 @@ namespace Chilli
 		return _BindlessManager.GetMaterialShaderIndex(RawMaterialHandle);
 	}
 
-	void VulkanGraphicsBackend::SetColorWriteEnable(VkCommandBuffer CmdBuffer, size_t Count, ChBool8* States)
+	MaterialBindingSlot VulkanGraphicsBackend::FindMaterialBindingSlot(uint32_t RawMaterialHandle, const char* Name)
 	{
-		//if (cachedValue != value)
+		return _ShaderManager.FindUserBindingSlot(_MaterialManager.Get(RawMaterialHandle)->ProgramID, Name);
+	}
+
+	void VulkanGraphicsBackend::SetColorWriteEnable(VulkanRecordingContext& Ctx, size_t Count, ChBool8* States)
+	{
+		VULKAN_ASSERT(Count <= CH_MAX_COLOR_ATTACHMENT_COUNT, "Too Many Color Write Enables Given!");
+
+		auto& Shadow = Ctx.DynamicState;
+		bool Changed = Shadow.ColorWriteEnableCount != Count;
+		for (size_t i = 0; i < Count && !Changed; i++)
+			Changed = Shadow.ColorWriteEnables[i] != States[i];
+
+		if (Ctx.ShouldSetDynamicState(DynamicStateBit::ColorWriteEnable, Changed))
 		{
 			VkBool32* Enables = (VkBool32*)alloca(sizeof(VkBool32) * Count);
 			for (int i = 0; i < Count; i++)
@@ -1746,10 +2166,14 @@ namespace Chilli
 
 			// Requires VK_EXT_color_write_enable
 			pfn_vkCmdSetColorWriteEnableEXT(
-				CmdBuffer,
+				Ctx.CmdBuffer,
 				Count,
 				Enables
 			);
+
+			Shadow.ColorWriteEnableCount = uint32_t(Count);
+			for (size_t i = 0; i < Count; i++)
+				Shadow.ColorWriteEnables[i] = States[i];
 		}
 	}
 
@@ -1781,9 +2205,19 @@ namespace Chilli
 		_BufferManager.MapBufferData(_Data.Device, BufferHandle, Data, Size, Offset);
 	}
 
+	void VulkanGraphicsBackend::ReadBufferData(uint32_t BufferHandle, void* Data, uint32_t Size, uint32_t Offset)
+	{
+		_BufferManager.ReadBufferData(BufferHandle, Data, Size, Offset);
+	}
+
 	void VulkanGraphicsBackend::FreeBuffer(uint32_t BufferHandle)
 	{
-		_BufferManager.Destroy(_Data.Allocator, BufferHandle);
+		_DeletionQueue.Push([this, BufferHandle]() { _BufferManager.Destroy(_Data.Allocator, BufferHandle); });
+	}
+
+	void VulkanGraphicsBackend::DeferDestroy(std::function<void()>&& Fn)
+	{
+		_DeletionQueue.Push(std::move(Fn));
 	}
 
 #pragma region CoreInitials
@@ -1928,8 +2362,9 @@ namespace Chilli
 		outInfo.APIVersionMinor = VK_API_VERSION_MINOR(vkInfo.properties.apiVersion);
 	}
 
-	void PopulateDeviceLimits(const VulkanPhysiscalDeviceInfo& vkInfo, RenderDeviceLimits& outLimits)
+	void PopulateDeviceLimits(const VulkanPhysicalDevice& Device, RenderDeviceLimits& outLimits)
 	{
+		const auto& vkInfo = Device.Info;
 		const auto& props = vkInfo.properties;
 		// --- 2. MSAA Setup ---
 		// Combine Color and Depth support to find the common denominator
@@ -1967,6 +2402,23 @@ namespace Chilli
 		outLimits.bSupportsRayTracing = false; // Requires checking specific RT extensions/features
 		outLimits.bSupportsMeshShaders = vkInfo.features13.dynamicRendering; // Just an example, check actual Mesh features
 		outLimits.bSupportsVariableRateShading = false; // Requires checking VK_KHR_fragment_shading_rate
+		outLimits.bSupportsMultiDrawIndirect = vkInfo.features.multiDrawIndirect;
+		outLimits.bSupportsDrawIndirectCount = vkInfo.features12.drawIndirectCount;
+		outLimits.bSupportsDrawIndirectFirstInstance = vkInfo.features.drawIndirectFirstInstance;
+
+		// --- 6. Compressed Formats ---
+		outLimits.SampledCompressedFormats = 0;
+		if (vkInfo.features.textureCompressionBC)
+		{
+			for (uint32_t Format = uint32_t(ImageFormat::BC1_RGBA); Format <= uint32_t(ImageFormat::BC7_SRGBA); Format++)
+			{
+				VkFormatProperties FormatProps{};
+				vkGetPhysicalDeviceFormatProperties(Device.PhysicalDevice, FormatToVk(ImageFormat(Format)), &FormatProps);
+				if (FormatProps.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)
+					outLimits.SampledCompressedFormats |= 1u << (Format - uint32_t(ImageFormat::BC1_RGBA));
+			}
+		}
+		outLimits.bSupportsTextureCompressionBC = vkInfo.features.textureCompressionBC;
 	}
 
 	void VulkanGraphicsBackend::_CreatePhysicalDevice(std::vector<const char*>& DeviceExtensions)
@@ -2014,7 +2466,7 @@ namespace Chilli
 		for (int i = 0; i < _Data.PhysicalDevices.size(); i++)
 		{
 			PopulateDeviceInfo(_Data.PhysicalDevices[i].Info, _Data.PhysicalDeviceInfos[i]);
-			PopulateDeviceLimits(_Data.PhysicalDevices[i].Info, _Data.PhysicalDeviceLimits[i]);
+			PopulateDeviceLimits(_Data.PhysicalDevices[i], _Data.PhysicalDeviceLimits[i]);
 			_Data.PhysicalDeviceInfos[i].RawDeviceHandle = i;
 		}
 
@@ -2088,9 +2540,11 @@ namespace Chilli
 	{
 		_Data.SwapChainKHR.Init(_Data.Device, _Data.SurfaceKHR, _Spec.ViewPortSize.x, _Spec.ViewPortSize.y, _Spec.VSync);
 		_Spec.ViewPortResized = false;
+		_TransitionSwapChainImages();
+	}
 
-		//if(_ActiveCo)
-
+	void VulkanGraphicsBackend::_TransitionSwapChainImages()
+	{
 		for (int i = 0; i < _Data.SwapChainKHR.GetImages().size(); i++)
 		{
 			_Uploader.TransitionImageLayout(_Data.SwapChainKHR.GetImages()[i], VK_IMAGE_LAYOUT_UNDEFINED,
@@ -2103,8 +2557,6 @@ namespace Chilli
 	{
 		if (_Spec.ViewPortResized)
 		{
-			vkDeviceWaitIdle(_Data.Device.GetHandle());
-
 			// Query the new size from the surface
 			VkSurfaceCapabilitiesKHR surfaceCaps;
 			vkGetPhysicalDeviceSurfaceCapabilitiesKHR(_Data.Device.GetPhysicalDevice()->PhysicalDevice, _Data.SurfaceKHR, &surfaceCaps);
@@ -2113,8 +2565,16 @@ namespace Chilli
 			_Spec.ViewPortSize.x = surfaceCaps.currentExtent.width;
 			_Spec.ViewPortSize.y = surfaceCaps.currentExtent.height;
 
-			_DestroySwapChainKHR();
-			_CreateSwapChainKHR();
+			// The device keeps running, the old swapchain is handed over as oldSwapchain and destroyed once
+			// the frames in flight that may still present from it are done
+			VulkanSwapChainKHR::RetiredSwapChain Retired;
+			_Data.SwapChainKHR.Recreate(_Data.Device, _Data.SurfaceKHR, _Spec.ViewPortSize.x, _Spec.ViewPortSize.y,
+				_Spec.VSync, Retired);
+			_Spec.ViewPortResized = false;
+			_TransitionSwapChainImages();
+
+			VkDevice Device = _Data.Device.GetHandle();
+			_DeletionQueue.Push([Device, Retired]() { VulkanSwapChainKHR::DestroyRetired(Device, Retired); });
 		}
 	}
 
@@ -2296,11 +2756,7 @@ namespace Chilli
 
 	void VulkanGraphicsBackend::_CreateVulkanDataUploader()
 	{
-		auto StagingBufferCmd = _CommandManager.AllocateCommandBuffer(_Data.Device.GetHandle(), CommandBufferPurpose::TRANSFER);
-		auto GraphicsBufferCmd = _CommandManager.AllocateCommandBuffer(_Data.Device.GetHandle(), CommandBufferPurpose::GRAPHICS);
-		_Uploader.Init(&_Data.Device, _Data.Allocator,
-			_CommandManager.Get(StagingBufferCmd.CommandBufferHandle),
-			_CommandManager.Get(GraphicsBufferCmd.CommandBufferHandle));
+		_Uploader.Init(&_Data.Device, _Data.Allocator);
 	}
 
 	void VulkanGraphicsBackend::_DestroyVulkanDataUploader()
@@ -2327,6 +2783,13 @@ namespace Chilli
 		ImageManagerSpec.MapBufferData = [&](uint32_t BufferHandle, void* Data, uint32_t Size, uint32_t Offset) {
 			this->MapBufferData(BufferHandle, Data, Size, Offset);
 			};
+		ImageManagerSpec.Allocator = _Data.Allocator;
+		ImageManagerSpec.DeferDestroy = [&](std::function<void()>&& Fn) {
+			this->_DeletionQueue.Push(std::move(Fn));
+			};
+		ImageManagerSpec.TextureViewChanged = [&](uint32_t TextureHandle, VkImageView View) {
+			this->_BindlessManager.RetargetTexture(TextureHandle, View);
+			};
 		_ImageDataManager.Init(ImageManagerSpec);
 	}
 
@@ -2410,7 +2873,11 @@ namespace Chilli
 	{
 		if (Module.RawModuleHandle == BackBone::npos)
 			VULKAN_ERROR("No Valid Raw Module Handle Given!");
-		_ShaderManager.DestroyShaderModule(_Data.Device.GetHandle(), Module.RawModuleHandle);
+
+		uint32_t ModuleHandle = Module.RawModuleHandle;
+		_DeletionQueue.Push([this, ModuleHandle]() {
+			_ShaderManager.DestroyShaderModule(_Data.Device.GetHandle(), ModuleHandle);
+		});
 	}
 
 	void VulkanGraphicsBackend::PrepareForShutDown()
@@ -2418,6 +2885,11 @@ namespace Chilli
 		vkDeviceWaitIdle(_Data.Device.GetHandle());
 	}
 
+	void VulkanGraphicsBackend::WaitIdle()
+	{
+		vkDeviceWaitIdle(_Data.Device.GetHandle());
+	}
+
 #pragma region VulkanCommandManager
 	VkCommandPool __CreateVkCommandPool(VkDevice device, uint32_t queueFamilyIndex,
 		VkCommandPoolCreateFlags Flags)
@@ -2501,42 +2973,163 @@ namespace Chilli
 	}
 #pragma endregion
 
-	void VulkanDataUploader::Init(VulkanDevice* Device, VmaAllocator Allocator, VkCommandBuffer CommandBufferHandle, VkCommandBuffer GraphicsCmdBuffer)
+	void VulkanDataUploader::Init(VulkanDevice* Device, VmaAllocator Allocator)
 	{
 		_Device = Device;
 		_Allocator = Allocator;
-		_CmdBuffer = CommandBufferHandle;
-		_GraphicsCmdBuffer = GraphicsCmdBuffer;
-		// Create Fence
-		VkFenceCreateInfo fenceInfo{};
-		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+		_LatestTicket = 0;
+		_CompletedTicket = 0;
+
+		VkSemaphoreTypeCreateInfo TypeInfo{};
+		TypeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		TypeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		TypeInfo.initialValue = 0;
 
-		VULKAN_SUCCESS_ASSERT(vkCreateFence(Device->GetHandle(), &fenceInfo, nullptr, &_TransferFence),
-			"Failed To Create Fence");
-		VULKAN_SUCCESS_ASSERT(vkCreateFence(Device->GetHandle(), &fenceInfo, nullptr, &_GraphicsFence),
-			"Failed To Create Fence");
+		VkSemaphoreCreateInfo SemaphoreInfo{};
+		SemaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		SemaphoreInfo.pNext = &TypeInfo;
+
+		VULKAN_SUCCESS_ASSERT(vkCreateSemaphore(Device->GetHandle(), &SemaphoreInfo, nullptr, &_TimelineSemaphore),
+			"Failed To Create Upload Timeline Semaphore");
 
 		_TransferQueueFamilyIndex = Device->GetPhysicalDevice()->Info.QueueIndicies.Queues[int(QueueFamilies::TRANSFER)].value();
 		_GraphicsQueueFamilyIndex = Device->GetPhysicalDevice()->Info.QueueIndicies.Queues[int(QueueFamilies::GRAPHICS)].value();
 
 		if (_TransferQueueFamilyIndex == _GraphicsQueueFamilyIndex)
 			_SameFamily = true;
+
+		_CreateBatchRing(_TransferRing, _TransferQueueFamilyIndex, QueueFamilies::TRANSFER);
+		_CreateBatchRing(_GraphicsRing, _GraphicsQueueFamilyIndex, QueueFamilies::GRAPHICS);
 	}
 
 	void VulkanDataUploader::Destroy()
 	{
-		vkDestroyFence(_Device->GetHandle(), _TransferFence, nullptr);
-		vkDestroyFence(_Device->GetHandle(), _GraphicsFence, nullptr);
+		WaitIdle();
+
+		_DestroyBatchRing(_TransferRing);
+		_DestroyBatchRing(_GraphicsRing);
+		vkDestroySemaphore(_Device->GetHandle(), _TimelineSemaphore, nullptr);
+		_TimelineSemaphore = VK_NULL_HANDLE;
 		_Device = VK_NULL_HANDLE;
 	}
 
+	void VulkanDataUploader::_CreateBatchRing(BatchRing& Ring, uint32_t QueueFamily, QueueFamilies Family)
+	{
+		VkCommandPoolCreateInfo PoolInfo{};
+		PoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		PoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		PoolInfo.queueFamilyIndex = QueueFamily;
+
+		VULKAN_SUCCESS_ASSERT(vkCreateCommandPool(_Device->GetHandle(), &PoolInfo, nullptr, &Ring.Pool),
+			"Failed to create upload command pool!");
+		Ring.Queue = _Device->GetQueue(Family);
+		Ring.Slots.clear();
+	}
+
+	void VulkanDataUploader::_DestroyBatchRing(BatchRing& Ring)
+	{
+		// Destroying the pool frees every buffer allocated from it
+		vkDestroyCommandPool(_Device->GetHandle(), Ring.Pool, nullptr);
+		Ring.Pool = VK_NULL_HANDLE;
+		Ring.Slots.clear();
+	}
+
+	uint32_t VulkanDataUploader::_AcquireBatchSlot(BatchRing& Ring)
+	{
+		auto FindFreeSlot = [&]() -> uint32_t {
+			for (uint32_t i = 0; i < uint32_t(Ring.Slots.size()); i++)
+				if (Ring.Slots[i].Ticket <= _CompletedTicket)
+					return i;
+			return UINT32_MAX;
+			};
+
+		uint32_t Index = FindFreeSlot();
+		if (Index == UINT32_MAX)
+		{
+			_RefreshCompletedTicket();
+			Index = FindFreeSlot();
+		}
+
+		if (Index == UINT32_MAX && Ring.Slots.size() < CH_UPLOAD_MAX_BATCHES_IN_FLIGHT)
+		{
+			VkCommandBufferAllocateInfo AllocInfo{};
+			AllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			AllocInfo.commandPool = Ring.Pool;
+			AllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			AllocInfo.commandBufferCount = 1;
+
+			BatchRing::Slot NewSlot;
+			VULKAN_SUCCESS_ASSERT(vkAllocateCommandBuffers(_Device->GetHandle(), &AllocInfo, &NewSlot.CmdBuffer),
+				"Failed to allocate upload command buffer!");
+			Ring.Slots.push_back(NewSlot);
+			Index = uint32_t(Ring.Slots.size() - 1);
+		}
+
+		if (Index == UINT32_MAX)
+		{
+			// Every slot is in flight, only now does the CPU wait and only for the oldest batch
+			Index = 0;
+			for (uint32_t i = 1; i < uint32_t(Ring.Slots.size()); i++)
+				if (Ring.Slots[i].Ticket < Ring.Slots[Index].Ticket)
+					Index = i;
+			Wait(Ring.Slots[Index].Ticket);
+		}
+
+		return Index;
+	}
+
+	void VulkanDataUploader::_RefreshCompletedTicket()
+	{
+		uint64_t Value = 0;
+		VULKAN_SUCCESS_ASSERT(vkGetSemaphoreCounterValue(_Device->GetHandle(), _TimelineSemaphore, &Value),
+			"Failed to read upload timeline semaphore!");
+		_CompletedTicket = std::max(_CompletedTicket, Value);
+	}
+
+	bool VulkanDataUploader::IsComplete(VulkanUploadTicket Ticket)
+	{
+		if (Ticket <= _CompletedTicket)
+			return true;
+
+		_RefreshCompletedTicket();
+		return Ticket <= _CompletedTicket;
+	}
+
+	void VulkanDataUploader::Wait(VulkanUploadTicket Ticket)
+	{
+		if (IsComplete(Ticket))
+			return;
+
+		VULKAN_ASSERT(Ticket <= _LatestTicket, "Waiting on an upload that was never submitted!");
+
+		VkSemaphoreWaitInfo WaitInfo{};
+		WaitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		WaitInfo.semaphoreCount = 1;
+		WaitInfo.pSemaphores = &_TimelineSemaphore;
+		WaitInfo.pValues = &Ticket;
+
+		VULKAN_SUCCESS_ASSERT(vkWaitSemaphores(_Device->GetHandle(), &WaitInfo, UINT64_MAX),
+			"Failed to wait on upload timeline semaphore!");
+		_CompletedTicket = std::max(_CompletedTicket, Ticket);
+	}
+
+	uint32_t VulkanDataUploader::GetPendingBatchCount()
+	{
+		if (_LatestTicket > _CompletedTicket)
+			_RefreshCompletedTicket();
+		return uint32_t(_LatestTicket - _CompletedTicket);
+	}
+
 	void VulkanDataUploader::BeginBatching(CommandBufferPurpose Purpose)
 	{
-		auto VkCmdHandle = _CmdBuffer;
+		VULKAN_ASSERT(_BatchRecording == CH_NONE, "An upload batch is already recording!");
 
+		_ActiveRing = &_TransferRing;
 		if (Purpose == CommandBufferPurpose::GRAPHICS)
-			VkCmdHandle = _GraphicsCmdBuffer;
+			_ActiveRing = &_GraphicsRing;
+
+		_ActiveSlot = _AcquireBatchSlot(*_ActiveRing);
+		auto VkCmdHandle = _ActiveRing->Slots[_ActiveSlot].CmdBuffer;
 
 		VkCommandBufferBeginInfo beginInfo{};
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -2552,50 +3145,64 @@ namespace Chilli
 		_ActiveCmdBuffer = VkCmdHandle;
 	}
 
-	void VulkanDataUploader::EndBatching()
+	VulkanUploadTicket VulkanDataUploader::EndBatching()
 	{
-		auto device = _Device->GetHandle();
-
 		vkEndCommandBuffer(_ActiveCmdBuffer);
 
+		// Every batch waits on the one before it, so batches execute in submission order across both
+		// queues (a transition on graphics is done before the transfer copy recorded after it) and the
+		// timeline is only ever signalled with increasing values
+		const VulkanUploadTicket Ticket = _LatestTicket + 1;
+		const uint64_t WaitValue = _LatestTicket;
+		const uint64_t SignalValue = Ticket;
+
+		VkTimelineSemaphoreSubmitInfo TimelineInfo{};
+		TimelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		TimelineInfo.waitSemaphoreValueCount = 1;
+		TimelineInfo.pWaitSemaphoreValues = &WaitValue;
+		TimelineInfo.signalSemaphoreValueCount = 1;
+		TimelineInfo.pSignalSemaphoreValues = &SignalValue;
+
+		VkPipelineStageFlags WaitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
 		VkSubmitInfo Submit{};
 		Submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		Submit.pNext = &TimelineInfo;
+		Submit.waitSemaphoreCount = 1;
+		Submit.pWaitSemaphores = &_TimelineSemaphore;
+		Submit.pWaitDstStageMask = &WaitStage;
 		Submit.commandBufferCount = 1;
 		Submit.pCommandBuffers = &_ActiveCmdBuffer;
+		Submit.signalSemaphoreCount = 1;
+		Submit.pSignalSemaphores = &_TimelineSemaphore;
 
 		std::string FailMessage = "TRANSFER QUEUE FAILED TO SUBMIT";
-		auto Queue = _Device->GetQueue(QueueFamilies::TRANSFER);
-		auto Fence = this->_TransferFence;
-
-		if (_ActiveCmdBuffer == _GraphicsCmdBuffer)
-		{
-			Queue = _Device->GetQueue(QueueFamilies::GRAPHICS);
+		if (_ActiveRing == &_GraphicsRing)
 			FailMessage = "GRAPHICS QUEUE FAILED TO SUBMIT";
-			Fence = this->_GraphicsFence;
-		}
-
-		vkResetFences(_Device->GetHandle(), 1, &Fence);
 
-		VULKAN_SUCCESS_ASSERT(vkQueueSubmit(Queue, 1, &Submit, Fence),
+		VULKAN_SUCCESS_ASSERT(vkQueueSubmit(_ActiveRing->Queue, 1, &Submit, VK_NULL_HANDLE),
 			FailMessage);
 
-		vkWaitForFences(device, 1, &Fence, VK_TRUE, UINT64_MAX);
+		_ActiveRing->Slots[_ActiveSlot].Ticket = Ticket;
+		_LatestTicket = Ticket;
+
 		_BatchRecording = CH_NONE;
 		_ActiveCmdBuffer = VK_NULL_HANDLE;
+		_ActiveRing = nullptr;
+		return Ticket;
 	}
 
-	void VulkanDataUploader::CopyBufferToBuffer(VkBuffer Src, VkBuffer Dst, const BufferCopyInfo& Info,
+	VulkanUploadTicket VulkanDataUploader::CopyBufferToBuffer(VkBuffer Src, VkBuffer Dst, const BufferCopyInfo& Info,
 		VkAccessFlags2 dstAccess,
 		VkPipelineStageFlags2 dstStage)
 	{
-		auto VkCmdHandle = _CmdBuffer;
-
 		bool DoOneTimeBatching = true;
 		if (_BatchRecording != ChBool8(CH_NONE))
 			DoOneTimeBatching = false;
 
 		if (DoOneTimeBatching)
 			BeginBatching();
+		auto VkCmdHandle = _ActiveCmdBuffer;
 
 		VkBufferCopy copyRegion{};
 		copyRegion.srcOffset = Info.SrcOffset; // Offset in bytes from the start of srcBuffer
@@ -2613,10 +3220,11 @@ namespace Chilli
 			dstStage
 		);
 
+		VulkanUploadTicket Ticket = GetRecordingTicket();
 		if (DoOneTimeBatching)
 			EndBatching();
 
-		// 🔵 If families differ → acquire on graphics queue
+		// 🔵 If families differ → acquire on graphics queue, the batch waits on the release through the timeline
 		if (!_SameFamily && DoOneTimeBatching)
 		{
 			BeginBatching(CommandBufferPurpose::GRAPHICS);
@@ -2628,30 +3236,38 @@ namespace Chilli
 				dstStage
 			);
 
-			EndBatching();
+			Ticket = EndBatching();
 		}
+
+		return Ticket;
 	}
 
-	void VulkanDataUploader::CopyBufferToImage(VkBuffer Src, VkImage Dst, const VkBufferImageCopy& Copy,
+	VulkanUploadTicket VulkanDataUploader::CopyBufferToImage(VkBuffer Src, VkImage Dst, const VkBufferImageCopy& Copy,
 		VkImageLayout oldLayout, VkImageLayout newLayout, VkImageSubresourceRange Range,
 		VkAccessFlags2 dstAccess, VkPipelineStageFlags2 dstStage)
 	{
-		auto VkCmdHandle = _CmdBuffer;
+		return CopyBufferToImage(Src, Dst, &Copy, 1, oldLayout, newLayout, Range, dstAccess, dstStage);
+	}
 
+	VulkanUploadTicket VulkanDataUploader::CopyBufferToImage(VkBuffer Src, VkImage Dst, const VkBufferImageCopy* Copies,
+		uint32_t CopyCount, VkImageLayout oldLayout, VkImageLayout newLayout, VkImageSubresourceRange Range,
+		VkAccessFlags2 dstAccess, VkPipelineStageFlags2 dstStage)
+	{
 		bool DoOneTimeBatching = true;
 		if (_BatchRecording != CH_NONE)
 			DoOneTimeBatching = false;
 
 		if (DoOneTimeBatching)
 			BeginBatching();
+		auto VkCmdHandle = _ActiveCmdBuffer;
 
 		vkCmdCopyBufferToImage(
 			VkCmdHandle,
 			Src,
 			Dst,
 			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			1,
-			&Copy
+			CopyCount,
+			Copies
 		);
 
 		BarrierAfterCopy_Image(
@@ -2664,10 +3280,11 @@ namespace Chilli
 			dstStage
 		);
 
+		VulkanUploadTicket Ticket = GetRecordingTicket();
 		if (DoOneTimeBatching)
 			EndBatching();
 
-		// 🔵 If families differ → acquire on graphics queue
+		// 🔵 If families differ → acquire on graphics queue, the batch waits on the release through the timeline
 		if (!_SameFamily && DoOneTimeBatching)
 		{
 			BeginBatching(CommandBufferPurpose::GRAPHICS);
@@ -2682,22 +3299,23 @@ namespace Chilli
 				dstStage
 			);
 
-			EndBatching();
+			Ticket = EndBatching();
 		}
+
+		return Ticket;
 	}
 
-	void VulkanDataUploader::CopyImageToBuffer(VkImage Src, VkBuffer Dst, const VkBufferImageCopy& Copy,
+	VulkanUploadTicket VulkanDataUploader::CopyImageToBuffer(VkImage Src, VkBuffer Dst, const VkBufferImageCopy& Copy,
 		VkAccessFlags2 dstAccess,
 		VkPipelineStageFlags2 dstStage)
 	{
-		auto VkCmdHandle = _CmdBuffer;
-
 		bool DoOneTimeBatching = true;
 		if (_BatchRecording != CH_NONE)
 			DoOneTimeBatching = false;
 
 		if (DoOneTimeBatching)
 			BeginBatching();
+		auto VkCmdHandle = _ActiveCmdBuffer;
 
 		vkCmdCopyImageToBuffer(
 			VkCmdHandle,
@@ -2716,10 +3334,11 @@ namespace Chilli
 			dstStage
 		);
 
+		VulkanUploadTicket Ticket = GetRecordingTicket();
 		if (DoOneTimeBatching)
 			EndBatching();
 
-		// 🔵 If families differ → acquire on graphics queue
+		// 🔵 If families differ → acquire on graphics queue, the batch waits on the release through the timeline
 		if (!_SameFamily && DoOneTimeBatching)
 		{
 			BeginBatching(CommandBufferPurpose::GRAPHICS);
@@ -2731,22 +3350,23 @@ namespace Chilli
 				dstStage
 			);
 
-			EndBatching();
+			Ticket = EndBatching();
 		}
+
+		return Ticket;
 	}
 
-	void VulkanDataUploader::CopyImageToImage(VkImage Src, VkImage Dst, const VkImageCopy& Copy,
+	VulkanUploadTicket VulkanDataUploader::CopyImageToImage(VkImage Src, VkImage Dst, const VkImageCopy& Copy,
 		VkImageLayout oldLayout, VkImageLayout newLayout, VkImageSubresourceRange Range,
 		VkAccessFlags2 dstAccess, VkPipelineStageFlags2 dstStage)
 	{
-		auto VkCmdHandle = _CmdBuffer;
-
 		bool DoOneTimeBatching = true;
 		if (_BatchRecording != CH_NONE)
 			DoOneTimeBatching = false;
 
 		if (DoOneTimeBatching)
 			BeginBatching();
+		auto VkCmdHandle = _ActiveCmdBuffer;
 
 		vkCmdCopyImage(
 			VkCmdHandle,
@@ -2768,10 +3388,11 @@ namespace Chilli
 			dstStage
 		);
 
+		VulkanUploadTicket Ticket = GetRecordingTicket();
 		if (DoOneTimeBatching)
 			EndBatching();
 
-		// 🔵 If families differ → acquire on graphics queue
+		// 🔵 If families differ → acquire on graphics queue, the batch waits on the release through the timeline
 		if (!_SameFamily && DoOneTimeBatching)
 		{
 			BeginBatching(CommandBufferPurpose::GRAPHICS);
@@ -2786,8 +3407,10 @@ namespace Chilli
 				dstStage
 			);
 
-			EndBatching();
+			Ticket = EndBatching();
 		}
+
+		return Ticket;
 	}
 
 	void VulkanDataUploader::TransitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, VkImageAspectFlags aspectFlags)
@@ -2938,13 +3561,10 @@ namespace Chilli
 	void VulkanDataUploader::GenerateMipmaps(VkImage image, VkFormat format, int32_t texWidth, int32_t texHeight, uint32_t mipLevels)
 	{
 		// Mip generation requires a queue that supports GRAPHICS
-		auto VkCmdHandle = _GraphicsCmdBuffer;
-
 		bool DoOneTimeBatching = (_BatchRecording == CH_NONE);
 		if (DoOneTimeBatching)
 			BeginBatching(CommandBufferPurpose::GRAPHICS);
-		else
-			VkCmdHandle = _ActiveCmdBuffer;
+		auto VkCmdHandle = _ActiveCmdBuffer;
 
 		// --- 1. Transition Level 0 for Blitting ---
 		// If we just came from a Transfer queue, we need to ensure Level 0 
@@ -6,6 +6,8 @@
 #include "VulkanShader.h"
 #include "VulkanBuffer.h"
 #include "VulkanTexture.h"
+#include "VulkanParallelRecorder.h"
+#include "VulkanDeletionQueue.h"
 
 const char* VkResultToChar(VkResult Result);
 
@@ -71,37 +73,58 @@ namespace Chilli
 		SparseSet<VkCommandBuffer> _Buffers;
 	};
 
+#define CH_UPLOAD_MAX_BATCHES_IN_FLIGHT 16
+
+	// Records copies and layout transitions into batches on the transfer or graphics queue. Batches are
+	// never waited on when submitted, every one of them signals the next value of a timeline semaphore
+	// and that value is handed out as a ticket to poll or wait on.
 	class VulkanDataUploader
 	{
 	public:
 		VulkanDataUploader() {}
 		~VulkanDataUploader() {}
 
-		void Init(VulkanDevice* Device, VmaAllocator Allocator, VkCommandBuffer CommandBufferHandle,
-			VkCommandBuffer GraphicsCmdBuffer);
+		void Init(VulkanDevice* Device, VmaAllocator Allocator);
+		// Waits for every submitted batch before destroying anything
 		void Destroy();
 
 		void BeginBatching(CommandBufferPurpose Purpose = CommandBufferPurpose::TRANSFER);
-		// Ends Recording and submits them
-		void EndBatching();
+		// Ends recording and submits without waiting, the ticket completes once the batch has executed
+		VulkanUploadTicket EndBatching();
 
-		void CopyBufferToBuffer(VkBuffer Src, VkBuffer Dst, const BufferCopyInfo& Info,
+		// The copies return the ticket of the batch they were recorded into
+		VulkanUploadTicket CopyBufferToBuffer(VkBuffer Src, VkBuffer Dst, const BufferCopyInfo& Info,
 			VkAccessFlags2 dstAccess,
 			VkPipelineStageFlags2 dstStage);
 
-		void CopyBufferToImage(VkBuffer Src, VkImage Dst, const VkBufferImageCopy& Copy,
+		VulkanUploadTicket CopyBufferToImage(VkBuffer Src, VkImage Dst, const VkBufferImageCopy& Copy,
+			VkImageLayout oldLayout, VkImageLayout newLayout, VkImageSubresourceRange Range,
+			VkAccessFlags2 dstAccess, VkPipelineStageFlags2 dstStage);
+		// Every region in one vkCmdCopyBufferToImage, Range has to cover all of them
+		VulkanUploadTicket CopyBufferToImage(VkBuffer Src, VkImage Dst, const VkBufferImageCopy* Copies, uint32_t CopyCount,
 			VkImageLayout oldLayout, VkImageLayout newLayout, VkImageSubresourceRange Range,
 			VkAccessFlags2 dstAccess, VkPipelineStageFlags2 dstStage);
 
-		void CopyImageToBuffer(VkImage Src, VkBuffer Dst, const VkBufferImageCopy& Copy,
+		VulkanUploadTicket CopyImageToBuffer(VkImage Src, VkBuffer Dst, const VkBufferImageCopy& Copy,
 			VkAccessFlags2 dstAccess,
 			VkPipelineStageFlags2 dstStage);
 
-		void CopyImageToImage(VkImage Src, VkImage Dst, const VkImageCopy& Copy,
+		VulkanUploadTicket CopyImageToImage(VkImage Src, VkImage Dst, const VkImageCopy& Copy,
 			VkImageLayout oldLayout, VkImageLayout newLayout, VkImageSubresourceRange Range,
 			VkAccessFlags2 dstAccess, VkPipelineStageFlags2 dstStage);
 
 		bool IsBatchRecording() const { return _BatchRecording; }
+		VkCommandBuffer GetActiveCmdBuffer() const { return _ActiveCmdBuffer; }
+
+		bool IsComplete(VulkanUploadTicket Ticket);
+		void Wait(VulkanUploadTicket Ticket);
+		void WaitIdle() { Wait(_LatestTicket); }
+
+		// Ticket the currently recording batch will get once it is submitted
+		VulkanUploadTicket GetRecordingTicket() const { return _LatestTicket + 1; }
+		VulkanUploadTicket GetLatestTicket() const { return _LatestTicket; }
+		VkSemaphore GetTimelineSemaphore() const { return _TimelineSemaphore; }
+		uint32_t GetPendingBatchCount();
 
 		void TransitionImageLayout(VkImage image,
 			VkImageLayout oldLayout, VkImageLayout newLayout,
@@ -137,12 +160,38 @@ namespace Chilli
 			VkImage dstImage, VkExtent2D extent, VkImageAspectFlags aspect);
 
 
+	private:
+		// Command buffers of one queue, a slot is recycled once its batch's ticket has completed
+		struct BatchRing
+		{
+			struct Slot
+			{
+				VkCommandBuffer CmdBuffer = VK_NULL_HANDLE;
+				VulkanUploadTicket Ticket = 0;
+			};
+
+			VkCommandPool Pool = VK_NULL_HANDLE;
+			VkQueue Queue = VK_NULL_HANDLE;
+			std::vector<Slot> Slots;
+		};
+
+		void _CreateBatchRing(BatchRing& Ring, uint32_t QueueFamily, QueueFamilies Family);
+		void _DestroyBatchRing(BatchRing& Ring);
+		uint32_t _AcquireBatchSlot(BatchRing& Ring);
+		void _RefreshCompletedTicket();
+
 	private:
 		VulkanDevice* _Device;
 		VmaAllocator _Allocator;
-		VkFence _TransferFence, _GraphicsFence;
-		VkCommandBuffer _CmdBuffer, _GraphicsCmdBuffer;
-		VkCommandBuffer _ActiveCmdBuffer;
+		VkCommandBuffer _ActiveCmdBuffer = VK_NULL_HANDLE;
+
+		BatchRing _TransferRing, _GraphicsRing;
+		BatchRing* _ActiveRing = nullptr;
+		uint32_t _ActiveSlot = 0;
+
+		VkSemaphore _TimelineSemaphore = VK_NULL_HANDLE;
+		VulkanUploadTicket _LatestTicket = 0;
+		VulkanUploadTicket _CompletedTicket = 0;
 
 		ChBool8 _BatchRecording = CH_NONE;
 
@@ -151,6 +200,74 @@ namespace Chilli
 		bool _SameFamily = false;
 	};
 
+	enum class DynamicStateBit : uint32_t
+	{
+		TopologyMode = 1 << 0,
+		PrimitiveRestartEnable = 1 << 1,
+		ShaderCullMode = 1 << 2,
+		FrontFace = 1 << 3,
+		ShaderFillMode = 1 << 4,
+		LineWidth = 1 << 5,
+		RasterizerDiscardEnable = 1 << 6,
+		DepthBiasEnable = 1 << 7,
+		DepthBias = 1 << 8,
+		DepthTestEnable = 1 << 9,
+		DepthWriteEnable = 1 << 10,
+		DepthCompareOp = 1 << 11,
+		StencilTestEnable = 1 << 12,
+		StencilFront = 1 << 13,
+		StencilBack = 1 << 14,
+		AlphaToCoverageEnable = 1 << 15,
+		SampleCount = 1 << 16,
+		SampleMask = 1 << 17,
+		ColorBlendEnable = 1 << 18,
+		ColorWriteMask = 1 << 19,
+		ColorBlendEquation = 1 << 20,
+		ColorWriteEnable = 1 << 21,
+	};
+
+	// Dynamic state last recorded into one command buffer. A field is only trusted once its bit is in
+	// ValidMask, Vulkan leaves every dynamic state undefined when a command buffer begins.
+	struct VulkanDynamicStateShadow
+	{
+		PipelineStateInfo State;
+		uint32_t ValidMask = 0;
+		uint32_t SampleMaskCount = 0;
+		uint32_t ColorWriteEnableCount = 0;
+		ChBool8 ColorWriteEnables[CH_MAX_COLOR_ATTACHMENT_COUNT];
+	};
+
+	// Everything one thread needs to translate commands into a single command buffer
+	struct VulkanRecordingContext
+	{
+		VkCommandBuffer CmdBuffer = VK_NULL_HANDLE;
+		VulkanDynamicStateShadow DynamicState;
+		// Only the per frame counters are used, they are summed into the backend's stats after translation
+		RenderDeviceStats Stats;
+
+		inline void Begin(VkCommandBuffer InCmdBuffer)
+		{
+			CmdBuffer = InCmdBuffer;
+			DynamicState.ValidMask = 0;
+			Stats = RenderDeviceStats();
+		}
+
+		// Counts the call either way, returns true when it has to be recorded and marks the state valid
+		inline bool ShouldSetDynamicState(DynamicStateBit Bit, bool Changed)
+		{
+			uint32_t Mask = uint32_t(Bit);
+			if (!Changed && (DynamicState.ValidMask & Mask))
+			{
+				Stats.DynamicStateCallsSkipped++;
+				return false;
+			}
+
+			DynamicState.ValidMask |= Mask;
+			Stats.DynamicStateCallsPerFrame++;
+			return true;
+		}
+	};
+
 	class VulkanGraphicsBackend : public GraphicsBackendApi
 	{
 	public:
@@ -169,7 +286,9 @@ namespace Chilli
 
 		virtual uint32_t AllocateBuffer(const BufferCreateInfo& Info);
 		virtual void MapBufferData(uint32_t BufferHandle, void* Data, uint32_t Size, uint32_t Offset = 0);
+		virtual void ReadBufferData(uint32_t BufferHandle, void* Data, uint32_t Size, uint32_t Offset = 0) override;
 		virtual void FreeBuffer(uint32_t BufferHandle) override;
+		virtual void DeferDestroy(std::function<void()>&& Fn) override;
 
 		virtual ShaderModule CreateShaderModule(const char* FilePath, ShaderStageType Type);
 		virtual void DestroyShaderModule(const ShaderModule& Module);
@@ -184,43 +303,51 @@ namespace Chilli
 				_BindlessManager.GetBindlessSetLayouts());
 		}
 
+		virtual uint32_t GetShaderProgramVariant(uint32_t ProgramHandle, ShaderPermutationKey Key) override
+		{
+			return _ShaderManager.GetProgramVariant(_Data.Device.GetHandle(), ProgramHandle, Key);
+		}
+
 		virtual void ClearShaderProgram(uint32_t ProgramHandle) override
 		{
-			_ShaderManager.ClearShaderProgram(_Data.Device.GetHandle(), ProgramHandle);
+			_DeletionQueue.Push([this, ProgramHandle]() {
+				_ShaderManager.ClearShaderProgram(_Data.Device.GetHandle(), ProgramHandle);
+			});
 		}
 
-		void SetActiveGraphicsPipelineState(VkCommandBuffer CmdBuffer, const PipelineStateInfo& State);
+		void SetActiveGraphicsPipelineState(VulkanRecordingContext& Ctx, const PipelineStateInfo& State);
 		virtual void PrepareForShutDown() override;
+		virtual void WaitIdle() override;
 
-		void SetColorBlendState(VkCommandBuffer CmdBuffer,
+		void SetColorBlendState(VulkanRecordingContext& Ctx,
 			const ColorBlendAttachmentState* ColorBlendAttachments, uint32_t ColorBlendAttachmentCount);
 
-		void SetPrimitiveTopology(VkCommandBuffer CmdBuffer, InputTopologyMode mode);
-		void SetPrimitiveRestartEnable(VkCommandBuffer CmdBuffer, ChBool8 enable);
+		void SetPrimitiveTopology(VulkanRecordingContext& Ctx, InputTopologyMode mode);
+		void SetPrimitiveRestartEnable(VulkanRecordingContext& Ctx, ChBool8 enable);
 
-		void SetCullMode(VkCommandBuffer CmdBuffer, CullMode mode);
-		void SetFrontFace(VkCommandBuffer CmdBuffer, FrontFaceMode mode);
-		void SetPolygonMode(VkCommandBuffer CmdBuffer, PolygonMode mode);
-		void SetLineWidth(VkCommandBuffer CmdBuffer, float width);
-		void SetRasterizerDiscardEnable(VkCommandBuffer CmdBuffer, ChBool8 enable);
+		void SetCullMode(VulkanRecordingContext& Ctx, CullMode mode);
+		void SetFrontFace(VulkanRecordingContext& Ctx, FrontFaceMode mode);
+		void SetPolygonMode(VulkanRecordingContext& Ctx, PolygonMode mode);
+		void SetLineWidth(VulkanRecordingContext& Ctx, float width);
+		void SetRasterizerDiscardEnable(VulkanRecordingContext& Ctx, ChBool8 enable);
 
-		void SetDepthBiasEnable(VkCommandBuffer CmdBuffer, ChBool8 enable);
-		void SetDepthBias(VkCommandBuffer CmdBuffer, float constantFactor, float clamp, float slopeFactor);
-		void SetDepthTestEnable(VkCommandBuffer CmdBuffer, ChBool8 enable);
+		void SetDepthBiasEnable(VulkanRecordingContext& Ctx, ChBool8 enable);
+		void SetDepthBias(VulkanRecordingContext& Ctx, float constantFactor, float clamp, float slopeFactor);
+		void SetDepthTestEnable(VulkanRecordingContext& Ctx, ChBool8 enable);
 
-		void SetDepthWriteEnable(VkCommandBuffer CmdBuffer, ChBool8 enable);
-		void SetDepthCompareOp(VkCommandBuffer CmdBuffer, CompareOp op);
+		void SetDepthWriteEnable(VulkanRecordingContext& Ctx, ChBool8 enable);
+		void SetDepthCompareOp(VulkanRecordingContext& Ctx, CompareOp op);
 
-		void SetStencilTestEnable(VkCommandBuffer CmdBuffer, ChBool8 enable);
-		void SetStencilFrontOp(VkCommandBuffer CmdBuffer, const StencilOpState& state);
-		void SetStencilBackOp(VkCommandBuffer CmdBuffer, const StencilOpState& state);
-		void SetAlphaToCoverageEnable(VkCommandBuffer CmdBuffer, ChBool8 enable);
+		void SetStencilTestEnable(VulkanRecordingContext& Ctx, ChBool8 enable);
+		void SetStencilFrontOp(VulkanRecordingContext& Ctx, const StencilOpState& state);
+		void SetStencilBackOp(VulkanRecordingContext& Ctx, const StencilOpState& state);
+		void SetAlphaToCoverageEnable(VulkanRecordingContext& Ctx, ChBool8 enable);
 		void SetVertexInputState(VkCommandBuffer CmdBuffer, const VertexInputShaderLayout& Layout);
 
-		void SetColorWriteEnable(VkCommandBuffer CmdBuffer, size_t Count, ChBool8* States);
-		void SetSampleMask(VkCommandBuffer CmdBuffer, uint32_t sampleCount,
+		void SetColorWriteEnable(VulkanRecordingContext& Ctx, size_t Count, ChBool8* States);
+		void SetSampleMask(VulkanRecordingContext& Ctx, uint32_t sampleCount,
 			uint32_t sampleMask);
-		void SetRasterizationSamples(VkCommandBuffer CmdBuffer, uint32_t sampleCount);
+		void SetRasterizationSamples(VulkanRecordingContext& Ctx, uint32_t sampleCount);
 
 		void UpdateGlobalShaderData(const GlobalShaderData& Data) override {
 			_BindlessManager.UpdateGlobalShaderData(Data);
@@ -233,6 +360,7 @@ namespace Chilli
 
 		uint32_t PrepareMaterialData(uint32_t ShaderProgramHandle) override;
 		void ClearMaterialData(uint32_t RawMaterialHandle) override;
+		void _ClearMaterialData(uint32_t RawMaterialHandle);
 
 		virtual const GraphcisBackendCreateSpec& GetSpec() const override { return _Spec; }
 		virtual uint32_t GetCurrentFrameIndex() override { return _FrameResource.CurrentFrameIndex; }
@@ -241,11 +369,14 @@ namespace Chilli
 			return _ImageDataManager.AllocateImage(_Data.Allocator, Spec);
 		}
 		virtual void DestroyImage(uint32_t ImageHandle) override {
-			_ImageDataManager.DestroyImage(_Data.Allocator, ImageHandle);
+			_DeletionQueue.Push([this, ImageHandle]() { _ImageDataManager.DestroyImage(_Data.Allocator, ImageHandle); });
 		}
 		virtual void MapImageData(uint32_t ImageHandle, void* Data, int Width, int Height) override {
 			_ImageDataManager.MapImageData(ImageHandle, Data, Width, Height);
 		}
+		virtual void MapImageMips(uint32_t ImageHandle, const void* Data, const ImageMipRegion* Mips, uint32_t MipCount) override {
+			_ImageDataManager.MapImageMips(ImageHandle, Data, Mips, MipCount);
+		}
 
 		virtual uint32_t CreateTexture(uint32_t ImageHandle, TextureSpec& Spec) override {
 			auto Handle = _ImageDataManager.CreateTexture(_Data.Device.GetHandle(), ImageHandle, Spec);
@@ -253,26 +384,35 @@ namespace Chilli
 			return Handle;
 		}
 		virtual void DestroyTexture(uint32_t TextureHandle) override {
-			_ImageDataManager.DestroyTexture(_Data.Device.GetHandle(), TextureHandle);
+			_DeletionQueue.Push([this, TextureHandle]() {
+				_ImageDataManager.DestroyTexture(_Data.Device.GetHandle(), TextureHandle);
+			});
+		}
+		virtual void AliasImages(const ImageAliasRange* Ranges, uint32_t Count) override {
+			_ImageDataManager.AliasImages(Ranges, Count);
 		}
 
 		virtual uint32_t CreateSampler(const SamplerSpec& Spec);
 		virtual void DestroySampler(uint32_t SamplerHandle) override;
 
 		virtual uint32_t GetTextureShaderIndex(uint32_t RawTextureHandle) override;
+		virtual void SetTextureScreenSize(uint32_t RawTextureHandle, float ScreenSize) override {
+			_ImageDataManager.SetTextureScreenSize(RawTextureHandle, ScreenSize);
+		}
 		virtual uint32_t GetSamplerShaderIndex(uint32_t RawSamplerHandle) override;
 		virtual uint32_t GetMaterialShaderIndex(uint32_t RawMaterialHandle) override;
+		virtual MaterialBindingSlot FindMaterialBindingSlot(uint32_t RawMaterialHandle, const char* Name) override;
 
 		virtual void UpdateMaterialShaderData(uint32_t MaterialHandle, const MaterialShaderData& Data) {
 			_BindlessManager.UpdateMaterialShaderData(MaterialHandle, Data);
 		}
 
-		virtual void UpdateObjectShaderData(BackBone::Entity Entity, const ObjectShaderData& Data) override {
-			_BindlessManager.UpdateObjectShaderData(Entity, Data);
+		virtual ObjectShaderData* AllocateObjectShaderData(uint32_t FrameIndex, uint32_t Count, uint32_t& OutFirstIndex) override {
+			return _BindlessManager.AllocateObjectShaderData(FrameIndex, Count, OutFirstIndex);
 		}
 
-		virtual uint32_t GetObjectShaderIndex(uint32_t Entity) override {
-			return _BindlessManager.GetObjectShaderIndex(Entity);
+		virtual void UpdateInstanceIndexData(uint32_t FrameIndex, const uint32_t* Indices, uint32_t Count, uint32_t Offset = 0) override {
+			_BindlessManager.UpdateInstanceIndexData(FrameIndex, Indices, Count, Offset);
 		}
 
 		virtual const std::vector<RenderDeviceInfo>& GetRenderDevices() {
@@ -311,7 +451,13 @@ namespace Chilli
 			std::vector< MaterialDataUpdateCmdPayload> MaterailWritingDatas;
 		} _FrameResource;
 
-		PipelineStateInfo _ActivePipelineState;
+		VulkanRecordingContext _PrimaryContext;
+		std::vector<VulkanRecordingContext> _PassContexts;
+		VulkanParallelRecorder _ParallelRecorder;
+		// Buffers, images, textures, samplers, shaders, material sets and retired swapchains are released
+		// through here, never while a frame in flight may use them
+		VulkanDeletionQueue _DeletionQueue;
+		VulkanShaderBinaryCache _ShaderBinaryCache;
 		VulkanBindlessRenderingManager _BindlessManager;
 		VulkanBindlessSetManagerCreateInfo  _BindlessCreateInfo;
 
@@ -351,6 +497,7 @@ namespace Chilli
 		// SwapChain
 		void _CreateSwapChainKHR();
 		void _ReCreateSwapChainKHR();
+		void _TransitionSwapChainImages();
 		void _DestroySwapChainKHR();
 
 		void _CreateVMAAllocator();
@@ -375,12 +522,19 @@ namespace Chilli
 
 		VkCommandBuffer _BeginFrame(const BeginFrameCmdPayload& Payload);
 		void _EndFrame(const EndFrameCmdPayload& Payload, VkCommandBuffer CmdBuffer);
-		void _BeginRenderPass(const BeginRenderPassCmdPayload& Payload, VkCommandBuffer CmdBuffer);
+		void _BeginRenderPass(const BeginRenderPassCmdPayload& Payload, VkCommandBuffer CmdBuffer,
+			bool SecondaryContents = false);
 		void _EndRenderPass(const EndRenderPassCmdPayload& Payload, VkCommandBuffer CmdBuffer);
 		void _ExecutePipelineBarriers(const PipelineBarrier* barriers, uint32_t count, VkCommandBuffer cmdBuffer);
 		void _AppendMaterialUpdateData(const MaterialDataUpdateCmdPayload& Payload);
+
+		// Opcodes valid both in the frame's stream and in a pass stream, returns false for any other
+		bool _TranslateDrawCommand(RenderOpCode Code, const uint8_t* Dst, VulkanRecordingContext& Ctx);
+		void _RecordPassStream(const RenderPassStream& PassStream, VkCommandBuffer CmdBuffer, VulkanRecordingContext& Ctx);
+		void _MergeRecordingStats(const RenderDeviceStats& Stats);
 		void _UpdateAllMaterialUpdateData();
 
-		VkCommandBuffer _TranslateGraphicsCommandBuffer(const GraphicsCommandBuffer& CmdBuffer);
+		VkCommandBuffer _TranslateGraphicsCommandBuffer(const RenderFramePacket& Packet);
+		void _TranslateComputeCommandBuffer(const ComputeCommandBuffer& CmdBuffer, VkCommandBuffer ActiveCommandBuffer);
 	};
 }
@@ -17,6 +17,7 @@ namespace Chilli
 	void VulkanBufferManager::Free(const VulkanDevice& Device, VmaAllocator Allocator)
 	{
 		_FreeStagingBuffer(Device, Allocator);
+		_FrameRing.Destroy(Allocator);
 
 		if (GetActiveCount() > 0)
 			VULKAN_ERROR("All Buffer Must be Fred!");
@@ -99,9 +100,9 @@ namespace Chilli
 		auto BufferHandle = _Buffers.Create(Buffer);
 		_Allocator = Allocator;
 
-		if (CreateInfo.State == BufferState::STATIC_DRAW ||
+		if (CreateInfo.Data != nullptr && (CreateInfo.State == BufferState::STATIC_DRAW ||
 			CreateInfo.State == BufferState::STATIC_COPY ||
-			CreateInfo.State == BufferState::DYNAMIC_COPY)
+			CreateInfo.State == BufferState::DYNAMIC_COPY))
 		{
 			MapBufferData(Device, BufferHandle, CreateInfo.Data, CreateInfo.SizeInBytes, 0);
 		}
@@ -114,6 +115,9 @@ namespace Chilli
 		auto Buffer = _Buffers.Get(Handle);
 		VULKAN_ASSERT(Buffer != nullptr, "Given Buffer Handle Gives a null Buffer");
 
+		// Usually long done, the frame that last used the buffer waited on it
+		_Uploader->Wait(Buffer->LastUpload);
+
 		vmaDestroyBuffer(Allocator, Buffer->Buffer, Buffer->Allocation);
 		_Buffers.Destroy(Handle);
 	}
@@ -156,6 +160,15 @@ namespace Chilli
 		// Includes: STATIC_DRAW, STATIC_COPY, DYNAMIC_COPY.
 		// The CPU cannot see this memory directly.
 
+		// DYNAMIC_COPY buffers are rewritten often, inside a frame their data goes through the frame's ring
+		// and is copied by the frame's own command buffer. Loads keep using the uploader.
+		if (Buffer->CreateInfo.State == BufferState::DYNAMIC_COPY && _FrameRingState != FrameRingState::CLOSED)
+		{
+			if (_WriteThroughFrameRing(Buffer, Data, Size, Offset))
+				return;
+			_FlushOverlappingFrameCopies(Buffer->Buffer, Size, Offset);
+		}
+
 		size_t remaining = Size;
 		size_t srcOffset = 0;
 
@@ -163,8 +176,13 @@ namespace Chilli
 		{
 			size_t chunk = std::min(remaining, (size_t)_StagingBuffer.AllocatedSize);
 
-			// 1. Fill the staging buffer (Staging is always DYNAMIC/Mapped)
-			uint32_t stagingHandle = _StagingBuffer.Buffer;
+			// 1. Fill the next staging buffer of the ring (Staging is always DYNAMIC/Mapped), the upload that
+			// last read from it has to be finished first
+			const uint32_t stagingSlot = _StagingBuffer.Next;
+			_StagingBuffer.Next = (_StagingBuffer.Next + 1) % CH_STAGING_BUFFER_COUNT;
+			_Uploader->Wait(_StagingBuffer.Tickets[stagingSlot]);
+
+			uint32_t stagingHandle = _StagingBuffer.Buffers[stagingSlot];
 			MapBufferData(Device, stagingHandle, (uint8_t*)Data + srcOffset, chunk, 0);
 
 			// 2. GPU-to-GPU Copy (Staging VRAM -> Destination VRAM)
@@ -205,6 +223,12 @@ namespace Chilli
 				DstStage |= VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
 			}
 
+			// Indirect arguments
+			if (type & BUFFER_TYPE_INDIRECT) {
+				DstAccess |= VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT;
+				DstStage |= VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT;
+			}
+
 			// Transfer source
 			if (type & BUFFER_TYPE_TRANSFER_SRC) {
 				DstAccess |= VK_ACCESS_2_TRANSFER_READ_BIT;
@@ -217,15 +241,264 @@ namespace Chilli
 				DstStage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
 			}
 
-			_Uploader->CopyBufferToBuffer(StagingBuffer, Buffer->Buffer, copy, DstAccess, DstStage);
+			auto Ticket = _Uploader->CopyBufferToBuffer(StagingBuffer, Buffer->Buffer, copy, DstAccess, DstStage);
+			_StagingBuffer.Tickets[stagingSlot] = Ticket;
+			Buffer->LastUpload = Ticket;
 			srcOffset += chunk;
 			remaining -= chunk;
 		}
 	}
 
+	void VulkanBufferManager::ReadBufferData(uint32_t Handle, void* Data, size_t Size, size_t Offset)
+	{
+		auto Buffer = _Buffers.Get(Handle);
+		if (Buffer == nullptr)
+			return;
+
+		if ((Buffer->CreateInfo.State != BufferState::STATIC_READ && Buffer->CreateInfo.State != BufferState::DYNAMIC_READ) ||
+			Buffer->AllocationInfo.pMappedData == nullptr)
+		{
+			VULKAN_PRINTLN("Only STATIC_READ and DYNAMIC_READ buffers can be read back");
+			return;
+		}
+
+		if (Size == CH_BUFFER_WHOLE_SIZE)
+			Size = Buffer->CreateInfo.SizeInBytes - Offset;
+
+		// No-op on host coherent memory
+		vmaInvalidateAllocation(_Allocator, Buffer->Allocation, Offset, Size);
+		memcpy(Data, (uint8_t*)Buffer->AllocationInfo.pMappedData + Offset, Size);
+	}
+
+	void VulkanBufferManager::InitFrameStaging(VkDevice Device, uint32_t FramesInFlight, uint32_t SizePerFrame)
+	{
+		_DeviceHandle = Device;
+		_FrameRing.Init(_Allocator, FramesInFlight, SizePerFrame);
+		_FrameCopies.clear();
+		_FrameRingState = FrameRingState::CLOSED;
+	}
+
+	void VulkanBufferManager::PrepareFrameStaging(uint32_t FrameIndex, VkFence FrameFence)
+	{
+		_FrameRingIndex = FrameIndex;
+		_FrameRingFence = FrameFence;
+		_FrameRingState = FrameRingState::PENDING;
+	}
+
+	void VulkanBufferManager::BeginFrameStaging(uint32_t FrameIndex)
+	{
+		if (_FrameRingState == FrameRingState::OPEN && _FrameRingIndex == FrameIndex)
+			return;
+
+		// A frame that never reached its translation still owes its copies
+		SubmitFrameCopies();
+
+		_FrameRingIndex = FrameIndex;
+		_FrameRing.BeginFrame(FrameIndex);
+		_FrameRingOverflows = 0;
+		_FrameRingState = FrameRingState::OPEN;
+	}
+
+	bool VulkanBufferManager::_WriteThroughFrameRing(VulkanBuffer* Buffer, void* Data, size_t Size, size_t Offset)
+	{
+		if (_FrameRingState == FrameRingState::PENDING)
+		{
+			// The same wait BeginFrame does, only earlier
+			vkWaitForFences(_DeviceHandle, 1, &_FrameRingFence, VK_TRUE, UINT64_MAX);
+			_FrameRing.BeginFrame(_FrameRingIndex);
+			_FrameRingOverflows = 0;
+			_FrameRingState = FrameRingState::OPEN;
+		}
+
+		VulkanStagingAllocation Allocation;
+		if (!_FrameRing.Allocate(Size, CH_STAGING_RING_ALIGNMENT, Allocation))
+		{
+			// Falls back to the uploader, whose copies complete before the frame's own
+			_FrameRingOverflows++;
+			return false;
+		}
+
+		memcpy(Allocation.Mapped, Data, Size);
+
+		FrameStagingCopy Copy;
+		Copy.Dst = Buffer->Buffer;
+		Copy.Region.srcOffset = Allocation.Offset;
+		Copy.Region.dstOffset = Offset;
+		Copy.Region.size = Size;
+		_FrameCopies.push_back(Copy);
+		return true;
+	}
+
+	void VulkanBufferManager::_FlushOverlappingFrameCopies(VkBuffer Dst, size_t Size, size_t Offset)
+	{
+		bool Overlaps = false;
+		for (size_t i = 0; i < _FrameCopies.size() && !Overlaps; i++)
+		{
+			const auto& Written = _FrameCopies[i];
+			Overlaps = Written.Dst == Dst && Offset < Written.Region.dstOffset + Written.Region.size &&
+				Written.Region.dstOffset < Offset + Size;
+		}
+		if (!Overlaps)
+			return;
+
+		// An uploader write runs before the frame's ring copies, so the older ring data would land on top of it.
+		// The frame's copies are submitted and waited on first, the ring stays open for the rest of the frame.
+		SubmitFrameCopies();
+		_FrameRingState = FrameRingState::OPEN;
+	}
+
+	void VulkanBufferManager::RecordFrameCopies(VkCommandBuffer CmdBuffer)
+	{
+		_FrameRingState = FrameRingState::CLOSED;
+		if (_FrameCopies.empty())
+			return;
+
+		_FrameRing.Flush(_Allocator);
+
+		// Everything a device local buffer can be read by
+		const VkPipelineStageFlags2 ConsumerStages = VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT |
+			VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT |
+			VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+		const VkAccessFlags2 ConsumerAccess = VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_2_INDEX_READ_BIT |
+			VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_UNIFORM_READ_BIT | VK_ACCESS_2_SHADER_READ_BIT;
+
+		auto Barrier = [&](VkPipelineStageFlags2 SrcStage, VkAccessFlags2 SrcAccess,
+			VkPipelineStageFlags2 DstStage, VkAccessFlags2 DstAccess) {
+				VkMemoryBarrier2 MemoryBarrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+				MemoryBarrier.srcStageMask = SrcStage;
+				MemoryBarrier.srcAccessMask = SrcAccess;
+				MemoryBarrier.dstStageMask = DstStage;
+				MemoryBarrier.dstAccessMask = DstAccess;
+
+				VkDependencyInfo DepInfo = { VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+				DepInfo.memoryBarrierCount = 1;
+				DepInfo.pMemoryBarriers = &MemoryBarrier;
+				vkCmdPipelineBarrier2(CmdBuffer, &DepInfo);
+			};
+
+		// Earlier frames on this queue are done reading before the copies overwrite the buffers
+		Barrier(ConsumerStages, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+
+		// Consecutive copies into the same buffer share one vkCmdCopyBuffer
+		VkBuffer GroupDst = VK_NULL_HANDLE;
+		auto FlushGroup = [&]() {
+			if (!_FrameCopyRegions.empty())
+				vkCmdCopyBuffer(CmdBuffer, _FrameRing.GetHandle(), GroupDst, uint32_t(_FrameCopyRegions.size()),
+					_FrameCopyRegions.data());
+			_FrameCopyRegions.clear();
+			};
+
+		size_t SinceBarrier = 0;
+		for (size_t i = 0; i < _FrameCopies.size(); i++)
+		{
+			const auto& Copy = _FrameCopies[i];
+
+			// The same bytes written twice in a frame need a barrier in between, or the order is undefined
+			bool Overlaps = false;
+			for (size_t j = SinceBarrier; j < i && !Overlaps; j++)
+			{
+				const auto& Written = _FrameCopies[j];
+				Overlaps = Written.Dst == Copy.Dst &&
+					Copy.Region.dstOffset < Written.Region.dstOffset + Written.Region.size &&
+					Written.Region.dstOffset < Copy.Region.dstOffset + Copy.Region.size;
+			}
+
+			if (Overlaps)
+			{
+				FlushGroup();
+				Barrier(VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+					VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+				SinceBarrier = i;
+			}
+			else if (Copy.Dst != GroupDst)
+				FlushGroup();
+
+			GroupDst = Copy.Dst;
+			_FrameCopyRegions.push_back(Copy.Region);
+		}
+		FlushGroup();
+
+		Barrier(VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, ConsumerStages, ConsumerAccess);
+		_FrameCopies.clear();
+	}
+
+	void VulkanBufferManager::SubmitFrameCopies()
+	{
+		if (_FrameCopies.empty())
+		{
+			_FrameRingState = FrameRingState::CLOSED;
+			return;
+		}
+
+		// Only hit when the frame is dropped, the ring region is rewound without a fence covering these
+		_Uploader->BeginBatching(CommandBufferPurpose::GRAPHICS);
+		RecordFrameCopies(_Uploader->GetActiveCmdBuffer());
+		_Uploader->Wait(_Uploader->EndBatching());
+	}
+
+	void VulkanStagingRing::Init(VmaAllocator Allocator, uint32_t FramesInFlight, VkDeviceSize SizePerFrame)
+	{
+		_SizePerFrame = SizePerFrame;
+		_FrameBase = 0;
+		_Head = 0;
+
+		VkBufferCreateInfo BufferInfo{};
+		BufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		BufferInfo.size = SizePerFrame * FramesInFlight;
+		BufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		BufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		VmaAllocationCreateInfo AllocInfo{};
+		AllocInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+		AllocInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+		VmaAllocationInfo Info{};
+		VULKAN_SUCCESS_ASSERT(vmaCreateBuffer(Allocator, &BufferInfo, &AllocInfo, &_Buffer, &_Allocation, &Info),
+			"Vulkan Staging Ring Creation Failed!");
+		_Mapped = (uint8_t*)Info.pMappedData;
+	}
+
+	void VulkanStagingRing::Destroy(VmaAllocator Allocator)
+	{
+		if (_Buffer == VK_NULL_HANDLE)
+			return;
+
+		vmaDestroyBuffer(Allocator, _Buffer, _Allocation);
+		_Buffer = VK_NULL_HANDLE;
+		_Allocation = VK_NULL_HANDLE;
+		_Mapped = nullptr;
+	}
+
+	void VulkanStagingRing::BeginFrame(uint32_t FrameIndex)
+	{
+		_FrameBase = _SizePerFrame * FrameIndex;
+		_Head = 0;
+	}
+
+	bool VulkanStagingRing::Allocate(VkDeviceSize Size, VkDeviceSize Alignment, VulkanStagingAllocation& Out)
+	{
+		const VkDeviceSize Start = (_Head + Alignment - 1) & ~(Alignment - 1);
+		if (Start + Size > _SizePerFrame)
+			return false;
+
+		_Head = Start + Size;
+		Out.Buffer = _Buffer;
+		Out.Offset = _FrameBase + Start;
+		Out.Mapped = _Mapped + Out.Offset;
+		return true;
+	}
+
+	void VulkanStagingRing::Flush(VmaAllocator Allocator)
+	{
+		// No-op on host coherent memory
+		if (_Head > 0)
+			vmaFlushAllocation(Allocator, _Allocation, _FrameBase, _Head);
+	}
+
 	void VulkanBufferManager::_FreeStagingBuffer(const VulkanDevice& Device, VmaAllocator Allocator)
 	{
-		Destroy(Allocator, _StagingBuffer.Buffer);
+		for (uint32_t Staging : _StagingBuffer.Buffers)
+			Destroy(Allocator, Staging);
 	}
 
 	void VulkanBufferManager::_SetupStagingBuffer(const VulkanDevice& Device, VmaAllocator Allocator)
@@ -236,6 +509,9 @@ namespace Chilli
 		CreateInfo.State = BufferState::DYNAMIC_DRAW;
 		CreateInfo.SizeInBytes = _StagingBuffer.AllocatedSize;
 
-		_StagingBuffer.Buffer = Create(Device, Allocator, CreateInfo);
+		for (uint32_t& Staging : _StagingBuffer.Buffers)
+			Staging = Create(Device, Allocator, CreateInfo);
+		_StagingBuffer.Tickets.fill(0);
+		_StagingBuffer.Next = 0;
 	}
 }
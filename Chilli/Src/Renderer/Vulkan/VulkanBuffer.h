@@ -7,20 +7,70 @@ namespace Chilli
 {
 	class VulkanDataUploader;
 
+	// Value the uploader's timeline semaphore reaches once an upload batch has executed, 0 is always complete
+	using VulkanUploadTicket = uint64_t;
+
 	struct VulkanBuffer
 	{
 		VkBuffer Buffer;
 		VmaAllocation Allocation;
 		VmaAllocationInfo AllocationInfo;
 		BufferCreateInfo CreateInfo;
+		// Last upload that wrote into the buffer, destroying it waits for this
+		VulkanUploadTicket LastUpload = 0;
 	};
 
+#define CH_STAGING_BUFFER_COUNT 3
+
+	// Uploads are not waited on, so each chunk goes through the next buffer of a small ring and a buffer
+	// is only refilled once the upload that last read from it has finished
 	struct StagingBufferManager
 	{
-		uint32_t Buffer = BackBone::npos;
+		std::array<uint32_t, CH_STAGING_BUFFER_COUNT> Buffers{};
+		std::array<VulkanUploadTicket, CH_STAGING_BUFFER_COUNT> Tickets{};
+		uint32_t Next = 0;
 		uint32_t AllocatedSize = 1e6;
 	};
 
+#define CH_STAGING_RING_ALIGNMENT 16
+
+	struct VulkanStagingAllocation
+	{
+		VkBuffer Buffer = VK_NULL_HANDLE;
+		VkDeviceSize Offset = 0;
+		uint8_t* Mapped = nullptr;
+	};
+
+	// One persistently mapped host buffer cut into a region per frame in flight. A region is rewound
+	// once its frame's fence has been waited on, allocations are bumped out of it and never freed.
+	class VulkanStagingRing
+	{
+	public:
+		VulkanStagingRing() {}
+		~VulkanStagingRing() {}
+
+		void Init(VmaAllocator Allocator, uint32_t FramesInFlight, VkDeviceSize SizePerFrame);
+		void Destroy(VmaAllocator Allocator);
+
+		void BeginFrame(uint32_t FrameIndex);
+		// Fails once the frame's region is full
+		bool Allocate(VkDeviceSize Size, VkDeviceSize Alignment, VulkanStagingAllocation& Out);
+		// Makes the frame's writes visible when the memory is not host coherent
+		void Flush(VmaAllocator Allocator);
+
+		VkBuffer GetHandle() const { return _Buffer; }
+		VkDeviceSize GetUsed() const { return _Head; }
+		VkDeviceSize GetSizePerFrame() const { return _SizePerFrame; }
+
+	private:
+		VkBuffer _Buffer = VK_NULL_HANDLE;
+		VmaAllocation _Allocation = VK_NULL_HANDLE;
+		uint8_t* _Mapped = nullptr;
+		VkDeviceSize _SizePerFrame = 0;
+		VkDeviceSize _FrameBase = 0;
+		VkDeviceSize _Head = 0;
+	};
+
 	class VulkanBufferManager
 	{
 	public:
@@ -33,18 +83,54 @@ namespace Chilli
 		uint32_t Create(const VulkanDevice& Device, VmaAllocator Allocator, const BufferCreateInfo& CreateInfo);
 		void Destroy(VmaAllocator Allocator, uint32_t Handle);
 		void MapBufferData(const VulkanDevice& Device, uint32_t Handle, void* Data, size_t Size, size_t Offset);
+		void ReadBufferData(uint32_t Handle, void* Data, size_t Size, size_t Offset);
 
 		void CopyBufferToBuffer(uint32_t SrcBuffer, uint32_t DstBuffer, BufferCopyInfo Copy);
 
+		void InitFrameStaging(VkDevice Device, uint32_t FramesInFlight, uint32_t SizePerFrame);
+		// Writes to DYNAMIC_COPY buffers go through the frame's staging ring from here on. The first such
+		// write waits on the frame's fence, so updates made before BeginFrame can use the ring too.
+		void PrepareFrameStaging(uint32_t FrameIndex, VkFence FrameFence);
+		// Called once the frame's fence has been waited on, keeps what was written since PrepareFrameStaging
+		void BeginFrameStaging(uint32_t FrameIndex);
+		// Records the frame's ring copies at the start of its command buffer and closes the ring,
+		// later writes take the uploader again
+		void RecordFrameCopies(VkCommandBuffer CmdBuffer);
+		// For a frame that is never submitted, the copies are submitted on their own and waited on
+		void SubmitFrameCopies();
+
+		VkDeviceSize GetFrameStagingUsed() const { return _FrameRing.GetUsed(); }
+		VkDeviceSize GetFrameStagingCapacity() const { return _FrameRing.GetSizePerFrame(); }
+		uint32_t GetFrameStagingOverflows() const { return _FrameRingOverflows; }
+
 		VulkanBuffer* Get(uint32_t Handle) { return _Buffers.Get(Handle); }
 
 		uint32_t GetActiveCount() { return _Buffers.GetActiveCount(); }
 	private:
 		void _SetupStagingBuffer(const VulkanDevice& Device, VmaAllocator Allocator);
 		void _FreeStagingBuffer(const VulkanDevice& Device, VmaAllocator Allocator);
+		bool _WriteThroughFrameRing(VulkanBuffer* Buffer, void* Data, size_t Size, size_t Offset);
+		void _FlushOverlappingFrameCopies(VkBuffer Dst, size_t Size, size_t Offset);
 	private:
+		struct FrameStagingCopy
+		{
+			VkBuffer Dst;
+			VkBufferCopy Region;
+		};
+
 		SparseSet<VulkanBuffer> _Buffers;
 		StagingBufferManager _StagingBuffer;
+
+		VulkanStagingRing _FrameRing;
+		std::vector<FrameStagingCopy> _FrameCopies;
+		std::vector<VkBufferCopy> _FrameCopyRegions;
+		enum class FrameRingState { CLOSED, PENDING, OPEN };
+
+		VkDevice _DeviceHandle = VK_NULL_HANDLE;
+		FrameRingState _FrameRingState = FrameRingState::CLOSED;
+		uint32_t _FrameRingIndex = 0;
+		VkFence _FrameRingFence = VK_NULL_HANDLE;
+		uint32_t _FrameRingOverflows = 0;
 		VulkanDataUploader* _Uploader;
 		VmaAllocator _Allocator;
 	};
@@ -224,6 +224,29 @@ namespace Chilli
 
 		case ImageFormat::D32F_S8I:
 			return VK_FORMAT_D32_SFLOAT_S8_UINT;
+
+		case ImageFormat::BC1_RGBA:
+			return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+		case ImageFormat::BC1_SRGBA:
+			return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+		case ImageFormat::BC2_RGBA:
+			return VK_FORMAT_BC2_UNORM_BLOCK;
+		case ImageFormat::BC2_SRGBA:
+			return VK_FORMAT_BC2_SRGB_BLOCK;
+		case ImageFormat::BC3_RGBA:
+			return VK_FORMAT_BC3_UNORM_BLOCK;
+		case ImageFormat::BC3_SRGBA:
+			return VK_FORMAT_BC3_SRGB_BLOCK;
+		case ImageFormat::BC4_R:
+			return VK_FORMAT_BC4_UNORM_BLOCK;
+		case ImageFormat::BC5_RG:
+			return VK_FORMAT_BC5_UNORM_BLOCK;
+		case ImageFormat::BC6H_RGBF:
+			return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+		case ImageFormat::BC7_RGBA:
+			return VK_FORMAT_BC7_UNORM_BLOCK;
+		case ImageFormat::BC7_SRGBA:
+			return VK_FORMAT_BC7_SRGB_BLOCK;
 		}
 
 		// Should never happen
@@ -333,6 +356,7 @@ namespace Chilli
 		if (type & BUFFER_TYPE_STORAGE)  flags |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
 		if (type & BUFFER_TYPE_TRANSFER_SRC) flags |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 		if (type & BUFFER_TYPE_TRANSFER_DST) flags |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		if (type & BUFFER_TYPE_INDIRECT) flags |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
 		return flags;
 	}
 
@@ -631,12 +655,22 @@ namespace Chilli
 		case ImageFormat::D32F:     return 4;  // 32-bit depth float
 		case ImageFormat::D32F_S8I: return 5;  // 4 bytes depth + 1 byte stencil
 
+		// Block compressed formats have no per pixel size, see GetImageFormatDataSize
+
 		case ImageFormat::NONE:
 		default:
 			return 0;
 		}
 	}
 
+	// Bytes of one Width x Height level, block compressed formats are rounded up to whole 4x4 blocks
+	inline uint64_t GetImageFormatDataSize(ImageFormat format, uint32_t Width, uint32_t Height)
+	{
+		if (IsBlockCompressedFormat(format))
+			return uint64_t((Width + 3) / 4) * ((Height + 3) / 4) * GetBlockCompressedBlockSize(format);
+		return uint64_t(Width) * Height * GetImageFormatBytesPerPixel(format);
+	}
+
 	inline ImageFormat VkToFormat(VkFormat format)
 	{
 		switch (format)
@@ -682,6 +716,29 @@ namespace Chilli
 
 		case VK_FORMAT_D32_SFLOAT_S8_UINT:
 			return ImageFormat::D32F_S8I;
+
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+			return ImageFormat::BC1_RGBA;
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			return ImageFormat::BC1_SRGBA;
+		case VK_FORMAT_BC2_UNORM_BLOCK:
+			return ImageFormat::BC2_RGBA;
+		case VK_FORMAT_BC2_SRGB_BLOCK:
+			return ImageFormat::BC2_SRGBA;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+			return ImageFormat::BC3_RGBA;
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			return ImageFormat::BC3_SRGBA;
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+			return ImageFormat::BC4_R;
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+			return ImageFormat::BC5_RG;
+		case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+			return ImageFormat::BC6H_RGBF;
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+			return ImageFormat::BC7_RGBA;
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			return ImageFormat::BC7_SRGBA;
 		}
 
 		// Unknown / unsupported VkFormat
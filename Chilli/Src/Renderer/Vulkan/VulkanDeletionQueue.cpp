@@ -0,0 +1,60 @@
+#include "ChV_PCH.h"
+
+#include "vulkan\vulkan.h"
+#include "vk_mem_alloc.h"
+#include "VulkanBackend.h"
+
+namespace Chilli
+{
+	void VulkanDeletionQueue::Init(uint32_t FramesInFlight)
+	{
+		_Slots.resize(FramesInFlight);
+		_FrameIndex = 0;
+		_Flushed = 0;
+		_Immediate = false;
+	}
+
+	void VulkanDeletionQueue::Destroy()
+	{
+		// Anything queued while flushing runs right away, the slots go oldest first so destruction keeps the
+		// order it was asked for in
+		_Immediate = true;
+		for (uint32_t i = 1; i <= _Slots.size(); i++)
+			_Flush(_Slots[(_FrameIndex + i) % _Slots.size()]);
+	}
+
+	void VulkanDeletionQueue::Push(DeleteFn&& Fn)
+	{
+		if (_Immediate)
+		{
+			Fn();
+			return;
+		}
+		_Slots[_FrameIndex].push_back(std::move(Fn));
+	}
+
+	void VulkanDeletionQueue::BeginFrame(uint32_t FrameIndex)
+	{
+		_FrameIndex = FrameIndex;
+		_Flushed = uint32_t(_Slots[FrameIndex].size());
+		_Flush(_Slots[FrameIndex]);
+	}
+
+	uint32_t VulkanDeletionQueue::GetPendingCount() const
+	{
+		size_t Count = 0;
+		for (const auto& Slot : _Slots)
+			Count += Slot.size();
+		return uint32_t(Count);
+	}
+
+	void VulkanDeletionQueue::_Flush(std::vector<DeleteFn>& Slot)
+	{
+		// A deletion may queue another one (a manager freeing its own buffers), those land in the current
+		// slot and wait for the next round
+		std::vector<DeleteFn> Ready;
+		Ready.swap(Slot);
+		for (auto& Fn : Ready)
+			Fn();
+	}
+}
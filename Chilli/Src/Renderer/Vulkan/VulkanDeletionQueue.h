@@ -0,0 +1,39 @@
+#pragma once
+
+#include <functional>
+
+namespace Chilli
+{
+	// Destruction of anything a frame in flight may still use is pushed into the slot of the frame being
+	// recorded and runs the next time that slot begins, once its fence has signalled. Frames go out on one
+	// queue in order, so every frame that could have seen the resource is done by then.
+	class VulkanDeletionQueue
+	{
+	public:
+		using DeleteFn = std::function<void()>;
+
+		VulkanDeletionQueue() {}
+		~VulkanDeletionQueue() {}
+
+		void Init(uint32_t FramesInFlight);
+		// Runs everything still queued, the device has to be idle. Pushes after this run right away
+		void Destroy();
+
+		void Push(DeleteFn&& Fn);
+		// The frame's fence has signalled, runs what was queued the last time the slot was recorded
+		void BeginFrame(uint32_t FrameIndex);
+
+		uint32_t GetPendingCount() const;
+		// Deletions run by the last BeginFrame
+		uint32_t GetFlushedCount() const { return _Flushed; }
+
+	private:
+		void _Flush(std::vector<DeleteFn>& Slot);
+
+	private:
+		std::vector<std::vector<DeleteFn>> _Slots;
+		uint32_t _FrameIndex = 0;
+		uint32_t _Flushed = 0;
+		bool _Immediate = false;
+	};
+}
@@ -216,12 +216,14 @@ namespace Chilli
 		VkPhysicalDeviceVulkan12Features features12{};
 		features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
 		features12.samplerFilterMinmax = VK_TRUE;
+		features12.timelineSemaphore = VK_TRUE;
 		features12.bufferDeviceAddressCaptureReplay = VK_TRUE;
 		features12.descriptorBindingPartiallyBound = VK_TRUE;
 		features12.descriptorBindingVariableDescriptorCount = VK_TRUE;
 		features12.runtimeDescriptorArray = VK_TRUE;
 		features12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
 		features12.descriptorIndexing = VK_TRUE;
+		features12.drawIndirectCount = PDevice->Info.features12.drawIndirectCount;
 		features12.pNext = &features13; // chain 1.3 features after 1.
 		features12.descriptorBindingUniformBufferUpdateAfterBind = PDevice->Info.features12.descriptorBindingUniformBufferUpdateAfterBind ? VK_TRUE : VK_FALSE;
 		features12.descriptorBindingSampledImageUpdateAfterBind = PDevice->Info.features12.descriptorBindingSampledImageUpdateAfterBind ? VK_TRUE : VK_FALSE;
@@ -229,6 +231,9 @@ namespace Chilli
 		VkPhysicalDeviceFeatures EnabledFeatures{};
 		EnabledFeatures.fillModeNonSolid = VK_TRUE;
 		EnabledFeatures.samplerAnisotropy = VK_TRUE;
+		EnabledFeatures.multiDrawIndirect = PDevice->Info.features.multiDrawIndirect;
+		EnabledFeatures.drawIndirectFirstInstance = PDevice->Info.features.drawIndirectFirstInstance;
+		EnabledFeatures.textureCompressionBC = PDevice->Info.features.textureCompressionBC;
 
 		VkPhysicalDeviceFeatures2 features2{};
 		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
@@ -0,0 +1,179 @@
+#include "ChV_PCH.h"
+
+#include "vulkan\vulkan.h"
+#include "vk_mem_alloc.h"
+#include "VulkanBackend.h"
+
+namespace Chilli
+{
+	void VulkanParallelRecorder::Init(VkDevice Device, uint32_t QueueFamily, uint32_t FramesInFlight, uint32_t ThreadCount)
+	{
+		_Device = Device;
+		_Quit = false;
+		_Generation = 0;
+		_JobCount = 0;
+
+		_Slots.resize(ThreadCount + 1);
+		for (auto& Slot : _Slots)
+		{
+			Slot.Pools.resize(FramesInFlight);
+			Slot.Buffers.resize(FramesInFlight);
+
+			VkCommandPoolCreateInfo PoolInfo{};
+			PoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			// Buffers are only ever reset together with their pool
+			PoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			PoolInfo.queueFamilyIndex = QueueFamily;
+
+			for (auto& Pool : Slot.Pools)
+				VULKAN_SUCCESS_ASSERT(vkCreateCommandPool(_Device, &PoolInfo, nullptr, &Pool),
+					"Failed to create recording command pool!");
+		}
+
+		for (uint32_t i = 0; i < ThreadCount; i++)
+			_Threads.emplace_back(&VulkanParallelRecorder::_WorkerLoop, this, i + 1);
+	}
+
+	void VulkanParallelRecorder::Destroy()
+	{
+		WaitAll();
+
+		{
+			std::lock_guard<std::mutex> Lock(_Mutex);
+			_Quit = true;
+		}
+		_WorkCondition.notify_all();
+		for (auto& Thread : _Threads)
+			Thread.join();
+		_Threads.clear();
+
+		// Destroying a pool frees every buffer allocated from it
+		for (auto& Slot : _Slots)
+			for (auto Pool : Slot.Pools)
+				vkDestroyCommandPool(_Device, Pool, nullptr);
+		_Slots.clear();
+
+		_JobBuffers.clear();
+		_JobDone.clear();
+		_Fn = nullptr;
+	}
+
+	void VulkanParallelRecorder::Dispatch(uint32_t FrameIndex, uint32_t Count, JobFn Fn)
+	{
+		WaitAll();
+
+		const uint32_t SlotCount = uint32_t(_Slots.size());
+		_JobBuffers.resize(Count);
+		_JobDone.assign(Count, 0);
+
+		for (uint32_t SlotIndex = 0; SlotIndex < SlotCount; SlotIndex++)
+		{
+			auto& Slot = _Slots[SlotIndex];
+			vkResetCommandPool(_Device, Slot.Pools[FrameIndex], 0);
+
+			// Buffers are allocated once and reused every frame the pool comes around
+			uint32_t Needed = Count / SlotCount + (SlotIndex < Count % SlotCount ? 1 : 0);
+			auto& Buffers = Slot.Buffers[FrameIndex];
+			if (Buffers.size() < Needed)
+			{
+				uint32_t Start = uint32_t(Buffers.size());
+				Buffers.resize(Needed);
+
+				VkCommandBufferAllocateInfo AllocInfo{};
+				AllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+				AllocInfo.commandPool = Slot.Pools[FrameIndex];
+				AllocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+				AllocInfo.commandBufferCount = Needed - Start;
+				VULKAN_SUCCESS_ASSERT(vkAllocateCommandBuffers(_Device, &AllocInfo, Buffers.data() + Start),
+					"Failed to allocate secondary command buffers!");
+			}
+		}
+
+		for (uint32_t Job = 0; Job < Count; Job++)
+			_JobBuffers[Job] = _Slots[Job % SlotCount].Buffers[FrameIndex][Job / SlotCount];
+
+		{
+			std::lock_guard<std::mutex> Lock(_Mutex);
+			_Fn = std::move(Fn);
+			_JobCount = Count;
+			_Generation++;
+		}
+		_WorkCondition.notify_all();
+	}
+
+	VkCommandBuffer VulkanParallelRecorder::Wait(uint32_t Job)
+	{
+		VULKAN_ASSERT(Job < _JobCount, "Waiting on a job that was never dispatched!");
+
+		const uint32_t SlotCount = uint32_t(_Slots.size());
+		if (Job % SlotCount == 0)
+		{
+			// The submitting thread's own jobs, recorded in order up to the one asked for
+			for (uint32_t Own = 0; Own <= Job; Own += SlotCount)
+				if (!_JobDone[Own])
+				{
+					_RunJob(Own);
+					_JobDone[Own] = 1;
+				}
+			return _JobBuffers[Job];
+		}
+
+		std::unique_lock<std::mutex> Lock(_Mutex);
+		_DoneCondition.wait(Lock, [&] { return _JobDone[Job] != 0; });
+		return _JobBuffers[Job];
+	}
+
+	void VulkanParallelRecorder::WaitAll()
+	{
+		if (_JobCount == 0)
+			return;
+
+		const uint32_t SlotCount = uint32_t(_Slots.size());
+		for (uint32_t Job = 0; Job < _JobCount; Job += SlotCount)
+			Wait(Job);
+
+		{
+			std::unique_lock<std::mutex> Lock(_Mutex);
+			_DoneCondition.wait(Lock, [&] {
+				for (uint32_t Job = 0; Job < _JobCount; Job++)
+					if (!_JobDone[Job])
+						return false;
+				return true;
+				});
+			_JobCount = 0;
+		}
+	}
+
+	void VulkanParallelRecorder::_WorkerLoop(uint32_t SlotIndex)
+	{
+		uint64_t SeenGeneration = 0;
+		while (true)
+		{
+			uint32_t Count = 0;
+			{
+				std::unique_lock<std::mutex> Lock(_Mutex);
+				_WorkCondition.wait(Lock, [&] { return _Quit || _Generation != SeenGeneration; });
+				if (_Quit)
+					return;
+				SeenGeneration = _Generation;
+				Count = _JobCount;
+			}
+
+			const uint32_t SlotCount = uint32_t(_Slots.size());
+			for (uint32_t Job = SlotIndex; Job < Count; Job += SlotCount)
+			{
+				_RunJob(Job);
+				{
+					std::lock_guard<std::mutex> Lock(_Mutex);
+					_JobDone[Job] = 1;
+				}
+				_DoneCondition.notify_all();
+			}
+		}
+	}
+
+	void VulkanParallelRecorder::_RunJob(uint32_t Job)
+	{
+		_Fn(Job, _JobBuffers[Job]);
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace Chilli
+{
+	// Records jobs into secondary command buffers on a set of persistent worker threads.
+	// The submitting thread is an extra slot and records its share of the jobs inside Wait, so
+	// with no workers everything is recorded inline. Job j always runs on slot j % SlotCount and
+	// every slot owns one command pool per frame in flight, pools are never touched by two threads.
+	class VulkanParallelRecorder
+	{
+	public:
+		using JobFn = std::function<void(uint32_t Job, VkCommandBuffer CmdBuffer)>;
+
+		VulkanParallelRecorder() {}
+		~VulkanParallelRecorder() {}
+
+		void Init(VkDevice Device, uint32_t QueueFamily, uint32_t FramesInFlight, uint32_t ThreadCount);
+		void Destroy();
+
+		// Resets the frame's pools and starts recording Count jobs, the pools must no longer be in use by the GPU
+		void Dispatch(uint32_t FrameIndex, uint32_t Count, JobFn Fn);
+		// Blocks until the job is recorded and returns its secondary command buffer
+		VkCommandBuffer Wait(uint32_t Job);
+		// Has to be called before the next Dispatch
+		void WaitAll();
+
+		inline uint32_t GetThreadCount() const { return uint32_t(_Threads.size()); }
+		inline uint32_t GetJobCount() const { return _JobCount; }
+
+	private:
+		struct Slot
+		{
+			std::vector<VkCommandPool> Pools;
+			std::vector<std::vector<VkCommandBuffer>> Buffers;
+		};
+
+		void _WorkerLoop(uint32_t SlotIndex);
+		void _RunJob(uint32_t Job);
+
+	private:
+		VkDevice _Device = VK_NULL_HANDLE;
+		std::vector<Slot> _Slots;
+		std::vector<std::thread> _Threads;
+
+		std::mutex _Mutex;
+		std::condition_variable _WorkCondition;
+		std::condition_variable _DoneCondition;
+		uint64_t _Generation = 0;
+		bool _Quit = false;
+
+		JobFn _Fn;
+		uint32_t _JobCount = 0;
+		std::vector<VkCommandBuffer> _JobBuffers;
+		std::vector<uint8_t> _JobDone;
+	};
+}
@@ -12,12 +12,14 @@
 PFN_vkCreateShadersEXT pfn_vkCreateShadersEXT;
 PFN_vkCmdBindShadersEXT pfn_vkCmdBindShadersEXT;
 PFN_vkDestroyShaderEXT pfn_vkDestroyShaderEXT;
+PFN_vkGetShaderBinaryDataEXT pfn_vkGetShaderBinaryDataEXT;
 
 void LoadShaderObjectEXTFunctions(VkDevice Device)
 {
 	pfn_vkCreateShadersEXT = (PFN_vkCreateShadersEXT)vkGetDeviceProcAddr(Device, "vkCreateShadersEXT");
 	pfn_vkCmdBindShadersEXT = (PFN_vkCmdBindShadersEXT)vkGetDeviceProcAddr(Device, "vkCmdBindShadersEXT");
 	pfn_vkDestroyShaderEXT = (PFN_vkDestroyShaderEXT)vkGetDeviceProcAddr(Device, "vkDestroyShaderEXT");
+	pfn_vkGetShaderBinaryDataEXT = (PFN_vkGetShaderBinaryDataEXT)vkGetDeviceProcAddr(Device, "vkGetShaderBinaryDataEXT");
 }
 
 namespace Chilli
@@ -126,9 +128,14 @@ namespace Chilli
 	{
 		VulkanShaderModule RawModule;
 		_SpirvShaderReadFile(FilePath, RawModule.SpirvCode);
+		RawModule.SpirvHash = HashShaderBytes(RawModule.SpirvCode.data(), RawModule.SpirvCode.size());
 		RawModule.FilePath = FilePath;
-		RawModule.ReflectedInfo = ReflectShaderModule(Device, RawModule.SpirvCode,
-			ShaderStageTypeToVkFlagBit(Type));
+		if (!LoadShaderReflectionBlob(FilePath, RawModule.SpirvHash, RawModule.ReflectedInfo))
+		{
+			RawModule.ReflectedInfo = ReflectShaderModule(Device, RawModule.SpirvCode,
+				ShaderStageTypeToVkFlagBit(Type));
+			SaveShaderReflectionBlob(FilePath, RawModule.SpirvHash, RawModule.ReflectedInfo);
+		}
 		RawModule.Stage = Type;
 
 		return _ShaderModules.Create(RawModule);
@@ -152,6 +159,9 @@ namespace Chilli
 		auto Program = _ShaderPrograms.Get(ProgramHandle);
 		Program->ModuleHandles.push_back(Shader.RawModuleHandle);
 
+		if (Shader.Stage == SHADER_STAGE_COMPUTE)
+			Program->BindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
+
 		std::vector<ReflectedSetUniformInput> OutUniformInput;
 		CombineUniformReflection(OutUniformInput, Program->CombinedInfo.UniformInputs, _ShaderModules.Get(Shader.RawModuleHandle)->ReflectedInfo.UniformInputs, (ShaderStageType)Program->ActiveMask, Shader.Stage);
 
@@ -170,7 +180,7 @@ namespace Chilli
 		auto Program = _ShaderPrograms.Get(ProgramHandle);
 		uint32_t setLayoutCount = BindlessSetLayouts.size();
 
-		std::vector< VkShaderCreateInfoEXT> CreateInfos;
+		Program->UserBindings.clear();
 
 		// Create Set Layouts and fill PushConstants Ranges
 
@@ -201,6 +211,8 @@ namespace Chilli
 			VULKAN_SUCCESS_ASSERT(vkCreateDescriptorSetLayout(Device, &CreateInfo, nullptr, &Layout), "Failed to create vkCreateDescriptorSetLayout");
 			Program->SetLayouts[int(BindingInfo.Set - int(BindlessSetTypes::USER_0))] = Layout;
 			setLayoutCount++;
+
+			Program->UserBindings.insert(Program->UserBindings.end(), BindingInfo.Bindings.begin(), BindingInfo.Bindings.end());
 		}
 
 		std::vector<VkDescriptorSetLayout> Layouts;
@@ -231,9 +243,34 @@ namespace Chilli
 			vkCreatePipelineLayout(Device, &LayoutCreateInfo, nullptr, &Program->PipelineLayout);
 		}
 
-		for (int i = 0; i < Program->ModuleHandles.size(); i++)
+		Layouts.resize(setLayoutCount);
+		Program->LinkedSetLayouts = Layouts;
+		Program->LinkedPushConstants = VkPushConstants;
+		Program->ObjectHandles = _CreateShaderObjects(Device, *Program);
+	}
+
+	std::vector<VkShaderEXT> VulkanShaderDataManager::_CreateShaderObjects(VkDevice Device, const VulkanShaderProgram& Program)
+	{
+		// Every feature bit is handed over, a bit that is not set turns its constant off even where the
+		// shader defaults it on
+		std::array<VkSpecializationMapEntry, CH_SHADER_PERMUTATION_MAX_FEATURES> SpecializationEntries;
+		std::array<VkBool32, CH_SHADER_PERMUTATION_MAX_FEATURES> SpecializationValues;
+		for (uint32_t i = 0; i < CH_SHADER_PERMUTATION_MAX_FEATURES; i++)
 		{
-			auto VkShaderModuleData = _ShaderModules.Get(Program->ModuleHandles[i]);
+			SpecializationEntries[i] = { i, uint32_t(i * sizeof(VkBool32)), sizeof(VkBool32) };
+			SpecializationValues[i] = (Program.Permutation >> i) & 1u;
+		}
+
+		VkSpecializationInfo Specialization{};
+		Specialization.mapEntryCount = CH_SHADER_PERMUTATION_MAX_FEATURES;
+		Specialization.pMapEntries = SpecializationEntries.data();
+		Specialization.dataSize = sizeof(SpecializationValues);
+		Specialization.pData = SpecializationValues.data();
+
+		std::vector< VkShaderCreateInfoEXT> CreateInfos;
+		for (int i = 0; i < Program.ModuleHandles.size(); i++)
+		{
+			auto VkShaderModuleData = _ShaderModules.Get(Program.ModuleHandles[i]);
 			// 2. Create the VkShaderEXT (Driver object)
 			VkShaderCreateInfoEXT createInfo{};
 			createInfo.sType = VK_STRUCTURE_TYPE_SHADER_CREATE_INFO_EXT;
@@ -242,9 +279,9 @@ namespace Chilli
 			createInfo.stage = ShaderStageTypeToVkFlagBit(VkShaderModuleData->Stage);
 			// nextStage: Tessellation Evaluation
 
-			if (i + 1 < Program->ModuleHandles.size())
+			if (i + 1 < Program.ModuleHandles.size())
 				createInfo.nextStage = ShaderStageTypeToVkFlagBit(
-					_ShaderModules.Get(Program->ModuleHandles[i + 1])->Stage);
+					_ShaderModules.Get(Program.ModuleHandles[i + 1])->Stage);
 			else
 				createInfo.nextStage = 0;
 			// Code Source
@@ -254,32 +291,165 @@ namespace Chilli
 
 			// Entry Point
 			createInfo.pName = "main";
-			createInfo.pSpecializationInfo = nullptr;
+			createInfo.pSpecializationInfo = &Specialization;
 
 			// Resource Layout (MUST BE IDENTICAL TO ALL OTHER STAGES)
-			createInfo.setLayoutCount = setLayoutCount;
-			createInfo.pSetLayouts = Layouts.data();
+			createInfo.setLayoutCount = Program.LinkedSetLayouts.size();
+			createInfo.pSetLayouts = Program.LinkedSetLayouts.data();
 
-			createInfo.pushConstantRangeCount = VkPushConstants.size();
-			createInfo.pPushConstantRanges = VkPushConstants.data();
+			createInfo.pushConstantRangeCount = Program.LinkedPushConstants.size();
+			createInfo.pPushConstantRanges = Program.LinkedPushConstants.data();
 			CreateInfos.push_back(createInfo);
 		}
 
-		VkResult result;
 		std::vector<VkShaderEXT> ShaderObjects;
-		ShaderObjects.resize(Program->ModuleHandles.size());
+		ShaderObjects.resize(Program.ModuleHandles.size());
 
-		result = pfn_vkCreateShadersEXT(Device, CreateInfos.size(), CreateInfos.data(), NULL, ShaderObjects.data());
-		if (result != VK_SUCCESS)
+		if (!_CreateShadersFromCache(Device, Program, CreateInfos, ShaderObjects))
 		{
-			VULKAN_ERROR("Shader Creation Error!");
+			VkResult result = pfn_vkCreateShadersEXT(Device, CreateInfos.size(), CreateInfos.data(), NULL, ShaderObjects.data());
+			if (result != VK_SUCCESS)
+			{
+				VULKAN_ERROR("Shader Creation Error!");
+			}
+			_StoreShaderBinaries(Device, Program, ShaderObjects);
+		}
+		return ShaderObjects;
+	}
+
+	uint32_t VulkanShaderDataManager::GetProgramVariant(VkDevice Device, uint32_t ProgramHandle, ShaderPermutationKey Key)
+	{
+		auto Program = _ShaderPrograms.Get(ProgramHandle);
+		if (Program->BaseProgram != UINT32_MAX)
+		{
+			ProgramHandle = Program->BaseProgram;
+			Program = _ShaderPrograms.Get(ProgramHandle);
+		}
+
+		if (Key == Program->Permutation)
+			return ProgramHandle;
+
+		auto Found = Program->Variants.find(Key);
+		if (Found != Program->Variants.end())
+			return Found->second;
+
+		// Same reflection, layouts and modules, only the shader objects are specialized again
+		VulkanShaderProgram Variant;
+		Variant.ModuleHandles = Program->ModuleHandles;
+		Variant.CombinedInfo = Program->CombinedInfo;
+		Variant.ActiveMask = Program->ActiveMask;
+		Variant.BindPoint = Program->BindPoint;
+		Variant.PipelineLayout = Program->PipelineLayout;
+		Variant.SetLayouts = Program->SetLayouts;
+		Variant.UserBindings = Program->UserBindings;
+		Variant.LinkedSetLayouts = Program->LinkedSetLayouts;
+		Variant.LinkedPushConstants = Program->LinkedPushConstants;
+		Variant.Permutation = Key;
+		Variant.BaseProgram = ProgramHandle;
+		Variant.ObjectHandles = _CreateShaderObjects(Device, Variant);
+
+		uint32_t VariantHandle = _ShaderPrograms.Create(Variant);
+		// Creating may have moved the programs
+		_ShaderPrograms.Get(ProgramHandle)->Variants[Key] = VariantHandle;
+		return VariantHandle;
+	}
+
+	// The user set layouts and push constants handed to the driver come from the reflection of every stage of
+	// the program, so the key of one stage covers the SPIR-V of all of them. The engine sets and the push
+	// ranges as linked are folded in too, a binary is only valid for the layout it was created with
+	uint64_t VulkanShaderDataManager::_ShaderBinaryKey(const VulkanShaderProgram& Program, uint32_t StageIndex)
+	{
+		uint64_t Key = HashShaderBytes(&StageIndex, sizeof(StageIndex));
+		Key = HashShaderBytes(&Program.Permutation, sizeof(Program.Permutation), Key);
+		Key = HashShaderBytes(&_EngineSetLayoutHash, sizeof(_EngineSetLayoutHash), Key);
+		for (const auto& Range : Program.LinkedPushConstants)
+		{
+			const uint32_t Desc[3] = { Range.offset, Range.size, uint32_t(Range.stageFlags) };
+			Key = HashShaderBytes(Desc, sizeof(Desc), Key);
+		}
+		for (auto ModuleHandle : Program.ModuleHandles)
+		{
+			auto Module = _ShaderModules.Get(ModuleHandle);
+			Key = HashShaderBytes(&Module->SpirvHash, sizeof(Module->SpirvHash), Key);
+			Key = HashShaderBytes(&Module->Stage, sizeof(Module->Stage), Key);
+		}
+		return Key;
+	}
+
+	bool VulkanShaderDataManager::_CreateShadersFromCache(VkDevice Device, const VulkanShaderProgram& Program,
+		std::vector<VkShaderCreateInfoEXT> CreateInfos, std::vector<VkShaderEXT>& OutObjects)
+	{
+		if (_BinaryCache == nullptr || !_BinaryCache->IsEnabled())
+			return false;
+
+		for (uint32_t i = 0; i < CreateInfos.size(); i++)
+		{
+			auto Binary = _BinaryCache->Find(_ShaderBinaryKey(Program, i));
+			if (Binary == nullptr)
+			{
+				_BinaryCache->CountMiss();
+				return false;
+			}
+			CreateInfos[i].codeType = VK_SHADER_CODE_TYPE_BINARY_EXT;
+			CreateInfos[i].codeSize = Binary->size();
+			CreateInfos[i].pCode = Binary->data();
+		}
+
+		VkResult Result = pfn_vkCreateShadersEXT(Device, CreateInfos.size(), CreateInfos.data(), NULL, OutObjects.data());
+		if (Result == VK_SUCCESS)
+		{
+			_BinaryCache->CountHit();
+			return true;
+		}
+
+		// Incompatible binaries, whatever did get created is thrown away and the program goes through SPIR-V
+		for (uint32_t i = 0; i < OutObjects.size(); i++)
+		{
+			if (OutObjects[i] != VK_NULL_HANDLE)
+				pfn_vkDestroyShaderEXT(Device, OutObjects[i], nullptr);
+			OutObjects[i] = VK_NULL_HANDLE;
+			_BinaryCache->Drop(_ShaderBinaryKey(Program, i));
+		}
+		_BinaryCache->CountMiss();
+		return false;
+	}
+
+	void VulkanShaderDataManager::_StoreShaderBinaries(VkDevice Device, const VulkanShaderProgram& Program,
+		const std::vector<VkShaderEXT>& Objects)
+	{
+		if (_BinaryCache == nullptr || !_BinaryCache->IsEnabled())
+			return;
+
+		for (uint32_t i = 0; i < Objects.size(); i++)
+		{
+			size_t Size = 0;
+			if (pfn_vkGetShaderBinaryDataEXT(Device, Objects[i], &Size, nullptr) != VK_SUCCESS || Size == 0)
+				continue;
+
+			std::vector<char> Binary(Size);
+			if (pfn_vkGetShaderBinaryDataEXT(Device, Objects[i], &Size, Binary.data()) != VK_SUCCESS)
+				continue;
+			_BinaryCache->Store(_ShaderBinaryKey(Program, i), std::move(Binary));
 		}
-		Program->ObjectHandles = ShaderObjects;
 	}
 
 	void VulkanShaderDataManager::ClearShaderProgram(VkDevice Device, uint32_t Program)
 	{
 		auto VkProgram = _ShaderPrograms.Get(Program);
+
+		// Variants only own their shader objects, they go away together with the program they came from
+		if (VkProgram->BaseProgram != UINT32_MAX)
+			return;
+
+		for (auto& [Key, VariantHandle] : VkProgram->Variants)
+		{
+			for (auto& Object : _ShaderPrograms.Get(VariantHandle)->ObjectHandles)
+				pfn_vkDestroyShaderEXT(Device, Object, nullptr);
+			_ShaderPrograms.Destroy(VariantHandle);
+		}
+		VkProgram = _ShaderPrograms.Get(Program);
+		VkProgram->Variants.clear();
+
 		VkProgram->CombinedInfo.PushConstants.clear();
 		VkProgram->CombinedInfo.UniformInputs.clear();
 		VkProgram->CombinedInfo.VertexInputs.clear();
@@ -304,6 +474,13 @@ namespace Chilli
 	{
 		auto Program = _ShaderPrograms.Get(ProgramHandle);
 
+		if (Program->BindPoint == VK_PIPELINE_BIND_POINT_COMPUTE)
+		{
+			const VkShaderStageFlagBits stage = VK_SHADER_STAGE_COMPUTE_BIT;
+			pfn_vkCmdBindShadersEXT(CmdBuffer, 1, &stage, &Program->ObjectHandles[0]);
+			return;
+		}
+
 		const VkShaderStageFlagBits stages[2] =
 		{
 			VK_SHADER_STAGE_VERTEX_BIT,
@@ -346,7 +523,7 @@ namespace Chilli
 
 		std::array<VkDescriptorSet, int(BindlessSetTypes::COUNT_NON_USER)> Sets = BindlessManager.GetBindlessSets()[FrameIndex];
 
-		vkCmdBindDescriptorSets(CmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, Program->PipelineLayout,
+		vkCmdBindDescriptorSets(CmdBuffer, Program->BindPoint, Program->PipelineLayout,
 			0, int(BindlessSetTypes::COUNT_NON_USER), Sets.data(), 0, nullptr);
 	}
 
@@ -359,7 +536,7 @@ namespace Chilli
 			if (Sets[i] == VK_NULL_HANDLE)
 				continue;
 
-			vkCmdBindDescriptorSets(CmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, Program->PipelineLayout,
+			vkCmdBindDescriptorSets(CmdBuffer, Program->BindPoint, Program->PipelineLayout,
 				int(BindlessSetTypes::USER_0) + i, 1, &Sets[i], 0, nullptr);
 		}
 	}
@@ -382,6 +559,20 @@ namespace Chilli
 		return { ReflectedBindingUniformInput(), false };
 	}
 
+	MaterialBindingSlot VulkanShaderDataManager::FindUserBindingSlot(uint32_t ProgramID, const char* Name)
+	{
+		auto Program = _ShaderPrograms.Get(ProgramID);
+
+		// Names are compared like the update payload stores them, zero padded to the fixed size
+		char PaddedName[SHADER_UNIFORM_BINDING_NAME_SIZE] = { 0 };
+		strncpy(PaddedName, Name, SHADER_UNIFORM_BINDING_NAME_SIZE);
+
+		for (uint32_t i = 0; i < Program->UserBindings.size(); i++)
+			if (memcmp(Program->UserBindings[i].Name, PaddedName, SHADER_UNIFORM_BINDING_NAME_SIZE) == 0)
+				return { i };
+		return {};
+	}
+
 #pragma endregion 
 
 #pragma region Bindless Rendering Manager
@@ -470,18 +661,18 @@ namespace Chilli
 
 
 		// --- 2. Create 1x Global Bindless Pool (HIGH Capacity) ---
-		// This pool is for the static Set 1 (TEX_SAMPLERS).
-		// It must be sized for the full MAX_TEXTURES/MAX_SAMPLERS count.
+		// This pool is for Set 1 (TEX_SAMPLERS), one per frame in flight so a slot can be pointed at
+		// a new view without touching a set the GPU may still be reading.
+		// It must be sized for the full MAX_TEXTURES/MAX_SAMPLERS count of every set.
 
 		const std::vector<VulkanDescriptorPoolSize> BindlessPoolSizes = {
 			VulkanDescriptorPoolSize(ShaderUniformTypes::SAMPLED_IMAGE,
-				BindlessRenderingLimits::MAX_TEXTURES), // Full Capacity
+				BindlessRenderingLimits::MAX_TEXTURES * Info.MaxFrameInFlight), // Full Capacity
 			VulkanDescriptorPoolSize(ShaderUniformTypes::SAMPLER,
-				BindlessRenderingLimits::MAX_SAMPLERS)
+				BindlessRenderingLimits::MAX_SAMPLERS * Info.MaxFrameInFlight)
 		};
 
-		// Only 1 set (the TEX_SAMPLERS set) is allocated from this pool.
-		uint32_t bindlessMaxSets = 1;
+		uint32_t bindlessMaxSets = Info.MaxFrameInFlight;
 
 		// Use a member variable for the single global bindless pool (e.g., _BindlessPool instead of _BindlessDescPools)
 		this->_BindlessTexPool =
@@ -515,6 +706,13 @@ namespace Chilli
 			if (BufferHandle != SparseSet<uint32_t>::npos)
 				Info.FreeBuffer(BufferHandle);
 
+		for (auto& Ring : _ObjectRings)
+		{
+			Info.FreeBuffer(Ring.ObjectBuffer);
+			Info.FreeBuffer(Ring.InstanceIndexBuffer);
+		}
+		_ObjectRings.clear();
+
 		for (auto& Layout : this->_BindlessSetLayouts)
 			vkDestroyDescriptorSetLayout(Device, Layout, nullptr);
 	}
@@ -525,16 +723,17 @@ namespace Chilli
 		{
 			// Global Set - 0 Binding 0
 			auto GlobalUBOLayoutBinding = __CreateSetLayoutBinding(0, ShaderUniformTypes::UNIFORM_BUFFER,
-				1, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, nullptr);
+				1, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT, nullptr);
 
 			// Global Set - 0 Binding 1
 			auto SceneUBOLayoutBinding = __CreateSetLayoutBinding(1, ShaderUniformTypes::UNIFORM_BUFFER,
-				1, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, nullptr);
+				1, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT, nullptr);
 
 			VkDescriptorSetLayoutBinding Bindings[] = { GlobalUBOLayoutBinding, SceneUBOLayoutBinding };
 
 			_BindlessSetLayouts[int(BindlessSetTypes::GLOBAL_SCENE)] = __CreateSetLayout(
 				device, 2, Bindings);
+			_HashSetLayout(Bindings, 2, nullptr);
 		} {
 			// Tex Sampler Set - CORRECT ORDER for bindless
 			// Binding 0: Samplers (fixed count)
@@ -560,6 +759,7 @@ namespace Chilli
 
 			_BindlessSetLayouts[int(BindlessSetTypes::TEX_SAMPLERS)] = __CreateSetLayout(
 				device, 2, Bindings, &bindingFlagsInfo);
+			_HashSetLayout(Bindings, 2, bindingFlags);
 		}
 
 		{
@@ -569,16 +769,37 @@ namespace Chilli
 
 			_BindlessSetLayouts[int(BindlessSetTypes::MATERIAl)] = __CreateSetLayout(
 				device, 1, &MaterialBinding, nullptr);
+			_HashSetLayout(&MaterialBinding, 1, nullptr);
 		}
 		{
 			// Object Set - 0 Binding 0
 			auto ObjectBinding = __CreateSetLayoutBinding(0, ShaderUniformTypes::STORAGE_BUFFER,
-				1, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, nullptr);
+				1, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT, nullptr);
+
+			// Object Set - 0 Binding 1: Instance -> Object index, written by the culling compute pass
+			auto InstanceIndexBinding = __CreateSetLayoutBinding(1, ShaderUniformTypes::STORAGE_BUFFER,
+				1, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT, nullptr);
+
+			VkDescriptorSetLayoutBinding Bindings[] = { ObjectBinding, InstanceIndexBinding };
 
 			_BindlessSetLayouts[int(BindlessSetTypes::PER_OBJECT)] = __CreateSetLayout(
-				device, 1, &ObjectBinding, nullptr);
+				device, 2, Bindings, nullptr);
+			_HashSetLayout(Bindings, 2, nullptr);
+
+		}
+	}
 
+	void VulkanBindlessRenderingManager::_HashSetLayout(const VkDescriptorSetLayoutBinding* pBindings, uint32_t BindingCount,
+		const VkDescriptorBindingFlags* pFlags)
+	{
+		for (uint32_t i = 0; i < BindingCount; i++)
+		{
+			const uint32_t Desc[5] = { pBindings[i].binding, uint32_t(pBindings[i].descriptorType), pBindings[i].descriptorCount,
+				uint32_t(pBindings[i].stageFlags), pFlags != nullptr ? uint32_t(pFlags[i]) : 0u };
+			_SetLayoutHash = HashShaderBytes(Desc, sizeof(Desc), _SetLayoutHash);
 		}
+		// Keeps the sets apart
+		_SetLayoutHash = HashShaderBytes(&BindingCount, sizeof(BindingCount), _SetLayoutHash);
 	}
 
 	void VulkanBindlessRenderingManager::_SetupBindlessSetManagerSets(const VulkanBindlessSetManagerCreateInfo& Info)
@@ -600,31 +821,33 @@ namespace Chilli
 		{
 			// 1. Prepare Layouts (Required for batch allocation)
 
-			uint32_t BindlessMaxTexs = BindlessRenderingLimits::MAX_TEXTURES;
+			std::vector<uint32_t> BindlessMaxTexs(Info.MaxFrameInFlight, BindlessRenderingLimits::MAX_TEXTURES);
+			std::vector<VkDescriptorSetLayout> TexSamplersLayouts(Info.MaxFrameInFlight, texSamplersLayout);
 
 			VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo{};
 			variableCountInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
 			// CRITICAL FIX: The count must match the number of sets being allocated
-			variableCountInfo.descriptorSetCount = 1;
-			variableCountInfo.pDescriptorCounts = &BindlessMaxTexs; // Use the dynamically sized vector data
+			variableCountInfo.descriptorSetCount = Info.MaxFrameInFlight;
+			variableCountInfo.pDescriptorCounts = BindlessMaxTexs.data(); // Use the dynamically sized vector data
 
 			// 3. Prepare Allocation Info
 			VkDescriptorSetAllocateInfo allocInfo{};
 			allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
 			allocInfo.descriptorPool = this->_BindlessTexPool; // The single global pool
-			allocInfo.descriptorSetCount = 1;
-			allocInfo.pSetLayouts = &texSamplersLayout;
+			allocInfo.descriptorSetCount = Info.MaxFrameInFlight;
+			allocInfo.pSetLayouts = TexSamplersLayouts.data();
 			allocInfo.pNext = &variableCountInfo;
 
 			// 4. Allocate Sets
-			VkDescriptorSet Sets;
-			if (vkAllocateDescriptorSets(device, &allocInfo, &Sets) != VK_SUCCESS) {
+			std::vector<VkDescriptorSet> Sets(Info.MaxFrameInFlight);
+			if (vkAllocateDescriptorSets(device, &allocInfo, Sets.data()) != VK_SUCCESS) {
 				throw std::runtime_error("failed to allocate TEX_SAMPLERS set!");
 			}
 
 			// 5. Store Sets in per-frame slots
 			for (int i = 0; i < Info.MaxFrameInFlight; ++i)
-				this->_BindlessSets[i][int(BindlessSetTypes::TEX_SAMPLERS)] = Sets;
+				this->_BindlessSets[i][int(BindlessSetTypes::TEX_SAMPLERS)] = Sets[i];
+			_TextureSetWrites.resize(Info.MaxFrameInFlight);
 		}
 		// Loop through ALL frames in flight (i)
 		for (int i = 0; i < Info.MaxFrameInFlight; i++)
@@ -719,21 +942,84 @@ namespace Chilli
 			BufferInfo.Type = BUFFER_TYPE_STORAGE;
 
 			_SetBuffers[int(BindlessSetTypes::MATERIAl)] = Info.AllocateBuffer(BufferInfo);
+
+			_MaterialShadowData.resize(CH_MATERIAL_SHADER_DATA_AMOUNT);
+			_MaterialDirtyRanges.resize(Info.MaxFrameInFlight);
 		}
 		{
-			// Material Buffers
-			constexpr size_t rawSize = sizeof(ObjectShaderData);
+			// Object and Instance Index Buffers, owned by the per frame rings
+			_SetBuffers[int(BindlessSetTypes::PER_OBJECT)] = SparseSet<uint32_t>::npos;
 
-			std::vector< ObjectShaderData> DeafultData;
-			DeafultData.resize(CH_OBJECT_SHADER_DATA_AMOUNT * Info.MaxFrameInFlight);
+			_ObjectRings.resize(Info.MaxFrameInFlight);
+			for (uint32_t i = 0; i < Info.MaxFrameInFlight; i++)
+				_CreateObjectRing(i, CH_OBJECT_SHADER_DATA_INITIAL_AMOUNT);
+		}
+	}
 
-			BufferCreateInfo BufferInfo{};
-			BufferInfo.Data = DeafultData.data();
-			BufferInfo.SizeInBytes = rawSize * CH_OBJECT_SHADER_DATA_AMOUNT * Info.MaxFrameInFlight;
-			BufferInfo.State = BufferState::DYNAMIC_DRAW;
-			BufferInfo.Type = BUFFER_TYPE_STORAGE;
+	void VulkanBindlessRenderingManager::_CreateObjectRing(uint32_t FrameIndex, uint32_t Capacity)
+	{
+		auto& Ring = _ObjectRings[FrameIndex];
+
+		BufferCreateInfo ObjectBufferInfo{};
+		ObjectBufferInfo.Data = nullptr;
+		ObjectBufferInfo.SizeInBytes = sizeof(ObjectShaderData) * Capacity;
+		ObjectBufferInfo.State = BufferState::DYNAMIC_DRAW;
+		ObjectBufferInfo.Type = BUFFER_TYPE_STORAGE;
+
+		BufferCreateInfo IndexBufferInfo{};
+		IndexBufferInfo.Data = nullptr;
+		IndexBufferInfo.SizeInBytes = sizeof(uint32_t) * Capacity;
+		IndexBufferInfo.State = BufferState::DYNAMIC_DRAW;
+		IndexBufferInfo.Type = BUFFER_TYPE_STORAGE;
+
+		uint32_t ObjectBuffer = _CreateInfo.AllocateBuffer(ObjectBufferInfo);
+		uint32_t IndexBuffer = _CreateInfo.AllocateBuffer(IndexBufferInfo);
+		auto MappedObjects = (ObjectShaderData*)_CreateInfo.GetMappedBuffer(ObjectBuffer);
+		auto MappedIndices = (uint32_t*)_CreateInfo.GetMappedBuffer(IndexBuffer);
+
+		// Growing keeps whatever the frame already wrote, earlier indices stay valid
+		if (Ring.Capacity != 0)
+		{
+			memcpy(MappedObjects, Ring.MappedObjects, sizeof(ObjectShaderData) * Ring.Count);
+			memcpy(MappedIndices, Ring.MappedIndices, sizeof(uint32_t) * Ring.Capacity);
+
+			_CreateInfo.FreeBuffer(Ring.ObjectBuffer);
+			_CreateInfo.FreeBuffer(Ring.InstanceIndexBuffer);
+		}
+
+		Ring.ObjectBuffer = ObjectBuffer;
+		Ring.InstanceIndexBuffer = IndexBuffer;
+		Ring.MappedObjects = MappedObjects;
+		Ring.MappedIndices = MappedIndices;
+		Ring.Capacity = Capacity;
+
+		_WriteObjectRingSet(FrameIndex);
+	}
+
+	// The frame's set is only bound by the frame's own command buffer, which has retired by the time it grows.
+	// Queued, the frame's BEGIN_FRAME writes it before anything is recorded against it
+	void VulkanBindlessRenderingManager::_WriteObjectRingSet(uint32_t FrameIndex)
+	{
+		auto& Ring = _ObjectRings[FrameIndex];
+
+		const uint32_t Buffers[2] = { Ring.ObjectBuffer, Ring.InstanceIndexBuffer };
+		const VkDeviceSize Ranges[2] = { Ring.Capacity * sizeof(ObjectShaderData), Ring.Capacity * sizeof(uint32_t) };
 
-			_SetBuffers[int(BindlessSetTypes::PER_OBJECT)] = Info.AllocateBuffer(BufferInfo);
+		for (uint32_t Binding = 0; Binding < 2; Binding++)
+		{
+			PendingDescriptorWrite Pending{};
+			Pending.BufferInfo.buffer = _CreateInfo.GetBuffer(Buffers[Binding]);
+			Pending.BufferInfo.offset = 0;
+			Pending.BufferInfo.range = Ranges[Binding];
+
+			Pending.Write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			Pending.Write.dstSet = _BindlessSets[FrameIndex][int(BindlessSetTypes::PER_OBJECT)];
+			Pending.Write.dstBinding = Binding;
+			Pending.Write.dstArrayElement = 0;
+			Pending.Write.descriptorType = ShaderUniformTypeToVk(ShaderUniformTypes::STORAGE_BUFFER);
+			Pending.Write.descriptorCount = 1;
+
+			_PendingWrites.push_back(Pending);
 		}
 	}
 
@@ -802,76 +1088,57 @@ namespace Chilli
 				descriptorWrite.pImageInfo = nullptr; // Optional
 				descriptorWrite.pTexelBufferView = nullptr; // Optional
 
-				vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
-			}
-			{
-				VkDescriptorBufferInfo bufferInfo{};
-				bufferInfo.buffer = Info.GetBuffer(_SetBuffers[int(BindlessSetTypes::PER_OBJECT)]);
-				bufferInfo.offset = i * CH_OBJECT_SHADER_DATA_AMOUNT * sizeof(ObjectShaderData);
-				bufferInfo.range = CH_OBJECT_SHADER_DATA_AMOUNT * sizeof(ObjectShaderData);
-
-				VkWriteDescriptorSet descriptorWrite{};
-				descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				descriptorWrite.dstSet = _BindlessSets[i][int(BindlessSetTypes::PER_OBJECT)];
-				descriptorWrite.dstBinding = 0;
-				descriptorWrite.dstArrayElement = 0;
-
-				descriptorWrite.descriptorType = ShaderUniformTypeToVk(ShaderUniformTypes::STORAGE_BUFFER);
-				descriptorWrite.descriptorCount = 1;
-
-				descriptorWrite.pBufferInfo = &bufferInfo;
-				descriptorWrite.pImageInfo = nullptr; // Optional
-				descriptorWrite.pTexelBufferView = nullptr; // Optional
-
 				vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
 			}
 		}
 	}
 
-	void VulkanBindlessRenderingManager::_WriteShaderTexture(VkDevice device, uint32_t Index, VkImageView Texture)
+	void VulkanBindlessRenderingManager::_WriteShaderTexture(uint32_t Index, VkImageView Texture)
 	{
-		VkDescriptorImageInfo imageinfo{};
-		imageinfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		imageinfo.sampler = VK_NULL_HANDLE;
-		imageinfo.imageView = Texture;
-
-		VkWriteDescriptorSet descriptorWrite{};
-		descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrite.dstSet = _BindlessSets[0][int(BindlessSetTypes::TEX_SAMPLERS)];
-		descriptorWrite.dstBinding = 1;
-		descriptorWrite.dstArrayElement = Index;
-
-		descriptorWrite.descriptorType = ShaderUniformTypeToVk(ShaderUniformTypes::SAMPLED_IMAGE);
-		descriptorWrite.descriptorCount = 1;
-
-		descriptorWrite.pBufferInfo = nullptr;
-		descriptorWrite.pImageInfo = &imageinfo; // Optional
-		descriptorWrite.pTexelBufferView = nullptr; // Optional
-
-		vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
+		for (auto& Writes : _TextureSetWrites)
+			Writes.push_back({ 1, Index, Texture, VK_NULL_HANDLE });
 	}
 
-	void VulkanBindlessRenderingManager::_WriteShaderSampler(VkDevice device, uint32_t Index, VkSampler Sampler)
+	void VulkanBindlessRenderingManager::_WriteShaderSampler(uint32_t Index, VkSampler Sampler)
 	{
-		VkDescriptorImageInfo imageinfo{};
-		imageinfo.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		imageinfo.sampler = Sampler;
-		imageinfo.imageView = VK_NULL_HANDLE;
-
-		VkWriteDescriptorSet descriptorWrite{};
-		descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrite.dstSet = _BindlessSets[0][int(BindlessSetTypes::TEX_SAMPLERS)];
-		descriptorWrite.dstBinding = 0;
-		descriptorWrite.dstArrayElement = Index;
+		for (auto& Writes : _TextureSetWrites)
+			Writes.push_back({ 0, Index, VK_NULL_HANDLE, Sampler });
+	}
 
-		descriptorWrite.descriptorType = ShaderUniformTypeToVk(ShaderUniformTypes::SAMPLER);
-		descriptorWrite.descriptorCount = 1;
+	void VulkanBindlessRenderingManager::AppendPendingWrites(uint32_t FrameIndex, std::vector<VkWriteDescriptorSet>& OutWrites)
+	{
+		// Only the frame's own texture set is written, the other sets catch up when their frame begins
+		for (const auto& SetWrite : _TextureSetWrites[FrameIndex])
+		{
+			PendingDescriptorWrite Pending{};
+			Pending.ImageInfo.imageLayout = SetWrite.Binding == 1 ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL :
+				VK_IMAGE_LAYOUT_UNDEFINED;
+			Pending.ImageInfo.sampler = SetWrite.Sampler;
+			Pending.ImageInfo.imageView = SetWrite.View;
+
+			Pending.Write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			Pending.Write.dstSet = _BindlessSets[FrameIndex][int(BindlessSetTypes::TEX_SAMPLERS)];
+			Pending.Write.dstBinding = SetWrite.Binding;
+			Pending.Write.dstArrayElement = SetWrite.Index;
+			Pending.Write.descriptorType = ShaderUniformTypeToVk(SetWrite.Binding == 1 ?
+				ShaderUniformTypes::SAMPLED_IMAGE : ShaderUniformTypes::SAMPLER);
+			Pending.Write.descriptorCount = 1;
+
+			_PendingWrites.push_back(Pending);
+		}
+		_TextureSetWrites[FrameIndex].clear();
 
-		descriptorWrite.pBufferInfo = nullptr;
-		descriptorWrite.pImageInfo = &imageinfo; // Optional
-		descriptorWrite.pTexelBufferView = nullptr; // Optional
+		// Pointers are only resolved here, queuing may have reallocated the storage
+		for (auto& Pending : _PendingWrites)
+		{
+			if (Pending.Write.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER ||
+				Pending.Write.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+				Pending.Write.pBufferInfo = &Pending.BufferInfo;
+			else
+				Pending.Write.pImageInfo = &Pending.ImageInfo;
 
-		vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
+			OutWrites.push_back(Pending.Write);
+		}
 	}
 
 	void VulkanBindlessRenderingManager::UpdateGlobalShaderData(const GlobalShaderData& Data)
@@ -922,7 +1189,7 @@ namespace Chilli
 			MetaData->ShaderIndex = _ActiveTextureCounter;
 
 			// Update Descritpor Set
-			_WriteShaderTexture(device, _ActiveTextureCounter, Txt);
+			_WriteShaderTexture(_ActiveTextureCounter, Txt);
 
 			// 2. Increment the counter for the NEXT texture
 			_ActiveTextureCounter++;
@@ -934,6 +1201,15 @@ namespace Chilli
 		return UINT32_MAX;
 	}
 
+	void VulkanBindlessRenderingManager::RetargetTexture(uint32_t HandleId, VkImageView Txt)
+	{
+		auto MetaData = _TextureMap.Get(HandleId);
+
+		// A texture that never got a slot picks up the new view once it is asked for one
+		if (MetaData && MetaData->ShaderIndex != UINT32_MAX)
+			_WriteShaderTexture(MetaData->ShaderIndex, Txt);
+	}
+
 	void VulkanBindlessRenderingManager::PrepareForSampler(uint32_t SamplerIndex)
 	{
 		_SamplerMap.Create({ SamplerIndex, UINT32_MAX });
@@ -951,7 +1227,7 @@ namespace Chilli
 			MetaData->ShaderIndex = _ActiveSamplerCounter;
 
 			// Update Descritpor Set
-			_WriteShaderSampler(device, _ActiveSamplerCounter, Sampler);
+			_WriteShaderSampler(_ActiveSamplerCounter, Sampler);
 
 			// 2. Increment the counter for the NEXT texture
 			_ActiveSamplerCounter++;
@@ -986,69 +1262,95 @@ namespace Chilli
 				MaterialOffset = MetaData->ShaderIndex;
 		}
 
-		for (uint32_t i = 0; i < _CreateInfo.MaxFrameInFlight; i++)
+		if (MaterialOffset >= CH_MATERIAL_SHADER_DATA_AMOUNT)
 		{
-			const uint32_t frameOffset =
-				i * CH_MATERIAL_SHADER_DATA_AMOUNT * sizeof(MaterialShaderData);
+			CH_CORE_ERROR("Material shader data overflow: index {0}, capacity {1}", MaterialOffset,
+				CH_MATERIAL_SHADER_DATA_AMOUNT);
+			return;
+		}
 
-			_CreateInfo.MapBufferData(
-				_SetBuffers[int(BindlessSetTypes::MATERIAl)],
-				(void*)&Data,
-				sizeof(MaterialShaderData),
-				frameOffset + (MaterialOffset * sizeof(MaterialShaderData))
-			);
+		_MaterialShadowData[MaterialOffset] = Data;
+		for (auto& Range : _MaterialDirtyRanges)
+		{
+			Range.Begin = std::min(Range.Begin, uint32_t(MaterialOffset));
+			Range.End = std::max(Range.End, uint32_t(MaterialOffset) + 1);
 		}
 
 		if (Increment)
 			_ActiveMaterialCounter++;
 	}
 
-	// Use Entity Handle for Objects
-	void VulkanBindlessRenderingManager::UpdateObjectShaderData(
-		BackBone::Entity Entity,
-		const ObjectShaderData& Data
-	)
+	// Materials are few and usually change in bursts, one memcpy of the span between the lowest and highest
+	// dirty index beats a copy per update per frame
+	void VulkanBindlessRenderingManager::FlushMaterialShaderData(uint32_t FrameIndex)
 	{
-		uint32_t ObjectOffset = _ActiveObjectCounter;
-		auto MetaData = _ObjectsMap.Get(Entity);
+		auto& Range = _MaterialDirtyRanges[FrameIndex];
+		if (Range.Begin >= Range.End)
+			return;
 
-		if (!MetaData)
-		{
-			BindlessObjectMetaData MData;
-			MData.ShaderIndex = UINT32_MAX;
-			_ObjectsMap.Insert(Entity, MData);
-			MetaData = _ObjectsMap.Get(Entity);
-		}
+		const uint32_t frameOffset = FrameIndex * CH_MATERIAL_SHADER_DATA_AMOUNT * sizeof(MaterialShaderData);
 
-		bool Increment = false;
-		if (MetaData)
+		_CreateInfo.MapBufferData(
+			_SetBuffers[int(BindlessSetTypes::MATERIAl)],
+			&_MaterialShadowData[Range.Begin],
+			(Range.End - Range.Begin) * sizeof(MaterialShaderData),
+			frameOffset + Range.Begin * sizeof(MaterialShaderData)
+		);
+
+		Range = MaterialDirtyRange();
+	}
+
+	void VulkanBindlessRenderingManager::ResetObjectShaderData(uint32_t FrameIndex)
+	{
+		_ObjectRings[FrameIndex].Count = 0;
+	}
+
+	ObjectShaderData* VulkanBindlessRenderingManager::AllocateObjectShaderData(uint32_t FrameIndex, uint32_t Count,
+		uint32_t& OutFirstIndex)
+	{
+		auto& Ring = _ObjectRings[FrameIndex];
+
+		if (Ring.Count + Count > Ring.Capacity)
 		{
-			if (MetaData->ShaderIndex == UINT32_MAX)
-			{
-				MetaData->ShaderIndex = ObjectOffset;
-				Increment = true;
-			}
-			else
-			{
-				ObjectOffset = MetaData->ShaderIndex;
-			}
+			uint32_t NewCapacity = Ring.Capacity;
+			while (NewCapacity < Ring.Count + Count)
+				NewCapacity *= 2;
+			_CreateObjectRing(FrameIndex, NewCapacity);
 		}
 
-		for (uint32_t i = 0; i < _CreateInfo.MaxFrameInFlight; i++)
-		{
-			const uint32_t frameOffset =
-				i * CH_OBJECT_SHADER_DATA_AMOUNT * sizeof(ObjectShaderData);
+		OutFirstIndex = Ring.Count;
+		Ring.Count += Count;
+		return Ring.MappedObjects + OutFirstIndex;
+	}
 
-			_CreateInfo.MapBufferData(
-				_SetBuffers[int(BindlessSetTypes::PER_OBJECT)],
-				(void*)&Data,
-				sizeof(ObjectShaderData),
-				frameOffset + (ObjectOffset * sizeof(ObjectShaderData))
-			);
+	void VulkanBindlessRenderingManager::FlushObjectShaderData(uint32_t FrameIndex)
+	{
+		auto& Ring = _ObjectRings[FrameIndex];
+		if (Ring.Count != 0)
+			_CreateInfo.FlushBuffer(Ring.ObjectBuffer, 0, Ring.Count * sizeof(ObjectShaderData));
+	}
+
+	// Only touches the buffer of the frame being recorded, the other frames may still be in flight
+	void VulkanBindlessRenderingManager::UpdateInstanceIndexData(uint32_t FrameIndex, const uint32_t* Indices,
+		uint32_t Count, uint32_t Offset)
+	{
+		if (Count == 0)
+			return;
+
+		auto& Ring = _ObjectRings[FrameIndex];
+		if (Offset + Count > Ring.Capacity)
+		{
+			CH_CORE_ERROR("Instance index buffer overflow: {0} indices at offset {1}, capacity {2}",
+				Count, Offset, Ring.Capacity);
+			return;
 		}
 
-		if (Increment)
-			_ActiveObjectCounter++;
+		_CreateInfo.MapBufferData(
+			Ring.InstanceIndexBuffer,
+			(void*)Indices,
+			Count * sizeof(uint32_t),
+			Offset * sizeof(uint32_t)
+		);
 	}
 
 #pragma endregion 
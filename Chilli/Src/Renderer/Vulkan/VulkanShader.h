@@ -3,6 +3,7 @@
 #include "SparseSet.h"
 #include "Pipeline.h"
 #include <GraphicsBackend.h>
+#include "VulkanShaderCache.h"
 
 void LoadShaderObjectEXTFunctions(VkDevice Device);
 
@@ -17,6 +18,7 @@ namespace Chilli
 		ReflectedShaderInfo ReflectedInfo;
 		const char* FilePath;
 		std::vector<char> SpirvCode;
+		uint64_t SpirvHash = 0;
 		ShaderStageType Stage;
 	};
 
@@ -25,10 +27,21 @@ namespace Chilli
 		std::vector<uint32_t> ModuleHandles;
 		ReflectedShaderInfo CombinedInfo;
 		uint32_t ActiveMask = 0;
+		// Compute programs hold a single compute module and bind their sets on the compute bind point
+		VkPipelineBindPoint BindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 
 		VkPipelineLayout PipelineLayout = VK_NULL_HANDLE;
 		std::vector< VkShaderEXT> ObjectHandles;
 		std::array<VkDescriptorSetLayout, int(BindlessSetTypes::COUNT_USER)> SetLayouts;
+		// Every user set binding, a MaterialBindingSlot indexes this
+		std::vector<ReflectedBindingUniformInput> UserBindings;
+
+		std::vector<VkDescriptorSetLayout> LinkedSetLayouts;
+		std::vector<VkPushConstantRange> LinkedPushConstants;
+		ShaderPermutationKey Permutation = 0;
+		// Variants share the layouts of the program they were specialized from and are cleared with it
+		uint32_t BaseProgram = UINT32_MAX;
+		std::unordered_map<ShaderPermutationKey, uint32_t> Variants;
 	};
 
 	using VulkanBindlessSetLayoutType = std::array<VkDescriptorSetLayout, int(BindlessSetTypes::COUNT_NON_USER)>;
@@ -40,6 +53,11 @@ namespace Chilli
 		}
 		~VulkanShaderDataManager();
 
+		// Linked programs look their shader objects up here before compiling SPIR-V, nullptr always compiles
+		void SetBinaryCache(VulkanShaderBinaryCache* Cache) { _BinaryCache = Cache; }
+		// Hash of the engine bindless set layouts (sets 0-3), part of every cached binary's key
+		void SetEngineSetLayoutHash(uint64_t Hash) { _EngineSetLayoutHash = Hash; }
+
 		uint32_t CreateShaderModule(VkDevice Device, const char* FilePath, ShaderStageType Type);
 		void DestroyShaderModule(VkDevice Device, uint32_t Handle);
 
@@ -48,6 +66,8 @@ namespace Chilli
 		void LinkShaderProgram(VkDevice Device, uint32_t ProgramHandle,
 			const VulkanBindlessSetLayoutType& BindlessSetLayouts);
 		void ClearShaderProgram(VkDevice Device, uint32_t ProgramHandle);
+		// The program specialized for Key, created on the first request and kept until the program is cleared
+		uint32_t GetProgramVariant(VkDevice Device, uint32_t ProgramHandle, ShaderPermutationKey Key);
 		void BindShaderProgram(VkCommandBuffer CmdBuffer, uint32_t ProgramHandle);
 
 		void PushConstants(VkCommandBuffer CmdBuffer, uint32_t ProgramHandle, uint32_t Stage, void* Data, size_t Size, size_t Offset);
@@ -65,6 +85,10 @@ namespace Chilli
 		};
 		// For User 
 		VulkanShaderLocationData FindUserShaderDataLocation(uint32_t ProgramID, const char* Name);
+		MaterialBindingSlot FindUserBindingSlot(uint32_t ProgramID, const char* Name);
+		const ReflectedBindingUniformInput& GetUserBinding(uint32_t ProgramID, MaterialBindingSlot Slot) {
+			return _ShaderPrograms.Get(ProgramID)->UserBindings[Slot.ID];
+		}
 
 		const ReflectedShaderInfo& GetProgramInfo(uint32_t ProgramID) { 
 			return _ShaderPrograms.Get(ProgramID)->CombinedInfo; 
@@ -74,15 +98,27 @@ namespace Chilli
 			return _ShaderPrograms.Get(ID)->SetLayouts;
 		}
 
+	private:
+		std::vector<VkShaderEXT> _CreateShaderObjects(VkDevice Device, const VulkanShaderProgram& Program);
+		uint64_t _ShaderBinaryKey(const VulkanShaderProgram& Program, uint32_t StageIndex);
+		bool _CreateShadersFromCache(VkDevice Device, const VulkanShaderProgram& Program,
+			std::vector<VkShaderCreateInfoEXT> CreateInfos, std::vector<VkShaderEXT>& OutObjects);
+		void _StoreShaderBinaries(VkDevice Device, const VulkanShaderProgram& Program,
+			const std::vector<VkShaderEXT>& Objects);
+
 	private:
 		SparseSet<VulkanShaderModule> _ShaderModules;
 		SparseSet<VulkanShaderProgram> _ShaderPrograms;
+		VulkanShaderBinaryCache* _BinaryCache = nullptr;
+		uint64_t _EngineSetLayoutHash = 0;
 	};
 
 	using GetVkBufferFn = std::function<VkBuffer(uint32_t)>;
 	using AllocateVkBufferFn = std::function<uint32_t(const BufferCreateInfo&)>;
 	using FreeVkBufferFn = std::function<void(uint32_t)>;
 	using MapVkBufferFn = std::function<void(uint32_t, void*, uint32_t, uint32_t)>;
+	using GetMappedVkBufferFn = std::function<void* (uint32_t)>;
+	using FlushVkBufferFn = std::function<void(uint32_t, uint32_t, uint32_t)>;
 
 	struct VulkanBindlessSetManagerCreateInfo
 	{
@@ -93,6 +129,8 @@ namespace Chilli
 		AllocateVkBufferFn AllocateBuffer;
 		FreeVkBufferFn FreeBuffer;
 		MapVkBufferFn MapBufferData;
+		GetMappedVkBufferFn GetMappedBuffer;
+		FlushVkBufferFn FlushBuffer;
 	};
 
 	struct VulkanDescriptorPoolSize
@@ -111,6 +149,8 @@ namespace Chilli
 		void Destroy(const VulkanBindlessSetManagerCreateInfo& Info);
 
 		const VulkanBindlessSetLayoutType& GetBindlessSetLayouts() { return _BindlessSetLayouts; }
+		// Covers the bindings the engine sets were created from, changes whenever their layout does
+		uint64_t GetSetLayoutHash() const { return _SetLayoutHash; }
 		const std::vector<std::array<VkDescriptorSet, int(BindlessSetTypes::COUNT_NON_USER)>>& GetBindlessSets() const {
 			return _BindlessSets;
 		}
@@ -122,31 +162,49 @@ namespace Chilli
 
 		void PrepareForTexture(uint32_t TexIndex);
 		uint32_t UpdateTexture(VkDevice device, uint32_t HandleId, VkImageView Txt);
+		// Keeps the texture's slot and points it at a new view, the caller keeps the old view alive
+		// until every frame in flight has begun once since
+		void RetargetTexture(uint32_t HandleId, VkImageView Txt);
 
 		void PrepareForSampler(uint32_t SamplerIndex);
 		uint32_t UpdateSampler(VkDevice device, uint32_t HandleId, VkSampler Sampler);
 		
+		// Only updates the CPU copy, every frame in flight receives the coalesced dirty range once it begins
 		void UpdateMaterialShaderData(uint32_t MaterialHandle, const MaterialShaderData& Data);
-		void UpdateObjectShaderData(BackBone::Entity Entity, const ObjectShaderData& Data);
+		void FlushMaterialShaderData(uint32_t FrameIndex);
+		void UpdateInstanceIndexData(uint32_t FrameIndex, const uint32_t* Indices, uint32_t Count, uint32_t Offset);
+
+		// Object data is packed per draw into a ring owned by each frame in flight, the returned
+		// indices are only valid for the frame they were allocated in
+		void ResetObjectShaderData(uint32_t FrameIndex);
+		ObjectShaderData* AllocateObjectShaderData(uint32_t FrameIndex, uint32_t Count, uint32_t& OutFirstIndex);
+		void FlushObjectShaderData(uint32_t FrameIndex);
+		uint32_t GetObjectShaderDataCount(uint32_t FrameIndex) const { return _ObjectRings[FrameIndex].Count; }
+		uint32_t GetObjectShaderDataCapacity(uint32_t FrameIndex) const { return _ObjectRings[FrameIndex].Capacity; }
 
 		uint32_t GetMaterialShaderIndex(uint32_t RawMaterialHandle) { return _MaterialMap.Get(RawMaterialHandle)->ShaderIndex; }
 
-		uint32_t GetObjectShaderIndex(uint32_t Entity) {
-			if (auto Val = _ObjectsMap.Get(Entity))
-				return Val->ShaderIndex;
-			return UINT32_MAX;
-		}
+		// Texture, sampler and object set writes are queued and go out with the material writes of the next
+		// BEGIN_FRAME in a single vkUpdateDescriptorSets. Every frame in flight has its own texture set which is
+		// only written when that frame begins. The appended writes stay valid until ClearPendingWrites
+		void AppendPendingWrites(uint32_t FrameIndex, std::vector<VkWriteDescriptorSet>& OutWrites);
+		void ClearPendingWrites() { _PendingWrites.clear(); }
 
 	private:
 		void _SetupBindlessSetLayouts(VkDevice Device);
+		void _HashSetLayout(const VkDescriptorSetLayoutBinding* pBindings, uint32_t BindingCount,
+			const VkDescriptorBindingFlags* pFlags);
 		void _SetupBindlessSetManagerSets(const VulkanBindlessSetManagerCreateInfo& Info);
 		void _SetupManagerBuffers(const VulkanBindlessSetManagerCreateInfo& Info);
 		void _WriteBindlessSetManagerSets(const VulkanBindlessSetManagerCreateInfo& Info);
+		void _CreateObjectRing(uint32_t FrameIndex, uint32_t Capacity);
+		void _WriteObjectRingSet(uint32_t FrameIndex);
 		;
-		void _WriteShaderTexture(VkDevice device, uint32_t Index, VkImageView Texture);
-		void _WriteShaderSampler(VkDevice device, uint32_t Index, VkSampler Sampler);
+		void _WriteShaderTexture(uint32_t Index, VkImageView Texture);
+		void _WriteShaderSampler(uint32_t Index, VkSampler Sampler);
 	private:
 		VulkanBindlessSetLayoutType _BindlessSetLayouts = { VK_NULL_HANDLE };
+		uint64_t _SetLayoutHash = 1469598103934665603ull;
 		std::vector< VkDescriptorPool> _BindlessDescPools;
 		VkDescriptorPool _BindlessTexPool;
 		std::vector<std::array<VkDescriptorSet, int(BindlessSetTypes::COUNT_NON_USER)>> _BindlessSets;
@@ -170,19 +228,58 @@ namespace Chilli
 			uint32_t ShaderIndex;
 		};
 
-		struct BindlessObjectMetaData
-		{
-			uint32_t ObjectIndex;
-			uint32_t ShaderIndex;
-		};
-
 		SparseSet<BindlessTextureMetaData> _TextureMap;
 		SparseSet<BindlessSamplerMetaData> _SamplerMap;
 		SparseSet<BindlessMaterialMetaData> _MaterialMap;
-		SparseSet<BindlessObjectMetaData> _ObjectsMap;
 
 		std::array<uint32_t, int(BindlessSetTypes::COUNT_NON_USER)> _SetBuffers;
 
+		// Every frame in flight owns its buffers so growing one never touches memory the GPU may still read
+		struct ObjectShaderDataRing
+		{
+			// Per Object Set - Binding 0
+			uint32_t ObjectBuffer = SparseSet<uint32_t>::npos;
+			// Per Object Set - Binding 1, sized like the objects since every draw has its own object
+			uint32_t InstanceIndexBuffer = SparseSet<uint32_t>::npos;
+			ObjectShaderData* MappedObjects = nullptr;
+			uint32_t* MappedIndices = nullptr;
+			uint32_t Capacity = 0;
+			uint32_t Count = 0;
+		};
+
+		std::vector<ObjectShaderDataRing> _ObjectRings;
+
+		struct MaterialDirtyRange
+		{
+			uint32_t Begin = UINT32_MAX;
+			uint32_t End = 0;
+		};
+
+		std::vector<MaterialShaderData> _MaterialShadowData;
+		// One per frame in flight
+		std::vector<MaterialDirtyRange> _MaterialDirtyRanges;
+
+		struct PendingDescriptorWrite
+		{
+			VkWriteDescriptorSet Write;
+			VkDescriptorImageInfo ImageInfo;
+			VkDescriptorBufferInfo BufferInfo;
+		};
+
+		std::vector<PendingDescriptorWrite> _PendingWrites;
+
+		// Binding 0 writes a sampler, binding 1 a texture view
+		struct TextureSetWrite
+		{
+			uint32_t Binding;
+			uint32_t Index;
+			VkImageView View;
+			VkSampler Sampler;
+		};
+
+		// One per frame in flight
+		std::vector<std::vector<TextureSetWrite>> _TextureSetWrites;
+
 		size_t _GlobalBufferAlignedSize = 0;
 		size_t _SceneBufferAlignedSize = 0;
 
@@ -190,7 +287,6 @@ namespace Chilli
 		uint32_t _ActiveTextureCounter = 0;
 		uint32_t _ActiveSamplerCounter = 0;
 		uint32_t _ActiveMaterialCounter = 0;
-		uint32_t _ActiveObjectCounter = 0;
 	};
 }
 
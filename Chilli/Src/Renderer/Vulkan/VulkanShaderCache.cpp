@@ -0,0 +1,298 @@
+#include "ChV_PCH.h"
+#include "vulkan\vulkan.h"
+
+#include "vk_mem_alloc.h"
+#include "VulkanBackend.h"
+
+// "CHSC"
+#define CH_SHADER_CACHE_MAGIC 0x43534843u
+#define CH_SHADER_CACHE_VERSION 1u
+// "CHRF"
+#define CH_SHADER_REFLECTION_MAGIC 0x46524843u
+#define CH_SHADER_REFLECTION_VERSION 1u
+
+namespace Chilli
+{
+	uint64_t HashShaderBytes(const void* Data, size_t Size, uint64_t Seed)
+	{
+		const uint8_t* Bytes = static_cast<const uint8_t*>(Data);
+		uint64_t Hash = Seed;
+		for (size_t i = 0; i < Size; i++)
+		{
+			Hash ^= Bytes[i];
+			Hash *= 1099511628211ull;
+		}
+		return Hash;
+	}
+
+	void VulkanShaderBinaryCache::Init(VulkanDevice& Device, const char* Path)
+	{
+		if (Path == nullptr)
+			return;
+		_Path = Path;
+
+		const auto& Properties = Device.GetPhysicalDevice()->Info.properties;
+
+		VkPhysicalDeviceShaderObjectPropertiesEXT ShaderObjectProperties{};
+		ShaderObjectProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_PROPERTIES_EXT;
+		VkPhysicalDeviceProperties2 Properties2{};
+		Properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		Properties2.pNext = &ShaderObjectProperties;
+		vkGetPhysicalDeviceProperties2(Device.GetPhysicalDevice()->PhysicalDevice, &Properties2);
+
+		_DeviceHeader.Magic = CH_SHADER_CACHE_MAGIC;
+		_DeviceHeader.Version = CH_SHADER_CACHE_VERSION;
+		_DeviceHeader.VendorID = Properties.vendorID;
+		_DeviceHeader.DeviceID = Properties.deviceID;
+		_DeviceHeader.DriverVersion = Properties.driverVersion;
+		memcpy(_DeviceHeader.PipelineCacheUUID, Properties.pipelineCacheUUID, VK_UUID_SIZE);
+		memcpy(_DeviceHeader.ShaderBinaryUUID, ShaderObjectProperties.shaderBinaryUUID, VK_UUID_SIZE);
+		_DeviceHeader.ShaderBinaryVersion = ShaderObjectProperties.shaderBinaryVersion;
+		_DeviceHeader.EntryCount = 0;
+
+		_Load();
+	}
+
+	void VulkanShaderBinaryCache::_Load()
+	{
+		std::ifstream File(_Path, std::ios::binary);
+		if (!File.is_open())
+			return;
+
+		Header FileHeader{};
+		File.read(reinterpret_cast<char*>(&FileHeader), sizeof(Header));
+		if (!File)
+			return;
+
+		// Binaries of another driver or device are of no use, the file is rewritten on Save
+		const uint32_t EntryCount = FileHeader.EntryCount;
+		FileHeader.EntryCount = 0;
+		if (memcmp(&FileHeader, &_DeviceHeader, sizeof(Header)) != 0)
+		{
+			VULKAN_PRINTLN("Shader binary cache " << _Path << " was written by another device or driver, rebuilding");
+			_Dirty = true;
+			return;
+		}
+
+		for (uint32_t i = 0; i < EntryCount && File; i++)
+		{
+			uint64_t Key = 0;
+			uint32_t Size = 0;
+			File.read(reinterpret_cast<char*>(&Key), sizeof(Key));
+			File.read(reinterpret_cast<char*>(&Size), sizeof(Size));
+			if (!File)
+				break;
+
+			std::vector<char> Binary(Size);
+			File.read(Binary.data(), Size);
+			if (!File)
+				break;
+			_Entries[Key] = std::move(Binary);
+		}
+
+		// A truncated file keeps whatever was read in full
+		if (_Entries.size() != EntryCount)
+			_Dirty = true;
+		VULKAN_PRINTLN("Shader binary cache loaded " << _Entries.size() << " binaries from " << _Path);
+	}
+
+	void VulkanShaderBinaryCache::Save()
+	{
+		if (!IsEnabled() || !_Dirty)
+			return;
+
+		std::ofstream File(_Path, std::ios::binary | std::ios::trunc);
+		if (!File.is_open())
+		{
+			VULKAN_PRINTLN("Shader binary cache " << _Path << " could not be written");
+			return;
+		}
+
+		Header FileHeader = _DeviceHeader;
+		FileHeader.EntryCount = uint32_t(_Entries.size());
+		File.write(reinterpret_cast<const char*>(&FileHeader), sizeof(Header));
+
+		for (const auto& [Key, Binary] : _Entries)
+		{
+			uint32_t Size = uint32_t(Binary.size());
+			File.write(reinterpret_cast<const char*>(&Key), sizeof(Key));
+			File.write(reinterpret_cast<const char*>(&Size), sizeof(Size));
+			File.write(Binary.data(), Size);
+		}
+
+		_Dirty = false;
+		VULKAN_PRINTLN("Shader binary cache saved " << _Entries.size() << " binaries, " << _Hits << " hits and "
+			<< _Misses << " misses this run");
+	}
+
+	const std::vector<char>* VulkanShaderBinaryCache::Find(uint64_t Key) const
+	{
+		auto It = _Entries.find(Key);
+		return It == _Entries.end() ? nullptr : &It->second;
+	}
+
+	void VulkanShaderBinaryCache::Store(uint64_t Key, std::vector<char>&& Binary)
+	{
+		_Entries[Key] = std::move(Binary);
+		_Dirty = true;
+	}
+
+	void VulkanShaderBinaryCache::Drop(uint64_t Key)
+	{
+		if (_Entries.erase(Key) != 0)
+			_Dirty = true;
+	}
+
+	namespace
+	{
+		class BlobWriter
+		{
+		public:
+			template<typename T>
+			void Write(const T& Value)
+			{
+				const char* Bytes = reinterpret_cast<const char*>(&Value);
+				Data.insert(Data.end(), Bytes, Bytes + sizeof(T));
+			}
+
+			void WriteString(const std::string& Value)
+			{
+				Write(uint32_t(Value.size()));
+				Data.insert(Data.end(), Value.begin(), Value.end());
+			}
+
+			std::vector<char> Data;
+		};
+
+		class BlobReader
+		{
+		public:
+			BlobReader(const std::vector<char>& Blob) : _Blob(Blob) {}
+
+			template<typename T>
+			bool Read(T& Value)
+			{
+				if (_Offset + sizeof(T) > _Blob.size())
+					return false;
+				memcpy(&Value, _Blob.data() + _Offset, sizeof(T));
+				_Offset += sizeof(T);
+				return true;
+			}
+
+			bool ReadString(std::string& Value)
+			{
+				uint32_t Size = 0;
+				if (!Read(Size) || _Offset + Size > _Blob.size())
+					return false;
+				Value.assign(_Blob.data() + _Offset, Size);
+				_Offset += Size;
+				return true;
+			}
+
+			// Guards the counts against a damaged blob before anything gets resized to them
+			bool ReadCount(uint32_t& Count)
+			{
+				return Read(Count) && Count <= _Blob.size() - _Offset;
+			}
+
+		private:
+			const std::vector<char>& _Blob;
+			size_t _Offset = 0;
+		};
+
+		std::string ReflectionBlobPath(const std::string& SpirvPath)
+		{
+			return SpirvPath + ".refl";
+		}
+	}
+
+	bool LoadShaderReflectionBlob(const std::string& SpirvPath, uint64_t SpirvHash, ReflectedShaderInfo& OutInfo)
+	{
+		std::ifstream File(ReflectionBlobPath(SpirvPath), std::ios::ate | std::ios::binary);
+		if (!File.is_open())
+			return false;
+
+		std::vector<char> Blob(size_t(File.tellg()));
+		File.seekg(0);
+		File.read(Blob.data(), Blob.size());
+		if (!File)
+			return false;
+
+		BlobReader Reader(Blob);
+		uint32_t Magic = 0, Version = 0;
+		uint64_t Hash = 0;
+		if (!Reader.Read(Magic) || !Reader.Read(Version) || !Reader.Read(Hash) ||
+			Magic != CH_SHADER_REFLECTION_MAGIC || Version != CH_SHADER_REFLECTION_VERSION || Hash != SpirvHash)
+			return false;
+
+		ReflectedShaderInfo Info;
+		uint32_t Count = 0;
+
+		if (!Reader.ReadCount(Count))
+			return false;
+		Info.VertexInputs.resize(Count);
+		for (auto& Input : Info.VertexInputs)
+			if (!Reader.ReadString(Input.Name) || !Reader.Read(Input.Location) || !Reader.Read(Input.Format) ||
+				!Reader.Read(Input.Offset))
+				return false;
+
+		if (!Reader.ReadCount(Count))
+			return false;
+		Info.UniformInputs.resize(Count);
+		for (auto& Set : Info.UniformInputs)
+		{
+			if (!Reader.Read(Set.Set) || !Reader.ReadCount(Count))
+				return false;
+			Set.Bindings.resize(Count);
+			for (auto& Binding : Set.Bindings)
+				if (!Reader.Read(Binding))
+					return false;
+		}
+
+		if (!Reader.ReadCount(Count))
+			return false;
+		Info.PushConstants.resize(Count);
+		for (auto& PushConstant : Info.PushConstants)
+			if (!Reader.Read(PushConstant))
+				return false;
+
+		OutInfo = std::move(Info);
+		return true;
+	}
+
+	void SaveShaderReflectionBlob(const std::string& SpirvPath, uint64_t SpirvHash, const ReflectedShaderInfo& Info)
+	{
+		BlobWriter Writer;
+		Writer.Write(uint32_t(CH_SHADER_REFLECTION_MAGIC));
+		Writer.Write(uint32_t(CH_SHADER_REFLECTION_VERSION));
+		Writer.Write(SpirvHash);
+
+		Writer.Write(uint32_t(Info.VertexInputs.size()));
+		for (const auto& Input : Info.VertexInputs)
+		{
+			Writer.WriteString(Input.Name);
+			Writer.Write(Input.Location);
+			Writer.Write(Input.Format);
+			Writer.Write(Input.Offset);
+		}
+
+		// Bindings and push constant ranges are plain data and go out as they are
+		Writer.Write(uint32_t(Info.UniformInputs.size()));
+		for (const auto& Set : Info.UniformInputs)
+		{
+			Writer.Write(Set.Set);
+			Writer.Write(uint32_t(Set.Bindings.size()));
+			for (const auto& Binding : Set.Bindings)
+				Writer.Write(Binding);
+		}
+
+		Writer.Write(uint32_t(Info.PushConstants.size()));
+		for (const auto& PushConstant : Info.PushConstants)
+			Writer.Write(PushConstant);
+
+		// A read only shader directory just means reflecting again next run
+		std::ofstream File(ReflectionBlobPath(SpirvPath), std::ios::binary | std::ios::trunc);
+		if (File.is_open())
+			File.write(Writer.Data.data(), Writer.Data.size());
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+namespace Chilli
+{
+	class VulkanDevice;
+
+	// Shader object binaries from vkGetShaderBinaryDataEXT kept on disk between runs. Entries are keyed by the
+	// hash of the SPIR-V they were built from, the file as a whole is only used on the same device, driver
+	// version and pipeline/shader binary UUIDs it was written with
+	class VulkanShaderBinaryCache
+	{
+	public:
+		VulkanShaderBinaryCache() {}
+		~VulkanShaderBinaryCache() {}
+
+		// A null path disables the cache
+		void Init(VulkanDevice& Device, const char* Path);
+		// Writes the file back if anything was added or dropped since it was loaded
+		void Save();
+
+		bool IsEnabled() const { return !_Path.empty(); }
+
+		// nullptr on a miss
+		const std::vector<char>* Find(uint64_t Key) const;
+		void Store(uint64_t Key, std::vector<char>&& Binary);
+		// The driver refused the binary, it is rebuilt from SPIR-V and stored again
+		void Drop(uint64_t Key);
+
+		uint32_t GetHitCount() const { return _Hits; }
+		uint32_t GetMissCount() const { return _Misses; }
+		void CountHit() { _Hits++; }
+		void CountMiss() { _Misses++; }
+
+	private:
+		struct Header
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			uint32_t VendorID;
+			uint32_t DeviceID;
+			uint32_t DriverVersion;
+			uint8_t PipelineCacheUUID[VK_UUID_SIZE];
+			uint8_t ShaderBinaryUUID[VK_UUID_SIZE];
+			uint32_t ShaderBinaryVersion;
+			uint32_t EntryCount;
+		};
+
+		void _Load();
+
+	private:
+		std::string _Path;
+		Header _DeviceHeader{};
+		std::unordered_map<uint64_t, std::vector<char>> _Entries;
+		bool _Dirty = false;
+		uint32_t _Hits = 0;
+		uint32_t _Misses = 0;
+	};
+
+	// FNV-1a over the bytes, Seed chains several inputs into one key
+	uint64_t HashShaderBytes(const void* Data, size_t Size, uint64_t Seed = 1469598103934665603ull);
+
+	// Reflection of a module is kept in <spv path>.refl, the blob is only used while the hash of the SPIR-V
+	// it was written for still matches
+	bool LoadShaderReflectionBlob(const std::string& SpirvPath, uint64_t SpirvHash, ReflectedShaderInfo& OutInfo);
+	void SaveShaderReflectionBlob(const std::string& SpirvPath, uint64_t SpirvHash, const ReflectedShaderInfo& Info);
+}
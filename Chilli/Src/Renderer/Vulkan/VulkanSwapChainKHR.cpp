@@ -67,14 +67,26 @@ namespace Chilli
 		_CreateSwapChainImageViews(device);
 	}
 
-	void VulkanSwapChainKHR::Recreate(VulkanDevice& device, VkSurfaceKHR SurfaceKHR, int Width, int Height, bool VSync)
+	void VulkanSwapChainKHR::Recreate(VulkanDevice& device, VkSurfaceKHR SurfaceKHR, int Width, int Height, bool VSync,
+		RetiredSwapChain& Retired)
 	{
-		vkDeviceWaitIdle(device.GetHandle());
-		Destroy(device);
-		Init(device, SurfaceKHR, Width, Height, VSync);
+		Retired.SwapChain = _SwapChain;
+		Retired.ImageViews = std::move(_ImageViews);
+		_ImageViews.clear();
+
+		_CreateSwapChainKHR(device, SurfaceKHR, Width, Height, VSync, Retired.SwapChain);
+		_CreateSwapChainImageViews(device);
+	}
+
+	void VulkanSwapChainKHR::DestroyRetired(VkDevice Device, const RetiredSwapChain& Retired)
+	{
+		for (auto View : Retired.ImageViews)
+			vkDestroyImageView(Device, View, nullptr);
+		vkDestroySwapchainKHR(Device, Retired.SwapChain, nullptr);
 	}
 
-	void VulkanSwapChainKHR::_CreateSwapChainKHR(VulkanDevice& device, VkSurfaceKHR SurfaceKHR, int Width, int Height, bool VSync)
+	void VulkanSwapChainKHR::_CreateSwapChainKHR(VulkanDevice& device, VkSurfaceKHR SurfaceKHR, int Width, int Height, bool VSync,
+		VkSwapchainKHR OldSwapChain)
 	{
 		auto& deviceInfo = device.GetPhysicalDevice()->Info;
 		SwapChainSupportDetails support = QuerySwapChainSupport(device.GetPhysicalDevice()->PhysicalDevice, SurfaceKHR);
@@ -121,7 +133,7 @@ namespace Chilli
 		createInfo.preTransform = support.capabilities.currentTransform;
 		createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 		createInfo.clipped = VK_TRUE;
-		createInfo.oldSwapchain = VK_NULL_HANDLE;
+		createInfo.oldSwapchain = OldSwapChain;
 
 		if (VSync)
 			createInfo.presentMode = VK_PRESENT_MODE_FIFO_KHR;
@@ -5,12 +5,23 @@ namespace Chilli
 	class VulkanSwapChainKHR
 	{
 	public:
+		// What Recreate hands back, presents of earlier frames may still use it
+		struct RetiredSwapChain
+		{
+			VkSwapchainKHR SwapChain = VK_NULL_HANDLE;
+			std::vector<VkImageView> ImageViews;
+		};
+
 		VulkanSwapChainKHR() {}
 		~VulkanSwapChainKHR() {}
 
 		void Destroy(VulkanDevice& device);
 		void Init(VulkanDevice& device, VkSurfaceKHR SurfaceKHR, int Width, int Height, bool VSync);
-		void Recreate(VulkanDevice& device, VkSurfaceKHR SurfaceKHR, int Width, int Height, bool VSync);
+		// Creates the new swapchain with the current one as oldSwapchain, the current one is retired
+		// instead of destroyed
+		void Recreate(VulkanDevice& device, VkSurfaceKHR SurfaceKHR, int Width, int Height, bool VSync,
+			RetiredSwapChain& Retired);
+		static void DestroyRetired(VkDevice Device, const RetiredSwapChain& Retired);
 
 		VkFormat GetFormat() const { return _Format; }
 		VkExtent2D GetExtent() const { return _Extent; }
@@ -23,7 +34,8 @@ namespace Chilli
 		VkImageLayout GetImageLayout(int Index) { return _Layout[Index]; }
 
 	private:
-		void _CreateSwapChainKHR(VulkanDevice& device, VkSurfaceKHR SurfaceKHR, int Width, int Height, bool VSync);
+		void _CreateSwapChainKHR(VulkanDevice& device, VkSurfaceKHR SurfaceKHR, int Width, int Height, bool VSync,
+			VkSwapchainKHR OldSwapChain = VK_NULL_HANDLE);
 		void _CreateSwapChainImageViews(VulkanDevice& device);
 
 	private:
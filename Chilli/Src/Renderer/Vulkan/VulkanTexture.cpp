@@ -4,6 +4,9 @@
 #include "vk_mem_alloc.h"
 #include "VulkanBackend.h"
 #include "VulkanConversions.h"
+#include "MipChain.h"
+#include <algorithm>
+#include <cmath>
 
 namespace Chilli
 {
@@ -25,6 +28,7 @@ namespace Chilli
 	};
 
 	std::tuple<VkImage, VmaAllocation, VmaAllocationInfo> CreateVulkanImage(VmaAllocator Allocator, const CreateVulkanImageSpec& Spec);
+	VkImage CreateAliasingVulkanImage(VmaAllocator Allocator, VmaAllocation Memory, const CreateVulkanImageSpec& Spec);
 
 	VkImageView CreateImageView(VkDevice Device, VkImage Image, VkFormat Format,
 		VkImageAspectFlags AspectFlag, VkImageViewType ViewType,
@@ -43,10 +47,55 @@ namespace Chilli
 		// 3. Must not be a storage or attachment-only image
 		bool isStorage = (spec.Usage & IMAGE_USAGE_STORAGE_IMAGE);
 
-		return isSampled && !isDepth && !isStorage;
+		// 4. Block compressed formats cannot be blitted, their mips come with the data
+		bool isCompressed = IsBlockCompressedFormat(spec.Format);
+
+		return isSampled && !isDepth && !isStorage && !isCompressed;
+	}
+
+	bool IsStreamable(const ImageSpec& Spec)
+	{
+		// The CPU side mip chain is kept as 4 byte texels
+		bool IsRGBA8 = Spec.Format == ImageFormat::RGBA8 || Spec.Format == ImageFormat::SRGBA8;
+		bool SampledOnly = (Spec.Usage & IMAGE_USAGE_SAMPLED_IMAGE) && !(Spec.Usage & (IMAGE_USAGE_STORAGE_IMAGE |
+			IMAGE_USAGE_COLOR_ATTACHMENT | IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT | IMAGE_USAGE_INPUT_ATTACHMENT |
+			IMAGE_USAGE_TRANSIENT_ATTACHMENT));
+
+		return Spec.Type == ImageType::IMAGE_TYPE_2D && Spec.MipLevel > 1 && IsRGBA8 && SampledOnly;
+	}
+
+	uint32_t MipExtent(int Size, uint32_t Mip)
+	{
+		return std::max(uint32_t(Size) >> Mip, 1u);
+	}
+
+	uint64_t StreamedMipBytes(const ImageSpec& Full, uint32_t Mip)
+	{
+		return uint64_t(MipExtent(Full.Resolution.Width, Mip)) * MipExtent(Full.Resolution.Height, Mip) * 4;
+	}
+
+	// Bytes of every mip from FirstMip down
+	uint64_t StreamedChainBytes(const ImageSpec& Full, uint32_t FirstMip)
+	{
+		uint64_t Bytes = 0;
+		for (uint32_t Mip = FirstMip; Mip < Full.MipLevel; Mip++)
+			Bytes += StreamedMipBytes(Full, Mip);
+		return Bytes;
+	}
+
+	// The image that holds the mips from FirstMip down of the full chain
+	ImageSpec ResidentImageSpec(const ImageSpec& Full, uint32_t FirstMip)
+	{
+		ImageSpec Spec = Full;
+		Spec.Resolution.Width = MipExtent(Full.Resolution.Width, FirstMip);
+		Spec.Resolution.Height = MipExtent(Full.Resolution.Height, FirstMip);
+		Spec.MipLevel = Full.MipLevel - FirstMip;
+		Spec.ImageData = nullptr;
+		return Spec;
 	}
 
-	void VulkanImage::Init(VmaAllocator Allocator, ImageSpec& Spec, VulkanDataUploader* Uploader)
+	void VulkanImage::Init(VmaAllocator Allocator, ImageSpec& Spec, VulkanDataUploader* Uploader,
+		VmaAllocation AliasMemory)
 	{
 		if (Spec.Resolution.Width == 0 || Spec.Resolution.Height == 0)
 			VULKAN_ERROR("Invalid Width or Height Given!");
@@ -110,10 +159,19 @@ namespace Chilli
 
 		Info.Usage = ImageUsageToVk(Spec.Usage);
 
-		auto [Image, Allocation, AllocInfo] = CreateVulkanImage(Allocator, Info);
-		_Image = Image;
-		_Allocation = Allocation;
-		_AllocationInfo = AllocInfo;
+		if (AliasMemory == VK_NULL_HANDLE)
+		{
+			auto [Image, Allocation, AllocInfo] = CreateVulkanImage(Allocator, Info);
+			_Image = Image;
+			_Allocation = Allocation;
+			_AllocationInfo = AllocInfo;
+		}
+		else
+		{
+			_Image = CreateAliasingVulkanImage(Allocator, AliasMemory, Info);
+			_Allocation = VK_NULL_HANDLE;
+			_AllocationInfo = {};
+		}
 
 		VkImageAspectFlags Aspect = FormatToVkAspectMask(Spec.Format, Spec.Usage);
 
@@ -138,6 +196,7 @@ namespace Chilli
 
 				// Track new layout internally
 				SetImageLayout(targetLayout);
+				_LastUpload = Uploader->GetLatestTicket();
 			}
 		}
 		_Spec = Spec;
@@ -145,6 +204,7 @@ namespace Chilli
 
 	void VulkanImage::Destroy(VmaAllocator Allocator)
 	{
+		// Only the image goes for an aliased one, its memory is the group's
 		vmaDestroyImage(Allocator, _Image, _Allocation);
 		_Image = VK_NULL_HANDLE;
 	}
@@ -196,6 +256,9 @@ namespace Chilli
 		// 1. Determine Aspect
 		VkImageAspectFlags AspectFlag = 0;
 		ImageFormat finalFormat = (Spec.Format != ImageFormat::NONE) ? Spec.Format : ImgSpec.Format;
+		// Compressed images can only be viewed in their own block format
+		if (IsBlockCompressedFormat(ImgSpec.Format) && !IsBlockCompressedFormat(finalFormat))
+			finalFormat = ImgSpec.Format;
 
 		if (Spec.Aspect & IMAGE_ASPECT_ASSUME_FROM_USAGE) {
 			AspectFlag = FormatToVkAspectMask(finalFormat, ImgSpec.Usage);
@@ -209,6 +272,13 @@ namespace Chilli
 		Spec.Format = VkToFormat(Format);
 		Spec.Aspect = VkToImageAspects(AspectFlag);
 
+		// A streamed image is replaced whenever its resident mips change, the view always covers all of them
+		if (ImgSpec.Streamed)
+		{
+			Spec.BaseMipLevel = 0;
+			Spec.MipCount = UINT32_MAX;
+		}
+
 		// 3. Create View using engine Spec
 		// We pass ImgSpec.MipCount to help calculate the UINT32_MAX logic
 		_ImageView = CreateImageView(Device, Image->GetHandle(), Format, AspectFlag,
@@ -221,7 +291,15 @@ namespace Chilli
 		vkDestroyImageView(Device, _ImageView, nullptr);
 	}
 
-	std::tuple<VkImage, VmaAllocation, VmaAllocationInfo> CreateVulkanImage(VmaAllocator Allocator, const CreateVulkanImageSpec& Spec)
+	VkImageView VulkanTexture::Recreate(VkDevice Device, const VulkanImage* Image)
+	{
+		VkImageView OldView = _ImageView;
+		_ImageView = CreateImageView(Device, Image->GetHandle(), FormatToVk(_Spec.Format), ImageAspectsToVk(_Spec.Aspect),
+			VK_IMAGE_VIEW_TYPE_2D, _Spec, Image->GetSpec().MipLevel);
+		return OldView;
+	}
+
+	static VkImageCreateInfo VulkanImageCreateInfo(const CreateVulkanImageSpec& Spec)
 	{
 		VkImageCreateInfo imageInfo{};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -238,6 +316,12 @@ namespace Chilli
 		imageInfo.sharingMode = Spec.SharingMode;
 		imageInfo.samples = Spec.Samples;
 		imageInfo.flags = Spec.Flags;
+		return imageInfo;
+	}
+
+	std::tuple<VkImage, VmaAllocation, VmaAllocationInfo> CreateVulkanImage(VmaAllocator Allocator, const CreateVulkanImageSpec& Spec)
+	{
+		VkImageCreateInfo imageInfo = VulkanImageCreateInfo(Spec);
 
 		VmaAllocationCreateInfo imageAllocInfo{};
 		imageAllocInfo.usage = VMA_MEMORY_USAGE_AUTO;
@@ -262,6 +346,16 @@ namespace Chilli
 		return { Image, Allocation, AllocationInfo };
 	}
 
+	VkImage CreateAliasingVulkanImage(VmaAllocator Allocator, VmaAllocation Memory, const CreateVulkanImageSpec& Spec)
+	{
+		VkImageCreateInfo imageInfo = VulkanImageCreateInfo(Spec);
+
+		VkImage Image = VK_NULL_HANDLE;
+		if (vmaCreateAliasingImage(Allocator, Memory, &imageInfo, &Image) != VK_SUCCESS)
+			VULKAN_ERROR("Failed to place an image on alias memory!");
+		return Image;
+	}
+
 	VkImageView CreateImageView(VkDevice Device, VkImage Image, VkFormat Format,
 		VkImageAspectFlags AspectFlag, VkImageViewType ViewType,
 		const TextureSpec& Spec, uint32_t ImageFullMipCount)
@@ -315,14 +409,42 @@ namespace Chilli
 	{
 		VULKAN_ASSERT(_ImageSet.GetActiveCount() == 0, "All Image must be Freed!");
 		VULKAN_ASSERT(_TextureSet.GetActiveCount() == 0, "All Texture must be Freed!");
+		VULKAN_ASSERT(_AliasGroups.empty(), "Alias memory outlived its images!");
 		_Spec.FreeBuffer(_StagingBuffer);
 	}
 
 	uint32_t VulkanImageDataManager::AllocateImage(VmaAllocator Allocator, ImageSpec& Spec)
 	{
+		if (Spec.Streamed && !IsStreamable(Spec))
+		{
+			VULKAN_PRINTLN("Only sampled 2D RGBA8 images with mips can be streamed, allocating it fully");
+			Spec.Streamed = false;
+		}
+
 		VulkanImage Image;
-		Image.Init(Allocator, Spec, _Spec.Uploader);
+		if (!Spec.Streamed)
+		{
+			Image.Init(Allocator, Spec, _Spec.Uploader);
+			auto ReturnHandle = _ImageSet.Create(Image);
+			return ReturnHandle;
+		}
+
+		// Only the low mips get memory until the texture is asked for at a larger size
+		StreamedImage Streamed;
+		const int Largest = std::max(Spec.Resolution.Width, Spec.Resolution.Height);
+		while (Streamed.LowestMip + 1 < Spec.MipLevel && (Largest >> Streamed.LowestMip) > CH_TEXTURE_STREAM_MIN_RESIDENT_SIZE)
+			Streamed.LowestMip++;
+		Streamed.ResidentMip = Streamed.LowestMip;
+
+		ImageSpec Resident = ResidentImageSpec(Spec, Streamed.ResidentMip);
+		Image.Init(Allocator, Resident, _Spec.Uploader);
+		Spec.Usage = Resident.Usage;
+		Spec.Sample = Resident.Sample;
+		Streamed.FullSpec = Spec;
+		Streamed.FullSpec.ImageData = nullptr;
+
 		auto ReturnHandle = _ImageSet.Create(Image);
+		_StreamedImages[ReturnHandle] = std::move(Streamed);
 		return ReturnHandle;
 	}
 
@@ -330,42 +452,42 @@ namespace Chilli
 	{
 		auto Image = _ImageSet.Get(ImageHandle);
 		if (Image == nullptr)VULKAN_ERROR("Image Not Found!");
+		_Spec.Uploader->Wait(Image->GetLastUpload());
 		Image->Destroy(Allocator);
+		_ReleaseAliasGroup(*Image);
 		_ImageSet.Destroy(ImageHandle);
+		_StreamedImages.erase(ImageHandle);
 	}
 
 	void VulkanImageDataManager::MapImageData(uint32_t ImageHandle, void* Data, int Width, int Height)
 	{
 		auto Image = _ImageSet.Get(ImageHandle);
+		auto Found = _StreamedImages.find(ImageHandle);
+		if (Found == _StreamedImages.end())
+		{
+			_UploadImageData(Image, Data, Width, Height);
+			return;
+		}
+
+		auto& Streamed = Found->second;
+		VULKAN_ASSERT(Width == Streamed.FullSpec.Resolution.Width && Height == Streamed.FullSpec.Resolution.Height,
+			"Streamed images have to be mapped whole!");
+
+		// Kept on the CPU so any mip can be uploaded again once it is raised
+		_BuildStreamedMips(Streamed, Data, nullptr);
+		_UploadStreamedImage(ImageHandle, Streamed);
+	}
+
+	void VulkanImageDataManager::_UploadImageData(VulkanImage* Image, const void* Data, int Width, int Height)
+	{
 		VkImageAspectFlags aspect = FormatToVkAspectMask(Image->GetSpec().Format, Image->GetSpec().Usage);
 
 		_Spec.Uploader->TransitionImageLayout(Image->GetHandle(), Image->GetImageLayout(),
 			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, aspect);
 		Image->SetImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
 
-		// 4 bytes per pixel for RGBA8. Adjust if using HDR/16-bit formats!
-		size_t requiredSize = (size_t)Width * Height * GetImageFormatBytesPerPixel(Image->GetSpec().Format);
-
-		// --- GROWTH CHECK ---
-		if (requiredSize > _StagingBufferRange) {
-			// Log the growth so you can monitor memory usage
-			VULKAN_PRINTLN("Growing Staging Buffer from  " << _StagingBufferRange << " to " << requiredSize
-				<< " bytes ");
-
-			// 1. Destroy old buffer
-			_Spec.FreeBuffer(_StagingBuffer);
-
-			// 2. Reallocate new, larger buffer
-			_StagingBufferRange = requiredSize;
-
-			BufferCreateInfo CreateInfo{};
-			CreateInfo.SizeInBytes = _StagingBufferRange;
-			CreateInfo.State = BufferState::DYNAMIC_DRAW;
-			CreateInfo.Type = BUFFER_TYPE_TRANSFER_SRC;
-			_StagingBuffer = _Spec.AllocateBuffer(CreateInfo);
-		}
-		// Map the whole thing into the (now large enough) staging buffer
-		_Spec.MapBufferData(_StagingBuffer, Data, requiredSize, 0);
+		size_t requiredSize = (size_t)GetImageFormatDataSize(Image->GetSpec().Format, Width, Height);
+		_FillStagingBuffer(Data, requiredSize);
 
 		VkBufferImageCopy region{};
 		region.bufferOffset = 0;
@@ -396,9 +518,10 @@ namespace Chilli
 			DstStage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
 		}
 
+		// Images mapped without a stored chain still get their mips blitted on the device
 		if (ShouldGenerateMips(Image->GetSpec()))
 		{
-			_Spec.Uploader->CopyBufferToImage(
+			_StagingTicket = _Spec.Uploader->CopyBufferToImage(
 				_Spec.GetBuffer(_StagingBuffer),
 				Image->GetHandle(),
 				region,
@@ -421,22 +544,506 @@ namespace Chilli
 		}
 		else
 		{
-			_Spec.Uploader->CopyBufferToImage(_Spec.GetBuffer(_StagingBuffer), Image->GetHandle(), region,
+			_StagingTicket = _Spec.Uploader->CopyBufferToImage(_Spec.GetBuffer(_StagingBuffer), Image->GetHandle(), region,
 				Image->GetImageLayout(), finalLayout, Range, DstAccess, DstStage);
 			Image->SetImageLayout(finalLayout);
 		}
+
+		Image->SetLastUpload(_Spec.Uploader->GetLatestTicket());
+	}
+
+	void VulkanImageDataManager::MapImageMips(uint32_t ImageHandle, const void* Data, const ImageMipRegion* Mips, uint32_t MipCount)
+	{
+		auto Image = _ImageSet.Get(ImageHandle);
+		auto Found = _StreamedImages.find(ImageHandle);
+		if (Found == _StreamedImages.end())
+		{
+			VULKAN_ASSERT(MipCount == Image->GetSpec().MipLevel, "Every mip level of the image has to be given!");
+			_UploadImageMips(Image, Data, Mips, MipCount);
+			return;
+		}
+
+		auto& Streamed = Found->second;
+		VULKAN_ASSERT(MipCount == Streamed.FullSpec.MipLevel, "Every mip level of the image has to be given!");
+		_BuildStreamedMips(Streamed, Data, Mips);
+		_UploadStreamedImage(ImageHandle, Streamed);
+	}
+
+	void VulkanImageDataManager::_UploadImageMips(VulkanImage* Image, const void* Data, const ImageMipRegion* Mips,
+		uint32_t MipCount)
+	{
+		const auto& ImgSpec = Image->GetSpec();
+		VkImageAspectFlags aspect = FormatToVkAspectMask(ImgSpec.Format, ImgSpec.Usage);
+
+		_Spec.Uploader->TransitionImageLayout(Image->GetHandle(), Image->GetImageLayout(),
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, aspect);
+		Image->SetImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+		// Levels may be packed in any order (KTX2 keeps the smallest first), the whole span goes up at once
+		size_t requiredSize = 0;
+		std::vector<VkBufferImageCopy> Regions(MipCount);
+		for (uint32_t Mip = 0; Mip < MipCount; Mip++)
+		{
+			requiredSize = std::max(requiredSize, size_t(Mips[Mip].Offset + Mips[Mip].Size));
+
+			auto& Region = Regions[Mip];
+			Region.bufferOffset = Mips[Mip].Offset;
+			Region.imageSubresource = { aspect, Mip, 0, 1 };
+			Region.imageExtent = { Mips[Mip].Width, Mips[Mip].Height, 1 };
+		}
+		_FillStagingBuffer(Data, requiredSize);
+
+		VkImageSubresourceRange Range{};
+		Range.aspectMask = aspect;
+		Range.baseMipLevel = 0;
+		Range.levelCount = MipCount;
+		Range.baseArrayLayer = 0;
+		Range.layerCount = 1;
+
+		VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		VkAccessFlags2 DstAccess = VK_ACCESS_2_SHADER_READ_BIT;
+		VkPipelineStageFlags2 DstStage = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+
+		if (ImgSpec.Usage & IMAGE_USAGE_STORAGE_IMAGE) {
+			finalLayout = VK_IMAGE_LAYOUT_GENERAL;
+			DstAccess = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT;
+			DstStage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+		}
+
+		// One copy for the whole chain, nothing is blitted
+		_StagingTicket = _Spec.Uploader->CopyBufferToImage(_Spec.GetBuffer(_StagingBuffer), Image->GetHandle(),
+			Regions.data(), MipCount, Image->GetImageLayout(), finalLayout, Range, DstAccess, DstStage);
+		Image->SetImageLayout(finalLayout);
+
+		Image->SetLastUpload(_Spec.Uploader->GetLatestTicket());
+	}
+
+	void VulkanImageDataManager::_FillStagingBuffer(const void* Data, size_t requiredSize)
+	{
+		// The staging buffer is refilled (or freed when growing) only once the last copy out of it is done
+		_Spec.Uploader->Wait(_StagingTicket);
+
+		// --- GROWTH CHECK ---
+		if (requiredSize > _StagingBufferRange) {
+			// Log the growth so you can monitor memory usage
+			VULKAN_PRINTLN("Growing Staging Buffer from  " << _StagingBufferRange << " to " << requiredSize
+				<< " bytes ");
+
+			// 1. Destroy old buffer
+			_Spec.FreeBuffer(_StagingBuffer);
+
+			// 2. Reallocate new, larger buffer
+			_StagingBufferRange = requiredSize;
+
+			BufferCreateInfo CreateInfo{};
+			CreateInfo.SizeInBytes = _StagingBufferRange;
+			CreateInfo.State = BufferState::DYNAMIC_DRAW;
+			CreateInfo.Type = BUFFER_TYPE_TRANSFER_SRC;
+			_StagingBuffer = _Spec.AllocateBuffer(CreateInfo);
+		}
+		// Map the whole thing into the (now large enough) staging buffer
+		_Spec.MapBufferData(_StagingBuffer, (void*)Data, requiredSize, 0);
 	}
 
 	uint32_t VulkanImageDataManager::CreateTexture(VkDevice Device, uint32_t ImageHandle, TextureSpec& Spec)
 	{
 		VulkanTexture Texture;
 		Texture.Init(Device, ImageHandle, _ImageSet.Get(ImageHandle), Spec);
-		return _TextureSet.Create(Texture);
+		auto TextureHandle = _TextureSet.Create(Texture);
+
+		auto Found = _StreamedImages.find(ImageHandle);
+		if (Found != _StreamedImages.end())
+			Found->second.Textures.push_back(TextureHandle);
+		return TextureHandle;
 	}
 
 	void VulkanImageDataManager::DestroyTexture(VkDevice Device, uint32_t TextureHandle)
 	{
-		_TextureSet.Get(TextureHandle)->Destroy(Device);
+		auto Texture = _TextureSet.Get(TextureHandle);
+		auto Found = _StreamedImages.find(Texture->GetImageHandle());
+		if (Found != _StreamedImages.end())
+		{
+			auto& Textures = Found->second.Textures;
+			Textures.erase(std::remove(Textures.begin(), Textures.end(), TextureHandle), Textures.end());
+		}
+
+		Texture->Destroy(Device);
 		_TextureSet.Destroy(TextureHandle);
 	}
+
+	void VulkanImageDataManager::SetTextureScreenSize(uint32_t TextureHandle, float ScreenSize)
+	{
+		auto Texture = _TextureSet.Get(TextureHandle);
+		if (Texture == nullptr)
+			return;
+
+		auto Found = _StreamedImages.find(Texture->GetImageHandle());
+		if (Found != _StreamedImages.end())
+			Found->second.ScreenSize = std::max(Found->second.ScreenSize, ScreenSize);
+	}
+
+	void VulkanImageDataManager::PinStreamedTexture(uint32_t TextureHandle)
+	{
+		auto Texture = _TextureSet.Get(TextureHandle);
+		if (Texture == nullptr)
+			return;
+
+		auto Found = _StreamedImages.find(Texture->GetImageHandle());
+		if (Found == _StreamedImages.end() || Found->second.Pinned)
+			return;
+
+		Found->second.Pinned = true;
+		if (!Found->second.Pixels.empty() && Found->second.ResidentMip != 0)
+			_ChangeResidency(Found->first, Found->second, 0);
+	}
+
+	void VulkanImageDataManager::UpdateStreaming(uint64_t DeviceLocalUsage, uint64_t DeviceLocalBudget)
+	{
+		_StreamFrame++;
+		_StreamedMipsRaised = 0;
+		_StreamedMipsEvicted = 0;
+
+		_StreamedResidentBytes = 0;
+		_StreamCandidates.clear();
+		for (auto& [Handle, Streamed] : _StreamedImages)
+		{
+			_StreamedResidentBytes += StreamedChainBytes(Streamed.FullSpec, Streamed.ResidentMip);
+
+			if (Streamed.ScreenSize > 0.0f)
+			{
+				Streamed.LastScreenSize = Streamed.ScreenSize;
+				Streamed.LastRequestFrame = _StreamFrame;
+				Streamed.ScreenSize = 0.0f;
+			}
+
+			if (Streamed.Pinned || Streamed.Pixels.empty())
+				continue;
+
+			// One texel per pixel, every halving of the screen size drops a mip
+			uint32_t WantedMip = Streamed.LowestMip;
+			if (Streamed.LastScreenSize > 0.0f && _StreamFrame - Streamed.LastRequestFrame <= CH_TEXTURE_STREAM_IDLE_FRAMES)
+			{
+				float Largest = float(std::max(Streamed.FullSpec.Resolution.Width, Streamed.FullSpec.Resolution.Height));
+				float Ratio = Largest / Streamed.LastScreenSize;
+				WantedMip = Ratio <= 1.0f ? 0 : std::min(uint32_t(std::log2(Ratio)), Streamed.LowestMip);
+			}
+			_StreamCandidates.push_back({ Handle, WantedMip, &Streamed });
+		}
+
+		if (_StreamCandidates.empty() || DeviceLocalBudget == 0)
+			return;
+
+		// Replaced images are still allocated until they are retired but their memory is already given back
+		int64_t Usage = int64_t(DeviceLocalUsage) - int64_t(_RetiredBytes);
+		const int64_t EvictAbove = int64_t(double(DeviceLocalBudget) * CH_TEXTURE_STREAM_EVICT_BUDGET);
+		const int64_t RaiseBelow = int64_t(double(DeviceLocalBudget) * CH_TEXTURE_STREAM_RAISE_BUDGET);
+		uint32_t Changes = 0;
+
+		if (Usage > EvictAbove)
+		{
+			// Textures holding more than they want go first, then the ones smallest on screen
+			std::sort(_StreamCandidates.begin(), _StreamCandidates.end(), [](const StreamCandidate& A, const StreamCandidate& B) {
+				int ExcessA = int(A.WantedMip) - int(A.Streamed->ResidentMip);
+				int ExcessB = int(B.WantedMip) - int(B.Streamed->ResidentMip);
+				if (ExcessA != ExcessB)
+					return ExcessA > ExcessB;
+				return A.Streamed->LastScreenSize < B.Streamed->LastScreenSize;
+				});
+
+			for (auto& Candidate : _StreamCandidates)
+			{
+				if (Usage <= EvictAbove || Changes == CH_TEXTURE_STREAM_CHANGES_PER_FRAME)
+					break;
+
+				auto& Streamed = *Candidate.Streamed;
+				if (Streamed.ResidentMip >= Streamed.LowestMip)
+					continue;
+
+				Usage -= int64_t(StreamedMipBytes(Streamed.FullSpec, Streamed.ResidentMip));
+				_ChangeResidency(Candidate.ImageHandle, Streamed, Streamed.ResidentMip + 1);
+				_StreamedMipsEvicted++;
+				Changes++;
+			}
+			return;
+		}
+
+		// Furthest from what they want first, then the ones largest on screen
+		std::sort(_StreamCandidates.begin(), _StreamCandidates.end(), [](const StreamCandidate& A, const StreamCandidate& B) {
+			int MissingA = int(A.Streamed->ResidentMip) - int(A.WantedMip);
+			int MissingB = int(B.Streamed->ResidentMip) - int(B.WantedMip);
+			if (MissingA != MissingB)
+				return MissingA > MissingB;
+			return A.Streamed->LastScreenSize > B.Streamed->LastScreenSize;
+			});
+
+		for (auto& Candidate : _StreamCandidates)
+		{
+			auto& Streamed = *Candidate.Streamed;
+			if (Changes == CH_TEXTURE_STREAM_CHANGES_PER_FRAME || Streamed.ResidentMip <= Candidate.WantedMip)
+				break;
+
+			// The old image stays allocated until it is retired, both have to fit for now
+			if (Usage + int64_t(StreamedChainBytes(Streamed.FullSpec, Streamed.ResidentMip - 1)) > RaiseBelow)
+				continue;
+
+			Usage += int64_t(StreamedMipBytes(Streamed.FullSpec, Streamed.ResidentMip - 1));
+			_ChangeResidency(Candidate.ImageHandle, Streamed, Streamed.ResidentMip - 1);
+			_StreamedMipsRaised++;
+			Changes++;
+		}
+	}
+
+	void VulkanImageDataManager::_BuildStreamedMips(StreamedImage& Streamed, const void* Data, const ImageMipRegion* Mips)
+	{
+		const auto& Full = Streamed.FullSpec;
+
+		uint64_t Size = LayoutMipChainRGBA8(Full.Resolution.Width, Full.Resolution.Height, Full.MipLevel, Streamed.Mips);
+		Streamed.Pixels.resize(size_t(Size));
+
+		// A chain that came with the data is kept as is, otherwise it is built from the top level
+		if (Mips != nullptr)
+		{
+			for (uint32_t Mip = 0; Mip < Full.MipLevel; Mip++)
+			{
+				const auto& Region = Streamed.Mips[Mip];
+				VULKAN_ASSERT(Mips[Mip].Size == Region.Size, "Mip level does not match the streamed image!");
+				memcpy(Streamed.Pixels.data() + Region.Offset, static_cast<const uint8_t*>(Data) + Mips[Mip].Offset,
+					size_t(Region.Size));
+			}
+			return;
+		}
+
+		memcpy(Streamed.Pixels.data(), Data, size_t(Streamed.Mips[0].Size));
+
+		MipChainSpec ChainSpec;
+		ChainSpec.Filter = MipFilter::BOX;
+		ChainSpec.SRGB = Full.Format == ImageFormat::SRGBA8;
+		GenerateMipChainRGBA8(Streamed.Pixels.data(), Streamed.Mips.data(), Full.MipLevel, ChainSpec);
+	}
+
+	void VulkanImageDataManager::_UploadStreamedImage(uint32_t ImageHandle, StreamedImage& Streamed)
+	{
+		if (Streamed.Pinned && Streamed.ResidentMip != 0)
+			_ChangeResidency(ImageHandle, Streamed, 0);
+		else
+			_UploadResidentMips(_ImageSet.Get(ImageHandle), Streamed, Streamed.ResidentMip);
+	}
+
+	void VulkanImageDataManager::_UploadResidentMips(VulkanImage* Image, const StreamedImage& Streamed, uint32_t FirstMip)
+	{
+		// Only the resident part of the chain is staged, the regions are rebased onto its first mip
+		const uint64_t Base = Streamed.Mips[FirstMip].Offset;
+		std::vector<ImageMipRegion> Mips(Streamed.Mips.begin() + FirstMip, Streamed.Mips.end());
+		for (auto& Mip : Mips)
+			Mip.Offset -= Base;
+
+		_UploadImageMips(Image, Streamed.Pixels.data() + Base, Mips.data(), uint32_t(Mips.size()));
+	}
+
+	void VulkanImageDataManager::_ChangeResidency(uint32_t ImageHandle, StreamedImage& Streamed, uint32_t NewMip)
+	{
+		auto Image = _ImageSet.Get(ImageHandle);
+
+		// The new image gets every resident mip from the CPU chain in one copy
+		ImageSpec Spec = ResidentImageSpec(Streamed.FullSpec, NewMip);
+		VulkanImage NewImage;
+		NewImage.Init(_Spec.Allocator, Spec, _Spec.Uploader);
+		_UploadResidentMips(&NewImage, Streamed, NewMip);
+
+		VulkanImage OldImage = *Image;
+		std::vector<VkImageView> OldViews;
+		*Image = NewImage;
+
+		for (uint32_t TextureHandle : Streamed.Textures)
+		{
+			auto Texture = _TextureSet.Get(TextureHandle);
+			OldViews.push_back(Texture->Recreate(_Spec.Device->GetHandle(), Image));
+			_Spec.TextureViewChanged(TextureHandle, Texture->GetHandle());
+		}
+
+		_RetireImage(OldImage, std::move(OldViews), StreamedChainBytes(Streamed.FullSpec, Streamed.ResidentMip));
+		Streamed.ResidentMip = NewMip;
+	}
+
+	void VulkanImageDataManager::_RetireImage(const VulkanImage& Image, std::vector<VkImageView>&& Views, uint64_t Bytes)
+	{
+		_RetiredBytes += Bytes;
+		_Spec.DeferDestroy([this, Retired = Image, Views = std::move(Views), Bytes]() mutable {
+			for (auto View : Views)
+				vkDestroyImageView(_Spec.Device->GetHandle(), View, nullptr);
+			Retired.Destroy(_Spec.Allocator);
+			_ReleaseAliasGroup(Retired);
+			_RetiredBytes -= Bytes;
+			});
+	}
+
+	void VulkanImageDataManager::AliasImages(const ImageAliasRange* Ranges, uint32_t Count)
+	{
+		struct Candidate
+		{
+			ImageAliasRange Range;
+			VkMemoryRequirements Requirements;
+		};
+
+		std::vector<Candidate> Candidates;
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			auto Image = _ImageSet.Get(Ranges[i].ImageHandle);
+			// Streamed images are replaced on their own schedule
+			if (Image == nullptr || _StreamedImages.count(Ranges[i].ImageHandle) != 0)
+				continue;
+
+			Candidate NewCandidate;
+			NewCandidate.Range = Ranges[i];
+			vkGetImageMemoryRequirements(_Spec.Device->GetHandle(), Image->GetHandle(), &NewCandidate.Requirements);
+			Candidates.push_back(NewCandidate);
+		}
+
+		// Largest first so the smaller images land in memory that is already big enough
+		std::sort(Candidates.begin(), Candidates.end(), [](const Candidate& A, const Candidate& B) {
+			return A.Requirements.size > B.Requirements.size;
+			});
+
+		struct PlannedGroup
+		{
+			std::vector<const Candidate*> Members;
+			VkMemoryRequirements Requirements;
+		};
+
+		std::vector<PlannedGroup> Planned;
+		for (const auto& Entry : Candidates)
+		{
+			PlannedGroup* Found = nullptr;
+			for (auto& Group : Planned)
+			{
+				if ((Group.Requirements.memoryTypeBits & Entry.Requirements.memoryTypeBits) == 0)
+					continue;
+
+				bool Overlaps = false;
+				for (auto Member : Group.Members)
+					Overlaps |= Member->Range.FirstPass <= Entry.Range.LastPass &&
+					Entry.Range.FirstPass <= Member->Range.LastPass;
+				if (!Overlaps)
+				{
+					Found = &Group;
+					break;
+				}
+			}
+
+			if (Found == nullptr)
+			{
+				Planned.push_back({ {}, Entry.Requirements });
+				Found = &Planned.back();
+			}
+
+			Found->Members.push_back(&Entry);
+			Found->Requirements.size = std::max(Found->Requirements.size, Entry.Requirements.size);
+			Found->Requirements.alignment = std::max(Found->Requirements.alignment, Entry.Requirements.alignment);
+			Found->Requirements.memoryTypeBits &= Entry.Requirements.memoryTypeBits;
+		}
+
+		for (const auto& Group : Planned)
+		{
+			const uint32_t Current = _ImageSet.Get(Group.Members[0]->Range.ImageHandle)->GetAliasGroup();
+
+			// Sharing with nothing, the image goes back to memory of its own
+			if (Group.Members.size() == 1)
+			{
+				if (Current != UINT32_MAX)
+					_PlaceImage(Group.Members[0]->Range.ImageHandle, UINT32_MAX);
+				continue;
+			}
+
+			// Called again after a resize with nothing changed for this group
+			bool AlreadyPlaced = Current != UINT32_MAX && _AliasGroups[Current].Size >= Group.Requirements.size;
+			for (auto Member : Group.Members)
+				AlreadyPlaced &= _ImageSet.Get(Member->Range.ImageHandle)->GetAliasGroup() == Current;
+			if (AlreadyPlaced)
+				continue;
+
+			AliasGroup NewGroup;
+			NewGroup.Size = Group.Requirements.size;
+
+			VmaAllocationCreateInfo AllocInfo{};
+			AllocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			if (vmaAllocateMemory(_Spec.Allocator, &Group.Requirements, &AllocInfo, &NewGroup.Memory, nullptr) != VK_SUCCESS)
+			{
+				VULKAN_PRINTLN("Alias memory of " << NewGroup.Size << " bytes could not be allocated, "
+					<< Group.Members.size() << " images keep their own");
+				continue;
+			}
+
+			const uint32_t GroupIndex = _NextAliasGroup++;
+			_AliasGroups[GroupIndex] = NewGroup;
+			_AliasedMemoryBytes += NewGroup.Size;
+			for (auto Member : Group.Members)
+				_PlaceImage(Member->Range.ImageHandle, GroupIndex);
+
+			VULKAN_PRINTLN("Aliased " << Group.Members.size() << " images on " << NewGroup.Size << " bytes, "
+				<< _AliasGroups[GroupIndex].MemberBytes - NewGroup.Size << " bytes saved");
+		}
+	}
+
+	void VulkanImageDataManager::_PlaceImage(uint32_t ImageHandle, uint32_t Group)
+	{
+		auto Image = _ImageSet.Get(ImageHandle);
+
+		// Same spec and state, only the memory changes. The contents are not carried over
+		ImageSpec Spec = Image->GetSpec();
+		Spec.ImageData = nullptr;
+
+		VulkanImage NewImage;
+		if (Group == UINT32_MAX)
+			NewImage.Init(_Spec.Allocator, Spec, _Spec.Uploader);
+		else
+		{
+			auto& Shared = _AliasGroups[Group];
+			NewImage.Init(_Spec.Allocator, Spec, _Spec.Uploader, Shared.Memory);
+			NewImage.SetAliasGroup(Group);
+
+			VkMemoryRequirements Requirements;
+			vkGetImageMemoryRequirements(_Spec.Device->GetHandle(), NewImage.GetHandle(), &Requirements);
+			Shared.MemberBytes += Requirements.size;
+			Shared.MemberCount++;
+			_AliasedImageBytes += Requirements.size;
+			_AliasedImageCount++;
+		}
+
+		// Frames in flight may still render to the old image, it goes the same way a streamed one does
+		VulkanImage OldImage = *Image;
+		std::vector<VkImageView> OldViews;
+		*Image = NewImage;
+
+		for (uint32_t i = 0; i < _TextureSet.size(); i++)
+		{
+			if (_TextureSet.GetDataBuffer()[i].GetImageHandle() != ImageHandle)
+				continue;
+
+			const uint32_t TextureHandle = _TextureSet.GetIdAtDenseIndex(i);
+			auto Texture = _TextureSet.Get(TextureHandle);
+			OldViews.push_back(Texture->Recreate(_Spec.Device->GetHandle(), Image));
+			_Spec.TextureViewChanged(TextureHandle, Texture->GetHandle());
+		}
+
+		_RetireImage(OldImage, std::move(OldViews), 0);
+	}
+
+	void VulkanImageDataManager::_ReleaseAliasGroup(const VulkanImage& Image)
+	{
+		if (Image.GetAliasGroup() == UINT32_MAX)
+			return;
+
+		auto Found = _AliasGroups.find(Image.GetAliasGroup());
+		VULKAN_ASSERT(Found != _AliasGroups.end(), "Image sits on alias memory that is gone!");
+
+		auto& Group = Found->second;
+		_AliasedImageCount--;
+		if (--Group.MemberCount != 0)
+			return;
+
+		vmaFreeMemory(_Spec.Allocator, Group.Memory);
+		_AliasedImageBytes -= Group.MemberBytes;
+		_AliasedMemoryBytes -= Group.Size;
+		_AliasGroups.erase(Found);
+	}
 }
@@ -2,6 +2,16 @@
 
 #include "Texture.h"
 
+// Streamed images keep every mip from this size down resident whatever the budget says
+#define CH_TEXTURE_STREAM_MIN_RESIDENT_SIZE 64
+// Residency changes started per frame, each one is a new image plus an upload
+#define CH_TEXTURE_STREAM_CHANGES_PER_FRAME 4
+// Fractions of the device local budget, mips are raised below the first and evicted above the second
+#define CH_TEXTURE_STREAM_RAISE_BUDGET 0.80
+#define CH_TEXTURE_STREAM_EVICT_BUDGET 0.90
+// Frames a texture keeps its last requested screen size once it stops being drawn
+#define CH_TEXTURE_STREAM_IDLE_FRAMES 120
+
 namespace Chilli
 {
 	class VulkanImage
@@ -10,7 +20,9 @@ namespace Chilli
 		VulkanImage() {}
 		~VulkanImage() {}
 
-		void Init(VmaAllocator Allocator, ImageSpec& Spec, VulkanDataUploader* Uploader);
+		// With AliasMemory the image is placed on that allocation and does not own it
+		void Init(VmaAllocator Allocator, ImageSpec& Spec, VulkanDataUploader* Uploader,
+			VmaAllocation AliasMemory = VK_NULL_HANDLE);
 		void Destroy(VmaAllocator Allocator);
 
 		VkImage GetHandle() const { return _Image; }
@@ -19,12 +31,22 @@ namespace Chilli
 		VkImageLayout GetImageLayout() const { return _Layout; }
 		void SetImageLayout(VkImageLayout Layout) { _Layout = Layout; }
 		void SetResourceState(ResourceState State) { _Spec.State = State; }
+
+		// Last upload batch that touched the image, destroying it waits for this
+		VulkanUploadTicket GetLastUpload() const { return _LastUpload; }
+		void SetLastUpload(VulkanUploadTicket Ticket) { _LastUpload = Ticket; }
+
+		// Alias group whose memory the image sits on, UINT32_MAX when it owns its allocation
+		uint32_t GetAliasGroup() const { return _AliasGroup; }
+		void SetAliasGroup(uint32_t Group) { _AliasGroup = Group; }
 	private:
 		VkImage _Image = VK_NULL_HANDLE;
 		VmaAllocation _Allocation;
 		VmaAllocationInfo _AllocationInfo;
 		ImageSpec _Spec;
 		VkImageLayout _Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VulkanUploadTicket _LastUpload = 0;
+		uint32_t _AliasGroup = UINT32_MAX;
 	};
 
 	class VulkanSampler
@@ -57,6 +79,9 @@ namespace Chilli
 		const TextureSpec& GetSpec() const { return _Spec; }
 		uint32_t GetImageHandle() { return _ImageHandle; }
 
+		// Views the image that replaced the one the texture was created on, returns the old view to retire
+		VkImageView Recreate(VkDevice Device, const VulkanImage* Image);
+
 	private:
 		VkImageView _ImageView = VK_NULL_HANDLE;
 		TextureSpec _Spec;
@@ -71,6 +96,11 @@ namespace Chilli
 		std::function<uint32_t(const BufferCreateInfo&)> AllocateBuffer;
 		std::function<void(uint32_t)> FreeBuffer;
 		std::function<void(uint32_t, void*, uint32_t, uint32_t)>MapBufferData;
+		VmaAllocator Allocator;
+		// Runs the function once the frames in flight that may still use the current resources are done
+		std::function<void(std::function<void()>&&)> DeferDestroy;
+		// A streamed texture got a new view, receives the texture handle and the view
+		std::function<void(uint32_t, VkImageView)> TextureViewChanged;
 	};
 
 	struct VulkanImageDataManager
@@ -85,6 +115,9 @@ namespace Chilli
 		uint32_t AllocateImage(VmaAllocator Allocator, ImageSpec& Spec);
 		void DestroyImage(VmaAllocator Allocator, uint32_t ImageHandle);
 		void MapImageData(uint32_t ImageHandle, void* Data, int Width, int Height);
+		// Uploads a packed mip chain as given, every level in one staging fill and one copy. Streamed images keep
+		// the chain on the CPU and upload their resident mips from it
+		void MapImageMips(uint32_t ImageHandle, const void* Data, const ImageMipRegion* Mips, uint32_t MipCount);
 		VulkanImage* GetImage(uint32_t Handle) { return _ImageSet.Get(Handle); }
 
 		uint32_t CreateTexture(VkDevice Device, uint32_t ImageHandle, TextureSpec& Spec);
@@ -93,11 +126,97 @@ namespace Chilli
 
 		uint32_t GetImageAllocatedCount() { return _ImageSet.GetActiveCount(); }
 		uint32_t GetTextureAllocatedCount() { return _TextureSet.GetActiveCount(); }
+
+		// Streamed images only hold the mips from their resident one down. Called once per frame after the
+		// frame's fence, raises or evicts mips against the device local usage and budget
+		void UpdateStreaming(uint64_t DeviceLocalUsage, uint64_t DeviceLocalBudget);
+		// Largest size in pixels the texture covers on screen, kept as the maximum until the next update
+		void SetTextureScreenSize(uint32_t TextureHandle, float ScreenSize);
+		// The texture's view went somewhere that is never retargeted, it is made fully resident and left there
+		void PinStreamedTexture(uint32_t TextureHandle);
+
+		uint32_t GetStreamedImageCount() const { return uint32_t(_StreamedImages.size()); }
+		uint32_t GetStreamedMipsRaised() const { return _StreamedMipsRaised; }
+		uint32_t GetStreamedMipsEvicted() const { return _StreamedMipsEvicted; }
+		uint64_t GetStreamedResidentBytes() const { return _StreamedResidentBytes; }
+
+		// Images with non overlapping ranges share one allocation, each placement gets a new image and views
+		// and the old ones are retired like streamed images. A group that is already placed as planned is kept
+		void AliasImages(const ImageAliasRange* Ranges, uint32_t Count);
+		uint32_t GetAliasedImageCount() const { return _AliasedImageCount; }
+		uint64_t GetAliasedMemoryBytes() const { return _AliasedMemoryBytes; }
+		uint64_t GetAliasedBytesSaved() const { return _AliasedImageBytes - _AliasedMemoryBytes; }
+	private:
+		void _UploadImageData(VulkanImage* Image, const void* Data, int Width, int Height);
+		void _UploadImageMips(VulkanImage* Image, const void* Data, const ImageMipRegion* Mips, uint32_t MipCount);
+		void _FillStagingBuffer(const void* Data, size_t Size);
+
+		struct StreamedImage
+		{
+			// Spec of the full chain, the image in the set only has the mips from ResidentMip down
+			ImageSpec FullSpec;
+			uint32_t ResidentMip = 0;
+			// Never evicted past this one
+			uint32_t LowestMip = 0;
+			float ScreenSize = 0.0f;
+			float LastScreenSize = 0.0f;
+			uint64_t LastRequestFrame = 0;
+			bool Pinned = false;
+			// Every mip of the full chain packed one after another, filled by MapImageData or MapImageMips
+			std::vector<uint8_t> Pixels;
+			std::vector<ImageMipRegion> Mips;
+			std::vector<uint32_t> Textures;
+		};
+
+		struct StreamCandidate
+		{
+			uint32_t ImageHandle;
+			uint32_t WantedMip;
+			StreamedImage* Streamed;
+		};
+
+		void _BuildStreamedMips(StreamedImage& Streamed, const void* Data, const ImageMipRegion* Mips);
+		void _UploadStreamedImage(uint32_t ImageHandle, StreamedImage& Streamed);
+		void _UploadResidentMips(VulkanImage* Image, const StreamedImage& Streamed, uint32_t FirstMip);
+		void _ChangeResidency(uint32_t ImageHandle, StreamedImage& Streamed, uint32_t NewMip);
+		// Frames in flight may still use the replaced image and views, they go through DeferDestroy
+		void _RetireImage(const VulkanImage& Image, std::vector<VkImageView>&& Views, uint64_t Bytes);
+
+		struct AliasGroup
+		{
+			VmaAllocation Memory = VK_NULL_HANDLE;
+			uint64_t Size = 0;
+			// Sum of what the members need on their own
+			uint64_t MemberBytes = 0;
+			uint32_t MemberCount = 0;
+		};
+
+		// Puts the image on Group's memory, or on its own allocation for UINT32_MAX
+		void _PlaceImage(uint32_t ImageHandle, uint32_t Group);
+		// The image leaves its group, the memory goes with the last member
+		void _ReleaseAliasGroup(const VulkanImage& Image);
 	private:
 		VulkanImageDataManagerSpec _Spec;
 		SparseSet<VulkanImage> _ImageSet;
 		SparseSet<VulkanTexture> _TextureSet;
 		uint32_t _StagingBuffer = UINT32_MAX;
 		uint32_t _StagingBufferRange = 1e6;
+		// Copy that last read from the staging buffer
+		VulkanUploadTicket _StagingTicket = 0;
+
+		// Keyed by image handle
+		std::unordered_map<uint32_t, StreamedImage> _StreamedImages;
+		std::vector<StreamCandidate> _StreamCandidates;
+		uint64_t _RetiredBytes = 0;
+		uint64_t _StreamFrame = 0;
+		uint32_t _StreamedMipsRaised = 0;
+		uint32_t _StreamedMipsEvicted = 0;
+		uint64_t _StreamedResidentBytes = 0;
+
+		std::unordered_map<uint32_t, AliasGroup> _AliasGroups;
+		uint32_t _NextAliasGroup = 0;
+		uint32_t _AliasedImageCount = 0;
+		uint64_t _AliasedImageBytes = 0;
+		uint64_t _AliasedMemoryBytes = 0;
 	};
 }
@@ -0,0 +1,152 @@
+#include "Ch_PCH.h"
+#include "Chilli/Chilli.h"
+#include "Profiling\Timer.h"
+
+// Times encoding and decoding of the paged RenderCommandBuffer against the old growing byte vector.
+// No window or renderer is created, only the streams are exercised.
+
+static double ToMs(long long Microseconds) { return double(Microseconds) / 1000.0; }
+
+static double ToMillionsPerSecond(uint64_t Count, long long Microseconds)
+{
+	return Microseconds > 0 ? double(Count) / double(Microseconds) : 0.0;
+}
+
+// What RenderCommandBuffer::PushCommand used to do, kept here as the baseline
+struct VectorCommandStream
+{
+	std::vector<uint8_t> Stream;
+
+	template<typename T>
+	void PushCommand(Chilli::RenderOpCode Op, const T& Payload)
+	{
+		struct { Chilli::RenderOpCode Code; uint16_t Size; } Header{ Op, uint16_t(sizeof(T)) };
+		size_t Current = Stream.size();
+		Stream.resize(Current + sizeof(Header) + sizeof(T));
+		memcpy(&Stream[Current], &Header, sizeof(Header));
+		memcpy(&Stream[Current + sizeof(Header)], &Payload, sizeof(T));
+	}
+};
+
+// A typical draw: material, vertex and index buffers, then the draw itself
+static void EncodeDraws(Chilli::GraphicsCommandBuffer& Stream, uint32_t DrawCount)
+{
+	uint32_t VertexBuffer = 3;
+	for (uint32_t i = 0; i < DrawCount; i++)
+	{
+		Stream.BindMaterailData(i & 63);
+		Stream.BindVertexBuffer(&VertexBuffer, 1);
+		Stream.BindIndexBuffer(4, Chilli::IndexBufferType::UINT32_T);
+		Stream.DrawIndexed(36, 1, 0, 0, i);
+	}
+}
+
+static void EncodeDraws(VectorCommandStream& Stream, uint32_t DrawCount)
+{
+	for (uint32_t i = 0; i < DrawCount; i++)
+	{
+		Stream.PushCommand<Chilli::BindMaterialDataCmdPayload>(Chilli::RenderOpCode::BIND_MATERIAL_DATA, { i & 63 });
+		Chilli::BindVertexBuffersCmdPayload Buffers{};
+		Buffers.VertexBufferCount = 1;
+		Stream.PushCommand(Chilli::RenderOpCode::BIND_VERTEX_BUFFERS, Buffers);
+		Stream.PushCommand<Chilli::BindIndexBufferCmdPayload>(Chilli::RenderOpCode::BIND_INDEX_BUFFER,
+			{ 4, Chilli::IndexBufferType::UINT32_T });
+		Chilli::DrawIndexedCmdPayload Draw{};
+		Draw.ElementCount = 36;
+		Draw.InstanceCount = 1;
+		Draw.FirstInstance = i;
+		Stream.PushCommand(Chilli::RenderOpCode::DRAW_INDEXED, Draw);
+	}
+}
+
+static void BenchEncode(uint32_t DrawCount, uint32_t Frames)
+{
+	const uint64_t Commands = uint64_t(DrawCount) * 4 * Frames;
+
+	// The pool is carved from an arena the same way the Renderer does it
+	Chilli::MemoryArena Arena;
+	Arena.Prepare(size_t(32) * Chilli::CH_RENDER_COMMAND_PAGE_SIZE);
+	Chilli::RenderCommandPagePool Pool;
+	Pool.Init(Arena, 32);
+
+	Chilli::GraphicsCommandBuffer Paged(&Pool);
+	long long PagedFirst = 0, PagedTime = 0;
+	for (uint32_t Frame = 0; Frame < Frames; Frame++)
+	{
+		Paged.Clear();
+		Chilli::Timer Timer;
+		EncodeDraws(Paged, DrawCount);
+		long long Time = Timer.ElapsedMcl();
+		PagedTime += Time;
+		if (Frame == 0)
+			PagedFirst = Time;
+	}
+
+	// Cleared every frame like the packet streams, so only the first frame grows
+	VectorCommandStream Vector;
+	long long VectorFirst = 0, VectorTime = 0;
+	for (uint32_t Frame = 0; Frame < Frames; Frame++)
+	{
+		Vector.Stream.clear();
+		Chilli::Timer Timer;
+		EncodeDraws(Vector, DrawCount);
+		long long Time = Timer.ElapsedMcl();
+		VectorTime += Time;
+		if (Frame == 0)
+			VectorFirst = Time;
+	}
+
+	CH_CORE_INFO("[{0} draws] Paged: {1:.1f} M cmds/s (first frame {2:.3f} ms), {3} KiB, {4} heap pages",
+		DrawCount, ToMillionsPerSecond(Commands, PagedTime), ToMs(PagedFirst), Paged.Size() / 1024,
+		Pool.GetHeapPageCount());
+	CH_CORE_INFO("[{0} draws] Vector: {1:.1f} M cmds/s (first frame {2:.3f} ms), {3} KiB",
+		DrawCount, ToMillionsPerSecond(Commands, VectorTime), ToMs(VectorFirst), Vector.Stream.size() / 1024);
+
+	Chilli::Timer Timer;
+	uint64_t Checksum = 0;
+	for (uint32_t Frame = 0; Frame < Frames; Frame++)
+	{
+		Chilli::RenderCommandReader Reader(Paged);
+		Chilli::RenderCommand Command;
+		while (Reader.Next(Command))
+			Checksum += uint32_t(Command.Code) + Command.Size;
+	}
+	long long ReadTime = Timer.ElapsedMcl();
+	CH_CORE_INFO("[{0} draws] Read: {1:.1f} M cmds/s (checksum {2})", DrawCount,
+		ToMillionsPerSecond(Commands, ReadTime), Checksum);
+}
+
+// Payloads past CH_RENDER_COMMAND_MAX_INLINE_PAYLOAD take the blob path
+static void BenchBlobs(uint32_t PayloadSize, uint32_t Count)
+{
+	std::vector<uint8_t> Data(PayloadSize, 0xAB);
+	Chilli::GraphicsCommandBuffer Stream;
+
+	Chilli::Timer Timer;
+	for (uint32_t i = 0; i < Count; i++)
+		Stream.PushInlineUniformData(1, 0, Data.data(), PayloadSize, 0);
+	long long Time = Timer.ElapsedMcl();
+
+	bool Valid = true;
+	Chilli::RenderCommandReader Reader(Stream);
+	Chilli::RenderCommand Command;
+	while (Reader.Next(Command))
+		Valid &= Command.Payload[Command.Size - 1] == 0xAB;
+
+	CH_CORE_INFO("[{0} byte payload] {1} commands in {2:.3f} ms, stream {3} KiB, valid: {4}", PayloadSize, Count,
+		ToMs(Time), Stream.Size() / 1024, Valid);
+}
+
+int main()
+{
+	Chilli::Log::Init();
+
+	for (uint32_t DrawCount : { 1000u, 10000u, 100000u })
+		BenchEncode(DrawCount, 100);
+
+	BenchBlobs(1024, 10000);
+	BenchBlobs(64 * 1024, 1000);
+	BenchBlobs(1024 * 1024, 16);
+
+	return 0;
+}
@@ -0,0 +1,184 @@
+#include "Ch_PCH.h"
+#include "Chilli/Chilli.h"
+#include "Profiling\Timer.h"
+
+#include <random>
+
+// Times the DynamicBVH behind SpatialIndexResource against a linear scan over the same boxes.
+// No window or renderer is created, only the tree is exercised.
+
+struct BenchScene
+{
+	std::vector<Chilli::BoundingBox> Boxes;
+	std::vector<uint32_t> Proxies;
+	Chilli::DynamicBVH Tree;
+};
+
+static Chilli::BoundingBox MakeBox(const glm::vec3& Center, float HalfSize)
+{
+	return { Center - glm::vec3(HalfSize), Center + glm::vec3(HalfSize) };
+}
+
+static double ToMs(long long Microseconds) { return double(Microseconds) / 1000.0; }
+
+static void BenchInsert(BenchScene& Scene, uint32_t Count, std::mt19937& Rng)
+{
+	std::uniform_real_distribution<float> Position(-500.0f, 500.0f);
+
+	Scene.Boxes.resize(Count);
+	for (auto& Box : Scene.Boxes)
+		Box = MakeBox(glm::vec3(Position(Rng), Position(Rng), Position(Rng)), 1.0f);
+
+	Chilli::Timer Timer;
+	Scene.Proxies.resize(Count);
+	for (uint32_t i = 0; i < Count; i++)
+		Scene.Proxies[i] = Scene.Tree.CreateProxy(Scene.Boxes[i], i);
+	long long InsertTime = Timer.ElapsedMcl();
+
+	Chilli::Timer RebuildTimer;
+	Scene.Tree.Rebuild();
+	long long RebuildTime = RebuildTimer.ElapsedMcl();
+
+	auto Stats = Scene.Tree.GetStats();
+	CH_CORE_INFO("[{0}] Insert: {1:.3f} ms, Rebuild: {2:.3f} ms, Height: {3}, Area Ratio: {4:.2f}", Count,
+		ToMs(InsertTime), ToMs(RebuildTime), Stats.Height, Stats.AreaRatio);
+}
+
+// Moves a fraction of the boxes by a small step every frame, like a scene of walking characters
+static void BenchMoves(BenchScene& Scene, float MoveFraction, uint32_t Frames, std::mt19937& Rng)
+{
+	std::uniform_real_distribution<float> Step(-0.5f, 0.5f);
+	std::uniform_int_distribution<uint32_t> Pick(0, uint32_t(Scene.Boxes.size()) - 1);
+	uint32_t MovesPerFrame = uint32_t(float(Scene.Boxes.size()) * MoveFraction);
+
+	auto StartStats = Scene.Tree.GetStats();
+	long long UpdateTime = 0;
+	for (uint32_t Frame = 0; Frame < Frames; Frame++)
+	{
+		for (uint32_t i = 0; i < MovesPerFrame; i++)
+		{
+			uint32_t Index = Pick(Rng);
+			glm::vec3 Offset(Step(Rng), Step(Rng), Step(Rng));
+			Scene.Boxes[Index] = { Scene.Boxes[Index].Min + Offset, Scene.Boxes[Index].Max + Offset };
+			Scene.Tree.MoveProxy(Scene.Proxies[Index], Scene.Boxes[Index]);
+		}
+
+		Chilli::Timer Timer;
+		Scene.Tree.Update();
+		UpdateTime += Timer.ElapsedMcl();
+	}
+
+	auto Stats = Scene.Tree.GetStats();
+	CH_CORE_INFO("[{0}] Moving {1:.0f}%: {2:.3f} ms per Update, Refits: {3}, Rebuilds: {4}, Area Ratio: {5:.2f}",
+		Scene.Boxes.size(), MoveFraction * 100.0f, ToMs(UpdateTime) / double(Frames),
+		Stats.RefitCount - StartStats.RefitCount, Stats.RebuildCount - StartStats.RebuildCount, Stats.AreaRatio);
+}
+
+static void BenchQueries(BenchScene& Scene, uint32_t Iterations)
+{
+	std::vector<uint32_t> Results;
+	const float Margin = Scene.Tree.GetConfig().FatMargin;
+
+	glm::mat4 ViewProj(1.0f);
+	ViewProj[0][0] = 1.0f / 150.0f; ViewProj[1][1] = 1.0f / 150.0f; ViewProj[2][2] = 1.0f / 150.0f;
+	Chilli::Frustum View = Chilli::Frustum::FromViewProj(ViewProj);
+	Chilli::BoundingBox QueryBox = MakeBox(glm::vec3(100.0f, 0.0f, -50.0f), 40.0f);
+	glm::vec3 SphereCenter(-50.0f, 20.0f, 10.0f);
+	float SphereRadius = 60.0f;
+
+	auto Time = [&](auto&& Query) {
+		size_t Found = 0;
+		Chilli::Timer Timer;
+		for (uint32_t i = 0; i < Iterations; i++)
+		{
+			Results.clear();
+			Query();
+			Found = Results.size();
+		}
+		return std::make_pair(ToMs(Timer.ElapsedMcl()) / double(Iterations), Found);
+		};
+
+	// The linear scans test the same fat boxes the tree stores so both sides find the same set
+	auto Fat = [&](uint32_t i) { return Scene.Boxes[i].Expanded(Margin); };
+
+	auto [FrustumTree, FrustumFound] = Time([&] { Scene.Tree.QueryFrustum(View, Results); });
+	auto [FrustumLinear, FrustumLinearFound] = Time([&] {
+		for (uint32_t i = 0; i < Scene.Boxes.size(); i++)
+		{
+			auto Box = Fat(i);
+			glm::vec3 C = Box.GetCenter(), E = Box.GetExtent();
+			bool Outside = false;
+			for (int p = 0; p < Chilli::Frustum::PLANE_COUNT && !Outside; p++)
+			{
+				const glm::vec4& Plane = View.Planes[p];
+				float Distance = C.x * Plane.x + C.y * Plane.y + C.z * Plane.z + Plane.w;
+				float Radius = E.x * std::fabs(Plane.x) + E.y * std::fabs(Plane.y) + E.z * std::fabs(Plane.z);
+				Outside = Distance + Radius < 0.0f;
+			}
+			if (!Outside)
+				Results.push_back(i);
+		}
+		});
+
+	auto [BoxTree, BoxFound] = Time([&] { Scene.Tree.QueryBox(QueryBox, Results); });
+	auto [BoxLinear, BoxLinearFound] = Time([&] {
+		for (uint32_t i = 0; i < Scene.Boxes.size(); i++)
+		{
+			auto Box = Fat(i);
+			if (Box.Min.x <= QueryBox.Max.x && Box.Min.y <= QueryBox.Max.y && Box.Min.z <= QueryBox.Max.z &&
+				QueryBox.Min.x <= Box.Max.x && QueryBox.Min.y <= Box.Max.y && QueryBox.Min.z <= Box.Max.z)
+				Results.push_back(i);
+		}
+		});
+
+	auto [SphereTree, SphereFound] = Time([&] { Scene.Tree.QuerySphere(SphereCenter, SphereRadius, Results); });
+	auto [SphereLinear, SphereLinearFound] = Time([&] {
+		for (uint32_t i = 0; i < Scene.Boxes.size(); i++)
+		{
+			auto Box = Fat(i);
+			float DistanceSq = 0.0f;
+			for (int Axis = 0; Axis < 3; Axis++)
+			{
+				float Delta = std::fmax(Box.Min[Axis] - SphereCenter[Axis], 0.0f) +
+					std::fmax(SphereCenter[Axis] - Box.Max[Axis], 0.0f);
+				DistanceSq += Delta * Delta;
+			}
+			if (DistanceSq <= SphereRadius * SphereRadius)
+				Results.push_back(i);
+		}
+		});
+
+	Chilli::Ray PickRay;
+	PickRay.Origin = glm::vec3(-600.0f, 0.0f, 0.0f);
+	PickRay.Direction = glm::vec3(1.0f, 0.01f, 0.02f);
+	Chilli::RayHit Hit;
+	auto [RayTree, RayFound] = Time([&] { if (Scene.Tree.RayCast(PickRay, Hit)) Results.push_back(Hit.UserData); });
+
+	CH_CORE_INFO("[{0}] Frustum: {1:.4f} ms vs linear {2:.4f} ms ({3} / {4} found)", Scene.Boxes.size(),
+		FrustumTree, FrustumLinear, FrustumFound, FrustumLinearFound);
+	CH_CORE_INFO("[{0}] Box:     {1:.4f} ms vs linear {2:.4f} ms ({3} / {4} found)", Scene.Boxes.size(),
+		BoxTree, BoxLinear, BoxFound, BoxLinearFound);
+	CH_CORE_INFO("[{0}] Sphere:  {1:.4f} ms vs linear {2:.4f} ms ({3} / {4} found)", Scene.Boxes.size(),
+		SphereTree, SphereLinear, SphereFound, SphereLinearFound);
+	CH_CORE_INFO("[{0}] RayCast: {1:.4f} ms ({2} hit)", Scene.Boxes.size(), RayTree, RayFound);
+}
+
+int main()
+{
+	Chilli::Log::Init();
+
+	std::mt19937 Rng(1234);
+	for (uint32_t Count : { 1000u, 10000u, 100000u })
+	{
+		BenchScene Scene;
+		BenchInsert(Scene, Count, Rng);
+		BenchQueries(Scene, 100);
+
+		// Few movers refit along their own paths, most movers take the single full refit pass
+		BenchMoves(Scene, 0.05f, 100, Rng);
+		BenchMoves(Scene, 0.75f, 20, Rng);
+		BenchQueries(Scene, 100);
+	}
+
+	return 0;
+}
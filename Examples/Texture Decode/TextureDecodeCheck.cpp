@@ -0,0 +1,182 @@
+#include "Ch_PCH.h"
+#include "Chilli/Chilli.h"
+#include "TextureCompression.h"
+
+// Decodes single BC1, BC3, BC5 and BC7 blocks and compares them texel by texel with reference RGBA.
+// The references come from an independent decoder, the BC7 blocks cover every mode, including
+// partitions whose anchor texels are not the last one. Returns non zero when any block differs.
+
+struct DecodeCase
+{
+	const char* Name;
+	Chilli::ImageFormat Format;
+	uint8_t Block[16];
+	uint8_t Expected[16 * 4];
+};
+
+static const DecodeCase Cases[] = {
+	{
+		"BC1, four colors", Chilli::ImageFormat::BC1_RGBA,
+		{ 0x1F, 0xF8, 0xE0, 0x07, 0xE4, 0x1B, 0x4E, 0xB1 },
+		{
+			255,   0, 255, 255,   0, 255,   0, 255, 170,  85, 170, 255,  85, 170,  85, 255,
+			 85, 170,  85, 255, 170,  85, 170, 255,   0, 255,   0, 255, 255,   0, 255, 255,
+			170,  85, 170, 255,  85, 170,  85, 255, 255,   0, 255, 255,   0, 255,   0, 255,
+			  0, 255,   0, 255, 255,   0, 255, 255,  85, 170,  85, 255, 170,  85, 170, 255,
+		},
+	},
+	{
+		"BC1, three colors and transparent black", Chilli::ImageFormat::BC1_RGBA,
+		{ 0xE0, 0x07, 0x1F, 0xF8, 0x1B, 0xE4, 0xB1, 0x4E },
+		{
+			  0,   0,   0,   0, 127, 127, 127, 255, 255,   0, 255, 255,   0, 255,   0, 255,
+			  0, 255,   0, 255, 255,   0, 255, 255, 127, 127, 127, 255,   0,   0,   0,   0,
+			255,   0, 255, 255,   0, 255,   0, 255,   0,   0,   0,   0, 127, 127, 127, 255,
+			127, 127, 127, 255,   0,   0,   0,   0,   0, 255,   0, 255, 255,   0, 255, 255,
+		},
+	},
+	{
+		"BC3, eight alpha values", Chilli::ImageFormat::BC3_RGBA,
+		{ 0xF0, 0x10, 0x88, 0xC6, 0xFA, 0x05, 0x39, 0xD7, 0x00, 0xF8, 0x1F, 0x00, 0x27, 0x72, 0x8D, 0xD8 },
+		{
+			 85,   0, 170, 240,   0,   0, 255,  16, 170,   0,  85, 208, 255,   0,   0, 176,
+			170,   0,  85, 144, 255,   0,   0, 112,  85,   0, 170,  80,   0,   0, 255,  48,
+			  0,   0, 255, 112,  85,   0, 170, 240, 255,   0,   0, 144, 170,   0,  85, 144,
+			255,   0,   0, 176, 170,   0,  85,  80,   0,   0, 255, 112,  85,   0, 170,  80,
+		},
+	},
+	{
+		"BC5, red with eight values, green with six and the 0/255 extremes", Chilli::ImageFormat::BC5_RG,
+		{ 0xE0, 0x20, 0x88, 0xC6, 0xFA, 0x05, 0x39, 0xD7, 0x30, 0xC0, 0xF1, 0x8E, 0x63, 0xAB, 0x17, 0x5C },
+		{
+			224, 192,   0, 255,  32,   0,   0, 255, 196, 105,   0, 255, 169, 255,   0, 255,
+			141,  48,   0, 255, 114, 255,   0, 255,  86,  48,   0, 255,  59, 105,   0, 255,
+			114, 105,   0, 255, 224, 163,   0, 255, 141,   0,   0, 255, 141, 105,   0, 255,
+			169, 192,   0, 255,  86,  48,   0, 255, 114, 255,   0, 255,  86,  76,   0, 255,
+		},
+	},
+	{
+		"BC7 mode 0, three subsets, partition 13 (anchors 5, 15)", Chilli::ImageFormat::BC7_RGBA,
+		{ 0xBB, 0x1C, 0x06, 0xBD, 0x46, 0x3E, 0x39, 0x23, 0xBC, 0x1A, 0xAD, 0xBD, 0xE4, 0x8B, 0x16, 0x97 },
+		{
+			103,  77, 129, 255,  41, 193, 176, 255, 209, 190, 183, 255, 239, 206, 222, 255,
+			124,  73, 111, 255,  16,  95,  79, 255, 194, 182, 163, 255, 239, 206, 222, 255,
+			189,  58,  53, 255,   0,  33,  16, 255, 209, 190, 183, 255, 209, 190, 183, 255,
+			 82,  82, 148, 255,  57, 255, 239, 255, 162, 164, 121, 255, 162, 164, 121, 255,
+		},
+	},
+	{
+		"BC7 mode 1, two subsets, partition 17 (anchor 2)", Chilli::ImageFormat::BC7_RGBA,
+		{ 0x46, 0x08, 0x07, 0x17, 0x37, 0x3B, 0x81, 0x9A, 0x06, 0x8F, 0x32, 0xB7, 0xA6, 0xB3, 0x8B, 0x6B },
+		{
+			 32, 221, 104, 255, 122, 100, 173, 255, 146,  93, 180, 255, 122, 100, 173, 255,
+			 66, 202, 104, 255,  90, 189, 104, 255,  43, 215, 104, 255,  71, 116, 158, 255,
+			 66, 202, 104, 255, 101, 183, 104, 255, 101, 183, 104, 255,  90, 189, 104, 255,
+			 32, 221, 104, 255, 112, 177, 104, 255,  55, 209, 104, 255,  66, 202, 104, 255,
+		},
+	},
+	{
+		"BC7 mode 2, three subsets, partition 20 (anchors 3, 15)", Chilli::ImageFormat::BC7_RGBA,
+		{ 0xA4, 0x72, 0x96, 0x47, 0xCF, 0xDE, 0x01, 0xC2, 0xCE, 0x28, 0xB2, 0x6C, 0x57, 0x47, 0x27, 0x37 },
+		{
+			206, 239,  49, 255, 118,  22,  52, 255, 118,  22,  52, 255, 118,  22,  52, 255,
+			206, 239,  82, 255, 148,   0,  33, 255,  87,  44,  71, 255,  87,  44,  71, 255,
+			206, 239,  82, 255, 214, 198, 181, 255, 195, 171, 200, 255, 175, 142, 220, 255,
+			206, 239,  82, 255, 175, 142, 220, 255, 195, 171, 200, 255, 214, 198, 181, 255,
+		},
+	},
+	{
+		"BC7 mode 3, two subsets, partition 34 (anchor 6)", Chilli::ImageFormat::BC7_RGBA,
+		{ 0x28, 0xC2, 0x56, 0x1A, 0x17, 0x61, 0x18, 0x5B, 0xD8, 0x58, 0x9A, 0x43, 0xCE, 0x0B, 0xBA, 0x75 },
+		{
+			 93,  50, 102, 255,  65,  73,  40, 255,  90,  93,  95, 255,  93,  23,  15, 255,
+			 65,  73,  40, 255,  93,  50, 102, 255,  52,  98,  52, 255,  97,   9, 109, 255,
+			 90,  93,  95, 255,  80,  48,  27, 255,  86, 134,  88, 255,  80,  48,  27, 255,
+			 65,  73,  40, 255,  93,  50, 102, 255,  93,  23,  15, 255,  93,  50, 102, 255,
+		},
+	},
+	{
+		"BC7 mode 4, alpha rotated into blue, index selection", Chilli::ImageFormat::BC7_RGBA,
+		{ 0xF0, 0x1F, 0xF9, 0xEC, 0x60, 0x14, 0x8D, 0x4B, 0xD4, 0xA0, 0x9E, 0xE2, 0xDC, 0x5C, 0x93, 0x31 },
+		{
+			175, 230,  69, 122, 175, 230,  69, 122, 202, 235,  69, 120, 228, 241,  69, 117,
+			 93, 212,  69, 130, 228, 241,  69, 117,  66, 206,  69, 132,  93, 212,  69, 130,
+			146, 223,  69, 125, 175, 230,  69, 122, 119, 218,  69, 127, 228, 241,  69, 117,
+			228, 241,  69, 117, 175, 230,  69, 122, 146, 223,  69, 125, 228, 241,  69, 117,
+		},
+	},
+	{
+		"BC7 mode 5, alpha rotated into green", Chilli::ImageFormat::BC7_RGBA,
+		{ 0xA0, 0x11, 0x0B, 0xA9, 0x3A, 0xC5, 0x4A, 0xFC, 0x14, 0xDA, 0x3B, 0xDD, 0x19, 0x61, 0x47, 0x74 },
+		{
+			 37,  18, 170, 104,  41,  48, 174, 139,  34,  33, 167,  72,  34,  18, 167,  72,
+			 37,  33, 170, 104,  44,  18, 177, 171,  41,  48, 174, 139,  44,  33, 177, 171,
+			 37,  63, 170, 104,  44,  33, 177, 171,  37,  18, 170, 104,  41,  33, 174, 139,
+			 41,  18, 174, 139,  44,  33, 177, 171,  41,  63, 174, 139,  44,  33, 177, 171,
+		},
+	},
+	{
+		"BC7 mode 6", Chilli::ImageFormat::BC7_RGBA,
+		{ 0xC0, 0xD5, 0x5D, 0x29, 0x5E, 0x5A, 0x35, 0xAB, 0x44, 0xB3, 0xEF, 0xAE, 0xA5, 0x12, 0x9B, 0xA2 },
+		{
+			108, 156, 154,  58, 127, 161, 157,  62, 118, 159, 155,  60, 198, 184, 166,  77,
+			238, 196, 172,  86, 229, 193, 171,  84, 229, 193, 171,  84, 188, 181, 165,  75,
+			137, 164, 158,  64, 188, 181, 165,  75, 108, 156, 154,  58,  96, 152, 152,  55,
+			198, 184, 166,  77, 177, 177, 163,  73, 108, 156, 154,  58, 188, 181, 165,  75,
+		},
+	},
+	{
+		"BC7 mode 7, two subsets with alpha, partition 52 (anchor 15)", Chilli::ImageFormat::BC7_RGBA,
+		{ 0x80, 0xB4, 0xBA, 0x3E, 0x29, 0x76, 0x61, 0x45, 0xFD, 0xEC, 0xA3, 0xB0, 0x8E, 0x38, 0xAF, 0x53 },
+		{
+			117,  88, 137, 167, 189, 169, 178, 120, 243, 186, 235,  81, 117,  88, 137, 167,
+			243, 186, 235,  81,  77, 134,  60, 199, 117,  88, 137, 167, 154,  94, 102, 112,
+			 77, 134,  60, 199, 117,  88, 137, 167, 117,  88, 137, 167,  77, 134,  60, 199,
+			117,  88, 137, 167, 154,  94, 102, 112, 131, 151, 117, 160, 243, 186, 235,  81,
+		},
+	},
+};
+
+static bool CheckCase(const DecodeCase& Case)
+{
+	uint8_t Texels[16 * 4];
+	if (!Chilli::DecodeBlockCompressedImage(Case.Format, Case.Block, Chilli::GetBlockCompressedBlockSize(Case.Format), 4, 4,
+		Texels))
+	{
+		CH_CORE_ERROR("{0}: not decoded", Case.Name);
+		return false;
+	}
+
+	uint32_t Mismatches = 0;
+	for (uint32_t i = 0; i < 16; i++)
+	{
+		if (memcmp(Texels + i * 4, Case.Expected + i * 4, 4) == 0)
+			continue;
+
+		// Only the first few, one wrong endpoint tends to break the whole block
+		if (Mismatches++ < 4)
+			CH_CORE_ERROR("{0}: texel {1} is ({2}, {3}, {4}, {5}), expected ({6}, {7}, {8}, {9})", Case.Name, i,
+				Texels[i * 4], Texels[i * 4 + 1], Texels[i * 4 + 2], Texels[i * 4 + 3],
+				Case.Expected[i * 4], Case.Expected[i * 4 + 1], Case.Expected[i * 4 + 2], Case.Expected[i * 4 + 3]);
+	}
+
+	if (Mismatches == 0)
+		CH_CORE_INFO("{0}: ok", Case.Name);
+	return Mismatches == 0;
+}
+
+int main()
+{
+	Chilli::Log::Init();
+
+	uint32_t Failed = 0;
+	for (const auto& Case : Cases)
+		if (!CheckCase(Case))
+			Failed++;
+
+	if (Failed > 0)
+		CH_CORE_ERROR("{0} of {1} blocks decoded wrong", Failed, std::size(Cases));
+	else
+		CH_CORE_INFO("All {0} blocks decoded correctly", std::size(Cases));
+	return Failed > 0 ? 1 : 0;
+}
@@ -1,9 +1,9 @@
 # ...existing code...
 #!/usr/bin/env python3
 r"""
-Compile all .vert and .frag GLSL files found in an input path using glslc,
-produce outputs named <shadername>_vert.spv and <shadername>_frag.spv and copy
-them to a provided output directory.
+Compile all .vert, .frag and .comp GLSL files found in an input path using glslc,
+produce outputs named <shadername>_vert.spv, <shadername>_frag.spv and
+<shadername>_comp.spv and copy them to a provided output directory.
 
 Usage:
     python Shader_Compile.py <input_path> <output_dir> [--glslc C:\path\to\glslc.exe]
@@ -17,11 +17,12 @@ import sys
 def find_shader_files(src: Path):
     files = []
     if src.is_file():
-        if src.suffix in ('.vert', '.frag'):
+        if src.suffix in ('.vert', '.frag', '.comp'):
             files.append(src)
     else:
         files.extend(src.rglob('*.vert'))
         files.extend(src.rglob('*.frag'))
+        files.extend(src.rglob('*.comp'))
     return sorted(set(files))
 
 def mapped_out_name(src: Path):
@@ -30,6 +31,8 @@ def mapped_out_name(src: Path):
         return f"{stem}_vert.spv"
     if src.suffix == '.frag':
         return f"{stem}_frag.spv"
+    if src.suffix == '.comp':
+        return f"{stem}_comp.spv"
     return f"{stem}.spv"
 
 def which_exe(name):
@@ -50,8 +53,8 @@ def compile_shader(glslc_path: str, src: Path, dest: Path):
     return True, ""
 
 def main():
-    p = argparse.ArgumentParser(description="Compile .vert/.frag files with glslc and copy .spv outputs")
-    p.add_argument("input", help="Input file or directory containing .vert/.frag files")
+    p = argparse.ArgumentParser(description="Compile .vert/.frag/.comp files with glslc and copy .spv outputs")
+    p.add_argument("input", help="Input file or directory containing .vert/.frag/.comp files")
     p.add_argument("output", help="Directory to place compiled .spv files")
     p.add_argument("--glslc", help="Path to glslc executable (optional; must be in PATH if omitted)")
     args = p.parse_args()
@@ -70,7 +73,7 @@ def main():
 
     shader_files = find_shader_files(src)
     if not shader_files:
-        print("No .vert or .frag files found.", file=sys.stderr)
+        print("No .vert, .frag or .comp files found.", file=sys.stderr)
         sys.exit(1)
 
     failed = []
@@ -86,6 +89,10 @@ def main():
 
         ok, msg = compile_shader(glslc_path, s, dest)
         if ok:
+            # The engine rewrites the reflection blob on the next load, it would be rejected by hash anyway
+            refl = dest.with_name(dest.name + '.refl')
+            if refl.exists():
+                refl.unlink()
             succeeded.append((s, dest))
             print(f"Compiled: {s} -> {dest}")
         else: